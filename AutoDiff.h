@@ -0,0 +1,134 @@
+// AutoDiff.h
+#ifndef AUTO_DIFF_H
+#define AUTO_DIFF_H
+
+#include <cmath>
+#include <complex>
+#include <type_traits>
+
+//forward-mode automatic differentiation: a value and its derivatives with respect to N inputs,
+//carried through arithmetic and the elementary functions, so a model's gradient comes out of one
+//evaluation of its formula instead of N + 1 bumped ones. T is double or std::complex<double>;
+//model code written as a template on its number type runs unchanged on Jets
+//(calibration gradients in Calibration.cpp and HestonCos)
+template <class T, int N>
+struct Jet {
+    T v{};     //value
+    T d[N]{};  //derivative with respect to input i
+
+    Jet() = default;
+    Jet(const T& value) : v(value) {}
+
+    //input i of the N being differentiated
+    static Jet variable(const T& value, int i) {
+        Jet x(value);
+        x.d[i] = T(1);
+        return x;
+    }
+};
+
+template <class X>
+struct IsJet : std::false_type {};
+template <class T, int N>
+struct IsJet<Jet<T, N>> : std::true_type {};
+
+//anything that mixes with a Jet<T, N> as a constant: double, or T itself
+template <class S, class T>
+concept JetScalar = !IsJet<S>::value && std::is_convertible_v<S, T>;
+
+//f(x) given f(v) and f'(v): the chain rule applied to every derivative
+template <class T, int N>
+inline Jet<T, N> chain(const Jet<T, N>& x, const T& value, const T& slope) {
+    Jet<T, N> out(value);
+    for (int i = 0; i < N; ++i) out.d[i] = slope * x.d[i];
+    return out;
+}
+
+template <class T, int N>
+inline Jet<T, N> operator-(const Jet<T, N>& x) {
+    return chain(x, -x.v, T(-1));
+}
+
+template <class T, int N>
+inline Jet<T, N> operator+(const Jet<T, N>& a, const Jet<T, N>& b) {
+    Jet<T, N> out(a.v + b.v);
+    for (int i = 0; i < N; ++i) out.d[i] = a.d[i] + b.d[i];
+    return out;
+}
+
+template <class T, int N>
+inline Jet<T, N> operator-(const Jet<T, N>& a, const Jet<T, N>& b) {
+    Jet<T, N> out(a.v - b.v);
+    for (int i = 0; i < N; ++i) out.d[i] = a.d[i] - b.d[i];
+    return out;
+}
+
+template <class T, int N>
+inline Jet<T, N> operator*(const Jet<T, N>& a, const Jet<T, N>& b) {
+    Jet<T, N> out(a.v * b.v);
+    for (int i = 0; i < N; ++i) out.d[i] = a.d[i] * b.v + a.v * b.d[i];
+    return out;
+}
+
+template <class T, int N>
+inline Jet<T, N> operator/(const Jet<T, N>& a, const Jet<T, N>& b) {
+    const T inv = T(1) / b.v;
+    const T q = a.v * inv;
+    Jet<T, N> out(q);
+    for (int i = 0; i < N; ++i) out.d[i] = (a.d[i] - q * b.d[i]) * inv;
+    return out;
+}
+
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator+(const Jet<T, N>& a, const S& s) { Jet<T, N> out = a; out.v += T(s); return out; }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator+(const S& s, const Jet<T, N>& a) { return a + s; }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator-(const Jet<T, N>& a, const S& s) { Jet<T, N> out = a; out.v -= T(s); return out; }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator-(const S& s, const Jet<T, N>& a) { Jet<T, N> out = -a; out.v += T(s); return out; }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator*(const Jet<T, N>& a, const S& s) { return chain(a, a.v * T(s), T(s)); }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator*(const S& s, const Jet<T, N>& a) { return a * s; }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator/(const Jet<T, N>& a, const S& s) { return a * (T(1) / T(s)); }
+template <class T, int N, JetScalar<T> S>
+inline Jet<T, N> operator/(const S& s, const Jet<T, N>& a) {
+    const T q = T(s) / a.v;
+    return chain(a, q, -q / a.v);
+}
+
+template <class T, int N>
+inline Jet<T, N> exp(const Jet<T, N>& x) {
+    using std::exp;
+    const T e = exp(x.v);
+    return chain(x, e, e);
+}
+
+template <class T, int N>
+inline Jet<T, N> log(const Jet<T, N>& x) {
+    using std::log;
+    return chain(x, log(x.v), T(1) / x.v);
+}
+
+template <class T, int N>
+inline Jet<T, N> sqrt(const Jet<T, N>& x) {
+    using std::sqrt;
+    const T s = sqrt(x.v);
+    return chain(x, s, T(0.5) / s);
+}
+
+template <class T, int N>
+inline Jet<T, N> pow(const Jet<T, N>& x, double p) {
+    using std::pow;
+    const T y = pow(x.v, p);
+    return chain(x, y, T(p) * y / x.v);
+}
+
+//value of a Jet or of a plain number, for branching on the value inside templated model code
+inline double valueOf(double x) { return x; }
+template <class T, int N>
+inline T valueOf(const Jet<T, N>& x) { return x.v; }
+
+#endif // AUTO_DIFF_H
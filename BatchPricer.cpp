@@ -0,0 +1,485 @@
+#include "BatchPricer.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+#include <cfloat>
+#include <limits>
+
+void OptionBatch::reserve(size_t n) {
+    S.reserve(n);
+    K.reserve(n);
+    T.reserve(n);
+    r.reserve(n);
+    sigma.reserve(n);
+    type.reserve(n);
+}
+
+void OptionBatch::add(double spot, double strike, double maturity, double rate, double vol, OptionType t) {
+    S.push_back(spot);
+    K.push_back(strike);
+    T.push_back(maturity);
+    r.push_back(rate);
+    sigma.push_back(vol);
+    type.push_back(t);
+}
+
+void BatchResult::resize(size_t n) {
+    price.resize(n);
+    delta.resize(n);
+    gamma.resize(n);
+    vega.resize(n);
+    theta.resize(n);
+    rho.resize(n);
+}
+
+//output arrays for one kernel run, greeks are left null when only prices are wanted
+struct BatchOutputs {
+    double* price;
+    double* delta;
+    double* gamma;
+    double* vega;
+    double* theta;
+    double* rho;
+};
+
+//scalar reference pass, also the fallback on CPUs/compilers without SIMD
+//log, sqrt and exp are computed once per contract and shared by the price and all five greeks,
+//instead of blackScholes() + calculateGreeks() each recomputing them per OptionPricer object
+template <bool WithGreeks>
+static void bsScalar(const double* S, const double* K, const double* T, const double* r,
+                     const double* sigma, const OptionType* type, BatchOutputs out, size_t begin, size_t n) {
+    for (size_t i = begin; i < n; ++i) {
+        if (WithGreeks) {
+            const PriceGreeks pg = OptionPricer::priceWithGreeks(S[i], K[i], T[i], r[i], sigma[i], type[i]);
+            out.price[i] = pg.price;
+            out.delta[i] = pg.greeks.delta;
+            out.gamma[i] = pg.greeks.gamma;
+            out.vega[i]  = pg.greeks.vega;
+            out.theta[i] = pg.greeks.theta;
+            out.rho[i]   = pg.greeks.rho;
+            continue;
+        }
+
+        const double vol_time = sigma[i] * std::sqrt(T[i]);
+        const double d1 = (std::log(S[i] / K[i]) + (r[i] + 0.5 * sigma[i] * sigma[i]) * T[i]) / vol_time;
+        const double d2 = d1 - vol_time;
+        const double Kdisc = K[i] * std::exp(-r[i] * T[i]);
+
+        //φ(d2) = φ(d1) S / (K e^(-rT)), the same shortcut as OptionPricer::priceWithGreeks
+        const double pdf_d1 = OptionPricer::normalPDF(d1);
+        const double pdf_d2 = pdf_d1 >= DBL_MIN ? pdf_d1 * S[i] / Kdisc : OptionPricer::normalPDF(d2);
+        const double Nd1 = OptionPricer::normalCDFFromPDF(d1, pdf_d1);
+        const double Nd2 = OptionPricer::normalCDFFromPDF(d2, pdf_d2);
+
+        //put values come from N(-x) = 1 - N(x), so only two CDF evaluations per contract
+        out.price[i] = type[i] == OptionType::CALL ? S[i] * Nd1 - Kdisc * Nd2
+                                                   : Kdisc * (1.0 - Nd2) - S[i] * (1.0 - Nd1);
+    }
+}
+
+#if OPTION_PRICER_SIMD
+
+//W contracts at a time, same math as bsScalar with the SimdMath log/exp/CDF
+template <int W, bool WithGreeks>
+static inline __attribute__((always_inline))
+void bsLanes(const double* S, const double* K, const double* T, const double* r,
+             const double* sigma, const OptionType* type, BatchOutputs out, size_t i) {
+    typedef typename simd::Vec<W>::d VD;
+    typedef typename simd::Vec<W>::i VI;
+
+    const VD s   = simd::load<W>(S + i);
+    const VD k   = simd::load<W>(K + i);
+    const VD t   = simd::load<W>(T + i);
+    const VD rr  = simd::load<W>(r + i);
+    const VD vol = simd::load<W>(sigma + i);
+    VI is_call;
+    for (int j = 0; j < W; ++j) is_call[j] = type[i + j] == OptionType::CALL ? -1 : 0;
+
+    const VD sqrt_T   = simd::sqrt<W>(t);
+    const VD vol_time = vol * sqrt_T;
+    const VD d1 = (simd::log<W>(s / k) + (rr + 0.5 * vol * vol) * t) / vol_time;
+    const VD d2 = d1 - vol_time;
+
+    const VD discount = simd::exp<W>(-rr * t);
+    const VD k_disc   = k * discount;
+
+    //one density for both CDFs via φ(d2) = φ(d1) S / (K e^(-rT)), lanes where φ(d1)
+    //underflowed (far from the money) get φ(d2) computed directly
+    const VD pdf_d1 = simd::normalPDF<W>(d1);
+    VD pdf_d2 = pdf_d1 * s / k_disc;
+    const VI underflow = pdf_d1 < DBL_MIN;
+    if (simd::any<W>(underflow)) {
+        pdf_d2 = underflow ? simd::normalPDF<W>(d2) : pdf_d2;
+    }
+    const VD Nd1 = simd::normalCDFFromPDF<W>(d1, pdf_d1);
+    const VD Nd2 = simd::normalCDFFromPDF<W>(d2, pdf_d2);
+
+    simd::store<W>(out.price + i, is_call ? s * Nd1 - k_disc * Nd2
+                                          : k_disc * (1.0 - Nd2) - s * (1.0 - Nd1));
+    if (!WithGreeks) return;
+
+    const VD theta_common = -(s * pdf_d1 * vol) / (2.0 * sqrt_T);
+    simd::store<W>(out.delta + i, is_call ? Nd1 : Nd1 - 1.0);
+    simd::store<W>(out.theta + i, (is_call ? theta_common - rr * k_disc * Nd2
+                                           : theta_common + rr * k_disc * (1.0 - Nd2)) / 365.0);
+    simd::store<W>(out.rho + i, (is_call ? k * t * discount * Nd2
+                                         : -k * t * discount * (1.0 - Nd2)) / 100.0);
+    simd::store<W>(out.gamma + i, pdf_d1 / (s * vol_time));
+    simd::store<W>(out.vega + i, s * pdf_d1 * sqrt_T);
+}
+
+//full vectors straight from the arrays, the tail is padded into a small stack buffer
+//so every contract goes through the same SIMD math
+template <int W, bool WithGreeks>
+static inline __attribute__((always_inline))
+void bsLoop(const double* S, const double* K, const double* T, const double* r,
+            const double* sigma, const OptionType* type, BatchOutputs out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        bsLanes<W, WithGreeks>(S, K, T, r, sigma, type, out, i);
+    }
+    if (i == n) return;
+
+    const size_t rem = n - i;
+    double pS[W], pK[W], pT[W], pr[W], psigma[W];
+    double oPrice[W], oDelta[W], oGamma[W], oVega[W], oTheta[W], oRho[W];
+    OptionType pType[W];
+    for (size_t j = 0; j < W; ++j) {
+        const size_t src = j < rem ? i + j : i;  //repeat a real contract in the padding lanes
+        pS[j] = S[src]; pK[j] = K[src]; pT[j] = T[src]; pr[j] = r[src]; psigma[j] = sigma[src];
+        pType[j] = type[src];
+    }
+    BatchOutputs tmp{oPrice, oDelta, oGamma, oVega, oTheta, oRho};
+    bsLanes<W, WithGreeks>(pS, pK, pT, pr, psigma, pType, tmp, 0);
+    for (size_t j = 0; j < rem; ++j) {
+        out.price[i + j] = oPrice[j];
+        if (!WithGreeks) continue;
+        out.delta[i + j] = oDelta[j];
+        out.gamma[i + j] = oGamma[j];
+        out.vega[i + j]  = oVega[j];
+        out.theta[i + j] = oTheta[j];
+        out.rho[i + j]   = oRho[j];
+    }
+}
+
+//one entry point per instruction set, the target attribute makes the compiler
+//emit the inlined bsLoop body with that ISA's registers and instructions
+template <bool WithGreeks>
+__attribute__((target("avx512f")))
+static void bsAvx512(const double* S, const double* K, const double* T, const double* r,
+                     const double* sigma, const OptionType* type, BatchOutputs out, size_t n) {
+    bsLoop<8, WithGreeks>(S, K, T, r, sigma, type, out, n);
+}
+
+template <bool WithGreeks>
+__attribute__((target("avx2,fma")))
+static void bsAvx2(const double* S, const double* K, const double* T, const double* r,
+                   const double* sigma, const OptionType* type, BatchOutputs out, size_t n) {
+    bsLoop<4, WithGreeks>(S, K, T, r, sigma, type, out, n);
+}
+
+template <bool WithGreeks>
+static void bsSse2(const double* S, const double* K, const double* T, const double* r,
+                   const double* sigma, const OptionType* type, BatchOutputs out, size_t n) {
+    bsLoop<2, WithGreeks>(S, K, T, r, sigma, type, out, n);
+}
+
+#endif // OPTION_PRICER_SIMD
+
+//runs the widest kernel allowed by both the request and the CPU
+template <bool WithGreeks>
+static void dispatch(const double* S, const double* K, const double* T, const double* r,
+                     const double* sigma, const OptionType* type, BatchOutputs out, size_t n,
+                     SimdLevel level) {
+    level = std::min(level, detectSimdLevel());
+#if OPTION_PRICER_SIMD
+    switch (level) {
+        case SimdLevel::AVX512: bsAvx512<WithGreeks>(S, K, T, r, sigma, type, out, n); return;
+        case SimdLevel::AVX2:   bsAvx2<WithGreeks>(S, K, T, r, sigma, type, out, n);   return;
+        case SimdLevel::SSE2:   bsSse2<WithGreeks>(S, K, T, r, sigma, type, out, n);   return;
+        default: break;
+    }
+#endif
+    bsScalar<WithGreeks>(S, K, T, r, sigma, type, out, 0, n);
+}
+
+void blackScholesBatch(const double* S, const double* K, const double* T, const double* r,
+                       const double* sigma, const OptionType* type, double* out, size_t n,
+                       SimdLevel level) {
+    BatchOutputs outputs{out, nullptr, nullptr, nullptr, nullptr, nullptr};
+    dispatch<false>(S, K, T, r, sigma, type, outputs, n, level);
+}
+
+void priceBatch(const OptionBatch& batch, BatchResult& out, SimdLevel level) {
+    priceBatch(batch.S.data(), batch.K.data(), batch.T.data(), batch.r.data(), batch.sigma.data(),
+               batch.type.data(), out, batch.size(), level);
+}
+
+void priceBatch(const double* S, const double* K, const double* T, const double* r, const double* sigma,
+                const OptionType* type, BatchResult& out, size_t n, SimdLevel level) {
+    out.resize(n);
+    BatchOutputs outputs{out.price.data(), out.delta.data(), out.gamma.data(),
+                         out.vega.data(), out.theta.data(), out.rho.data()};
+    dispatch<true>(S, K, T, r, sigma, type, outputs, n, level);
+}
+
+//----- implied volatility -----
+
+//quotes per thread pool task, enough to amortise the hand-off and a multiple of every SIMD width
+constexpr size_t kImpliedVolBlock = 1024;
+
+//iteration settings shared by every lane
+struct ImpliedVolParams {
+    double tolerance;
+    int max_iter;
+};
+
+#if OPTION_PRICER_SIMD
+
+//W quotes through solveImpliedVol lane by lane: the same bounds checks, out-of-the-money target and
+//initial guess, then its iterations in lockstep. Lanes that converge are masked off and the loop
+//runs until every lane is done or max_iter
+template <int W>
+static inline __attribute__((always_inline))
+void ivLanes(const double* price, const double* S, const double* K, const double* T, const double* r,
+             const OptionType* type, ImpliedVolResult* out, size_t i, ImpliedVolParams params) {
+    typedef typename simd::Vec<W>::d VD;
+    typedef typename simd::Vec<W>::i VI;
+
+    const VD p_in = simd::load<W>(price + i);
+    const VD s_in = simd::load<W>(S + i);
+    const VD k_in = simd::load<W>(K + i);
+    const VD t_in = simd::load<W>(T + i);
+    const VD r_in = simd::load<W>(r + i);
+    VI type_call;
+    for (int j = 0; j < W; ++j) type_call[j] = type[i + j] == OptionType::CALL ? -1 : 0;
+
+    //invalid lanes carry on with harmless values, their result is settled below
+    const VI valid = (s_in > 0.0) & (k_in > 0.0) & (t_in > 0.0) & (p_in >= 0.0);
+    const VD zero = simd::broadcast<W>(0.0);
+    const VD one = simd::broadcast<W>(1.0);
+    const VD s = valid ? s_in : one;
+    const VD t = valid ? t_in : one;
+    const VD k_disc = (valid ? k_in : one) * simd::exp<W>(-(valid ? r_in : zero) * t);
+    const VD sqrt_T = simd::sqrt<W>(t);
+    const VD log_m = simd::log<W>(s / k_disc);
+
+    //out-of-the-money side by put-call parity, as in solveImpliedVol
+    const VI is_call = s <= k_disc;
+    const VD gap = s - k_disc;
+    VD target = (type_call ^ is_call) ? (type_call ? p_in - gap : p_in + gap) : p_in;
+    const VD upper = is_call ? s : k_disc;
+    const VD rounding = -4.0 * DBL_EPSILON * (is_call ? k_disc : s);  //max(S, K e^(-rT))
+    target = ((target < 0.0) & (target >= rounding)) ? simd::broadcast<W>(0.0) : target;
+    const VI below = valid & ~(target >= 0.0);
+    const VI above = valid & ~below & ~(target < upper);
+    const VI intrinsic = valid & ~below & ~above & (target == 0.0);
+    VI active = valid & ~below & ~above & ~intrinsic;
+
+    //Corrado-Miller, Brenner-Subrahmanyam where it fails, clamped to [1e-4, 5]
+    const VD call = is_call ? target : target + gap;
+    const VD a = call - 0.5 * gap;
+    const VD disc = a * a - gap * gap / M_PI;
+    VD sigma = std::sqrt(2.0 * M_PI) / (s + k_disc) * (a + simd::sqrt<W>(disc > 0.0 ? disc : zero)) / sqrt_T;
+    const VI usable = (sigma > 0.0) & (sigma < std::numeric_limits<double>::infinity());
+    sigma = usable ? sigma : std::sqrt(2.0 * M_PI) / sqrt_T * call / s;
+    sigma = sigma < 1e-4 ? simd::broadcast<W>(1e-4) : sigma;
+    sigma = sigma > 5.0 ? simd::broadcast<W>(5.0) : sigma;
+    sigma = active ? sigma : one;  //settled lanes still evaluate, harmlessly
+
+    const VD inf = simd::broadcast<W>(std::numeric_limits<double>::infinity());
+    VD lo = zero;
+    VD hi = inf;
+    VD vol = sigma;
+    VI converged = active & 0;
+    VI iterations = active & 0;
+    for (int it = 0; it < params.max_iter && simd::any<W>(active); ++it) {
+        //evaluate() from ImpliedVol.cpp
+        const VD vol_time = sigma * sqrt_T;
+        const VD d1 = log_m / vol_time + 0.5 * vol_time;
+        const VD d2 = d1 - vol_time;
+        const VD pdf_d1 = simd::normalPDF<W>(d1);
+        VD pdf_d2 = pdf_d1 * s / k_disc;
+        const VI underflow = pdf_d1 < DBL_MIN;
+        if (simd::any<W>(underflow)) {
+            pdf_d2 = underflow ? simd::normalPDF<W>(d2) : pdf_d2;
+        }
+        const VD Nd1 = simd::normalCDFFromPDF<W>(d1, pdf_d1);
+        const VD Nd2 = simd::normalCDFFromPDF<W>(d2, pdf_d2);
+        const VD value = is_call ? s * Nd1 - k_disc * Nd2 : k_disc * (1.0 - Nd2) - s * (1.0 - Nd1);
+        const VD vega = s * pdf_d1 * sqrt_T;
+        const VD volga = vega * d1 * d2 / sigma;
+        iterations -= active;  //mask lanes are -1
+
+        const VD diff = value - target;
+        const VI hit = active & (simd::abs<W>(diff) < params.tolerance);
+        vol = hit ? sigma : vol;
+        converged |= hit;
+        active &= ~hit;
+        hi = (active & (diff > 0.0)) ? sigma : hi;
+        lo = (active & (diff <= 0.0)) ? sigma : lo;
+
+        //Halley where its correction is mild, Newton otherwise, bisection when the step leaves the bracket
+        VD step = diff / vega;
+        const VD correction = 1.0 - 0.5 * step * volga / vega;
+        step = ((correction > 0.5) & (correction < 2.0)) ? step / correction : step;
+        VD next = vega > 0.0 ? sigma - step : -one;
+        const VI outside = ~((next > lo) & (next < hi));
+        next = outside ? (hi == inf ? 2.0 * sigma : 0.5 * (lo + hi)) : next;
+
+        const VI collapsed = active & (simd::abs<W>(next - sigma) <= 4.0 * DBL_EPSILON * sigma);
+        vol = collapsed ? next : vol;
+        converged |= collapsed;
+        active &= ~collapsed;
+        sigma = active ? next : sigma;
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int j = 0; j < W; ++j) {
+        ImpliedVolResult& res = out[i + j];
+        res.iterations = static_cast<int>(iterations[j]);
+        if (!valid[j] || below[j] || above[j]) {
+            res.vol = nan;
+            res.converged = false;
+            res.status = !valid[j] ? ImpliedVolStatus::INVALID_INPUT
+                       : below[j]  ? ImpliedVolStatus::BELOW_INTRINSIC : ImpliedVolStatus::ABOVE_MAXIMUM;
+        } else if (intrinsic[j]) {
+            res.vol = 0.0;  //exactly intrinsic, only zero volatility gives that
+            res.converged = true;
+            res.status = ImpliedVolStatus::OK;
+        } else {
+            res.converged = converged[j] != 0;
+            res.vol = res.converged ? vol[j] : sigma[j];  //best estimate when the limit was hit
+            res.status = res.converged ? ImpliedVolStatus::OK : ImpliedVolStatus::NOT_CONVERGED;
+        }
+    }
+}
+
+//full vectors straight from the arrays, the tail is padded like bsLoop
+template <int W>
+static inline __attribute__((always_inline))
+void ivLoop(const double* price, const double* S, const double* K, const double* T, const double* r,
+            const OptionType* type, ImpliedVolResult* out, size_t n, ImpliedVolParams params) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        ivLanes<W>(price, S, K, T, r, type, out, i, params);
+    }
+    if (i == n) return;
+
+    const size_t rem = n - i;
+    double pPrice[W], pS[W], pK[W], pT[W], pr[W];
+    OptionType pType[W];
+    ImpliedVolResult oResult[W];
+    for (size_t j = 0; j < W; ++j) {
+        const size_t src = j < rem ? i + j : i;  //repeat a real quote in the padding lanes
+        pPrice[j] = price[src]; pS[j] = S[src]; pK[j] = K[src]; pT[j] = T[src]; pr[j] = r[src];
+        pType[j] = type[src];
+    }
+    ivLanes<W>(pPrice, pS, pK, pT, pr, pType, oResult, 0, params);
+    for (size_t j = 0; j < rem; ++j) out[i + j] = oResult[j];
+}
+
+__attribute__((target("avx512f")))
+static void ivAvx512(const double* price, const double* S, const double* K, const double* T, const double* r,
+                     const OptionType* type, ImpliedVolResult* out, size_t n, ImpliedVolParams params) {
+    ivLoop<8>(price, S, K, T, r, type, out, n, params);
+}
+
+__attribute__((target("avx2,fma")))
+static void ivAvx2(const double* price, const double* S, const double* K, const double* T, const double* r,
+                   const OptionType* type, ImpliedVolResult* out, size_t n, ImpliedVolParams params) {
+    ivLoop<4>(price, S, K, T, r, type, out, n, params);
+}
+
+static void ivSse2(const double* price, const double* S, const double* K, const double* T, const double* r,
+                   const OptionType* type, ImpliedVolResult* out, size_t n, ImpliedVolParams params) {
+    ivLoop<2>(price, S, K, T, r, type, out, n, params);
+}
+
+#endif // OPTION_PRICER_SIMD
+
+void impliedVolBatch(const double* price, const double* S, const double* K, const double* T, const double* r,
+                     const OptionType* type, ImpliedVolResult* out, size_t n,
+                     double tolerance, int max_iter, SimdLevel level, unsigned max_threads) {
+    level = std::min(level, detectSimdLevel());
+    const ImpliedVolParams params{tolerance, max_iter};
+    const size_t blocks = (n + kImpliedVolBlock - 1) / kImpliedVolBlock;
+    ThreadPool::shared().parallelFor(blocks, [&](size_t b) {
+        const size_t begin = b * kImpliedVolBlock;
+        const size_t count = std::min(kImpliedVolBlock, n - begin);
+        const double* p = price + begin;
+        const double* s = S + begin;
+        const double* k = K + begin;
+        const double* t = T + begin;
+        const double* rr = r + begin;
+        const OptionType* ty = type + begin;
+        ImpliedVolResult* o = out + begin;
+#if OPTION_PRICER_SIMD
+        switch (level) {
+            case SimdLevel::AVX512: ivAvx512(p, s, k, t, rr, ty, o, count, params); return;
+            case SimdLevel::AVX2:   ivAvx2(p, s, k, t, rr, ty, o, count, params);   return;
+            case SimdLevel::SSE2:   ivSse2(p, s, k, t, rr, ty, o, count, params);   return;
+            default: break;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) {
+            o[i] = solveImpliedVol(p[i], s[i], k[i], t[i], rr[i], ty[i], tolerance, max_iter);
+        }
+    }, max_threads);
+}
+
+//----- normal CDF -----
+
+#if OPTION_PRICER_SIMD
+
+template <int W, class Cdf>
+static inline __attribute__((always_inline))
+void cdfLoop(const double* x, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        simd::store<W>(out + i, simd::normalCDF<W, Cdf>(simd::load<W>(x + i)));
+    }
+    if (i == n) return;
+
+    const size_t rem = n - i;
+    double px[W], o[W];
+    for (size_t j = 0; j < W; ++j) px[j] = x[j < rem ? i + j : i];
+    simd::store<W>(o, simd::normalCDF<W, Cdf>(simd::load<W>(px)));
+    for (size_t j = 0; j < rem; ++j) out[i + j] = o[j];
+}
+
+template <class Cdf>
+__attribute__((target("avx512f")))
+static void cdfAvx512(const double* x, double* out, size_t n) {
+    cdfLoop<8, Cdf>(x, out, n);
+}
+
+template <class Cdf>
+__attribute__((target("avx2,fma")))
+static void cdfAvx2(const double* x, double* out, size_t n) {
+    cdfLoop<4, Cdf>(x, out, n);
+}
+
+template <class Cdf>
+static void cdfSse2(const double* x, double* out, size_t n) {
+    cdfLoop<2, Cdf>(x, out, n);
+}
+
+#endif // OPTION_PRICER_SIMD
+
+template <class Cdf>
+void normalCdfBatch(const double* x, double* out, size_t n, SimdLevel level) {
+    level = std::min(level, detectSimdLevel());
+#if OPTION_PRICER_SIMD
+    switch (level) {
+        case SimdLevel::AVX512: cdfAvx512<Cdf>(x, out, n); return;
+        case SimdLevel::AVX2:   cdfAvx2<Cdf>(x, out, n);   return;
+        case SimdLevel::SSE2:   cdfSse2<Cdf>(x, out, n);   return;
+        default: break;
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) out[i] = Cdf::cdf(x[i]);
+}
+
+template void normalCdfBatch<HornerCdf>(const double*, double*, size_t, SimdLevel);
+template void normalCdfBatch<CodyCdf>(const double*, double*, size_t, SimdLevel);
+template void normalCdfBatch<ErfcCdf>(const double*, double*, size_t, SimdLevel);
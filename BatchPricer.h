@@ -0,0 +1,67 @@
+// BatchPricer.h
+#ifndef BATCH_PRICER_H
+#define BATCH_PRICER_H
+
+#include <vector>
+#include <cstddef>
+#include "OptionPricer.h"
+#include "ImpliedVol.h"
+#include "SimdLevel.h"
+
+//many contracts stored as a structure of arrays (SoA)
+//each field is contiguous in memory so one loop can stream through the whole chain
+struct OptionBatch {
+    std::vector<double> S;      //spot prices
+    std::vector<double> K;      //strike prices
+    std::vector<double> T;      //times to maturity
+    std::vector<double> r;      //risk-free rates
+    std::vector<double> sigma;  //volatilities
+    std::vector<OptionType> type;
+
+    void reserve(size_t n);
+    void add(double spot, double strike, double maturity, double rate, double vol, OptionType t);
+    size_t size() const { return S.size(); }
+};
+
+//prices and greeks for every contract in a batch, same index as the input
+struct BatchResult {
+    std::vector<double> price;
+    std::vector<double> delta;
+    std::vector<double> gamma;
+    std::vector<double> vega;
+    std::vector<double> theta;  //per day, same as calculateGreeks
+    std::vector<double> rho;    //per 1%, same as calculateGreeks
+
+    void resize(size_t n);
+    size_t size() const { return price.size(); }
+};
+
+//black-scholes prices for n contracts given as separate arrays (SoA), written to out[0..n)
+//level caps the instruction set, it is clamped to what the CPU supports
+void blackScholesBatch(const double* S, const double* K, const double* T, const double* r,
+                       const double* sigma, const OptionType* type, double* out, size_t n,
+                       SimdLevel level = SimdLevel::AVX512);
+
+//black-scholes prices + greeks for the whole batch in a single pass over the arrays
+//matches OptionPricer::blackScholes / calculateGreeks contract by contract
+void priceBatch(const OptionBatch& batch, BatchResult& out, SimdLevel level = SimdLevel::AVX512);
+
+//same on separate arrays (SoA), for callers that substitute some of the fields (YieldCurve.h)
+void priceBatch(const double* S, const double* K, const double* T, const double* r, const double* sigma,
+                const OptionType* type, BatchResult& out, size_t n, SimdLevel level = SimdLevel::AVX512);
+
+//implied volatilities for n quotes, out[i] is what solveImpliedVol(price[i], S[i], ...) returns
+//(up to the SIMD exp/log rounding): W quotes run the same safeguarded Halley iterations side by side
+//in vector registers, and blocks of quotes are spread over at most max_threads threads of the
+//shared pool (0 = all of them)
+void impliedVolBatch(const double* price, const double* S, const double* K, const double* T, const double* r,
+                     const OptionType* type, ImpliedVolResult* out, size_t n,
+                     double tolerance = 1e-10, int max_iter = 50, SimdLevel level = SimdLevel::AVX512,
+                     unsigned max_threads = 0);
+
+//out[i] = N(x[i]) for n points with the vector form of a NormalCdf.h policy, out[i] matches
+//Cdf::cdf(x[i]) up to the SIMD exp rounding. Instantiated for HornerCdf, CodyCdf and ErfcCdf
+template <class Cdf = NormalCdf>
+void normalCdfBatch(const double* x, double* out, size_t n, SimdLevel level = SimdLevel::AVX512);
+
+#endif // BATCH_PRICER_H
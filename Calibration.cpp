@@ -0,0 +1,494 @@
+// Calibration.cpp
+#include "Calibration.h"
+#include "ImpliedVol.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+const char* calibrationStopName(CalibrationStop stop) {
+    switch (stop) {
+        case CalibrationStop::TOLERANCE:  return "tolerance";
+        case CalibrationStop::SMALL_STEP: return "small_step";
+        case CalibrationStop::TIME_BUDGET: return "time_budget";
+        default:                          return "max_iterations";
+    }
+}
+
+//----- Levenberg-Marquardt -----
+
+constexpr int kMaxLmParams = 5;
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+//when a fit that began at start must stop, never without a time budget
+static Deadline deadlineFor(Deadline start, const CalibrationOptions& options) {
+    if (!(options.timeBudgetMs > 0.0)) return Deadline::max();
+    return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double, std::milli>(options.timeBudgetMs));
+}
+
+//J^T J and J^T r of an m x n row-major jacobian
+static void normalEquations(const std::vector<double>& J, const std::vector<double>& r, int n,
+                            std::array<double, kMaxLmParams * kMaxLmParams>& A, std::array<double, kMaxLmParams>& g) {
+    A.fill(0.0);
+    g.fill(0.0);
+    for (size_t row = 0; row < r.size(); ++row) {
+        const double* Ji = J.data() + row * n;
+        for (int a = 0; a < n; ++a) {
+            g[a] += Ji[a] * r[row];
+            for (int b = 0; b <= a; ++b) A[a * n + b] += Ji[a] * Ji[b];
+        }
+    }
+    for (int a = 0; a < n; ++a) {
+        for (int b = a + 1; b < n; ++b) A[a * n + b] = A[b * n + a];
+    }
+}
+
+//solves M h = rhs for symmetric positive definite M by Cholesky, false if M is not
+static bool choleskySolve(std::array<double, kMaxLmParams * kMaxLmParams> M, const std::array<double, kMaxLmParams>& rhs,
+                          int n, std::array<double, kMaxLmParams>& h) {
+    for (int j = 0; j < n; ++j) {
+        double diag = M[j * n + j];
+        for (int k = 0; k < j; ++k) diag -= M[j * n + k] * M[j * n + k];
+        if (!(diag > 0.0)) return false;
+        M[j * n + j] = std::sqrt(diag);
+        for (int i = j + 1; i < n; ++i) {
+            double v = M[i * n + j];
+            for (int k = 0; k < j; ++k) v -= M[i * n + k] * M[j * n + k];
+            M[i * n + j] = v / M[j * n + j];
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        double v = rhs[i];
+        for (int k = 0; k < i; ++k) v -= M[i * n + k] * h[k];
+        h[i] = v / M[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double v = h[i];
+        for (int k = i + 1; k < n; ++k) v -= M[k * n + i] * h[k];
+        h[i] = v / M[i * n + i];
+    }
+    return true;
+}
+
+//minimizes half the squared residuals over the box [lower, upper], starting from x (n <= kMaxLmParams).
+//evaluate(x, r, J) fills the m residuals and the m x n jacobian. Marquardt's diagonal scaling, Nielsen's
+//damping update, steps projected onto the box. Past the deadline x is left at the last accepted point
+template <class Evaluate>
+static CalibrationStop levenbergMarquardt(double* x, const double* lower, const double* upper, int n, size_t m,
+                                          const Evaluate& evaluate, const CalibrationOptions& options,
+                                          Deadline deadline, CalibrationReport& report) {
+    std::vector<double> r(m), J(m * n), r_try(m), J_try(m * n);
+    auto cost = [](const std::vector<double>& res) {
+        double s = 0.0;
+        for (double v : res) s += v * v;
+        return 0.5 * s;
+    };
+    evaluate(x, r, J);
+    ++report.evaluations;
+    double f = cost(r);
+    std::array<double, kMaxLmParams * kMaxLmParams> A;
+    std::array<double, kMaxLmParams> g;
+    normalEquations(J, r, n, A, g);
+
+    double mu = 0.0;
+    for (int a = 0; a < n; ++a) mu = std::max(mu, A[a * n + a]);
+    mu *= 1e-3;
+    double growth = 2.0;
+
+    while (report.iterations < options.maxIterations) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return CalibrationStop::TIME_BUDGET;
+        }
+        ++report.iterations;
+        std::array<double, kMaxLmParams * kMaxLmParams> M = A;
+        std::array<double, kMaxLmParams> rhs, h;
+        for (int a = 0; a < n; ++a) {
+            M[a * n + a] += mu * std::max(A[a * n + a], 1e-12);
+            rhs[a] = -g[a];
+        }
+        if (!choleskySolve(M, rhs, n, h)) {
+            mu *= growth;
+            growth *= 2.0;
+            continue;
+        }
+        std::array<double, kMaxLmParams> x_try;
+        double step = 0.0, size = 0.0;
+        for (int a = 0; a < n; ++a) {
+            x_try[a] = std::clamp(x[a] + h[a], lower[a], upper[a]);
+            h[a] = x_try[a] - x[a];
+            step += h[a] * h[a];
+            size += x[a] * x[a];
+        }
+        if (std::sqrt(step) <= 1e-12 * (std::sqrt(size) + 1e-12)) {
+            return CalibrationStop::SMALL_STEP;
+        }
+
+        evaluate(x_try.data(), r_try, J_try);
+        ++report.evaluations;
+        const double f_try = cost(r_try);
+        //decrease the quadratic model predicted for the (projected) step
+        double predicted = 0.0;
+        for (int a = 0; a < n; ++a) {
+            double Ah = 0.0;
+            for (int b = 0; b < n; ++b) Ah += A[a * n + b] * h[b];
+            predicted -= g[a] * h[a] + 0.5 * h[a] * Ah;
+        }
+        if (f_try < f && predicted > 0.0) {
+            const double gain = (f - f_try) / predicted;
+            const double improvement = f - f_try;
+            std::copy(x_try.begin(), x_try.begin() + n, x);
+            r.swap(r_try);
+            J.swap(J_try);
+            normalEquations(J, r, n, A, g);
+            mu *= std::max(1.0 / 3.0, 1.0 - std::pow(2.0 * gain - 1.0, 3.0));
+            growth = 2.0;
+            if (improvement <= options.tolerance * f) {
+                return CalibrationStop::TOLERANCE;
+            }
+            f = f_try;
+        } else {
+            mu *= growth;
+            growth *= 2.0;
+        }
+    }
+    return CalibrationStop::MAX_ITERATIONS;
+}
+
+static void checkQuotes(double S, const std::vector<VolQuote>& quotes) {
+    if (!(S > 0.0)) {
+        throw std::invalid_argument("spot must be positive");
+    }
+    for (const VolQuote& q : quotes) {
+        if (!(q.strike > 0.0) || !(q.expiry > 0.0) || !(q.vol > 0.0) || !(q.weight >= 0.0)) {
+            throw std::invalid_argument("quotes need positive strike, expiry and vol and a non-negative weight");
+        }
+    }
+}
+
+//quote indices grouped by expiry, expiries increasing
+static std::vector<std::pair<double, std::vector<size_t>>> groupByExpiry(const std::vector<VolQuote>& quotes) {
+    std::map<double, std::vector<size_t>> groups;
+    for (size_t i = 0; i < quotes.size(); ++i) groups[quotes[i].expiry].push_back(i);
+    return {groups.begin(), groups.end()};
+}
+
+static void summarizeErrors(CalibrationReport& report) {
+    double sum = 0.0;
+    size_t count = 0;
+    report.maxError = 0.0;
+    for (double e : report.volErrors) {
+        if (std::isnan(e)) continue;
+        sum += e * e;
+        ++count;
+        report.maxError = std::max(report.maxError, std::abs(e));
+    }
+    report.rmsError = count ? std::sqrt(sum / count) : 0.0;
+}
+
+//iterations and evaluations of independent per-expiry fits summed, the slowest expiry decides how the
+//whole fit stopped
+static void mergeSliceReports(const std::vector<CalibrationReport>& reports, CalibrationReport& out) {
+    out.stop = CalibrationStop::TOLERANCE;
+    for (const CalibrationReport& report : reports) {
+        out.iterations += report.iterations;
+        out.evaluations += report.evaluations;
+        if (report.stop == CalibrationStop::TIME_BUDGET) {
+            out.stop = CalibrationStop::TIME_BUDGET;
+        } else if (report.stop == CalibrationStop::MAX_ITERATIONS && out.stop != CalibrationStop::TIME_BUDGET) {
+            out.stop = CalibrationStop::MAX_ITERATIONS;
+        } else if (report.stop == CalibrationStop::SMALL_STEP && out.stop == CalibrationStop::TOLERANCE) {
+            out.stop = CalibrationStop::SMALL_STEP;
+        }
+    }
+}
+
+//----- Heston -----
+
+//box the fit stays in, in HestonParams order
+constexpr std::array<double, kHestonParamCount> kHestonLower = {1e-5, 1e-3, 1e-5, 1e-3, -0.999};
+constexpr std::array<double, kHestonParamCount> kHestonUpper = {4.0, 20.0, 4.0, 5.0, 0.999};
+
+HestonParams hestonInitialGuess(const std::vector<VolQuote>& quotes) {
+    double sum = 0.0;
+    for (const VolQuote& q : quotes) sum += q.vol;
+    const double vol = quotes.empty() ? 0.2 : sum / quotes.size();
+    return {vol * vol, 2.0, vol * vol, 0.5, -0.5};
+}
+
+HestonCalibration calibrateHeston(double S, double r, const std::vector<VolQuote>& quotes,
+                                  const HestonParams& initial, const CalibrationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const Deadline deadline = deadlineFor(start, options);
+    checkQuotes(S, quotes);
+    if (quotes.size() < static_cast<size_t>(kHestonParamCount)) {
+        throw std::invalid_argument("heston calibration needs at least five quotes");
+    }
+    validateHeston(initial);
+
+    //market prices (calls: parity makes the residuals the same for puts) and their vegas, once
+    const auto groups = groupByExpiry(quotes);
+    std::vector<std::vector<double>> strikes(groups.size());
+    std::vector<double> market(quotes.size()), scale(quotes.size());
+    for (size_t e = 0; e < groups.size(); ++e) {
+        const double T = groups[e].first;
+        for (size_t i : groups[e].second) {
+            const VolQuote& q = quotes[i];
+            strikes[e].push_back(q.strike);
+            const PriceGreeks bs = OptionPricer::priceWithGreeks(S, q.strike, T, r, q.vol, OptionType::CALL);
+            market[i] = bs.price;
+            //vega per unit vol (Greeks::vega is per 1%), floored so quotes far in the wings cannot dominate
+            scale[i] = q.weight / std::max(100.0 * bs.greeks.vega, 1e-4 * S * std::sqrt(T));
+        }
+    }
+
+    auto evaluate = [&](const double* x, std::vector<double>& res, std::vector<double>& J) {
+        const HestonParams p{x[0], x[1], x[2], x[3], x[4]};
+        ThreadPool::shared().parallelFor(groups.size(), [&](size_t e) {
+            const HestonCos cos(S, groups[e].first, r, p, options.cosTerms, kHestonCosTruncation, true);
+            std::vector<double> prices, gradient;
+            cos.pricesAndGradients(strikes[e], OptionType::CALL, prices, gradient);
+            for (size_t j = 0; j < prices.size(); ++j) {
+                const size_t i = groups[e].second[j];
+                res[i] = scale[i] * (prices[j] - market[i]);
+                for (int a = 0; a < kHestonParamCount; ++a) {
+                    J[i * kHestonParamCount + a] = scale[i] * gradient[j * kHestonParamCount + a];
+                }
+            }
+        }, options.maxThreads);
+    };
+
+    HestonCalibration out;
+    double x[kHestonParamCount] = {initial.v0, initial.kappa, initial.theta, initial.xi, initial.rho};
+    for (int a = 0; a < kHestonParamCount; ++a) x[a] = std::clamp(x[a], kHestonLower[a], kHestonUpper[a]);
+    out.report.stop = levenbergMarquardt(x, kHestonLower.data(), kHestonUpper.data(), kHestonParamCount,
+                                         quotes.size(), evaluate, options, deadline, out.report);
+    out.params = {x[0], x[1], x[2], x[3], x[4]};
+
+    //exact implied vol errors of the fitted model, one pricing pass per expiry
+    out.report.volErrors.resize(quotes.size());
+    for (size_t e = 0; e < groups.size(); ++e) {
+        const double T = groups[e].first;
+        const std::vector<double> prices = HestonCos(S, T, r, out.params, options.cosTerms).prices(strikes[e], OptionType::CALL);
+        for (size_t j = 0; j < prices.size(); ++j) {
+            const size_t i = groups[e].second[j];
+            out.report.volErrors[i] = solveImpliedVol(prices[j], S, quotes[i].strike, T, r, OptionType::CALL).vol - quotes[i].vol;
+        }
+    }
+    summarizeErrors(out.report);
+    out.report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return out;
+}
+
+//----- SABR -----
+
+//alpha, rho, nu
+constexpr int kSabrFitted = 3;
+constexpr std::array<double, kSabrFitted> kSabrLower = {1e-8, -0.999, 1e-4};
+constexpr std::array<double, kSabrFitted> kSabrUpper = {1e4, 0.999, 10.0};
+
+SabrCalibration calibrateSabr(double S, double r, const std::vector<VolQuote>& quotes, double beta,
+                              const std::vector<SabrSlice>& initial, const CalibrationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const Deadline deadline = deadlineFor(start, options);
+    checkQuotes(S, quotes);
+    if (!(beta >= 0.0 && beta <= 1.0)) {
+        throw std::invalid_argument("beta must be between 0 and 1");
+    }
+    const auto groups = groupByExpiry(quotes);
+    for (const auto& group : groups) {
+        if (group.second.size() < static_cast<size_t>(kSabrFitted)) {
+            throw std::invalid_argument("sabr calibration needs at least three quotes per expiry");
+        }
+    }
+
+    SabrCalibration out;
+    out.slices.resize(groups.size());
+    out.report.volErrors.resize(quotes.size());
+    std::vector<CalibrationReport> reports(groups.size());
+    ThreadPool::shared().parallelFor(groups.size(), [&](size_t e) {
+        const double T = groups[e].first;
+        const std::vector<size_t>& members = groups[e].second;
+        const double F = S * std::exp(r * T);
+
+        //warm start from the nearest previous expiry, else alpha from the vol closest to the money
+        double x[kSabrFitted];
+        if (!initial.empty()) {
+            const SabrSlice* nearest = &initial[0];
+            for (const SabrSlice& slice : initial) {
+                if (std::abs(slice.expiry - T) < std::abs(nearest->expiry - T)) nearest = &slice;
+            }
+            x[0] = nearest->params.alpha;
+            x[1] = nearest->params.rho;
+            x[2] = nearest->params.nu;
+        } else {
+            size_t atm = members[0];
+            for (size_t i : members) {
+                if (std::abs(std::log(quotes[i].strike / F)) < std::abs(std::log(quotes[atm].strike / F))) atm = i;
+            }
+            x[0] = quotes[atm].vol * std::pow(F, 1.0 - beta);
+            x[1] = 0.0;
+            x[2] = 0.5;
+        }
+        for (int a = 0; a < kSabrFitted; ++a) x[a] = std::clamp(x[a], kSabrLower[a], kSabrUpper[a]);
+
+        using J3 = Jet<double, kSabrFitted>;
+        auto evaluate = [&](const double* p, std::vector<double>& res, std::vector<double>& J) {
+            const J3 alpha = J3::variable(p[0], 0), rho = J3::variable(p[1], 1), nu = J3::variable(p[2], 2);
+            for (size_t j = 0; j < members.size(); ++j) {
+                const VolQuote& q = quotes[members[j]];
+                const J3 vol = haganLognormalVol(F, q.strike, T, alpha, beta, rho, nu);
+                res[j] = q.weight * (vol.v - q.vol);
+                for (int a = 0; a < kSabrFitted; ++a) J[j * kSabrFitted + a] = q.weight * vol.d[a];
+            }
+        };
+        reports[e].stop = levenbergMarquardt(x, kSabrLower.data(), kSabrUpper.data(), kSabrFitted, members.size(),
+                                             evaluate, options, deadline, reports[e]);
+        out.slices[e] = {T, {x[0], beta, x[1], x[2]}};
+        for (size_t i : members) {
+            out.report.volErrors[i] = haganLognormalVol(F, quotes[i].strike, T, x[0], beta, x[1], x[2]) - quotes[i].vol;
+        }
+    }, options.maxThreads);
+
+    mergeSliceReports(reports, out.report);
+    summarizeErrors(out.report);
+    out.report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return out;
+}
+
+//----- SVI -----
+
+//minimum variance, b (1 + |rho|), rho, m, sigma
+constexpr int kSviFitted = 5;
+constexpr std::array<double, kSviFitted> kSviLower = {1e-8, 1e-6, -0.999, -5.0, 1e-4};
+constexpr std::array<double, kSviFitted> kSviUpper = {4.0, 2.0, 0.999, 5.0, 5.0};
+
+SviCalibration calibrateSvi(double S, double r, const std::vector<VolQuote>& quotes, const CalibrationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const Deadline deadline = deadlineFor(start, options);
+    checkQuotes(S, quotes);
+    const auto groups = groupByExpiry(quotes);
+    for (const auto& group : groups) {
+        if (group.second.size() < static_cast<size_t>(kSviFitted)) {
+            throw std::invalid_argument("svi calibration needs at least five quotes per expiry");
+        }
+    }
+
+    SviCalibration out;
+    out.slices.resize(groups.size());
+    out.report.volErrors.resize(quotes.size());
+    std::vector<CalibrationReport> reports(groups.size());
+    ThreadPool::shared().parallelFor(groups.size(), [&](size_t e) {
+        const double T = groups[e].first;
+        const std::vector<size_t>& members = groups[e].second;
+        const double lf = std::log(S) + r * T;
+        std::vector<double> k(members.size());
+        for (size_t j = 0; j < members.size(); ++j) k[j] = std::log(quotes[members[j]].strike) - lf;
+
+        //start from a symmetric smile whose minimum is the lowest quoted variance
+        size_t low = 0;
+        for (size_t j = 1; j < members.size(); ++j) {
+            if (quotes[members[j]].vol < quotes[members[low]].vol) low = j;
+        }
+        const double vmin = quotes[members[low]].vol * quotes[members[low]].vol * T;
+        double x[kSviFitted] = {vmin, 0.1, 0.0, k[low], 0.1};
+        for (int a = 0; a < kSviFitted; ++a) x[a] = std::clamp(x[a], kSviLower[a], kSviUpper[a]);
+
+        using J5 = Jet<double, kSviFitted>;
+        auto evaluate = [&](const double* p, std::vector<double>& res, std::vector<double>& J) {
+            const J5 minimum = J5::variable(p[0], 0), slope = J5::variable(p[1], 1), rho = J5::variable(p[2], 2);
+            const J5 m = J5::variable(p[3], 3), sigma = J5::variable(p[4], 4);
+            const J5 b = slope / (1.0 + (p[2] < 0.0 ? -rho : rho));
+            const J5 a = minimum - b * sigma * sqrt(1.0 - rho * rho);
+            for (size_t j = 0; j < members.size(); ++j) {
+                const VolQuote& q = quotes[members[j]];
+                const J5 vol = sqrt(sviTotalVariance(k[j], a, b, rho, m, sigma) / T);
+                res[j] = q.weight * (vol.v - q.vol);
+                for (int i = 0; i < kSviFitted; ++i) J[j * kSviFitted + i] = q.weight * vol.d[i];
+            }
+        };
+        reports[e].stop = levenbergMarquardt(x, kSviLower.data(), kSviUpper.data(), kSviFitted, members.size(),
+                                             evaluate, options, deadline, reports[e]);
+        const double b = x[1] / (1.0 + std::abs(x[2]));
+        const SviParams params{x[0] - b * x[4] * std::sqrt(1.0 - x[2] * x[2]), b, x[2], x[3], x[4]};
+        out.slices[e] = {T, params};
+        for (size_t j = 0; j < members.size(); ++j) {
+            out.report.volErrors[members[j]] = std::sqrt(sviTotalVariance(k[j], params) / T) - quotes[members[j]].vol;
+        }
+    }, options.maxThreads);
+
+    mergeSliceReports(reports, out.report);
+    summarizeErrors(out.report);
+    out.report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return out;
+}
+
+//----- SSVI -----
+
+//rho, eta (1 + |rho|), gamma
+constexpr int kSsviFitted = 3;
+constexpr std::array<double, kSsviFitted> kSsviLower = {-0.999, 1e-4, 1e-3};
+constexpr std::array<double, kSsviFitted> kSsviUpper = {0.999, 2.0, 0.5};
+
+SsviCalibration calibrateSsvi(double S, double r, const std::vector<VolQuote>& quotes, const CalibrationOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    const Deadline deadline = deadlineFor(start, options);
+    checkQuotes(S, quotes);
+    if (quotes.size() < static_cast<size_t>(kSsviFitted)) {
+        throw std::invalid_argument("ssvi calibration needs at least three quotes");
+    }
+    const auto groups = groupByExpiry(quotes);
+
+    //log-moneyness of every quote and the at-the-money total variance of every expiry
+    SsviCalibration out;
+    std::vector<double> k(quotes.size()), theta_of(quotes.size());
+    for (const auto& [T, members] : groups) {
+        const double lf = std::log(S) + r * T;
+        const double inf = std::numeric_limits<double>::infinity();
+        double below_k = -inf, below_w = 0.0, above_k = inf, above_w = 0.0;
+        for (size_t i : members) {
+            k[i] = std::log(quotes[i].strike) - lf;
+            const double w = quotes[i].vol * quotes[i].vol * T;
+            if (k[i] <= 0.0 && k[i] > below_k) { below_k = k[i]; below_w = w; }
+            if (k[i] >= 0.0 && k[i] < above_k) { above_k = k[i]; above_w = w; }
+        }
+        double theta;
+        if (std::isinf(below_k)) theta = above_w;
+        else if (std::isinf(above_k) || above_k == below_k) theta = below_w;
+        else theta = below_w + (above_w - below_w) * (-below_k) / (above_k - below_k);
+        if (!out.thetas.empty()) theta = std::max(theta, out.thetas.back());
+        out.expiries.push_back(T);
+        out.thetas.push_back(theta);
+        for (size_t i : members) theta_of[i] = theta;
+    }
+
+    using J3 = Jet<double, kSsviFitted>;
+    auto evaluate = [&](const double* p, std::vector<double>& res, std::vector<double>& J) {
+        const J3 rho = J3::variable(p[0], 0), bound = J3::variable(p[1], 1), gamma = J3::variable(p[2], 2);
+        const J3 eta = bound / (1.0 + (p[0] < 0.0 ? -rho : rho));
+        for (size_t i = 0; i < quotes.size(); ++i) {
+            const VolQuote& q = quotes[i];
+            const J3 vol = sqrt(ssviTotalVariance(k[i], theta_of[i], rho, eta, gamma) / q.expiry);
+            res[i] = q.weight * (vol.v - q.vol);
+            for (int a = 0; a < kSsviFitted; ++a) J[i * kSsviFitted + a] = q.weight * vol.d[a];
+        }
+    };
+    double x[kSsviFitted] = {-0.5, 1.0, 0.4};
+    out.report.stop = levenbergMarquardt(x, kSsviLower.data(), kSsviUpper.data(), kSsviFitted, quotes.size(),
+                                         evaluate, options, deadline, out.report);
+    out.params = {x[0], x[1] / (1.0 + std::abs(x[0])), x[2]};
+
+    out.report.volErrors.resize(quotes.size());
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        out.report.volErrors[i] = std::sqrt(ssviTotalVariance(k[i], theta_of[i], out.params) / quotes[i].expiry)
+                                  - quotes[i].vol;
+    }
+    summarizeErrors(out.report);
+    out.report.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return out;
+}
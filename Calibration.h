@@ -0,0 +1,111 @@
+// Calibration.h
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <vector>
+#include "Heston.h"
+#include "Sabr.h"
+#include "Svi.h"
+
+//fitting stochastic-volatility models to a snapshot of implied vol quotes by Levenberg-Marquardt.
+//Every iteration evaluates the residuals and their exact jacobian for the whole quote set in one pass
+//(forward-mode AD through the model formulas, AutoDiff.h), expiries in parallel on the shared thread
+//pool, instead of re-pricing every quote once per bumped parameter. Passing the previous snapshot's
+//parameters as the starting point usually leaves only a few iterations to do
+
+struct VolQuote {
+    double strike;
+    double expiry;
+    double vol;           //market implied vol
+    double weight = 1.0;  //multiplies the quote's residual
+};
+
+struct CalibrationOptions {
+    unsigned maxIterations = 100;
+    double tolerance = 1e-10;  //stop once an accepted step lowers the cost by less than this fraction
+    unsigned maxThreads = 0;   //as in monteCarloParallel, 0 = whole pool
+    unsigned cosTerms = kHestonCosTerms;
+    double timeBudgetMs = 0.0;  //> 0: stop at the best point so far once the fit has run this long
+};
+
+enum class CalibrationStop {
+    TOLERANCE,      //the cost stopped improving
+    SMALL_STEP,     //the step shrank to nothing (at a bound, or a flat direction)
+    MAX_ITERATIONS,
+    TIME_BUDGET
+};
+
+const char* calibrationStopName(CalibrationStop stop);
+
+struct CalibrationReport {
+    unsigned iterations = 0;   //Levenberg-Marquardt steps tried, accepted or not
+    unsigned evaluations = 0;  //residual + jacobian passes over the quote set
+    //model minus market implied vol per quote (input order, NaN where the model price has no
+    //implied vol), and their root mean square and largest magnitude
+    std::vector<double> volErrors;
+    double rmsError = 0.0;
+    double maxError = 0.0;
+    CalibrationStop stop = CalibrationStop::MAX_ITERATIONS;
+    double elapsedMs = 0.0;
+};
+
+//----- Heston -----
+
+//one parameter set for the whole surface. Residuals are price differences over black-scholes vega,
+//first-order vol differences that need no implied vol solve inside the loop.
+//Throws std::invalid_argument for fewer than kHestonParamCount quotes or non-positive inputs
+struct HestonCalibration {
+    HestonParams params;
+    CalibrationReport report;
+};
+
+HestonCalibration calibrateHeston(double S, double r, const std::vector<VolQuote>& quotes,
+                                  const HestonParams& initial, const CalibrationOptions& options = {});
+
+//a cold start for calibrateHeston: flat variance at the quotes' mean vol, moderate skew
+HestonParams hestonInitialGuess(const std::vector<VolQuote>& quotes);
+
+//----- SABR -----
+
+//one (alpha, rho, nu) per expiry at a fixed beta, residuals straight in vol (Hagan's formula is a vol).
+//Expiries are independent fits and run in parallel. Each expiry starts from the initial slice with the
+//nearest expiry, or from the at-the-money vol when initial is empty.
+//Throws std::invalid_argument for fewer than three quotes in an expiry or non-positive inputs
+struct SabrCalibration {
+    std::vector<SabrSlice> slices;  //by increasing expiry
+    CalibrationReport report;       //iterations and evaluations summed over the expiries
+};
+
+SabrCalibration calibrateSabr(double S, double r, const std::vector<VolQuote>& quotes, double beta,
+                              const std::vector<SabrSlice>& initial = {}, const CalibrationOptions& options = {});
+
+//----- SVI -----
+
+//raw SVI per expiry, residuals in vol, expiries in parallel. The fit runs on the smile's minimum
+//a + b sigma sqrt(1 - rho^2) in place of a, boxed to >= 0, and on the wing slope b (1 + |rho|) in place of
+//b, boxed to <= 2 like eta (1 + |rho|) in the SSVI fit: every slice returned passes validateSvi. Slices are
+//not checked for butterfly arbitrage, nor pairs of slices for calendar arbitrage.
+//Throws std::invalid_argument for fewer than five quotes in an expiry or non-positive inputs
+struct SviCalibration {
+    std::vector<SviSlice> slices;  //by increasing expiry
+    CalibrationReport report;      //iterations and evaluations summed over the expiries
+};
+
+SviCalibration calibrateSvi(double S, double r, const std::vector<VolQuote>& quotes,
+                            const CalibrationOptions& options = {});
+
+//SSVI over the whole surface: theta_t is read off each expiry's quotes at the money (total variance
+//interpolated linearly in log-moneyness to k = 0, then made nondecreasing across expiries) and
+//(rho, eta, gamma) are fitted to every quote at once, eta through eta (1 + |rho|) boxed to <= 2, so the
+//result is free of static arbitrage. Throws std::invalid_argument for fewer than three quotes or
+//non-positive inputs
+struct SsviCalibration {
+    SsviParams params;
+    std::vector<double> expiries, thetas;  //knots for SsviSurface
+    CalibrationReport report;
+};
+
+SsviCalibration calibrateSsvi(double S, double r, const std::vector<VolQuote>& quotes,
+                              const CalibrationOptions& options = {});
+
+#endif // CALIBRATION_H
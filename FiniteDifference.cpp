@@ -0,0 +1,338 @@
+#include "FiniteDifference.h"
+#include "SimdLevel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+//projected SOR: over-relaxation and the stopping change per sweep, relative to the strike
+constexpr double kPsorOmega = 1.5;
+constexpr double kPsorTolerance = 1e-10;
+constexpr unsigned kPsorMaxSweeps = 10000;
+
+//----- tridiagonal systems -----
+
+//LU factors of the constant n x n matrix tridiag(sub, diag, sup): the Thomas forward sweep's pivots
+//depend only on the matrix, so they are computed once per step size instead of once per step
+//built with sub and sup swapped for a reversed sweep (last row eliminated first)
+//the sweeps only carry one multiply and one subtract per row on their dependency chain, the
+//forward sweep's d_i / pivot_i is off the chain
+struct Factorization {
+    std::vector<double> cp;   //super-diagonal over the pivot
+    std::vector<double> lp;   //sub-diagonal over the pivot
+    std::vector<double> inv;  //1 / pivot
+};
+
+static Factorization factor(size_t n, double sub, double diag, double sup) {
+    Factorization f{std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+    double pivot = diag;
+    for (size_t i = 0; i < n; ++i) {
+        if (i > 0) pivot = diag - sub * f.cp[i - 1];
+        f.inv[i] = 1.0 / pivot;
+        f.cp[i] = sup * f.inv[i];
+        f.lp[i] = sub * f.inv[i];
+    }
+    return f;
+}
+
+//solves into x, d is overwritten. Reverse eliminates from the top row down and back substitutes
+//from the bottom up. Project is Brennan-Schwartz: the exercise value floors each unknown as it is
+//substituted, which is exact when the elimination starts on the continuation side, so it never mixes
+//in the rows of the exercise region (a put eliminates from high spots down, a call from low spots up)
+template <bool Reverse, bool Project>
+static OPTION_PRICER_ALWAYS_INLINE
+void thomas(const Factorization& f, double* d, double* x, const double* floor, size_t n) {
+    auto at = [n](size_t i) { return Reverse ? n - 1 - i : i; };
+    d[at(0)] *= f.inv[0];
+    for (size_t i = 1; i < n; ++i) {
+        d[at(i)] = d[at(i)] * f.inv[i] - f.lp[i] * d[at(i - 1)];
+    }
+    double last = d[at(n - 1)];
+    if constexpr (Project) last = std::max(last, floor[at(n - 1)]);
+    x[at(n - 1)] = last;
+    for (size_t i = n - 1; i-- > 0;) {
+        double v = d[at(i)] - f.cp[i] * x[at(i + 1)];
+        if constexpr (Project) v = std::max(v, floor[at(i)]);
+        x[at(i)] = v;
+    }
+}
+
+//both sweeps are one long dependency chain, nothing to vectorize; the fused multiply-add build
+//shortens the chain on every row where the CPU has it
+using ThomasKernel = void (*)(const Factorization& f, double* d, double* x, const double* floor, size_t n);
+
+#if OPTION_PRICER_SIMD
+
+template <bool Reverse, bool Project>
+__attribute__((target("avx2,fma")))
+static void thomasFma(const Factorization& f, double* d, double* x, const double* floor, size_t n) {
+    thomas<Reverse, Project>(f, d, x, floor, n);
+}
+
+#endif // OPTION_PRICER_SIMD
+
+template <bool Reverse, bool Project>
+static void thomasPortable(const Factorization& f, double* d, double* x, const double* floor, size_t n) {
+    thomas<Reverse, Project>(f, d, x, floor, n);
+}
+
+template <bool Reverse, bool Project>
+static ThomasKernel thomasKernelFor(SimdLevel level) {
+#if OPTION_PRICER_SIMD
+    if (level == SimdLevel::AVX2 || level == SimdLevel::AVX512) return thomasFma<Reverse, Project>;
+#endif
+    (void)level;
+    return thomasPortable<Reverse, Project>;
+}
+
+//projected SOR on tridiag(sub, diag, sup) x = d with x >= floor, x holds the starting guess
+static unsigned psor(double sub, double diag, double sup, const double* d, double* x, const double* floor,
+                     size_t n, double tolerance) {
+    const double inv_diag = 1.0 / diag;
+    for (unsigned sweep = 1; sweep <= kPsorMaxSweeps; ++sweep) {
+        double change = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            const double below = i > 0 ? x[i - 1] : 0.0, above = i + 1 < n ? x[i + 1] : 0.0;
+            const double gauss_seidel = (d[i] - sub * below - sup * above) * inv_diag;
+            const double v = std::max(floor[i], x[i] + kPsorOmega * (gauss_seidel - x[i]));
+            change = std::max(change, std::abs(v - x[i]));
+            x[i] = v;
+        }
+        if (change < tolerance) return sweep;
+    }
+    return kPsorMaxSweeps;
+}
+
+//----- the grid solve -----
+
+//one theta-scheme step size: (I - theta h L) V_new = (I + (1 - theta) h L) V_old,
+//L V_i = lo V_i-1 + mid V_i + up V_i+1 the discretized black-scholes operator
+struct StepScheme {
+    double h;
+    double imp_lo, imp_diag, imp_up;  //left-hand side
+    double exp_lo, exp_mid, exp_up;   //right-hand side
+    Factorization lu;
+};
+
+static StepScheme makeScheme(double h, double theta, double lo, double mid, double up, size_t n, bool reverse) {
+    StepScheme s;
+    s.h = h;
+    s.imp_lo = -theta * h * lo;
+    s.imp_diag = 1.0 - theta * h * mid;
+    s.imp_up = -theta * h * up;
+    s.exp_lo = (1.0 - theta) * h * lo;
+    s.exp_mid = 1.0 + (1.0 - theta) * h * mid;
+    s.exp_up = (1.0 - theta) * h * up;
+    s.lu = reverse ? factor(n, s.imp_up, s.imp_diag, s.imp_lo) : factor(n, s.imp_lo, s.imp_diag, s.imp_up);
+    return s;
+}
+
+//knock_low/knock_high: that grid edge is a knock-out barrier (value 0), otherwise the far-field
+//value of the vanilla contract
+static PdeGrid solveGrid(double x_min, double x_max, double K, double T, double r, double sigma, OptionType type,
+                         const PdeOptions& options, bool knock_low, bool knock_high) {
+    const size_t M = options.spotNodes, n = M - 2;  //n interior unknowns
+    const double dx = (x_max - x_min) / (M - 1);
+    const double dt = T / options.timeSteps;
+    const bool call = type == OptionType::CALL;
+    const bool american = options.exercise == ExerciseStyle::AMERICAN;
+    const bool use_psor = american && options.earlyExercise == EarlyExercise::PSOR;
+
+    std::vector<double> S(M), exercise(M), V(M), d(n);
+    for (size_t i = 0; i < M; ++i) {
+        S[i] = std::exp(x_min + i * dx);
+        exercise[i] = std::max(call ? S[i] - K : K - S[i], 0.0);
+        V[i] = exercise[i];
+    }
+    if (knock_low) V[0] = 0.0;
+    if (knock_high) V[M - 1] = 0.0;
+
+    //far-field values at time to expiry tau
+    auto lowEdge = [&](double tau) {
+        if (knock_low || call) return 0.0;
+        return american ? K - S[0] : K * std::exp(-r * tau) - S[0];
+    };
+    auto highEdge = [&](double tau) {
+        if (knock_high || !call) return 0.0;
+        return S[M - 1] - K * std::exp(-r * tau);
+    };
+
+    const double a = 0.5 * sigma * sigma / (dx * dx), b = (r - 0.5 * sigma * sigma) / (2.0 * dx);
+    const double lo = a - b, mid = -2.0 * a - r, up = a + b;
+    const StepScheme implicit_half = makeScheme(0.5 * dt, 1.0, lo, mid, up, n, !call);
+    const StepScheme crank_nicolson = makeScheme(dt, 0.5, lo, mid, up, n, !call);
+
+    const SimdLevel level = detectSimdLevel();
+    const ThomasKernel solve = !american ? (call ? thomasKernelFor<false, false>(level) : thomasKernelFor<true, false>(level))
+                                         : (call ? thomasKernelFor<false, true>(level) : thomasKernelFor<true, true>(level));
+    unsigned psor_iterations = 0;
+    const double psor_tolerance = kPsorTolerance * K;
+    double tau = 0.0;
+    auto step = [&](const StepScheme& s) {
+        tau += s.h;
+        const double low = lowEdge(tau), high = highEdge(tau);
+        for (size_t j = 0; j < n; ++j) {
+            d[j] = s.exp_lo * V[j] + s.exp_mid * V[j + 1] + s.exp_up * V[j + 2];
+        }
+        d[0] -= s.imp_lo * low;
+        d[n - 1] -= s.imp_up * high;
+        //the interior of V is solved in place, the right-hand side no longer needs it
+        double* x = V.data() + 1;
+        const double* floor = exercise.data() + 1;
+        if (use_psor) {
+            psor_iterations += psor(s.imp_lo, s.imp_diag, s.imp_up, d.data(), x, floor, n, psor_tolerance);
+        } else {
+            solve(s.lu, d.data(), x, floor, n);
+        }
+        V[0] = low;
+        V[M - 1] = high;
+    };
+
+    const unsigned steps = options.timeSteps;
+    const unsigned rannacher = std::min(options.rannacherSteps, steps);
+    std::vector<double> next;
+    for (unsigned k = 0; k < steps; ++k) {
+        if (k + 1 == steps) next = V;  //t = dt, for theta
+        if (k < rannacher) {
+            step(implicit_half);
+            step(implicit_half);
+        } else {
+            step(crank_nicolson);
+        }
+    }
+    return PdeGrid(x_min, dx, dt, std::move(V), std::move(next), psor_iterations);
+}
+
+static void validate(double S, double K, double T, double sigma, const PdeOptions& options) {
+    if (!(S > 0.0) || !(K > 0.0) || !(T > 0.0) || !(sigma > 0.0)) {
+        throw std::invalid_argument("spot, strike, maturity and volatility must be positive");
+    }
+    if (options.spotNodes < 8 || options.spotNodes > kMaxPdeNodes) {
+        throw std::invalid_argument("spotNodes must be between 8 and " + std::to_string(kMaxPdeNodes));
+    }
+    if (options.timeSteps < 1 || options.timeSteps > kMaxPdeTimeSteps) {
+        throw std::invalid_argument("timeSteps must be between 1 and " + std::to_string(kMaxPdeTimeSteps));
+    }
+    if (!(options.width > 0.0)) {
+        throw std::invalid_argument("width must be positive");
+    }
+    if (options.exercise == ExerciseStyle::BERMUDAN) {
+        throw std::invalid_argument("bermudan exercise is only supported on the lattice");
+    }
+}
+
+PdeGrid solvePde(double S, double K, double T, double r, double sigma, OptionType type, const PdeOptions& options) {
+    validate(S, K, T, sigma, options);
+    const double x = std::log(S), half_width = options.width * sigma * std::sqrt(T);
+    double x_min = x - half_width, x_max = x + half_width;
+    if (!options.hasBarrier) {
+        return solveGrid(x_min, x_max, K, T, r, sigma, type, options, false, false);
+    }
+
+    const BarrierType barrier_type = options.barrierType;
+    const bool up = barrier_type == BarrierType::UP_AND_OUT || barrier_type == BarrierType::UP_AND_IN;
+    const bool knock_in = barrier_type == BarrierType::UP_AND_IN || barrier_type == BarrierType::DOWN_AND_IN;
+    if (!(options.barrier > 0.0) || (up ? options.barrier <= S : options.barrier >= S)) {
+        throw std::invalid_argument("the spot must be strictly inside the barrier");
+    }
+    if (knock_in && options.exercise == ExerciseStyle::AMERICAN) {
+        throw std::invalid_argument("american knock-in options are not supported");
+    }
+    //the grid ends on the barrier unless it lies beyond the far field, where it has no effect
+    const double x_barrier = std::log(options.barrier);
+    const bool knock_low = !up && x_barrier > x_min, knock_high = up && x_barrier < x_max;
+    if (knock_low) x_min = x_barrier;
+    if (knock_high) x_max = x_barrier;
+    PdeGrid out = solveGrid(x_min, x_max, K, T, r, sigma, type, options, knock_low, knock_high);
+    if (!knock_in) {
+        return out;
+    }
+
+    //in-out parity on every node: knock-in = vanilla - knock-out
+    const double dt = T / options.timeSteps;
+    auto vanilla = [&](double Si, double tau) {
+        if (tau <= 0.0) return std::max(type == OptionType::CALL ? Si - K : K - Si, 0.0);
+        return OptionPricer(Si, K, tau, r, sigma).blackScholes(type);
+    };
+    std::vector<double> values(out.size()), next(out.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        values[i] = vanilla(out.spot(i), T) - out.values()[i];
+        next[i] = vanilla(out.spot(i), T - dt) - out.nextValues()[i];
+    }
+    return PdeGrid(x_min, (x_max - x_min) / (options.spotNodes - 1), dt, std::move(values), std::move(next), 0);
+}
+
+std::vector<double> pdeStrikeLadder(double S, const std::vector<double>& strikes, double T, double r,
+                                    double sigma, OptionType type, const PdeOptions& options) {
+    if (options.hasBarrier) {
+        throw std::invalid_argument("a strike ladder cannot have a barrier");
+    }
+    if (strikes.empty()) return {};
+    const auto [K_min, K_max] = std::minmax_element(strikes.begin(), strikes.end());
+    validate(S, *K_min, T, sigma, options);
+
+    //K = 1: the ladder's moneyness range S / K plus the usual far field on both sides
+    const double half_width = options.width * sigma * std::sqrt(T);
+    const double x_min = std::log(S / *K_max) - half_width, x_max = std::log(S / *K_min) + half_width;
+    const PdeGrid unit = solveGrid(x_min, x_max, 1.0, T, r, sigma, type, options, false, false);
+    std::vector<double> prices(strikes.size());
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        prices[i] = strikes[i] * unit.value(S / strikes[i]);
+    }
+    return prices;
+}
+
+//----- PdeGrid -----
+
+PdeGrid::PdeGrid(double x_min, double dx, double dt, std::vector<double> values, std::vector<double> next,
+                 unsigned psor_iterations)
+    : x0_(x_min), dx_(dx), dt_(dt), V_(std::move(values)), next_(std::move(next)), psorIterations_(psor_iterations) {}
+
+double PdeGrid::spot(size_t i) const {
+    return std::exp(x0_ + i * dx_);
+}
+
+//the quadratic through nodes j - 1, j, j + 1: value, d/dx and d2/dx2 at offset h from node j
+struct Local { double v, vx, vxx; };
+
+static Local localFit(const std::vector<double>& V, size_t j, double h, double dx) {
+    const double vx = (V[j + 1] - V[j - 1]) / (2.0 * dx);
+    const double vxx = (V[j + 1] - 2.0 * V[j] + V[j - 1]) / (dx * dx);
+    return {V[j] + vx * h + 0.5 * vxx * h * h, vx + vxx * h, vxx};
+}
+
+//the fits around the two nodes either side of ln S blended linearly, so the second derivative stays
+//second order accurate between nodes; false outside the grid
+static bool interpolate(const std::vector<double>& V, double x0, double dx, double S, Local& out) {
+    const double u = (std::log(S) - x0) / dx;
+    if (!(u >= -1e-9 && u <= V.size() - 1 + 1e-9)) return false;
+    const size_t j = std::clamp<size_t>(static_cast<size_t>(std::max(u, 0.0)), 1, V.size() - 3);
+    const double w = u - j;
+    const Local lo = localFit(V, j, w * dx, dx), hi = localFit(V, j + 1, (w - 1.0) * dx, dx);
+    out = {lo.v + w * (hi.v - lo.v), lo.vx + w * (hi.vx - lo.vx), lo.vxx + w * (hi.vxx - lo.vxx)};
+    return true;
+}
+
+double PdeGrid::value(double S) const {
+    Local fit;
+    return interpolate(V_, x0_, dx_, S, fit) ? fit.v : std::numeric_limits<double>::quiet_NaN();
+}
+
+double PdeGrid::delta(double S) const {
+    Local fit;
+    return interpolate(V_, x0_, dx_, S, fit) ? fit.vx / S : std::numeric_limits<double>::quiet_NaN();
+}
+
+double PdeGrid::gamma(double S) const {
+    Local fit;
+    return interpolate(V_, x0_, dx_, S, fit) ? (fit.vxx - fit.vx) / (S * S) : std::numeric_limits<double>::quiet_NaN();
+}
+
+double PdeGrid::theta(double S) const {
+    Local now, later;
+    if (!interpolate(V_, x0_, dx_, S, now) || !interpolate(next_, x0_, dx_, S, later)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return (later.v - now.v) / dt_ / 365.0;
+}
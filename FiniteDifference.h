@@ -0,0 +1,75 @@
+// FiniteDifference.h
+#ifndef FINITE_DIFFERENCE_H
+#define FINITE_DIFFERENCE_H
+
+#include <vector>
+#include "Lattice.h"
+#include "MonteCarlo.h"
+
+//black-scholes PDE in x = ln S on a uniform grid, stepped backwards from the payoff by Crank-Nicolson.
+//The coefficients are constant in x, so each time step size has one tridiagonal LU factorization done
+//up front and every step is a multiply for the right-hand side plus two Thomas sweeps over contiguous
+//buffers. One solve values the contract at every spot on the grid, which is what a spot-ladder chart
+//or a strike ladder (pdeStrikeLadder) needs
+
+enum class EarlyExercise {
+    BRENNAN_SCHWARTZ,  //projection inside the Thomas back substitution, exact for a single exercise boundary
+    PSOR               //projected SOR iterations, general but several sweeps per step
+};
+
+struct PdeOptions {
+    ExerciseStyle exercise = ExerciseStyle::EUROPEAN;
+    unsigned spotNodes = 400;   //grid points in ln S, 8..kMaxPdeNodes
+    unsigned timeSteps = 200;   //1..kMaxPdeTimeSteps
+    //Rannacher start-up: the first steps are each replaced by two implicit half steps, which damps
+    //the payoff kink that Crank-Nicolson alone would carry through as oscillations in delta and gamma
+    unsigned rannacherSteps = 2;
+    EarlyExercise earlyExercise = EarlyExercise::BRENNAN_SCHWARTZ;
+    double width = 5.0;         //grid half-width in standard deviations sigma sqrt(T) around the spot
+    //continuously monitored barrier, the grid ends on it (knock-outs) or the price comes from in-out parity
+    //(knock-ins, european only)
+    bool hasBarrier = false;
+    BarrierType barrierType = BarrierType::DOWN_AND_OUT;
+    double barrier = 0.0;
+};
+
+constexpr unsigned kMaxPdeNodes = 100000;
+constexpr unsigned kMaxPdeTimeSteps = 100000;
+
+//option values at t = 0 on the spot grid, and one time step later for theta
+//value/delta/gamma/theta interpolate quadratically in ln S between nodes, NaN outside the grid
+class PdeGrid {
+public:
+    PdeGrid(double x_min, double dx, double dt, std::vector<double> values, std::vector<double> next,
+            unsigned psor_iterations);
+
+    size_t size() const { return V_.size(); }
+    double spot(size_t i) const;
+    const std::vector<double>& values() const { return V_; }
+    const std::vector<double>& nextValues() const { return next_; }  //one time step later, t = dt
+    double minSpot() const { return spot(0); }
+    double maxSpot() const { return spot(V_.size() - 1); }
+    unsigned psorIterations() const { return psorIterations_; }  //0 unless PSOR was used
+
+    double value(double S) const;
+    double delta(double S) const;
+    double gamma(double S) const;
+    double theta(double S) const;  //per day, like Greeks::theta
+
+private:
+    double x0_, dx_, dt_;
+    std::vector<double> V_, next_;  //t = 0 and t = dt
+    unsigned psorIterations_;
+};
+
+//throws std::invalid_argument for non-positive inputs, option counts out of range, a spot on or past
+//a barrier, an american knock-in or bermudan exercise
+PdeGrid solvePde(double S, double K, double T, double r, double sigma, OptionType type,
+                 const PdeOptions& options = PdeOptions{});
+
+//prices of one spot across many strikes from a single solve: values are homogeneous in (S, K), so the
+//contract with K = 1 on a grid covering every S/K gives price(K) = K v(S / K). No barriers
+std::vector<double> pdeStrikeLadder(double S, const std::vector<double>& strikes, double T, double r,
+                                    double sigma, OptionType type, const PdeOptions& options = PdeOptions{});
+
+#endif // FINITE_DIFFERENCE_H
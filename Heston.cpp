@@ -0,0 +1,168 @@
+// Heston.cpp
+#include "Heston.h"
+#include "AutoDiff.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void validateHeston(const HestonParams& p) {
+    if (!(p.v0 >= 0.0) || !(p.kappa > 0.0) || !(p.theta > 0.0) || !(p.xi > 0.0) || !(p.rho >= -1.0 && p.rho <= 1.0)) {
+        throw std::invalid_argument("heston parameters need v0 >= 0, kappa, theta, vol of vol > 0 and -1 <= rho <= 1");
+    }
+}
+
+//the characteristic function on any complex-like number type: std::complex<double>, or a Jet of it
+//for the derivatives with respect to the parameters
+template <class C>
+static C characteristic(double u, double T, double r, const C& v0, const C& kappa, const C& theta, const C& xi,
+                        const C& rho) {
+    const std::complex<double> iu(0.0, u);
+    const C xi2 = xi * xi;
+    const C beta = kappa - rho * xi * iu;
+    const C d = sqrt(beta * beta + xi2 * (iu + u * u));
+    //g = 1 / g of the original Heston paper: with it e^(-dT) only ever decays, so the log below does
+    //not wind around the origin as T grows
+    const C g = (beta - d) / (beta + d);
+    const C decay = exp(-d * T);
+    const C drift = kappa * theta / xi2 * ((beta - d) * T - 2.0 * log((1.0 - g * decay) / (1.0 - g))) + iu * (r * T);
+    const C D = (beta - d) / xi2 * (1.0 - decay) / (1.0 - g * decay);
+    return exp(drift + D * v0);
+}
+
+std::complex<double> hestonCharacteristic(double u, double T, double r, const HestonParams& p) {
+    using C = std::complex<double>;
+    return characteristic<C>(u, T, r, p.v0, p.kappa, p.theta, p.xi, p.rho);
+}
+
+//first two cumulants of ln(S_T / S), Fang & Oosterlee (2008) table 11
+static void hestonCumulants(double T, double r, const HestonParams& p, double& c1, double& c2) {
+    const double k = p.kappa, th = p.theta, v0 = p.v0, xi = p.xi, rho = p.rho;
+    const double e = std::exp(-k * T);
+    c1 = r * T + (1.0 - e) * (th - v0) / (2.0 * k) - 0.5 * th * T;
+    c2 = (xi * T * k * e * (v0 - th) * (8.0 * k * rho - 4.0 * xi)
+          + k * rho * xi * (1.0 - e) * (16.0 * th - 8.0 * v0)
+          + 2.0 * th * k * T * (-4.0 * k * rho * xi + xi * xi + 4.0 * k * k)
+          + xi * xi * ((th - 2.0 * v0) * e * e + th * (6.0 * e - 7.0) + 2.0 * v0)
+          + 8.0 * k * k * (v0 - th) * (1.0 - e))
+         / (8.0 * k * k * k);
+    //the expansion can lose its sign for extreme parameters, the expected integrated variance still
+    //gives the scale of the distribution
+    if (!(c2 > 0.0)) {
+        c2 = th * T + (v0 - th) * (1.0 - e) / k;
+    }
+}
+
+HestonCos::HestonCos(double S, double T, double r, const HestonParams& params, unsigned terms, double truncation,
+                     bool gradient)
+    : S_(S), discount_(std::exp(-r * T)), sets_(gradient ? 1 + kHestonParamCount : 1) {
+    if (!(S > 0.0) || !(T > 0.0) || !(truncation > 0.0)) {
+        throw std::invalid_argument("spot, maturity and truncation must be positive");
+    }
+    validateHeston(params);
+    double c1, c2;
+    hestonCumulants(T, r, params, c1, c2);
+    const double half = truncation * std::sqrt(c2);
+    a_ = c1 - half;
+    width_ = 2.0 * half;
+    du_ = M_PI / width_;
+
+    const unsigned n = std::clamp(terms, 16u, kMaxHestonCosTerms);
+    density_.resize(n * sets_);
+    for (unsigned k = 0; k < n; ++k) {
+        const double u = k * du_;
+        const std::complex<double> shift = std::exp(std::complex<double>(0.0, -u * a_)) * (2.0 / width_);
+        double* row = density_.data() + k * sets_;
+        if (!gradient) {
+            row[0] = (hestonCharacteristic(u, T, r, params) * shift).real();
+            continue;
+        }
+        using J = Jet<std::complex<double>, kHestonParamCount>;
+        const J phi = characteristic<J>(u, T, r, J::variable(params.v0, 0), J::variable(params.kappa, 1),
+                                        J::variable(params.theta, 2), J::variable(params.xi, 3),
+                                        J::variable(params.rho, 4));
+        row[0] = (phi.v * shift).real();
+        for (int i = 0; i < kHestonParamCount; ++i) row[1 + i] = (phi.d[i] * shift).real();
+    }
+    for (size_t i = 0; i < sets_; ++i) density_[i] *= 0.5;
+}
+
+double HestonCos::price(double K, OptionType type) const {
+    return prices({K}, type)[0];
+}
+
+std::vector<double> HestonCos::putSums(const std::vector<double>& strikes, size_t sets) const {
+    const size_t m = strikes.size();
+    //per strike: the put pays K (1 - e^(x + z)) for z = ln(S_T / S) below -x, x = ln(S / K), so its
+    //integral against cos(u (z - a)) runs over [a, d], d = min(b, -x). cos and sin of u (d - a) advance
+    //from one term to the next by a fixed rotation, no trigonometric calls inside the sum
+    std::vector<double> sum(sets * m), span(m), ed(m), ea(m), c(m), s(m), rc(m), rs(m), term(m);
+    for (size_t j = 0; j < m; ++j) {
+        if (!(strikes[j] > 0.0)) {
+            throw std::invalid_argument("strikes must be positive");
+        }
+        const double x = std::log(S_ / strikes[j]);
+        const double d = std::min(a_ + width_, -x);
+        span[j] = std::max(d - a_, 0.0);  //0: the put is worthless over the whole range
+        ed[j] = span[j] > 0.0 ? std::exp(x + d) : 0.0;
+        ea[j] = span[j] > 0.0 ? std::exp(x + a_) : 0.0;
+        c[j] = 1.0;
+        s[j] = 0.0;
+        rc[j] = std::cos(du_ * span[j]);
+        rs[j] = std::sin(du_ * span[j]);
+        term[j] = span[j] - (ed[j] - ea[j]);
+    }
+    for (size_t k = 0; k < density_.size() / sets_; ++k) {
+        if (k > 0) {
+            const double u = k * du_;
+            const double inv_u = 1.0 / u;
+            const double inv_1u2 = 1.0 / (1.0 + u * u);
+            for (size_t j = 0; j < m; ++j) {
+                const double cj = c[j] * rc[j] - s[j] * rs[j];
+                const double sj = s[j] * rc[j] + c[j] * rs[j];
+                c[j] = cj;
+                s[j] = sj;
+                //integral of cos(u (z - a)) minus that of e^(x + z) cos(u (z - a)) over [a, d]
+                term[j] = sj * inv_u - inv_1u2 * (cj * ed[j] - ea[j] + u * sj * ed[j]);
+            }
+        }
+        const double* A = density_.data() + k * sets_;
+        for (size_t set = 0; set < sets; ++set) {
+            double* out = sum.data() + set * m;
+            for (size_t j = 0; j < m; ++j) out[j] += A[set] * term[j];
+        }
+    }
+    for (size_t set = 0; set < sets; ++set) {
+        for (size_t j = 0; j < m; ++j) sum[set * m + j] *= strikes[j] * discount_;
+    }
+    return sum;
+}
+
+std::vector<double> HestonCos::prices(const std::vector<double>& strikes, OptionType type) const {
+    std::vector<double> out = putSums(strikes, 1);
+    for (size_t j = 0; j < strikes.size(); ++j) {
+        const double put = std::max(out[j], 0.0);
+        out[j] = type == OptionType::PUT ? put : std::max(put + S_ - strikes[j] * discount_, 0.0);
+    }
+    return out;
+}
+
+void HestonCos::pricesAndGradients(const std::vector<double>& strikes, OptionType type, std::vector<double>& prices,
+                                   std::vector<double>& gradient) const {
+    if (sets_ == 1) {
+        throw std::logic_error("HestonCos was built without gradients");
+    }
+    const size_t m = strikes.size();
+    const std::vector<double> sums = putSums(strikes, sets_);
+    prices.resize(m);
+    gradient.resize(m * kHestonParamCount);
+    for (size_t j = 0; j < m; ++j) {
+        //put-call parity does not involve the parameters, calls and puts share the gradient
+        prices[j] = type == OptionType::PUT ? sums[j] : sums[j] + S_ - strikes[j] * discount_;
+        for (int i = 0; i < kHestonParamCount; ++i) gradient[j * kHestonParamCount + i] = sums[(1 + i) * m + j];
+    }
+}
+
+double hestonPrice(double S, double K, double T, double r, const HestonParams& params, OptionType type,
+                   unsigned terms) {
+    return HestonCos(S, T, r, params, terms).price(K, type);
+}
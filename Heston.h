@@ -0,0 +1,94 @@
+// Heston.h
+#ifndef HESTON_H
+#define HESTON_H
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include "OptionPricer.h"
+#include "MonteCarlo.h"
+
+//Heston stochastic volatility: dS = r S dt + sqrt(v) S dW1, dv = kappa (theta - v) dt + xi sqrt(v) dW2,
+//d<W1, W2> = rho dt. Unlike the flat sigma of OptionPricer it produces a skew and a term structure of smiles
+struct HestonParams {
+    double v0;     //initial variance
+    double kappa;  //mean reversion speed
+    double theta;  //long-run variance
+    double xi;     //volatility of variance
+    double rho;    //spot/variance correlation
+};
+
+//throws std::invalid_argument unless v0 >= 0, kappa, theta, xi > 0 and -1 <= rho <= 1
+void validateHeston(const HestonParams& params);
+
+//E[e^(iu ln(S_T / S))], in the "little trap" form of Albrecher et al. which stays on the principal
+//branch of the complex log for long maturities
+std::complex<double> hestonCharacteristic(double u, double T, double r, const HestonParams& params);
+
+//Fourier-cosine (COS, Fang & Oosterlee) pricing of every strike of one expiry: the density of
+//ln(S_T / S) is expanded in cosines on a truncation range [a, b] = c1 +- truncation * sqrt(c2) around
+//its mean, and integrating the put payoff against each cosine is closed form. The density's
+//coefficients, one characteristic function evaluation per term, depend only on the model and the
+//expiry and are computed once in the constructor; a strike is then one O(terms) sum, run for a whole
+//grid of strikes at a time. Calls come from put-call parity
+constexpr unsigned kHestonCosTerms = 256;
+constexpr unsigned kMaxHestonCosTerms = 65536;
+//half-width in standard deviations: wider than a normal would need, paths that spend their life at
+//low variance give ln(S_T / S) a heavy left tail (12 costs 5e-5 on the Fang-Oosterlee test case, 20 about 1e-7)
+constexpr double kHestonCosTruncation = 20.0;
+
+//parameter order of the gradients: v0, kappa, theta, xi, rho
+constexpr int kHestonParamCount = 5;
+
+class HestonCos {
+public:
+    //terms is clamped to 16..kMaxHestonCosTerms, throws std::invalid_argument for bad inputs
+    //gradient also keeps the derivatives of every coefficient with respect to the five parameters,
+    //from forward-mode AD through the characteristic function (AutoDiff.h), for pricesAndGradients
+    HestonCos(double S, double T, double r, const HestonParams& params,
+              unsigned terms = kHestonCosTerms, double truncation = kHestonCosTruncation, bool gradient = false);
+
+    double price(double K, OptionType type) const;
+    //same as price for each strike, one pass over the cached coefficients for all of them
+    std::vector<double> prices(const std::vector<double>& strikes, OptionType type) const;
+
+    //prices and d price / d parameter (row-major, kHestonParamCount per strike) from the same pass.
+    //The truncation range is held where the constructor put it, moving it only changes the price by
+    //the truncation error. Throws std::logic_error unless constructed with gradient = true
+    void pricesAndGradients(const std::vector<double>& strikes, OptionType type, std::vector<double>& prices,
+                            std::vector<double>& gradient) const;
+
+    unsigned terms() const { return static_cast<unsigned>(density_.size() / sets_); }
+    double lower() const { return a_; }  //truncation range of ln(S_T / S)
+    double upper() const { return a_ + width_; }
+
+private:
+    //K e^(-rT) times the put's cosine sum for each coefficient set, row-major sets x strikes
+    std::vector<double> putSums(const std::vector<double>& strikes, size_t sets) const;
+
+    double S_, discount_;
+    double a_, width_, du_;         //range start, b - a, frequency step pi / (b - a)
+    size_t sets_;                   //1, or 1 + kHestonParamCount with gradients
+    //cosine coefficients of the density on [a, b] (the first one halved), then their derivatives:
+    //row-major terms x sets
+    std::vector<double> density_;
+};
+
+//single contract, builds the coefficients for one strike
+double hestonPrice(double S, double K, double T, double r, const HestonParams& params, OptionType type,
+                   unsigned terms = kHestonCosTerms);
+
+//Monte Carlo with Andersen's quadratic-exponential variance step and the martingale-corrected
+//log-price step, for validating the Fourier prices. Runs on the chunked, seed-deterministic
+//estimator of monteCarloParallel (MonteCarlo.cpp): every kHestonChunkPaths draws use their own Philox
+//stream. ANTITHETIC/BOTH negate both normals, CONTROL_VARIATE/BOTH use S_T, whose mean S e^(rT)
+//the corrected scheme reproduces exactly
+constexpr long kHestonChunkPaths = 2048;
+constexpr unsigned kMaxHestonSteps = 10000;
+
+MonteCarloResult monteCarloHeston(double S, double K, double T, double r, const HestonParams& params,
+                                  OptionType type, long n_sims, std::uint64_t seed, unsigned steps = 100,
+                                  VarianceReduction vr = VarianceReduction::ANTITHETIC,
+                                  unsigned max_threads = 0);
+
+#endif // HESTON_H
@@ -0,0 +1,594 @@
+#include "ImpliedVol.h"
+#include <array>
+#include <cfloat>
+#include <limits>
+
+const char* impliedVolStatusName(ImpliedVolStatus status) {
+    switch (status) {
+        case ImpliedVolStatus::OK:              return "ok";
+        case ImpliedVolStatus::INVALID_INPUT:   return "invalid_input";
+        case ImpliedVolStatus::BELOW_INTRINSIC: return "below_intrinsic";
+        case ImpliedVolStatus::ABOVE_MAXIMUM:   return "above_maximum";
+        case ImpliedVolStatus::NOT_CONVERGED:   return "not_converged";
+    }
+    return "unknown";
+}
+
+namespace {
+
+//price, vega and volga at one volatility, from shared d1/d2 terms
+struct VolEval {
+    double price;
+    double vega;
+    double volga;
+};
+
+VolEval evaluate(double S, double K_disc, double sqrt_T, double log_moneyness, double sigma, bool is_call) {
+    const double vol_time = sigma * sqrt_T;
+    //log(S/K) + rT = log(S / (K e^(-rT))), so r is already folded into log_moneyness
+    const double d1 = log_moneyness / vol_time + 0.5 * vol_time;
+    const double d2 = d1 - vol_time;
+    const double pdf_d1 = OptionPricer::normalPDF(d1);
+    const double pdf_d2 = pdf_d1 >= DBL_MIN ? pdf_d1 * S / K_disc : OptionPricer::normalPDF(d2);
+    const double Nd1 = OptionPricer::normalCDFFromPDF(d1, pdf_d1);
+    const double Nd2 = OptionPricer::normalCDFFromPDF(d2, pdf_d2);
+
+    VolEval e;
+    e.price = is_call ? S * Nd1 - K_disc * Nd2 : K_disc * (1.0 - Nd2) - S * (1.0 - Nd1);
+    e.vega = S * pdf_d1 * sqrt_T;
+    e.volga = e.vega * d1 * d2 / sigma;
+    return e;
+}
+
+} // namespace
+
+ImpliedVolResult solveImpliedVol(double price, double S, double K, double T, double r, OptionType type,
+                                 double tolerance, int max_iter) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    ImpliedVolResult result{nan, 0, false, ImpliedVolStatus::INVALID_INPUT};
+    if (!(S > 0.0 && K > 0.0 && T > 0.0 && price >= 0.0)) return result;
+
+    const double K_disc = K * std::exp(-r * T);
+    const double sqrt_T = std::sqrt(T);
+    const double log_moneyness = std::log(S / K_disc);
+
+    //solve on the out-of-the-money option: its price is all time value, so no digits are lost
+    //to the intrinsic part. Calls are OTM when the forward is below the strike
+    const bool call_otm = S <= K_disc;
+    double target = price;
+    if ((type == OptionType::CALL) != call_otm) {
+        //put-call parity: C - P = S - K e^(-rT)
+        target = type == OptionType::CALL ? price - (S - K_disc) : price + (S - K_disc);
+    }
+    const double upper = call_otm ? S : K_disc;  //the price as sigma -> infinity
+    //a quote at exactly the intrinsic value can come out a few ulps under it after parity
+    if (target < 0.0 && target >= -4.0 * DBL_EPSILON * std::max(S, K_disc)) target = 0.0;
+    if (!(target >= 0.0)) {
+        result.status = ImpliedVolStatus::BELOW_INTRINSIC;
+        return result;
+    }
+    if (!(target < upper)) {
+        result.status = ImpliedVolStatus::ABOVE_MAXIMUM;
+        return result;
+    }
+    if (target == 0.0) {
+        //exactly intrinsic, only zero volatility gives that
+        result.vol = 0.0;
+        result.converged = true;
+        result.status = ImpliedVolStatus::OK;
+        return result;
+    }
+
+    //Corrado-Miller on the call price, an ATM-accurate closed form
+    const double call = call_otm ? target : target + (S - K_disc);
+    const double half_gap = 0.5 * (S - K_disc);
+    const double a = call - half_gap;
+    const double disc = a * a - (S - K_disc) * (S - K_disc) / M_PI;
+    double sigma = std::sqrt(2.0 * M_PI) / (S + K_disc) * (a + std::sqrt(std::max(disc, 0.0))) / sqrt_T;
+    if (!(sigma > 0.0) || !std::isfinite(sigma)) {
+        //Brenner-Subrahmanyam, exact only at the money but always positive
+        sigma = std::sqrt(2.0 * M_PI / T) * call / S;
+    }
+    sigma = std::min(std::max(sigma, 1e-4), 5.0);
+
+    //f(sigma) = BS(sigma) - target is increasing, every evaluation tightens [lo, hi]
+    double lo = 0.0;
+    double hi = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < max_iter; ++i) {
+        const VolEval e = evaluate(S, K_disc, sqrt_T, log_moneyness, sigma, call_otm);
+        ++result.iterations;
+        const double diff = e.price - target;
+        if (std::abs(diff) < tolerance) {
+            result.vol = sigma;
+            result.converged = true;
+            result.status = ImpliedVolStatus::OK;
+            return result;
+        }
+        if (diff > 0.0) hi = sigma;
+        else lo = sigma;
+
+        double next = -1.0;
+        if (e.vega > 0.0) {
+            double step = diff / e.vega;  //Newton
+            //Halley: divide by 1 - f f'' / (2 f'^2), only while that correction is mild
+            const double correction = 1.0 - 0.5 * step * e.volga / e.vega;
+            if (correction > 0.5 && correction < 2.0) step /= correction;
+            next = sigma - step;
+        }
+        if (!(next > lo && next < hi)) {
+            //step left the bracket (or vega vanished): bisect, or grow while there is no upper end yet
+            next = std::isinf(hi) ? 2.0 * sigma : 0.5 * (lo + hi);
+        }
+        if (std::abs(next - sigma) <= 4.0 * DBL_EPSILON * sigma) {
+            //bracket collapsed to machine precision, as close as double can get
+            result.vol = next;
+            result.converged = true;
+            result.status = ImpliedVolStatus::OK;
+            return result;
+        }
+        sigma = next;
+    }
+    result.vol = sigma;  //best estimate so far
+    result.status = ImpliedVolStatus::NOT_CONVERGED;
+    return result;
+}
+
+//----- rational (Let's Be Rational style) solver -----
+//everything below works on the normalised, undiscounted, out-of-the-money call
+//b(x, s) = e^(x/2) N(x/s + s/2) - e^(-x/2) N(x/s - s/2) with x = ln(F/K) <= 0, s = sigma sqrt(T)
+
+namespace {
+
+constexpr double kSqrt2 = 1.41421356237309504880;
+constexpr double kInvSqrtPi = 0.56418958354775628695;
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+constexpr double kLogSqrt2Pi = 0.91893853320467274178;
+
+//scaled complementary error function e^(v^2) erfc(v)
+double erfcx(double v) {
+    if (v < 0.0) return 2.0 * std::exp(v * v) - erfcx(-v);
+    if (v < 2.0) return std::exp(v * v) * std::erfc(v);
+    //continued fraction 1/sqrt(pi) / (v + (1/2)/(v + 1/(v + (3/2)/(v + ...)))), depth for full precision
+    const int depth = 10 + static_cast<int>(240.0 / (v * v));
+    double f = v;
+    for (int k = depth; k >= 1; --k) f = v + 0.5 * k / f;
+    return kInvSqrtPi / f;
+}
+
+//1 / (2n), the forward recurrence divides by it once per term
+constexpr std::array<double, 65> kHalfReciprocals = [] {
+    std::array<double, 65> out{};
+    for (int n = 1; n < 65; ++n) out[n] = 0.5 / n;
+    return out;
+}();
+
+//sum over odd n of (2 delta)^n e^(v^2) i^n erfc(v), with i^n erfc the repeated integrals of erfc
+//this is (erfcx(v - delta) - erfcx(v + delta)) / 2 as a series of positive terms, so it has none of
+//the cancellation of the difference when delta is small. The terms follow the recurrence
+//i^(n-2) = 2n i^n + 2v i^(n-1) starting from e^(v^2) i^(-1) erfc(v) = 2/sqrt(pi): forwards while v
+//is small, backwards (Miller's algorithm) once i^n erfc(v) decays fast enough for that to be stable
+//needs delta <= max(1, v) / 2
+double erfcxOddSeries(double v, double delta) {
+    constexpr int kTerms = 64;
+    const double x = 2.0 * delta;
+    double sum = 0.0;
+    if (v < 1.5) {
+        double prev = 2.0 * kInvSqrtPi;  //E_(n-2)
+        double cur = erfcx(v);           //E_(n-1)
+        double power = 1.0;
+        for (int n = 1; n <= kTerms; ++n) {
+            const double next = (prev - 2.0 * v * cur) * kHalfReciprocals[n];
+            power *= x;
+            if (n & 1) {
+                const double term = power * next;
+                sum += term;
+                if (term <= 1e-17 * sum) break;
+            }
+            prev = cur;
+            cur = next;
+        }
+        return sum;
+    }
+
+    //odd terms shrink by about (delta / v)^2 each, and the recurrence has to start far enough
+    //above the last one (and above ~200 / v^2) for the unwanted solution to have died out
+    const int last = std::min(kTerms - 1, 1 + 2 * static_cast<int>(19.6 / std::log(v / delta)));
+    const int start = std::max(last + 16, static_cast<int>(200.0 / (v * v)));
+    double E[kTerms + 1];
+    double above = 0.0;   //E_(m+1)
+    double cur = 1e-300;  //E_m
+    for (int m = start; m >= 0; --m) {
+        if (m <= last) E[m] = cur;
+        const double below = 2.0 * (m + 1) * above + 2.0 * v * cur;  //E_(m-1)
+        above = cur;
+        cur = below;
+        if (cur > 1e200) {
+            //keep the unnormalised values in range, only ratios matter
+            above *= 1e-200;
+            cur *= 1e-200;
+            for (int j = m; j <= last; ++j) E[j] *= 1e-200;
+        }
+    }
+    double power = x;
+    for (int n = 1; n <= last; n += 2) {
+        const double term = power * E[n];
+        sum += term;
+        if (term <= 1e-17 * sum) break;
+        power *= x * x;
+    }
+    return sum * (2.0 * kInvSqrtPi / cur);
+}
+
+//b(x, s) for x <= 0, s > 0, as b = e^log_scale * m so that ln b = log_scale + ln m stays finite
+//where b itself underflows
+struct NormalisedBlack {
+    double b;
+    double log_scale;
+    double m;
+
+    double logB() const { return log_scale + std::log(m); }
+};
+
+//Jaeckel's Taylor expansion of b / (e^(-(h^2 + t^2) / 2) / sqrt(2 pi)) in t to t^13, with
+//a = 1 + h N(h) / phi(h). Accurate to a few ulps for t < 2 eps^(1/16) while |h| is moderate: a cancels
+//like 1 / h^2 as h -> -infinity
+constexpr double kSmallT = 0.21022410381342863;  //2 DBL_EPSILON^(1/16)
+constexpr double kSmallTMaxV = 1.5;                //|h| / sqrt(2) up to which a keeps its digits
+
+double smallTExpansion(double h, double t, double v) {
+    constexpr double kSqrtHalfPi = 1.25331413731550025121;
+    const double a = 1.0 + h * kSqrtHalfPi * erfcx(v), w = t * t, h2 = h * h;
+    //coefficient of w^k is (p_k(h^2) + a q_k(h^2)) / (2k + 1)!, each independent of the others
+    const double c1 = (-1.0 + a * (3.0 + h2)) * (1.0 / 6.0);
+    const double c2 = (-7.0 - h2 + a * (15.0 + h2 * (10.0 + h2))) * (1.0 / 120.0);
+    const double c3 = (-57.0 - h2 * (18.0 + h2) + a * (105.0 + h2 * (105.0 + h2 * (21.0 + h2)))) * (1.0 / 5040.0);
+    const double c4 = (-561.0 - h2 * (285.0 + h2 * (33.0 + h2))
+                       + a * (945.0 + h2 * (1260.0 + h2 * (378.0 + h2 * (36.0 + h2))))) * (1.0 / 362880.0);
+    const double c5 = (-6555.0 - h2 * (4680.0 + h2 * (840.0 + h2 * (52.0 + h2)))
+                       + a * (10395.0 + h2 * (17325.0 + h2 * (6930.0 + h2 * (990.0 + h2 * (55.0 + h2)))))) * (1.0 / 39916800.0);
+    const double c6 = (-89055.0 - h2 * (82845.0 + h2 * (20370.0 + h2 * (1926.0 + h2 * (75.0 + h2))))
+                       + a * (135135.0 + h2 * (270270.0 + h2 * (135135.0 + h2 * (25740.0 + h2 * (2145.0 + h2 * (78.0 + h2)))))))
+                    * (1.0 / 6227020800.0);
+    return 2.0 * t * (a + w * (c1 + w * (c2 + w * (c3 + w * (c4 + w * (c5 + w * c6))))));
+}
+
+NormalisedBlack normalisedBlack(double x, double s) {
+    const double h = x / s;
+    const double t = 0.5 * s;
+    const double v = -h / kSqrt2;      //>= 0
+    const double delta = t / kSqrt2;
+    const double log_gauss = -0.5 * (h * h + t * t);  //e^(x/2) phi(h + t) = e^(-x/2) phi(h - t) = this / sqrt(2 pi)
+    if (t < kSmallT && v < kSmallTMaxV) {
+        //the common case near the money, a fixed polynomial instead of the series below
+        const double m = kInvSqrt2Pi * smallTExpansion(h, t, v);
+        return {std::exp(log_gauss) * m, log_gauss, m};
+    }
+    if (v < kSmallTMaxV) {
+        //near the money with t >= kSmallT: the two terms differ by at least ~10% of their size
+        const double b = 0.5 * (std::exp(0.5 * x) * std::erfc(v - delta) - std::exp(-0.5 * x) * std::erfc(v + delta));
+        return {b, 0.0, b};
+    }
+    if (delta <= 0.5 * v) {
+        //small s against the distance from the money: the difference would cancel, sum the series
+        const double m = erfcxOddSeries(v, delta);
+        return {std::exp(log_gauss) * m, log_gauss, m};
+    }
+    if (v >= delta) {
+        //both normal terms in the lower tail, scaled to avoid underflow
+        const double m = 0.5 * (erfcx(v - delta) - erfcx(v + delta));
+        return {std::exp(log_gauss) * m, log_gauss, m};
+    }
+    const double b = 0.5 * (std::exp(0.5 * x) * std::erfc(v - delta) - std::exp(-0.5 * x) * std::erfc(v + delta));
+    return {b, 0.0, b};
+}
+
+//b_max - b(x, s) = e^(x/2) N(-h - t) + e^(-x/2) N(h - t), a sum of positive terms
+double normalisedBlackComplement(double x, double s) {
+    const double h = x / s;
+    const double t = 0.5 * s;
+    return 0.5 * (std::exp(0.5 * x) * std::erfc((h + t) / kSqrt2) + std::exp(-0.5 * x) * std::erfc((t - h) / kSqrt2));
+}
+
+//db/ds, the normalised vega
+double normalisedVega(double x, double s) {
+    const double h = x / s;
+    const double t = 0.5 * s;
+    return kInvSqrt2Pi * std::exp(-0.5 * (h * h + t * t));
+}
+
+//----- rational cubic interpolation (Delbourgo & Gregory 1985, with Jaeckel's control parameters) -----
+//on [x_l, x_r] through y_l, y_r with slopes d_l, d_r; the control parameter r >= -1 bends it between
+//the cubic Hermite interpolant (r = 3) and the straight line (r -> infinity)
+
+constexpr double kMinRationalControl = -(1.0 - 1.4901161193847656e-08);  //-(1 - sqrt(DBL_EPSILON))
+constexpr double kMaxRationalControl = 2.0 / (DBL_EPSILON * DBL_EPSILON);
+
+double rationalCubic(double x, double x_l, double x_r, double y_l, double y_r, double d_l, double d_r, double r) {
+    const double h = x_r - x_l;
+    if (!(std::abs(h) > 0.0)) return 0.5 * (y_l + y_r);
+    const double t = (x - x_l) / h;
+    if (!(r >= kMaxRationalControl)) {
+        const double omt = 1.0 - t, t2 = t * t, omt2 = omt * omt;
+        return (y_r * t2 * t + (r * y_r - h * d_r) * t2 * omt + (r * y_l + h * d_l) * t * omt2 + y_l * omt2 * omt)
+             / (1.0 + (r - 3.0) * t * omt);
+    }
+    return y_r * t + y_l * (1.0 - t);
+}
+
+//smallest r keeping the interpolant monotone and convex (or concave) where the data are, s the secant
+double minimumRationalControl(double d_l, double d_r, double s, bool prefer_shape) {
+    const bool monotonic = d_l * s >= 0.0 && d_r * s >= 0.0;
+    const bool convex = d_l <= s && s <= d_r, concave = d_l >= s && s >= d_r;
+    if (!monotonic && !convex && !concave) return kMinRationalControl;
+    double r1 = -DBL_MAX, r2 = -DBL_MAX;
+    if (monotonic) {
+        if (std::abs(s) >= DBL_MIN) r1 = (d_r + d_l) / s;
+        else if (prefer_shape) r1 = kMaxRationalControl;
+    }
+    if (convex || concave) {
+        const double s_m_d_l = s - d_l, d_r_m_s = d_r - s;
+        if (std::abs(s_m_d_l) >= DBL_MIN && std::abs(d_r_m_s) >= DBL_MIN) {
+            r2 = std::max(std::abs((d_r - d_l) / d_r_m_s), std::abs((d_r - d_l) / s_m_d_l));
+        } else if (prefer_shape) {
+            r2 = kMaxRationalControl;
+        }
+    } else if (monotonic && prefer_shape) {
+        r2 = kMaxRationalControl;
+    }
+    return std::max(kMinRationalControl, std::max(r1, r2));
+}
+
+//r matching a second derivative at one end, raised to keep the shape
+double rationalControlLeft(double x_l, double x_r, double y_l, double y_r, double d_l, double d_r,
+                           double second_l, bool prefer_shape) {
+    const double h = x_r - x_l, secant = (y_r - y_l) / h;
+    const double numerator = 0.5 * h * second_l + (d_r - d_l), denominator = secant - d_l;
+    double r;
+    if (std::abs(numerator) < DBL_MIN) r = 0.0;
+    else if (std::abs(denominator) < DBL_MIN) r = numerator > 0.0 ? kMaxRationalControl : kMinRationalControl;
+    else r = numerator / denominator;
+    return std::max(r, minimumRationalControl(d_l, d_r, secant, prefer_shape));
+}
+
+double rationalControlRight(double x_l, double x_r, double y_l, double y_r, double d_l, double d_r,
+                            double second_r, bool prefer_shape) {
+    const double h = x_r - x_l, secant = (y_r - y_l) / h;
+    const double numerator = 0.5 * h * second_r + (d_r - d_l), denominator = d_r - secant;
+    double r;
+    if (std::abs(numerator) < DBL_MIN) r = 0.0;
+    else if (std::abs(denominator) < DBL_MIN) r = numerator > 0.0 ? kMaxRationalControl : kMinRationalControl;
+    else r = numerator / denominator;
+    return std::max(r, minimumRationalControl(d_l, d_r, secant, prefer_shape));
+}
+
+//the lower map f(b) = 2 pi |x| / sqrt(27) N(-|x| / (sqrt(3) s))^3, nearly b itself as b -> 0
+//(f' -> 1) and inverted in closed form; f' and f'' are with respect to b
+double lowerMap(double x, double s, double& fp, double& fpp) {
+    constexpr double kSqrt3 = 1.73205080756887729353;
+    constexpr double kTwoPiOverSqrt27 = 1.20919957615614523660;
+    constexpr double kPi = 3.14159265358979323846;
+    const double ax = std::abs(x), z = ax / (kSqrt3 * s), y = z * z, s2 = s * s;
+    const double Phi = 0.5 * std::erfc(z / kSqrt2), phi = kInvSqrt2Pi * std::exp(-0.5 * y);
+    fpp = kPi / 6.0 * y / (s2 * s) * Phi * (8.0 * kSqrt3 * s * ax + (3.0 * s2 * (s2 - 8.0) - 8.0 * x * x) * Phi / phi)
+        * std::exp(2.0 * y + 0.25 * s2);
+    fp = 2.0 * kPi * y * Phi * Phi * std::exp(y + 0.125 * s2);
+    return kTwoPiOverSqrt27 * ax * Phi * Phi * Phi;
+}
+
+double inverseLowerMap(double x, double f) {
+    constexpr double kSqrt3 = 1.73205080756887729353;
+    constexpr double kTwoPiOverSqrt27 = 1.20919957615614523660;
+    return std::abs(x / (kSqrt3 * OptionPricer::inverseNormalCDF(std::cbrt(f / (kTwoPiOverSqrt27 * std::abs(x))))));
+}
+
+//the upper map f(b) = N(-s/2), about (b_max - b) / 2 near the top; f' and f'' with respect to b
+double upperMap(double x, double s, double& fp, double& fpp) {
+    constexpr double kSqrtPiOverTwo = 1.25331413731550025121;
+    const double w = (x / s) * (x / s);
+    fp = -0.5 * std::exp(0.5 * w);
+    fpp = kSqrtPiOverTwo * std::exp(w + 0.125 * s * s) * w / s;
+    return 0.5 * std::erfc(0.5 * s / kSqrt2);
+}
+
+enum class Branch { LOWER, MIDDLE, UPPER };
+
+//s with b(x, s) = beta for x <= 0 and 0 < beta < e^(x/2), converged is false if the iteration limit was hit
+double solveNormalised(double x, double beta, int& iterations, bool& converged) {
+    const double b_max = std::exp(0.5 * x);
+    double s;
+    double lo = 0.0;
+    double hi = std::numeric_limits<double>::infinity();
+    Branch branch;
+
+    if (x == 0.0) {
+        //at the money b = 1 - 2 N(-s/2), inverted directly
+        s = -2.0 * OptionPricer::inverseNormalCDF(0.5 * (1.0 - beta));
+        branch = beta > 0.5 ? Branch::UPPER : Branch::MIDDLE;
+    } else {
+        //b is convex below the inflection point s_c and concave above; the tangent there meets
+        //b = 0 at s_l and b = b_max at s_u, which split the range into four branches
+        const double s_c = std::sqrt(2.0 * std::abs(x));
+        const double b_c = normalisedBlack(x, s_c).b;
+        const double v_c = normalisedVega(x, s_c);
+        if (beta <= b_c) {
+            const double s_l = std::max(s_c - b_c / v_c, 0.5 * s_c * DBL_EPSILON);
+            const double b_l = normalisedBlack(x, s_l).b;
+            if (beta < b_l) {
+                //interpolate the lower map between f(0) = 0 (slope 1) and s_l, matching f'' at s_l,
+                //then invert it: exact in the limit b -> 0
+                double fp_l, fpp_l;
+                const double f_l = lowerMap(x, s_l, fp_l, fpp_l);
+                const double r_ll = rationalControlRight(0.0, b_l, 0.0, f_l, 1.0, fp_l, fpp_l, true);
+                double f = rationalCubic(beta, 0.0, b_l, 0.0, f_l, 1.0, fp_l, r_ll);
+                if (!(f > 0.0)) {
+                    //rounding at extreme |x|: the quadratic through f(0) = 0, f'(0) = 1 and f(b_l)
+                    const double t = beta / b_l;
+                    f = (f_l * t + b_l * (1.0 - t)) * t;
+                }
+                s = inverseLowerMap(x, f);
+                hi = s_l;
+                branch = Branch::LOWER;
+            } else {
+                //s(b) is concave up to the inflection point, where s'' = -b'' / b'^3 = 0
+                const double v_l = normalisedVega(x, s_l);
+                const double r_lm = rationalControlRight(b_l, b_c, s_l, s_c, 1.0 / v_l, 1.0 / v_c, 0.0, false);
+                s = rationalCubic(beta, b_l, b_c, s_l, s_c, 1.0 / v_l, 1.0 / v_c, r_lm);
+                lo = s_l;
+                hi = s_c;
+                branch = Branch::MIDDLE;
+            }
+        } else {
+            const double s_u = s_c + (b_max - b_c) / v_c;
+            const double b_u = b_max - normalisedBlackComplement(x, s_u);
+            if (beta <= b_u) {
+                const double v_u = normalisedVega(x, s_u);
+                const double r_hm = rationalControlLeft(b_c, b_u, s_c, s_u, 1.0 / v_c, 1.0 / v_u, 0.0, false);
+                s = rationalCubic(beta, b_c, b_u, s_c, s_u, 1.0 / v_c, 1.0 / v_u, r_hm);
+                lo = s_c;
+                hi = s_u;
+                branch = Branch::MIDDLE;
+            } else {
+                //interpolate the upper map between s_u (matching f'' there) and f(b_max) = 0 (slope -1/2),
+                //then invert N
+                double fp_u, fpp_u;
+                const double f_u = upperMap(x, s_u, fp_u, fpp_u);
+                double f = -1.0;
+                if (std::isfinite(fpp_u)) {
+                    const double r_hh = rationalControlLeft(b_u, b_max, f_u, 0.0, fp_u, -0.5, fpp_u, true);
+                    f = rationalCubic(beta, b_u, b_max, f_u, 0.0, fp_u, -0.5, r_hh);
+                }
+                if (!(f > 0.0)) {
+                    const double h = b_max - b_u, t = (beta - b_u) / h;
+                    f = (f_u * (1.0 - t) + 0.5 * h * t) * (1.0 - t);
+                }
+                s = -2.0 * OptionPricer::inverseNormalCDF(f);
+                lo = s_u;
+                branch = Branch::UPPER;
+            }
+        }
+        s = std::max(s, lo);
+        if (s >= hi) s = 0.5 * (lo + hi);
+    }
+
+    //Householder steps of order 3 on the branch objective g, with g', g'', g''' from
+    //b'' / b' = x^2 / s^3 - s / 4 and b''' / b' = (x^2 / s^3 - s / 4)^2 - 3 x^2 / s^4 - 1/4
+    const double log_beta = std::log(beta);
+    const double w_target = b_max - beta;
+    const double log_w_target = std::log(w_target);
+    constexpr int kMaxIterations = 10;
+    constexpr double kFinalStep = 1e-5;
+    converged = false;
+    for (iterations = 0; iterations < kMaxIterations; ) {
+        if (!(s > 0.0) || !std::isfinite(s)) break;
+        const double a = x * x / (s * s * s) - 0.25 * s;
+        const double c = a * a - 3.0 * x * x / (s * s * s * s) - 0.25;
+        double g, g1, g2, g3;
+        bool increasing;
+        if (branch == Branch::LOWER) {
+            //g = 1/ln b - 1/ln beta, nearly linear in s where b is astronomically small
+            const NormalisedBlack nb = normalisedBlack(x, s);
+            const double u = nb.logB();
+            //b'/b from logs, finite even when b and b' underflow
+            const double r1 = std::exp(-kLogSqrt2Pi - 0.5 * (x * x / (s * s) + 0.25 * s * s) - u);
+            const double r2 = r1 * a, r3 = r1 * c;
+            const double u1 = r1, u2 = r2 - r1 * r1, u3 = r3 - 3.0 * r1 * r2 + 2.0 * r1 * r1 * r1;
+            g = 1.0 / u - 1.0 / log_beta;
+            g1 = -u1 / (u * u);
+            g2 = -u2 / (u * u) + 2.0 * u1 * u1 / (u * u * u);
+            g3 = -u3 / (u * u) + 6.0 * u1 * u2 / (u * u * u) - 6.0 * u1 * u1 * u1 / (u * u * u * u);
+            increasing = false;
+        } else if (branch == Branch::UPPER) {
+            //g = ln(b_max - b) - ln(b_max - beta)
+            const double w = normalisedBlackComplement(x, s);
+            const double vega = normalisedVega(x, s);
+            const double q1 = -vega / w, q2 = q1 * a, q3 = q1 * c;
+            g = std::log(w) - log_w_target;
+            g1 = q1;
+            g2 = q2 - q1 * q1;
+            g3 = q3 - 3.0 * q1 * q2 + 2.0 * q1 * q1 * q1;
+            increasing = false;
+        } else {
+            const double vega = normalisedVega(x, s);
+            g = normalisedBlack(x, s).b - beta;
+            g1 = vega;
+            g2 = vega * a;
+            g3 = vega * c;
+            increasing = true;
+        }
+        ++iterations;
+        if ((g > 0.0) == increasing) hi = std::min(hi, s);
+        else lo = std::max(lo, s);
+        if (g == 0.0 || hi - lo <= 4.0 * DBL_EPSILON * s) {
+            //exact, or g is rounding noise from here on
+            converged = true;
+            break;
+        }
+
+        const double newton = -g / g1;
+        const double halley = g2 / g1;
+        const double hh3 = g3 / g1;
+        const double factor = (1.0 + 0.5 * halley * newton) / (1.0 + newton * (halley + hh3 * newton / 6.0));
+        const double step = newton * (factor > 0.0 && std::isfinite(factor) ? factor : 1.0);
+        if (std::abs(step) <= kFinalStep * s) {
+            //the error after a step is of order step^4, already below rounding
+            s += step;
+            converged = true;
+            break;
+        }
+        const double previous = s;
+        s += step;
+        if (!(s > lo && s < hi)) {
+            s = std::isinf(hi) ? 2.0 * previous : 0.5 * (lo + hi);
+        }
+    }
+    return s;
+}
+
+} // namespace
+
+double blackScholesExact(double S, double K, double T, double r, double sigma, OptionType type) {
+    const double F = S * std::exp(r * T);
+    const double x = std::log(F / K);
+    const double discount_sqrt = std::exp(-r * T) * std::sqrt(F * K);
+    const double s = sigma * std::sqrt(T);
+    //normalised out-of-the-money price at -|x|, the in-the-money side adds the intrinsic value
+    const double otm = s > 0.0 ? normalisedBlack(-std::abs(x), s).b : 0.0;
+    const double intrinsic = std::max(type == OptionType::CALL ? std::exp(0.5 * x) - std::exp(-0.5 * x)
+                                                               : std::exp(-0.5 * x) - std::exp(0.5 * x), 0.0);
+    return discount_sqrt * (otm + intrinsic);
+}
+
+ImpliedVolResult solveImpliedVolRational(double price, double S, double K, double T, double r, OptionType type) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    ImpliedVolResult result{nan, 0, false, ImpliedVolStatus::INVALID_INPUT};
+    if (!(S > 0.0 && K > 0.0 && T > 0.0 && price >= 0.0)) return result;
+
+    //normalise: undiscounted price over sqrt(F K), so only x and s remain
+    const double F = S * std::exp(r * T);
+    const double x = std::log(F / K);
+    const double beta = price * std::exp(r * T) / std::sqrt(F * K);
+    const double theta = type == OptionType::CALL ? 1.0 : -1.0;
+    const double b_max = std::exp(0.5 * theta * x);
+    const double intrinsic = std::max(theta * (std::exp(0.5 * x) - std::exp(-0.5 * x)), 0.0);
+
+    //the out-of-the-money call at -|x|: parity subtracts the intrinsic value, symmetry flips the put
+    //a price quoted at exactly the intrinsic value can land a few ulps under it after normalising
+    double beta_otm = beta - intrinsic;
+    if (beta_otm < 0.0 && beta_otm >= -4.0 * DBL_EPSILON * (std::exp(0.5 * x) + std::exp(-0.5 * x))) beta_otm = 0.0;
+    if (beta_otm < 0.0) {
+        result.status = ImpliedVolStatus::BELOW_INTRINSIC;
+        return result;
+    }
+    if (beta >= b_max) {
+        result.status = ImpliedVolStatus::ABOVE_MAXIMUM;
+        return result;
+    }
+    if (beta_otm == 0.0) {
+        result.vol = 0.0;
+        result.converged = true;
+    } else {
+        result.vol = solveNormalised(-std::abs(x), beta_otm, result.iterations, result.converged) / std::sqrt(T);
+    }
+    result.status = result.converged ? ImpliedVolStatus::OK : ImpliedVolStatus::NOT_CONVERGED;
+    return result;
+}
@@ -0,0 +1,50 @@
+// ImpliedVol.h
+#ifndef IMPLIED_VOL_H
+#define IMPLIED_VOL_H
+
+#include "OptionPricer.h"
+
+//why an inversion has no volatility to report
+enum class ImpliedVolStatus {
+    OK,
+    INVALID_INPUT,     //non-positive spot, strike or maturity, or a negative/NaN price
+    BELOW_INTRINSIC,   //price under the discounted intrinsic value, no volatility reaches it
+    ABOVE_MAXIMUM,     //price at or over the sigma -> infinity limit (S for calls, K e^(-rT) for puts)
+    NOT_CONVERGED      //iteration limit hit, vol holds the best estimate
+};
+
+//"ok", "invalid_input", "below_intrinsic", "above_maximum" or "not_converged"
+const char* impliedVolStatusName(ImpliedVolStatus status);
+
+//outcome of one implied volatility inversion
+struct ImpliedVolResult {
+    double vol;       //NaN when the price is outside the no-arbitrage bounds
+    int iterations;   //black-scholes evaluations used
+    bool converged;   //status == OK
+    ImpliedVolStatus status;
+};
+
+//black-scholes implied volatility on plain parameters: no OptionPricer, no allocation, no RNG
+//starts from the Corrado-Miller guess (Brenner-Subrahmanyam if that fails) and takes Halley steps
+//(Newton when the curvature term is unreliable) inside a bracket that shrinks with every
+//evaluation, bisecting whenever a step would leave it. The out-of-the-money side is solved,
+//the other side is converted with put-call parity
+//tolerance is on the price difference, like OptionPricer::impliedVolatility
+ImpliedVolResult solveImpliedVol(double price, double S, double K, double T, double r, OptionType type,
+                                 double tolerance = 1e-10, int max_iter = 50);
+
+//implied volatility to near machine precision, in the style of Jaeckel's "Let's Be Rational" (2015)
+//works on the normalised Black function b(x, s), x = ln(F/K), s = sigma sqrt(T), evaluated with
+//erfc, a cancellation-free series and a Taylor expansion for small s and |x| instead of normalCDF.
+//The initial guess is a rational cubic (Delbourgo-Gregory) interpolation on one of four branches
+//around the inflection point s = sqrt(2|x|), taken through Jaeckel's lower and upper maps at the
+//extremes so it is exact in the limits. Householder steps of order 3 on a branch-specific objective
+//(1/ln b deep out of the money, ln(b_max - b) near the upper limit) then finish it in at most two
+//iterations (reported as iterations, the two branch-locating evaluations are not counted)
+ImpliedVolResult solveImpliedVolRational(double price, double S, double K, double T, double r, OptionType type);
+
+//black-scholes price with an accurate normal CDF (erfc based), the function solveImpliedVolRational
+//inverts. Agrees with blackScholes() to ~1e-15 with the default Cody CDF, ~1e-7 with HornerCdf
+double blackScholesExact(double S, double K, double T, double r, double sigma, OptionType type);
+
+#endif // IMPLIED_VOL_H
@@ -0,0 +1,301 @@
+//SimdMath.h first: its -Wpsabi suppression has to come before the Payoff.h policies that get
+//instantiated on vector types
+#include "SimdMath.h"
+#include "Lattice.h"
+#include "Payoff.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+//one tree: node i at step n is S u^i d^(n-i) (binomial, n + 1 nodes) or S u^(i-n) (trinomial, 2n + 1 nodes)
+//the branch probabilities already include the one-step discount
+struct Tree {
+    int branches;
+    double dt;
+    double u, d;
+    double pu, pm, pd;
+    double back;  //node price at (i, n - 1) over node price at (i, n)
+};
+
+static Tree buildTree(LatticeModel model, double S, double K, double T, double r, double sigma, unsigned steps) {
+    Tree t;
+    t.dt = T / steps;
+    const double disc = std::exp(-r * t.dt), growth = std::exp(r * t.dt);
+    switch (model) {
+        case LatticeModel::CRR: {
+            t.branches = 2;
+            t.u = std::exp(sigma * std::sqrt(t.dt));
+            t.d = 1.0 / t.u;
+            const double p = (growth - t.d) / (t.u - t.d);
+            t.pu = disc * p;
+            t.pm = 0.0;
+            t.pd = disc * (1.0 - p);
+            t.back = 1.0 / t.d;
+            break;
+        }
+        case LatticeModel::LEISEN_REIMER: {
+            //Peizer-Pratt method 2 inversion: the probabilities of finishing above the strike under the
+            //risk-neutral and the stock measure match N(d2) and N(d1)
+            auto h = [steps](double z) {
+                const double n = steps;
+                const double a = z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+                const double root = 0.5 * std::sqrt(1.0 - std::exp(-a * a * (n + 1.0 / 6.0)));
+                return z < 0.0 ? 0.5 - root : 0.5 + root;
+            };
+            const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
+            const double d2 = d1 - sigma * std::sqrt(T);
+            const double p = h(d2), p_stock = h(d1);
+            t.branches = 2;
+            t.u = growth * p_stock / p;
+            t.d = (growth - p * t.u) / (1.0 - p);
+            t.pu = disc * p;
+            t.pm = 0.0;
+            t.pd = disc * (1.0 - p);
+            t.back = 1.0 / t.d;
+            break;
+        }
+        case LatticeModel::TRINOMIAL:
+        default: {
+            //two binomial half steps of size dt/2 collapsed into one trinomial step
+            const double half = std::exp(r * t.dt / 2.0);
+            const double up = std::exp(sigma * std::sqrt(t.dt / 2.0)), down = 1.0 / up;
+            const double pu = (half - down) / (up - down), pd = (up - half) / (up - down);
+            t.branches = 3;
+            t.u = up * up;
+            t.d = 1.0 / t.u;
+            t.pu = disc * pu * pu;
+            t.pd = disc * pd * pd;
+            t.pm = disc * (1.0 - pu * pu - pd * pd);
+            t.back = t.u;
+            break;
+        }
+    }
+    return t;
+}
+
+static double nodePrice(const Tree& t, double S, unsigned n, unsigned i) {
+    if (t.branches == 2) {
+        return S * std::exp(i * std::log(t.u) + (static_cast<double>(n) - i) * std::log(t.d));
+    }
+    return S * std::exp((static_cast<double>(i) - n) * std::log(t.u));
+}
+
+static unsigned nodeCount(const Tree& t, unsigned n) {
+    return t.branches == 2 ? n + 1 : 2 * n + 1;
+}
+
+//european value over the last step, the Broadie-Detemple smoothing
+static double blackScholesPrice(double S, double K, double T, double r, double sigma, OptionType type) {
+    const double sd = sigma * std::sqrt(T);
+    const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / sd;
+    const double d2 = d1 - sd;
+    const double K_disc = K * std::exp(-r * T);
+    return type == OptionType::CALL ? S * OptionPricer::normalCDF(d1) - K_disc * OptionPricer::normalCDF(d2)
+                                    : K_disc * OptionPricer::normalCDF(-d2) - S * OptionPricer::normalCDF(-d1);
+}
+
+//----- backward induction -----
+
+//steps n = from .. to + 1 back to step to, in place: node i of step n - 1 reads nodes i .. i + branches - 1 of
+//step n, so walking i upwards never overwrites a value that is still needed. American trees also step
+//the node prices back (s[i] *= back) and take the exercise value where it is higher
+template <class Payoff>
+using InductionKernel = void (*)(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to);
+
+template <class V, int Branches, bool American, class Payoff>
+static OPTION_PRICER_ALWAYS_INLINE
+void nodeLanes(double* v, double* s, const Tree& t, const Payoff& payoff, size_t i) {
+    V value = t.pd * lanes::load<V>(v + i) + t.pu * lanes::load<V>(v + i + Branches - 1);
+    if constexpr (Branches == 3) {
+        value = value + t.pm * lanes::load<V>(v + i + 1);
+    }
+    if constexpr (American) {
+        const V price = lanes::load<V>(s + i) * t.back;
+        lanes::store(s + i, price);
+        const V exercise = payoff(price);
+        value = exercise > value ? exercise : value;
+    }
+    lanes::store(v + i, value);
+}
+
+template <class V, class V1, int Branches, bool American, class Payoff>
+static OPTION_PRICER_ALWAYS_INLINE
+void inductionLoop(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    constexpr size_t W = sizeof(V) / sizeof(double);
+    for (unsigned n = from; n > to; --n) {
+        const size_t count = Branches == 2 ? n : 2 * static_cast<size_t>(n) - 1;  //nodes of step n - 1
+        size_t i = 0;
+        for (; i + W <= count; i += W) nodeLanes<V, Branches, American>(v, s, t, payoff, i);
+        for (; i < count; ++i) nodeLanes<V1, Branches, American>(v, s, t, payoff, i);
+    }
+}
+
+#if OPTION_PRICER_SIMD
+
+template <class Payoff, int Branches, bool American>
+__attribute__((target("avx512f")))
+static void inductionAvx512(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    inductionLoop<simd::Vec<8>::d, simd::Vec<1>::d, Branches, American>(v, s, t, payoff, from, to);
+}
+
+template <class Payoff, int Branches, bool American>
+__attribute__((target("avx2")))
+static void inductionAvx2(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    inductionLoop<simd::Vec<4>::d, simd::Vec<1>::d, Branches, American>(v, s, t, payoff, from, to);
+}
+
+template <class Payoff, int Branches, bool American>
+static void inductionSse2(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    inductionLoop<simd::Vec<2>::d, simd::Vec<1>::d, Branches, American>(v, s, t, payoff, from, to);
+}
+
+template <class Payoff, int Branches, bool American>
+static void inductionScalar(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    inductionLoop<simd::Vec<1>::d, simd::Vec<1>::d, Branches, American>(v, s, t, payoff, from, to);
+}
+
+template <class Payoff, int Branches, bool American>
+static InductionKernel<Payoff> inductionKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return inductionAvx512<Payoff, Branches, American>;
+        case SimdLevel::AVX2:   return inductionAvx2<Payoff, Branches, American>;
+        case SimdLevel::SSE2:   return inductionSse2<Payoff, Branches, American>;
+        default:                return inductionScalar<Payoff, Branches, American>;
+    }
+}
+
+#else
+
+template <class Payoff, int Branches, bool American>
+static void inductionPortable(double* v, double* s, const Tree& t, const Payoff& payoff, unsigned from, unsigned to) {
+    inductionLoop<double, double, Branches, American>(v, s, t, payoff, from, to);
+}
+
+template <class Payoff, int Branches, bool American>
+static InductionKernel<Payoff> inductionKernelFor(SimdLevel) {
+    return inductionPortable<Payoff, Branches, American>;
+}
+
+#endif // OPTION_PRICER_SIMD
+
+template <class Payoff>
+static InductionKernel<Payoff> selectKernel(int branches, bool american) {
+    const SimdLevel level = detectSimdLevel();
+    if (branches == 2) {
+        return american ? inductionKernelFor<Payoff, 2, true>(level) : inductionKernelFor<Payoff, 2, false>(level);
+    }
+    return american ? inductionKernelFor<Payoff, 3, true>(level) : inductionKernelFor<Payoff, 3, false>(level);
+}
+
+//one tree of `steps` steps, greeks from the three nodes at `level` (2 binomial, 1 trinomial)
+//bermudan trees run the european kernel between the exercise times, rounded to the nearest step
+template <class Payoff>
+static LatticeResult runTree(LatticeModel model, double S, double K, double T, double r, double sigma,
+                             OptionType type, const Payoff& payoff, unsigned steps, ExerciseStyle exercise,
+                             const std::vector<double>& exercise_times, bool smoothing) {
+    const Tree t = buildTree(model, S, K, T, r, sigma, steps);
+    const bool american = exercise == ExerciseStyle::AMERICAN;
+    const InductionKernel<Payoff> kernel = selectKernel<Payoff>(t.branches, american);
+    const unsigned level = t.branches == 2 ? 2 : 1;
+    smoothing = smoothing && model != LatticeModel::LEISEN_REIMER;
+
+    std::vector<unsigned> dates;  //bermudan exercise steps, descending
+    if (exercise == ExerciseStyle::BERMUDAN) {
+        for (double time : exercise_times) dates.push_back(static_cast<unsigned>(std::lround(time / t.dt)));
+        std::sort(dates.begin(), dates.end(), std::greater<unsigned>());
+        dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+    }
+    auto exercisable = [&](unsigned n) { return american || std::find(dates.begin(), dates.end(), n) != dates.end(); };
+
+    //the only O(steps) state: node values and node prices of the current step
+    const unsigned start = smoothing ? steps - 1 : steps;
+    std::vector<double> v(nodeCount(t, start)), s(nodeCount(t, start));
+    const bool exercise_start = exercisable(start);
+    for (unsigned i = 0; i < v.size(); ++i) {
+        s[i] = nodePrice(t, S, start, i);
+        v[i] = smoothing ? blackScholesPrice(s[i], K, t.dt, r, sigma, type) : payoff(s[i]);
+        if (exercise_start) v[i] = std::max(v[i], payoff(s[i]));
+    }
+    //from step `from` back to step `to`, stopping at each bermudan date on the way to exercise
+    auto stepBack = [&](unsigned from, unsigned to) {
+        for (unsigned n : dates) {
+            if (n >= from || n < to) continue;
+            kernel(v.data(), s.data(), t, payoff, from, n);
+            for (unsigned i = 0; i < nodeCount(t, n); ++i) v[i] = std::max(v[i], payoff(nodePrice(t, S, n, i)));
+            from = n;
+        }
+        kernel(v.data(), s.data(), t, payoff, from, to);
+    };
+    stepBack(start, level);
+    const double Vd = v[0], Vm = v[1], Vu = v[2];
+    stepBack(level, 0);
+
+    //the three nodes at `level`, from the bottom
+    const double Sd = nodePrice(t, S, level, 0), Sm = nodePrice(t, S, level, 1), Su = nodePrice(t, S, level, 2);
+    LatticeResult out;
+    out.price = v[0];
+    out.steps = steps;
+    out.delta = (Vu - Vd) / (Su - Sd);
+    out.gamma = ((Vu - Vm) / (Su - Sm) - (Vm - Vd) / (Sm - Sd)) / (0.5 * (Su - Sd));
+    //the middle node is at the spot for CRR and the trinomial tree; Leisen-Reimer's drifts a little,
+    //so the move along delta and gamma is taken out first
+    const double move = Sm - S;
+    const double dV = Vm - out.price - out.delta * move - 0.5 * out.gamma * move * move;
+    out.theta = dV / (level * t.dt) / 365.0;
+    return out;
+}
+
+LatticeResult priceLattice(double S, double K, double T, double r, double sigma, OptionType type,
+                           const LatticeOptions& options) {
+    const bool early = options.exercise != ExerciseStyle::EUROPEAN;
+    const bool lr = options.model == LatticeModel::LEISEN_REIMER;
+    if (options.exercise == ExerciseStyle::BERMUDAN) {
+        if (options.exerciseTimes.empty()) throw std::invalid_argument("bermudan exercise needs exercise times");
+        for (double time : options.exerciseTimes) {
+            if (!(time > 0.0 && time <= T)) throw std::invalid_argument("exercise times must be in (0, T]");
+        }
+    }
+    //enough steps for the greek nodes and the half-size extrapolation tree; Leisen-Reimer needs odd counts
+    unsigned steps = std::clamp(options.steps, 8u, kMaxLatticeSteps);
+    if (lr) steps |= 1u;
+
+    auto price = [&](const auto& payoff) {
+        LatticeResult full = runTree(options.model, S, K, T, r, sigma, type, payoff, steps, options.exercise,
+                                     options.exerciseTimes, options.smoothing);
+        if (!options.richardson) {
+            return full;
+        }
+        //error ~ c / N^p: combine N and about N / 2 steps to cancel the leading term
+        const unsigned coarse_steps = lr ? (steps / 2) | 1u : steps / 2;
+        const LatticeResult coarse = runTree(options.model, S, K, T, r, sigma, type, payoff, coarse_steps,
+                                             options.exercise, options.exerciseTimes, options.smoothing);
+        //early exercise brings Leisen-Reimer back to a first order error
+        const double p = lr && !early ? 2.0 : 1.0;
+        const double wf = std::pow(double(steps), p), wc = std::pow(double(coarse_steps), p);
+        auto extrapolate = [&](double f, double c) { return (wf * f - wc * c) / (wf - wc); };
+        full.price = extrapolate(full.price, coarse.price);
+        full.delta = extrapolate(full.delta, coarse.delta);
+        full.gamma = extrapolate(full.gamma, coarse.gamma);
+        full.theta = extrapolate(full.theta, coarse.theta);
+        return full;
+    };
+    return type == OptionType::CALL ? price(CallPayoff{K}) : price(PutPayoff{K});
+}
+
+const char* latticeModelName(LatticeModel model) {
+    switch (model) {
+        case LatticeModel::CRR:           return "crr";
+        case LatticeModel::LEISEN_REIMER: return "leisen_reimer";
+        default:                          return "trinomial";
+    }
+}
+
+const char* exerciseStyleName(ExerciseStyle exercise) {
+    switch (exercise) {
+        case ExerciseStyle::EUROPEAN: return "european";
+        case ExerciseStyle::AMERICAN: return "american";
+        default:                      return "bermudan";
+    }
+}
@@ -0,0 +1,63 @@
+// Lattice.h
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <vector>
+#include "OptionPricer.h"
+
+//tree pricing for early exercise, next to OptionPricer::blackScholes for european contracts
+//backward induction runs in place on one vector of node values (plus one of node prices for the
+//exercise test), so memory is O(steps); each step is a vectorized pass over the nodes, compiled per
+//instruction set like the batch kernels
+
+enum class LatticeModel {
+    CRR,            //Cox-Ross-Rubinstein binomial, u = e^(sigma sqrt(dt))
+    LEISEN_REIMER,  //binomial centred on the strike by Peizer-Pratt inversion, odd step counts, error O(1/N^2)
+    TRINOMIAL       //up/middle/down tree of two binomial half steps (Hull), u = e^(sigma sqrt(2 dt))
+};
+
+enum class ExerciseStyle {
+    EUROPEAN,
+    AMERICAN,
+    BERMUDAN  //on LatticeOptions::exerciseTimes only (the lattice; the PDE solver rejects it)
+};
+
+struct LatticeOptions {
+    LatticeModel model = LatticeModel::LEISEN_REIMER;
+    ExerciseStyle exercise = ExerciseStyle::AMERICAN;
+    //BERMUDAN: exercise times in years, each in (0, T] and taken at the nearest step of every tree
+    std::vector<double> exerciseTimes;
+    unsigned steps = 200;  //clamped to 8..kMaxLatticeSteps, Leisen-Reimer rounds up to odd
+    //CRR and trinomial: black-scholes values one step before expiry instead of the payoff (Broadie &
+    //Detemple), which turns the oscillating O(1/N) error into a smooth one that extrapolates
+    bool smoothing = true;
+    //Richardson extrapolation from the tree with about half the steps: error order 1 for the smoothed
+    //CRR and trinomial trees and early-exercise Leisen-Reimer, 2 for european Leisen-Reimer. Costs 1.25x
+    //one tree. European prices at 200 steps land within ~1e-5 of black-scholes; with early exercise the
+    //exercise boundary crossing the nodes adds an O(1/N) oscillation that no extrapolation in N removes,
+    //so 200 steps extrapolated are only about as accurate as 2000 plain steps on average (RMS error ~1e-3
+    //per $100 of spot), and on a given contract can be worse than the plain tree
+    bool richardson = true;
+};
+
+constexpr unsigned kMaxLatticeSteps = 100000;
+
+//price plus the greeks the tree gives without re-pricing: delta and gamma from the nodes two steps
+//(binomial) or one step (trinomial) in, theta from the node back at the spot, per day like Greeks::theta
+//(vega and rho would need a second tree)
+struct LatticeResult {
+    double price;
+    double delta;
+    double gamma;
+    double theta;
+    unsigned steps;  //of the main tree
+};
+
+//throws std::invalid_argument for BERMUDAN without exercise times or with one outside (0, T]
+LatticeResult priceLattice(double S, double K, double T, double r, double sigma, OptionType type,
+                           const LatticeOptions& options = LatticeOptions{});
+
+const char* latticeModelName(LatticeModel model);
+const char* exerciseStyleName(ExerciseStyle exercise);
+
+#endif // LATTICE_H
@@ -0,0 +1,431 @@
+//SimdMath.h first: its -Wpsabi suppression has to come before the Payoff.h policies that get
+//instantiated on vector types
+#include "SimdMath.h"
+#include "LongstaffSchwartz.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+//no fused multiply-add contraction, as in MonteCarlo.cpp: every SIMD width has to produce the
+//same paths and the same exercise decisions for a seed
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+    #pragma clang fp contract(off)
+#endif
+
+//----- path simulation -----
+
+//draws of one chunk are simulated kPathGroup at a time: the group reads dates x kPathGroup normals from the
+//chunk's stream, date-major, kTileDates rows per fill
+constexpr size_t kPathGroup = 256;
+constexpr unsigned kTileDates = 16;
+static_assert(kPathGroup % NormalGenerator::kGroup == 0, "group rows must keep the normal stream aligned");
+
+struct GbmSetup {
+    double logS;              //log S(0)
+    double drift, diffusion;  //log S(t_i+1) = log S(t_i) + drift + diffusion * Z
+    unsigned dates;
+    size_t paths, draws;      //draws = paths / 2 with antithetic variates
+    bool antithetic;
+};
+
+using SimulateKernel = void (*)(const GbmSetup& p, double* S, std::uint64_t seed, size_t c);
+
+template <class V>
+static OPTION_PRICER_ALWAYS_INLINE
+void simulateChunkLoop(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    constexpr size_t W = sizeof(V) / sizeof(double);
+    const size_t begin = c * AmericanPathSet::kChunkPaths;
+    const size_t end = std::min(p.draws, begin + AmericanPathSet::kChunkPaths);
+    const int sides = p.antithetic ? 2 : 1;
+    NormalGenerator normals(seed, c);
+    alignas(64) double Z[kTileDates * kPathGroup];
+    alignas(64) double logS[2][kPathGroup];
+    alignas(64) double row[kPathGroup];
+
+    for (size_t group = begin; group < end; group += kPathGroup) {
+        const size_t count = std::min(kPathGroup, end - group);
+        std::fill(logS[0], logS[0] + 2 * kPathGroup, p.logS);
+        for (unsigned d0 = 0; d0 < p.dates; d0 += kTileDates) {
+            const unsigned rows = std::min(kTileDates, p.dates - d0);
+            normals.fill(Z, rows * kPathGroup);
+            for (unsigned r = 0; r < rows; ++r) {
+                const double* z = Z + r * kPathGroup;
+                for (int side = 0; side < sides; ++side) {
+                    const double diffusion = side == 0 ? p.diffusion : -p.diffusion;
+                    for (size_t i = 0; i < kPathGroup; i += W) {
+                        const V next = lanes::load<V>(logS[side] + i) + (p.drift + diffusion * lanes::load<V>(z + i));
+                        lanes::store(logS[side] + i, next);
+                        lanes::store(row + i, lanes::exp(next));
+                    }
+                    //the twin of draw j is path draws + j
+                    double* dst = S + static_cast<size_t>(d0 + r) * p.paths + side * p.draws + group;
+                    std::memcpy(dst, row, count * sizeof(double));
+                }
+            }
+        }
+    }
+}
+
+//----- regression passes -----
+
+//one pass over a block of paths at one date: apply the exercise decision fitted for `decide`'s date,
+//discount the cashflows one date back and accumulate the normal equations at `regress`'s date
+struct LsmPass {
+    const double* init;     //maturity row on the first pass (cashflow = exercise value), null after
+    const double* decide;   //row whose decision is applied with coeff, null if there is none
+    const double* regress;  //row of the next regression, null on the last pass
+    const double* coeff;    //continuation fit in u = S/K - 1, lowest power first
+    double* cf;             //per-path cashflow, discounted to the current date
+    double df, inv_K;
+    unsigned terms;         //degree + 1
+};
+
+//sums for the Hankel normal equations over the in-the-money paths: power[k] = sum u^k (k <= 2 degree),
+//rhs[k] = sum u^k cf (k <= degree)
+struct RegressionSums {
+    double power[2 * kMaxBasisDegree + 1] = {};
+    double rhs[kMaxBasisDegree + 1] = {};
+    void add(const RegressionSums& o) {
+        for (unsigned k = 0; k <= 2 * kMaxBasisDegree; ++k) power[k] += o.power[k];
+        for (unsigned k = 0; k <= kMaxBasisDegree; ++k) rhs[k] += o.rhs[k];
+    }
+};
+
+//the sums of a block are kept in kSumLanes interleaved lanes (path i to lane i % kSumLanes) and added up
+//in order at the end, so every SIMD width adds the same numbers in the same order
+constexpr size_t kSumLanes = 8;
+constexpr size_t kRegressionBlock = 16384;  //paths per parallel task
+
+struct RegressionLanes {
+    double power[2 * kMaxBasisDegree + 1][kSumLanes] = {};
+    double rhs[kMaxBasisDegree + 1][kSumLanes] = {};
+};
+
+template <class Payoff>
+using PassKernel = RegressionSums (*)(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end);
+
+template <class V>
+static OPTION_PRICER_ALWAYS_INLINE void accumulate(double* lanes_out, const V& v) {
+    lanes::store(lanes_out, lanes::load<V>(lanes_out) + v);
+}
+
+template <class V, class Payoff>
+static OPTION_PRICER_ALWAYS_INLINE
+void passLanes(const LsmPass& p, const Payoff& payoff, size_t i, RegressionLanes& acc, size_t lane) {
+    V cf = p.init ? payoff(lanes::load<V>(p.init + i)) : lanes::load<V>(p.cf + i);
+    if (p.decide) {
+        const V s = lanes::load<V>(p.decide + i);
+        const V ex = payoff(s);
+        const V u = s * p.inv_K - 1.0;
+        V cont = V{} + p.coeff[p.terms - 1];
+        for (int k = static_cast<int>(p.terms) - 2; k >= 0; --k) cont = cont * u + p.coeff[k];
+        //out-of-the-money paths never exercise, whatever the fit says there
+        const V take = ex > cont ? ex : cf;
+        cf = ex > 0.0 ? take : cf;
+    }
+    cf = cf * p.df;
+    lanes::store(p.cf + i, cf);
+    if (p.regress) {
+        const V s = lanes::load<V>(p.regress + i);
+        const V u = s * p.inv_K - 1.0;
+        V w = payoff(s) > 0.0 ? V{} + 1.0 : V{};  //u^k on the in-the-money paths, 0 elsewhere
+        for (unsigned k = 0; k < 2 * p.terms - 1; ++k) {
+            accumulate(acc.power[k] + lane, w);
+            if (k < p.terms) accumulate(acc.rhs[k] + lane, w * cf);
+            w = w * u;
+        }
+    }
+}
+
+//V lanes at a time, then one at a time (V1) for the tail of the last block
+template <class V, class V1, class Payoff>
+static OPTION_PRICER_ALWAYS_INLINE
+RegressionSums passLoop(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    constexpr size_t W = sizeof(V) / sizeof(double);
+    RegressionLanes acc;
+    size_t i = begin;
+    for (; i + W <= end; i += W) passLanes<V>(p, payoff, i, acc, (i - begin) % kSumLanes);
+    for (; i < end; ++i) passLanes<V1>(p, payoff, i, acc, (i - begin) % kSumLanes);
+
+    RegressionSums sums;
+    if (p.regress) {
+        for (unsigned k = 0; k < 2 * p.terms - 1; ++k) {
+            for (size_t j = 0; j < kSumLanes; ++j) sums.power[k] += acc.power[k][j];
+        }
+        for (unsigned k = 0; k < p.terms; ++k) {
+            for (size_t j = 0; j < kSumLanes; ++j) sums.rhs[k] += acc.rhs[k][j];
+        }
+    }
+    return sums;
+}
+
+#if OPTION_PRICER_SIMD
+
+__attribute__((target("avx512f")))
+static void simulateAvx512(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    simulateChunkLoop<simd::Vec<8>::d>(p, S, seed, c);
+}
+
+__attribute__((target("avx2")))
+static void simulateAvx2(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    simulateChunkLoop<simd::Vec<4>::d>(p, S, seed, c);
+}
+
+static void simulateSse2(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    simulateChunkLoop<simd::Vec<2>::d>(p, S, seed, c);
+}
+
+static void simulateScalar(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    simulateChunkLoop<simd::Vec<1>::d>(p, S, seed, c);
+}
+
+static SimulateKernel simulateKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return simulateAvx512;
+        case SimdLevel::AVX2:   return simulateAvx2;
+        case SimdLevel::SSE2:   return simulateSse2;
+        default:                return simulateScalar;
+    }
+}
+
+template <class Payoff>
+__attribute__((target("avx512f")))
+static RegressionSums passAvx512(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    return passLoop<simd::Vec<8>::d, simd::Vec<1>::d>(p, payoff, begin, end);
+}
+
+template <class Payoff>
+__attribute__((target("avx2")))
+static RegressionSums passAvx2(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    return passLoop<simd::Vec<4>::d, simd::Vec<1>::d>(p, payoff, begin, end);
+}
+
+template <class Payoff>
+static RegressionSums passSse2(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    return passLoop<simd::Vec<2>::d, simd::Vec<1>::d>(p, payoff, begin, end);
+}
+
+template <class Payoff>
+static RegressionSums passScalar(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    return passLoop<simd::Vec<1>::d, simd::Vec<1>::d>(p, payoff, begin, end);
+}
+
+template <class Payoff>
+static PassKernel<Payoff> passKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return passAvx512<Payoff>;
+        case SimdLevel::AVX2:   return passAvx2<Payoff>;
+        case SimdLevel::SSE2:   return passSse2<Payoff>;
+        default:                return passScalar<Payoff>;
+    }
+}
+
+#else
+
+static void simulatePortable(const GbmSetup& p, double* S, std::uint64_t seed, size_t c) {
+    simulateChunkLoop<double>(p, S, seed, c);
+}
+
+static SimulateKernel simulateKernelFor(SimdLevel) {
+    return simulatePortable;
+}
+
+template <class Payoff>
+static RegressionSums passPortable(const LsmPass& p, const Payoff& payoff, size_t begin, size_t end) {
+    return passLoop<double, double>(p, payoff, begin, end);
+}
+
+template <class Payoff>
+static PassKernel<Payoff> passKernelFor(SimdLevel) {
+    return passPortable<Payoff>;
+}
+
+#endif // OPTION_PRICER_SIMD
+
+AmericanPathSet::AmericanPathSet(const OptionPricer& pricer, long n_sims, unsigned dates, std::uint64_t seed,
+                                 bool antithetic, unsigned max_threads)
+    : S0_(pricer.getSpot()), T_(pricer.getTimeToMaturity()), r_(pricer.getRiskFreeRate()),
+      sigma_(pricer.getVolatility()), dates_(dates), antithetic_(antithetic) {
+    const long draws = antithetic ? n_sims / 2 : n_sims;
+    if (draws < (antithetic ? 1 : 2) || dates == 0 || dates > kMaxDates) {
+        throw std::invalid_argument("AmericanPathSet needs at least 2 paths and 1 to kMaxDates exercise dates");
+    }
+    paths_ = static_cast<size_t>(antithetic ? 2 * draws : draws);
+    S_.resize(paths_ * dates_);
+
+    const double dt = T_ / dates_;
+    GbmSetup setup;
+    setup.logS = std::log(S0_);
+    setup.drift = (r_ - 0.5 * sigma_ * sigma_) * dt;
+    setup.diffusion = sigma_ * std::sqrt(dt);
+    setup.dates = dates_;
+    setup.paths = paths_;
+    setup.draws = static_cast<size_t>(draws);
+    setup.antithetic = antithetic_;
+
+    const SimulateKernel kernel = simulateKernelFor(detectSimdLevel());
+    const size_t chunks = (setup.draws + kChunkPaths - 1) / kChunkPaths;
+    double* S = S_.data();
+    ThreadPool::shared().parallelFor(chunks, [&](size_t c) {
+        kernel(setup, S, seed, c);
+    }, max_threads);
+}
+
+//Cholesky solve of the normal equations A c = rhs with A_jk = power[j + k]
+//false when the fit is not determined (too few in-the-money paths, or a singular system),
+//the date is then skipped as an exercise opportunity
+static bool solveNormalEquations(const RegressionSums& s, unsigned terms, double* coeff) {
+    if (s.power[0] < 2.0 * terms) {
+        return false;
+    }
+    double L[kMaxBasisDegree + 1][kMaxBasisDegree + 1] = {};
+    for (unsigned j = 0; j < terms; ++j) {
+        for (unsigned k = 0; k <= j; ++k) {
+            double sum = s.power[j + k];
+            for (unsigned m = 0; m < k; ++m) sum -= L[j][m] * L[k][m];
+            if (j == k) {
+                if (!(sum > 1e-13 * s.power[2 * j])) return false;
+                L[j][j] = std::sqrt(sum);
+            } else {
+                L[j][k] = sum / L[k][k];
+            }
+        }
+    }
+    double y[kMaxBasisDegree + 1];
+    for (unsigned j = 0; j < terms; ++j) {
+        double sum = s.rhs[j];
+        for (unsigned m = 0; m < j; ++m) sum -= L[j][m] * y[m];
+        y[j] = sum / L[j][j];
+    }
+    for (int j = static_cast<int>(terms) - 1; j >= 0; --j) {
+        double sum = y[j];
+        for (unsigned m = j + 1; m < terms; ++m) sum -= L[m][j] * coeff[m];
+        coeff[j] = sum / L[j][j];
+    }
+    return true;
+}
+
+template <class Payoff>
+static MonteCarloResult runLongstaffSchwartz(const AmericanPathSet& paths, const Payoff& payoff, double K,
+                                             OptionType type, unsigned terms, bool european_control,
+                                             unsigned max_threads) {
+    const size_t n = paths.paths();
+    const unsigned dates = paths.dates();
+    const double dt = paths.maturity() / dates;
+    std::vector<double> cf(n);
+    const size_t blocks = (n + kRegressionBlock - 1) / kRegressionBlock;
+    std::vector<RegressionSums> partial(blocks);
+    const PassKernel<Payoff> kernel = passKernelFor<Payoff>(detectSimdLevel());
+
+    double coeff[kMaxBasisDegree + 1] = {};
+    bool fitted = false;
+    LsmPass pass;
+    pass.init = paths.row(dates);
+    pass.coeff = coeff;
+    pass.cf = cf.data();
+    pass.df = std::exp(-paths.rate() * dt);
+    pass.inv_K = 1.0 / K;
+    pass.terms = terms;
+
+    //the pass at `date` applies the decision fitted there on the previous pass, discounts to the
+    //date before, and regresses there; the last one leaves every cashflow discounted to t = 0
+    for (unsigned date = dates; date >= 1; --date) {
+        pass.decide = fitted ? paths.row(date) : nullptr;
+        pass.regress = date > 1 ? paths.row(date - 1) : nullptr;
+        ThreadPool::shared().parallelFor(blocks, [&](size_t b) {
+            partial[b] = kernel(pass, payoff, b * kRegressionBlock, std::min(n, (b + 1) * kRegressionBlock));
+        }, max_threads);
+        pass.init = nullptr;
+        if (pass.regress) {
+            RegressionSums total;
+            for (const RegressionSums& p : partial) {
+                total.add(p);
+            }
+            fitted = solveNormalEquations(total, terms, coeff);
+        }
+    }
+
+    //samples are antithetic pair averages, the control is the discounted european payoff on the same path
+    const size_t draws = paths.antithetic() ? n / 2 : n;
+    const double discount = std::exp(-paths.rate() * paths.maturity());
+    const double european = OptionPricer(paths.spot(), K, paths.maturity(), paths.rate(), paths.volatility())
+                                .blackScholes(type);
+    const double* ST = paths.row(dates);
+    auto sample = [&](size_t j) { return paths.antithetic() ? 0.5 * (cf[j] + cf[draws + j]) : cf[j]; };
+    auto control = [&](size_t j) {
+        const double x = paths.antithetic() ? 0.5 * (payoff(ST[j]) + payoff(ST[draws + j])) : payoff(ST[j]);
+        return discount * x - european;
+    };
+
+    //everything is in memory, so plain two-pass moments
+    double mean_y = 0.0, mean_x = 0.0, mean_raw = 0.0;
+    for (size_t j = 0; j < draws; ++j) {
+        mean_y += sample(j);
+        if (european_control) mean_x += control(j);
+    }
+    for (size_t j = 0; j < n; ++j) mean_raw += cf[j];
+    mean_y /= draws;
+    mean_x /= draws;
+    mean_raw /= n;
+    double var_y = 0.0, var_x = 0.0, cov_xy = 0.0, var_raw = 0.0;
+    for (size_t j = 0; j < draws; ++j) {
+        const double dy = sample(j) - mean_y;
+        var_y += dy * dy;
+        if (european_control) {
+            const double dx = control(j) - mean_x;
+            var_x += dx * dx;
+            cov_xy += dx * dy;
+        }
+    }
+    for (size_t j = 0; j < n; ++j) var_raw += (cf[j] - mean_raw) * (cf[j] - mean_raw);
+    const double bessel = draws > 1 ? 1.0 / (draws - 1.0) : 0.0;
+    var_y *= bessel;
+    var_x *= bessel;
+    cov_xy *= bessel;
+    var_raw = n > 1 ? var_raw / (n - 1.0) : 0.0;
+
+    double estimate = mean_y;
+    double variance = var_y;
+    if (european_control && var_x > 0.0) {
+        const double b = cov_xy / var_x;
+        estimate = mean_y - b * mean_x;  //E[X] = 0 after centring
+        variance = std::max(var_y - cov_xy * b, 0.0);
+    }
+
+    MonteCarloResult result;
+    result.price = estimate;
+    result.stdError = std::sqrt(variance / draws);
+    result.paths = static_cast<long>(n);
+    const double var_estimator = variance / draws;
+    result.varianceReductionFactor = var_estimator > 0.0 ? (var_raw / n) / var_estimator : 1.0;
+    //exercising right away is one more choice the holder has
+    const double intrinsic = payoff(paths.spot());
+    if (intrinsic > result.price) {
+        result.price = intrinsic;
+        result.stdError = 0.0;
+    }
+    result.ciLow = result.price - kConfidenceZ95 * result.stdError;
+    result.ciHigh = result.price + kConfidenceZ95 * result.stdError;
+    return result;
+}
+
+MonteCarloResult priceAmerican(const AmericanPathSet& paths, double K, OptionType type, unsigned degree,
+                               bool european_control, unsigned max_threads) {
+    const unsigned terms = std::clamp(degree, 1u, kMaxBasisDegree) + 1;
+    return type == OptionType::CALL
+        ? runLongstaffSchwartz(paths, CallPayoff{K}, K, type, terms, european_control, max_threads)
+        : runLongstaffSchwartz(paths, PutPayoff{K}, K, type, terms, european_control, max_threads);
+}
+
+MonteCarloResult monteCarloAmerican(const OptionPricer& pricer, OptionType type, long n_sims, std::uint64_t seed,
+                                    unsigned dates, VarianceReduction vr, unsigned degree, unsigned max_threads) {
+    const bool antithetic = vr == VarianceReduction::ANTITHETIC || vr == VarianceReduction::BOTH;
+    const bool control = vr == VarianceReduction::CONTROL_VARIATE || vr == VarianceReduction::BOTH;
+    AmericanPathSet paths(pricer, n_sims, dates, seed, antithetic, max_threads);
+    return priceAmerican(paths, pricer.getStrike(), type, degree, control, max_threads);
+}
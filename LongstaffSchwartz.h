@@ -0,0 +1,68 @@
+// LongstaffSchwartz.h
+#ifndef LONGSTAFF_SCHWARTZ_H
+#define LONGSTAFF_SCHWARTZ_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MonteCarlo.h"
+
+//GBM paths of one underlying sampled on the exercise dates t_i = i T / dates (i = 1..dates),
+//stored SoA: row(i) holds S(t_i) of every path contiguously, which is what the regression at date i
+//streams through. Simulated once in parallel and then priced for any number of strikes and option
+//types with priceAmerican, so a strike ladder shares one simulation
+//
+//every kAmericanChunkPaths draws use their own Philox stream, so the paths depend only on the seed
+//with antithetic variates the twin of path j is path j + paths() / 2
+class AmericanPathSet {
+public:
+    static constexpr unsigned kMaxDates = 2000;
+    static constexpr long kChunkPaths = 4096;  //draws per Philox stream
+
+    //throws std::invalid_argument for fewer than 2 paths, no dates or more than kMaxDates
+    AmericanPathSet(const OptionPricer& pricer, long n_sims, unsigned dates, std::uint64_t seed,
+                    bool antithetic = true, unsigned max_threads = 0);
+
+    //S(t_date) of every path, date in 1..dates()
+    const double* row(unsigned date) const { return S_.data() + static_cast<size_t>(date - 1) * paths_; }
+
+    size_t paths() const { return paths_; }
+    unsigned dates() const { return dates_; }
+    bool antithetic() const { return antithetic_; }
+    double spot() const { return S0_; }
+    double maturity() const { return T_; }
+    double rate() const { return r_; }
+    double volatility() const { return sigma_; }
+    size_t bytes() const { return S_.size() * sizeof(double); }
+
+private:
+    double S0_, T_, r_, sigma_;
+    size_t paths_;
+    unsigned dates_;
+    bool antithetic_;
+    std::vector<double> S_;  //dates x paths, row-major
+};
+
+constexpr unsigned kMaxBasisDegree = 5;
+
+//Longstaff & Schwartz (2001) least-squares Monte Carlo for an American (Bermudan on the path dates) option.
+//Backwards from maturity, the discounted realized cashflow of the in-the-money paths is regressed on
+//1, u, .., u^degree with u = S/K - 1, and a path exercises where the exercise value beats the fitted
+//continuation. Each date is one parallel pass over the cashflows: it applies the previous date's
+//decision, discounts, and accumulates the Hankel normal equations of the next date per block of paths;
+//the block sums are added in block order and the (degree+1)^2 system solved by Cholesky, so the price
+//only depends on the paths. Exercise at t = 0 is allowed (price >= intrinsic value).
+//The same paths fit and value the policy, a small upward bias well inside the standard error at ~1e5 paths.
+//european_control uses the discounted european payoff on the same paths as a control variate (its mean is
+//the black-scholes price), which removes most of the variance
+//degree is clamped to 1..kMaxBasisDegree
+MonteCarloResult priceAmerican(const AmericanPathSet& paths, double K, OptionType type, unsigned degree = 3,
+                               bool european_control = true, unsigned max_threads = 0);
+
+//simulate and price one contract (the pricer's strike) on `dates` exercise dates
+//ANTITHETIC/BOTH simulate antithetic pairs, CONTROL_VARIATE/BOTH use the european control
+MonteCarloResult monteCarloAmerican(const OptionPricer& pricer, OptionType type, long n_sims, std::uint64_t seed,
+                                    unsigned dates = 50, VarianceReduction vr = VarianceReduction::BOTH,
+                                    unsigned degree = 3, unsigned max_threads = 0);
+
+#endif // LONGSTAFF_SCHWARTZ_H
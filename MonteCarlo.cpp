@@ -0,0 +1,1026 @@
+//SimdMath.h first: its -Wpsabi suppression has to come before the Payoff.h policies that get
+//instantiated on vector types
+#include "SimdMath.h"
+#include "MonteCarlo.h"
+#include "Heston.h"
+#include "Random.h"
+#include "QuasiRandom.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//no fused multiply-add contraction in this file, as in Random.cpp: every SIMD width has to round
+//the same way for a seed to give the same price on every CPU
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+    #pragma clang fp contract(off)
+#endif
+
+//plain sums over one block of draws (at most NormalGenerator::kBlock), short enough that
+//sum of squares minus squared sum loses nothing that matters
+//y is one estimator sample (a pair average with antithetic variates), x is the control
+//centred on its known mean so the covariance sums do not cancel catastrophically
+struct ChunkSums {
+    double sum_y = 0.0, sum_y2 = 0.0;
+    double sum_x = 0.0, sum_x2 = 0.0, sum_xy = 0.0;
+    double sum_raw = 0.0, sum_raw2 = 0.0;  //every single path payoff, for the plain-MC baseline
+};
+
+//count, means and centred second moments of the estimator samples, the controls and the single path
+//payoffs. Samples go in with Welford's update, blocks and chunks are combined with the pairwise update
+//of Chan, Golub & LeVeque: nothing grows with the path count, and a 50M path run keeps its variance
+//instead of losing it to a difference of two huge sums of squares
+struct EstimatorMoments {
+    double n = 0.0, mean_y = 0.0, mean_x = 0.0;
+    double m2_y = 0.0, m2_x = 0.0, c_xy = 0.0;
+    double n_raw = 0.0, mean_raw = 0.0, m2_raw = 0.0;
+
+    void add(double y, double x) {
+        n += 1.0;
+        const double dy = y - mean_y, dx = x - mean_x;
+        mean_y += dy / n;
+        mean_x += dx / n;
+        m2_y += dy * (y - mean_y);
+        m2_x += dx * (x - mean_x);
+        c_xy += dx * (y - mean_y);
+    }
+
+    void addRaw(double v) {
+        n_raw += 1.0;
+        const double d = v - mean_raw;
+        mean_raw += d / n_raw;
+        m2_raw += d * (v - mean_raw);
+    }
+
+    void merge(const EstimatorMoments& o) {
+        if (o.n > 0.0) {
+            const double total = n + o.n, w = n * o.n / total;
+            const double dy = o.mean_y - mean_y, dx = o.mean_x - mean_x;
+            mean_y += dy * o.n / total;
+            mean_x += dx * o.n / total;
+            m2_y += o.m2_y + dy * dy * w;
+            m2_x += o.m2_x + dx * dx * w;
+            c_xy += o.c_xy + dx * dy * w;
+            n = total;
+        }
+        if (o.n_raw > 0.0) {
+            const double total = n_raw + o.n_raw;
+            const double d = o.mean_raw - mean_raw;
+            mean_raw += d * o.n_raw / total;
+            m2_raw += o.m2_raw + d * d * n_raw * o.n_raw / total;
+            n_raw = total;
+        }
+    }
+
+    //`count` samples (`raw_count` single paths) given as plain sums
+    void merge(const ChunkSums& s, double count, double raw_count) {
+        EstimatorMoments block;
+        block.n = count;
+        block.mean_y = s.sum_y / count;
+        block.mean_x = s.sum_x / count;
+        block.m2_y = std::max(s.sum_y2 - s.sum_y * block.mean_y, 0.0);
+        block.m2_x = std::max(s.sum_x2 - s.sum_x * block.mean_x, 0.0);
+        block.c_xy = s.sum_xy - s.sum_x * block.mean_y;
+        block.n_raw = raw_count;
+        block.mean_raw = s.sum_raw / raw_count;
+        block.m2_raw = std::max(s.sum_raw2 - s.sum_raw * block.mean_raw, 0.0);
+        merge(block);
+    }
+
+    //without antithetic pairs every path payoff is an estimator sample
+    void rawFromSamples() {
+        n_raw = n;
+        mean_raw = mean_y;
+        m2_raw = m2_y;
+    }
+};
+
+//what summarize needs to turn chunk sums into a price, common to the european and path-dependent runs
+struct EstimatorSetup {
+    double discount;
+    bool use_antithetic, use_control;
+};
+
+//per-run constants shared by every chunk
+struct EuropeanSetup : EstimatorSetup {
+    double S;
+    double drift, diffusion;  //log S_T = log S + drift + diffusion * Z
+    double forward;           //E[S_T] under the risk-neutral measure
+};
+
+static EuropeanSetup makeSetup(const OptionPricer& pricer, VarianceReduction vr) {
+    const double T = pricer.getTimeToMaturity();
+    const double r = pricer.getRiskFreeRate();
+    const double sigma = pricer.getVolatility();
+    EuropeanSetup setup;
+    setup.S = pricer.getSpot();
+    setup.drift = (r - 0.5 * sigma * sigma) * T;
+    setup.diffusion = sigma * std::sqrt(T);
+    setup.discount = std::exp(-r * T);
+    setup.forward = setup.S / setup.discount;
+    setup.use_antithetic = vr == VarianceReduction::ANTITHETIC || vr == VarianceReduction::BOTH;
+    setup.use_control = vr == VarianceReduction::CONTROL_VARIATE || vr == VarianceReduction::BOTH;
+    return setup;
+}
+
+//draws [c * chunk size, end) of the run, from chunk c's own Philox stream
+template <class Payoff>
+using ChunkKernel = EstimatorMoments (*)(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws);
+
+//the sums of a block are kept in kSumLanes interleaved lanes, draw i of a block going to lane i % kSumLanes,
+//and the lanes are added up in order at the end of the block. Every SIMD width then adds the same numbers
+//in the same order, so the price for a seed does not depend on the CPU
+constexpr int kSumLanes = 8;
+
+struct LaneSums {
+    double y[kSumLanes] = {}, y2[kSumLanes] = {};
+    double x[kSumLanes] = {}, x2[kSumLanes] = {}, xy[kSumLanes] = {};
+    double raw[kSumLanes] = {}, raw2[kSumLanes] = {};
+};
+
+#if OPTION_PRICER_SIMD
+
+template <int W>
+static inline __attribute__((always_inline))
+void accumulate(double* lanes, const typename simd::Vec<W>::d& v) {
+    simd::store<W>(lanes, simd::load<W>(lanes) + v);
+}
+
+//W draws into lanes [lane, lane + W): no branch on the payoff or the variance reduction, both are
+//fixed by the instantiation, and the control sums are skipped entirely when they will not be used
+template <int W, class Payoff, bool Antithetic, bool Control>
+static inline __attribute__((always_inline))
+void pathLanes(const EuropeanSetup& p, const Payoff& payoff, const double* Z, LaneSums& acc, int lane) {
+    typedef typename simd::Vec<W>::d VD;
+    const VD z = simd::load<W>(Z);
+    VD ST = p.S * simd::exp<W>(p.drift + p.diffusion * z);
+    VD y = payoff(ST);
+    if constexpr (Antithetic) {
+        const VD ST_anti = p.S * simd::exp<W>(p.drift - p.diffusion * z);
+        const VD y_anti = payoff(ST_anti);
+        accumulate<W>(acc.raw + lane, y + y_anti);
+        accumulate<W>(acc.raw2 + lane, y * y + y_anti * y_anti);
+        y = 0.5 * (y + y_anti);
+        ST = 0.5 * (ST + ST_anti);
+    }
+    accumulate<W>(acc.y + lane, y);
+    accumulate<W>(acc.y2 + lane, y * y);
+    if constexpr (Control) {
+        const VD x = ST - p.forward;
+        accumulate<W>(acc.x + lane, x);
+        accumulate<W>(acc.x2 + lane, x * x);
+        accumulate<W>(acc.xy + lane, x * y);
+    }
+}
+
+template <int W, class Payoff, bool Antithetic, bool Control>
+static inline __attribute__((always_inline))
+EstimatorMoments chunkLoop(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    const long begin = static_cast<long>(c) * kMonteCarloChunkSize;
+    const long end = std::min(draws, begin + kMonteCarloChunkSize);
+    NormalGenerator normals(seed, c);
+    double Z[NormalGenerator::kBlock];
+    EstimatorMoments moments;
+
+    //normals are generated a block at a time, then the payoff loop streams through them,
+    //W at a time and one at a time for the last few of a short block
+    for (long block = begin; block < end; block += NormalGenerator::kBlock) {
+        const long count = std::min<long>(NormalGenerator::kBlock, end - block);
+        normals.fill(Z, static_cast<size_t>(count));
+        LaneSums acc;
+        long i = 0;
+        for (; i + W <= count; i += W) {
+            pathLanes<W, Payoff, Antithetic, Control>(p, payoff, Z + i, acc, static_cast<int>(i % kSumLanes));
+        }
+        for (; i < count; ++i) {
+            pathLanes<1, Payoff, Antithetic, Control>(p, payoff, Z + i, acc, static_cast<int>(i % kSumLanes));
+        }
+
+        ChunkSums sums;
+        for (int j = 0; j < kSumLanes; ++j) {
+            sums.sum_y += acc.y[j];   sums.sum_y2 += acc.y2[j];
+            sums.sum_x += acc.x[j];   sums.sum_x2 += acc.x2[j];   sums.sum_xy += acc.xy[j];
+            sums.sum_raw += acc.raw[j]; sums.sum_raw2 += acc.raw2[j];
+        }
+        moments.merge(sums, static_cast<double>(count), Antithetic ? 2.0 * count : 0.0);
+    }
+    if (!Antithetic) {
+        moments.rawFromSamples();
+    }
+    return moments;
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+__attribute__((target("avx512f")))
+static EstimatorMoments chunkAvx512(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    return chunkLoop<8, Payoff, Antithetic, Control>(p, payoff, seed, c, draws);
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+__attribute__((target("avx2")))
+static EstimatorMoments chunkAvx2(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    return chunkLoop<4, Payoff, Antithetic, Control>(p, payoff, seed, c, draws);
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+static EstimatorMoments chunkSse2(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    return chunkLoop<2, Payoff, Antithetic, Control>(p, payoff, seed, c, draws);
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+static EstimatorMoments chunkScalar(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    return chunkLoop<1, Payoff, Antithetic, Control>(p, payoff, seed, c, draws);
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+static ChunkKernel<Payoff> chunkKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return chunkAvx512<Payoff, Antithetic, Control>;
+        case SimdLevel::AVX2:   return chunkAvx2<Payoff, Antithetic, Control>;
+        case SimdLevel::SSE2:   return chunkSse2<Payoff, Antithetic, Control>;
+        default:                return chunkScalar<Payoff, Antithetic, Control>;
+    }
+}
+
+#else
+
+//portable fallback: the same loop one draw at a time with std::exp
+template <class Payoff, bool Antithetic, bool Control>
+static EstimatorMoments chunkPortable(const EuropeanSetup& p, const Payoff& payoff, std::uint64_t seed, size_t c, long draws) {
+    const long begin = static_cast<long>(c) * kMonteCarloChunkSize;
+    const long end = std::min(draws, begin + kMonteCarloChunkSize);
+    NormalGenerator normals(seed, c);
+    double Z[NormalGenerator::kBlock];
+    EstimatorMoments moments;
+    for (long block = begin; block < end; block += NormalGenerator::kBlock) {
+        const long count = std::min<long>(NormalGenerator::kBlock, end - block);
+        normals.fill(Z, static_cast<size_t>(count));
+        for (long i = 0; i < count; ++i) {
+            double ST = p.S * std::exp(p.drift + p.diffusion * Z[i]);
+            double y = payoff(ST);
+            if constexpr (Antithetic) {
+                const double ST_anti = p.S * std::exp(p.drift - p.diffusion * Z[i]);
+                const double y_anti = payoff(ST_anti);
+                moments.addRaw(y);
+                moments.addRaw(y_anti);
+                y = 0.5 * (y + y_anti);
+                ST = 0.5 * (ST + ST_anti);
+            }
+            moments.add(y, Control ? ST - p.forward : 0.0);
+        }
+    }
+    if (!Antithetic) {
+        moments.rawFromSamples();
+    }
+    return moments;
+}
+
+template <class Payoff, bool Antithetic, bool Control>
+static ChunkKernel<Payoff> chunkKernelFor(SimdLevel) {
+    return chunkPortable<Payoff, Antithetic, Control>;
+}
+
+#endif // OPTION_PRICER_SIMD
+
+//runtime dispatch at the API boundary: the variance reduction and the CPU pick one compiled kernel per run
+template <class Payoff>
+static ChunkKernel<Payoff> selectKernel(const EuropeanSetup& p) {
+    const SimdLevel level = detectSimdLevel();
+    if (p.use_antithetic) {
+        return p.use_control ? chunkKernelFor<Payoff, true, true>(level) : chunkKernelFor<Payoff, true, false>(level);
+    }
+    return p.use_control ? chunkKernelFor<Payoff, false, true>(level) : chunkKernelFor<Payoff, false, false>(level);
+}
+
+//price, standard error, confidence interval and variance reduction of a whole run
+static MonteCarloResult summarize(const EstimatorSetup& p, const EstimatorMoments& m) {
+    const double n = m.n;
+    const double var_y = n > 1.0 ? m.m2_y / (n - 1.0) : 0.0;
+    const double var_x = n > 1.0 ? m.m2_x / (n - 1.0) : 0.0;
+    const double cov_xy = n > 1.0 ? m.c_xy / (n - 1.0) : 0.0;
+
+    double estimate = m.mean_y;
+    double variance = var_y;
+    if (p.use_control && var_x > 0.0) {
+        //optimal coefficient b = Cov(Y, X) / Var(X); the residual variance is Var(Y) (1 - rho^2)
+        const double b = cov_xy / var_x;
+        estimate = m.mean_y - b * m.mean_x;  //E[X] = 0 after centring
+        variance = std::max(var_y - cov_xy * b, 0.0);
+    }
+
+    MonteCarloResult result;
+    result.price = p.discount * estimate;
+    result.stdError = p.discount * std::sqrt(variance / n);
+    result.paths = static_cast<long>(m.n_raw);
+    result.ciLow = result.price - kConfidenceZ95 * result.stdError;
+    result.ciHigh = result.price + kConfidenceZ95 * result.stdError;
+
+    //what plain Monte Carlo with the same number of paths would have achieved
+    const double var_raw = m.n_raw > 1.0 ? m.m2_raw / (m.n_raw - 1.0) : 0.0;
+    const double var_estimator = variance / n;
+    result.varianceReductionFactor = var_estimator > 0.0 ? (var_raw / m.n_raw) / var_estimator : 1.0;
+    return result;
+}
+
+//chunks [first, first + count) on the shared pool, kChunksPerRound at a time, every round merged into
+//total in chunk order: the partial results held at once stay bounded however many paths the run has,
+//and the merge order (so the result) does not depend on the thread count
+constexpr size_t kChunksPerRound = 256;
+
+template <class RunChunk>
+static void runChunks(size_t first, size_t count, const RunChunk& run, EstimatorMoments& total, unsigned max_threads) {
+    std::vector<EstimatorMoments> partial(std::min(count, kChunksPerRound));
+    for (size_t done = 0; done < count;) {
+        const size_t round = std::min(kChunksPerRound, count - done);
+        ThreadPool::shared().parallelFor(round, [&](size_t i) {
+            partial[i] = run(first + done + i);
+        }, max_threads);
+        for (size_t i = 0; i < round; ++i) {
+            total.merge(partial[i]);
+        }
+        done += round;
+    }
+}
+
+template <class Payoff>
+MonteCarloResult monteCarloParallel(const OptionPricer& pricer, const Payoff& payoff, long n_sims,
+                                    std::uint64_t seed, VarianceReduction vr, unsigned max_threads) {
+    const EuropeanSetup setup = makeSetup(pricer, vr);
+    const ChunkKernel<Payoff> kernel = selectKernel<Payoff>(setup);
+
+    //with antithetic variates one draw gives a pair of paths, and the pair average is one sample
+    const long draws = setup.use_antithetic ? n_sims / 2 : n_sims;
+    if (draws <= 0) {
+        return {0.0, 0.0, 0};
+    }
+    const size_t chunks = static_cast<size_t>((draws + kMonteCarloChunkSize - 1) / kMonteCarloChunkSize);
+    EstimatorMoments total;
+    runChunks(0, chunks, [&](size_t c) { return kernel(setup, payoff, seed, c, draws); }, total, max_threads);
+    return summarize(setup, total);
+}
+
+template MonteCarloResult monteCarloParallel<CallPayoff>(const OptionPricer&, const CallPayoff&, long,
+                                                         std::uint64_t, VarianceReduction, unsigned);
+template MonteCarloResult monteCarloParallel<PutPayoff>(const OptionPricer&, const PutPayoff&, long,
+                                                        std::uint64_t, VarianceReduction, unsigned);
+template MonteCarloResult monteCarloParallel<DigitalCallPayoff>(const OptionPricer&, const DigitalCallPayoff&, long,
+                                                                std::uint64_t, VarianceReduction, unsigned);
+template MonteCarloResult monteCarloParallel<DigitalPutPayoff>(const OptionPricer&, const DigitalPutPayoff&, long,
+                                                               std::uint64_t, VarianceReduction, unsigned);
+
+MonteCarloResult monteCarloParallel(const OptionPricer& pricer, OptionType type, long n_sims,
+                                    std::uint64_t seed, VarianceReduction vr, unsigned max_threads) {
+    const double K = pricer.getStrike();
+    return type == OptionType::CALL ? monteCarloParallel(pricer, CallPayoff{K}, n_sims, seed, vr, max_threads)
+                                    : monteCarloParallel(pricer, PutPayoff{K}, n_sims, seed, vr, max_threads);
+}
+
+template <class Payoff>
+static AdaptiveMonteCarloResult runAdaptive(const OptionPricer& pricer, const Payoff& payoff,
+                                            const AdaptiveOptions& options, std::uint64_t seed,
+                                            VarianceReduction vr) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const EuropeanSetup setup = makeSetup(pricer, vr);
+    const ChunkKernel<Payoff> kernel = selectKernel<Payoff>(setup);
+    //the cap in draws, chunk c always covers the same draws as in a fixed-size run with this seed
+    const long max_draws = setup.use_antithetic ? options.maxSims / 2 : options.maxSims;
+    const size_t max_chunks = static_cast<size_t>((max_draws + kMonteCarloChunkSize - 1) / kMonteCarloChunkSize);
+    const size_t round = std::max<size_t>(1, options.roundChunks);
+
+    AdaptiveMonteCarloResult out;
+    out.result = {0.0, 0.0, 0};
+    out.stop = AdaptiveStop::MAX_PATHS;
+    if (max_draws <= 0) {
+        return out;
+    }
+
+    EstimatorMoments total;
+    size_t done = 0;
+    while (done < max_chunks) {
+        const size_t count = std::min(round, max_chunks - done);
+        runChunks(done, count, [&](size_t c) { return kernel(setup, payoff, seed, c, max_draws); }, total, 0);
+        done += count;
+        out.result = summarize(setup, total);
+        const double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        if (options.targetStdError > 0.0 && out.result.stdError <= options.targetStdError) {
+            out.stop = AdaptiveStop::TARGET_REACHED;
+            break;
+        }
+        //stop when the next round would probably not fit in what is left of the budget
+        const size_t next = std::min(round, max_chunks - done);
+        if (options.timeBudgetMs > 0.0 && next > 0 && elapsed + elapsed / done * next > options.timeBudgetMs) {
+            out.stop = AdaptiveStop::TIME_BUDGET;
+            break;
+        }
+    }
+    out.elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return out;
+}
+
+AdaptiveMonteCarloResult monteCarloAdaptive(const OptionPricer& pricer, OptionType type,
+                                            const AdaptiveOptions& options, std::uint64_t seed,
+                                            VarianceReduction vr) {
+    const double K = pricer.getStrike();
+    return type == OptionType::CALL ? runAdaptive(pricer, CallPayoff{K}, options, seed, vr)
+                                    : runAdaptive(pricer, PutPayoff{K}, options, seed, vr);
+}
+
+MonteCarloResult monteCarloQMC(const OptionPricer& pricer, OptionType type, long n_sims,
+                               std::uint64_t seed, unsigned steps) {
+    const double S = pricer.getSpot();
+    const double K = pricer.getStrike();
+    const double T = pricer.getTimeToMaturity();
+    const double r = pricer.getRiskFreeRate();
+    const double sigma = pricer.getVolatility();
+    const double discount = std::exp(-r * T);
+
+    if (n_sims < static_cast<long>(kQmcReplicates)) {
+        throw std::invalid_argument("quasi-Monte Carlo needs at least " + std::to_string(kQmcReplicates) + " simulations");
+    }
+    const long points = n_sims / kQmcReplicates;  //per replicate
+
+    //the bridge turns each point's normals into W on the grid, log-price is drift * t + sigma * W(t)
+    BrownianBridge bridge(steps, T);
+    const double drift = r - 0.5 * sigma * sigma;
+    std::vector<double> replicate_price(kQmcReplicates);
+
+    //one loop per payoff policy, so the call/put choice is made once instead of per path
+    auto runReplicates = [&](const auto& payoff) {
+        ThreadPool::shared().parallelFor(kQmcReplicates, [&](size_t rep) {
+            SobolSequence sobol(steps, seed * kQmcReplicates + rep);
+            std::vector<double> u(steps), W(steps);
+            double sum = 0.0;
+            for (long i = 0; i < points; ++i) {
+                sobol.next(u.data());
+                for (unsigned d = 0; d < steps; ++d) u[d] = OptionPricer::inverseNormalCDF(u[d]);
+                bridge.buildPath(u.data(), W.data());
+                //vanilla payoff only needs the terminal value, path-dependent payoffs would read all of W
+                sum += payoff(S * std::exp(drift * T + sigma * W[steps - 1]));
+            }
+            replicate_price[rep] = discount * sum / static_cast<double>(points);
+        });
+    };
+    if (type == OptionType::CALL) {
+        runReplicates(CallPayoff{K});
+    } else {
+        runReplicates(PutPayoff{K});
+    }
+
+    //replicates are i.i.d. unbiased estimates, so the usual sample statistics apply
+    double mean = 0.0;
+    for (double p : replicate_price) mean += p;
+    mean /= kQmcReplicates;
+    double var = 0.0;
+    for (double p : replicate_price) var += (p - mean) * (p - mean);
+    var /= (kQmcReplicates - 1);
+
+    MonteCarloResult result;
+    result.price = mean;
+    result.stdError = std::sqrt(var / kQmcReplicates);
+    result.paths = points * kQmcReplicates;
+    //only 16 replicates, so the interval uses Student's t with 15 degrees of freedom
+    static_assert(kQmcReplicates == 16, "t quantile below is for 15 degrees of freedom");
+    const double t95 = 2.131449545559323;
+    result.ciLow = result.price - t95 * result.stdError;
+    result.ciHigh = result.price + t95 * result.stdError;
+    return result;
+}
+
+//----- path-dependent options -----
+
+static_assert(kExoticPathGroup % NormalGenerator::kGroup == 0, "group rows must keep the normal stream aligned");
+static_assert(kExoticChunkPaths % kExoticPathGroup == 0, "a chunk is a whole number of path groups");
+
+//per path of a block: log price, the two state values, payoff and control, per antithetic side
+constexpr size_t kExoticArraysPerSide = 5;
+//time steps of normals per tile when the cache budget allows it
+constexpr unsigned kExoticTileSteps = 16;
+
+//L2 size of the running CPU (of core 0 on Linux, 1MB if it cannot be read)
+static size_t detectL2CacheBytes() {
+    static const size_t bytes = [] {
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE)
+        const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (l2 > 0) return static_cast<size_t>(l2);
+#endif
+        return static_cast<size_t>(1) << 20;
+    }();
+    return bytes;
+}
+
+PathBlocking pathBlockingFor(size_t cache_bytes, bool antithetic) {
+    if (cache_bytes == 0) {
+        cache_bytes = detectL2CacheBytes() / 2;
+    }
+    const size_t state = kExoticArraysPerSide * (antithetic ? 2 : 1) * sizeof(double);  //per path
+    const size_t group_bytes = kExoticPathGroup * (state + kExoticTileSteps * sizeof(double));
+    const size_t max_groups = kExoticChunkPaths / kExoticPathGroup;
+    const size_t groups = std::clamp<size_t>(cache_bytes / group_bytes, 1, max_groups);
+
+    PathBlocking blocking;
+    blocking.paths = static_cast<unsigned>(groups * kExoticPathGroup);
+    //a budget too small for one full group gets shorter tiles rather than a smaller group
+    const size_t tile_bytes = cache_bytes / blocking.paths;
+    blocking.steps = static_cast<unsigned>(std::clamp<size_t>(tile_bytes > state ? (tile_bytes - state) / sizeof(double) : 1,
+                                                              1, kExoticTileSteps));
+    return blocking;
+}
+
+//per-run constants of a path-dependent run
+struct ExoticSetup : EstimatorSetup {
+    double logS;              //log S(0)
+    double drift, diffusion;  //log S(t_i+1) = log S(t_i) + drift + diffusion * Z
+    unsigned steps;
+    double control_mean;      //E[control] undiscounted, subtracted per path
+    PathBlocking blocking;
+};
+
+//products: the running state of one path is two values a and b next to its log price
+//  init(a, b, logS0)            state before the first date
+//  step(a, b, prev, next)       log prices at two consecutive dates
+//  payoff(a, b, logST)          undiscounted payoff
+//  control(a, b, logST)         control variate sample, its mean goes in ExoticSetup::control_mean
+
+//a = sum of S(t_i), b = sum of log S(t_i); the control is the geometric Asian of the same path
+template <class Payoff>
+struct ArithmeticAsianPath {
+    Payoff payoff;
+    double inv_n;
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void init(V& a, V& b, const V&) const { a = V{}; b = V{}; }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void step(V& a, V& b, const V&, const V& next) const {
+        a += lanes::exp(next);
+        b += next;
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V value(const V& a, const V&, const V&) const {
+        return payoff(a * inv_n);
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V control(const V&, const V& b, const V&) const {
+        return payoff(lanes::exp(b * inv_n));
+    }
+};
+
+//b = sum of log S(t_i), no exp per step
+template <class Payoff>
+struct GeometricAsianPath {
+    Payoff payoff;
+    double inv_n;
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void init(V& a, V& b, const V&) const { a = V{}; b = V{}; }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void step(V&, V& b, const V&, const V& next) const { b += next; }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V value(const V&, const V& b, const V&) const {
+        return payoff(lanes::exp(b * inv_n));
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V control(const V&, const V&, const V& logST) const {
+        return lanes::exp(logST);
+    }
+};
+
+//a = survival weight: 1 while the path stays on the starting side of the barrier, times the
+//Brownian-bridge probability 1 - exp(-2 d_i d_i+1 / (sigma^2 dt)) of not touching it between two dates
+//(d = log distance to the barrier) when monitoring is continuous. Knock-ins pay vanilla * (1 - a),
+//so in + out is the vanilla payoff path by path
+template <class Payoff, bool Up>
+struct BarrierPath {
+    Payoff payoff;
+    double log_barrier;
+    double bridge;  //-2 / (sigma^2 dt), 0 for discrete monitoring
+    bool knock_in;
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V distance(const V& logS) const {
+        if constexpr (Up) return log_barrier - logS;
+        else return logS - log_barrier;
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void init(V& a, V& b, const V& logS0) const {
+        a = distance(logS0) > 0.0 ? V{} + 1.0 : V{};
+        b = V{};
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void step(V& a, V&, const V& prev, const V& next) const {
+        const V d_next = distance(next);
+        if (bridge != 0.0) {
+            //both distances clamped at 0: a crossed date gives a factor of exactly 0, and a path already
+            //out (a == 0) never sees exp of a positive argument
+            const V d_prev = distance(prev);
+            const V dp = d_prev > 0.0 ? d_prev : V{};
+            const V dn = d_next > 0.0 ? d_next : V{};
+            a *= 1.0 - lanes::exp(dp * dn * bridge);
+        } else {
+            a = d_next > 0.0 ? a : V{};
+        }
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V value(const V& a, const V&, const V& logST) const {
+        const V vanilla = payoff(lanes::exp(logST));
+        return knock_in ? vanilla * (1.0 - a) : vanilla * a;
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V control(const V&, const V&, const V& logST) const {
+        return lanes::exp(logST);
+    }
+};
+
+//a = max log S, b = min log S over S(0) and the dates, shifted outwards by `shift` at the payoff
+//(0.5826 sigma sqrt(dt) for continuous monitoring)
+struct LookbackPath {
+    double K;
+    double shift;
+    bool call, floating;
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void init(V& a, V& b, const V& logS0) const { a = logS0; b = logS0; }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE void step(V& a, V& b, const V&, const V& next) const {
+        a = next > a ? next : a;
+        b = next < b ? next : b;
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V value(const V& a, const V& b, const V& logST) const {
+        V v;
+        if (floating) {
+            v = call ? lanes::exp(logST) - lanes::exp(b - shift) : lanes::exp(a + shift) - lanes::exp(logST);
+        } else {
+            v = call ? lanes::exp(a + shift) - K : K - lanes::exp(b - shift);
+        }
+        return v > 0.0 ? v : V{};
+    }
+    template <class V> OPTION_PRICER_ALWAYS_INLINE V control(const V&, const V&, const V& logST) const {
+        return lanes::exp(logST);
+    }
+};
+
+template <class Product>
+using ExoticKernel = EstimatorMoments (*)(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws);
+
+//draws [c * kExoticChunkPaths, end) of the run, p.blocking.paths paths at a time (both antithetic
+//sides share each normal). Path group g of the chunk reads its normals from
+//[g * steps * kExoticPathGroup, (g + 1) * steps * kExoticPathGroup) of the chunk's stream, step-major, so
+//the blocking only changes what is in cache together, never which normal drives which path.
+//Every step reads one row of the tile per group and updates the block's log prices and state in place,
+//V lanes at a time; the per-path payoffs then go into the moments in path order, so every lane width
+//and every blocking gives the same result
+template <class V, class Product, bool Antithetic>
+static OPTION_PRICER_ALWAYS_INLINE
+EstimatorMoments exoticChunkLoop(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    constexpr int W = static_cast<int>(sizeof(V) / sizeof(double));
+    constexpr size_t kSides = Antithetic ? 2 : 1;
+    constexpr size_t G = kExoticPathGroup;
+    const long begin = static_cast<long>(c) * kExoticChunkPaths;
+    const long end = std::min(draws, begin + kExoticChunkPaths);
+    const size_t block_paths = p.blocking.paths;
+    const unsigned tile_steps = p.blocking.steps;
+    NormalGenerator normals(seed, c);
+
+    //the working set of a block, reused by every chunk this thread runs: a tile of normals (one
+    //tile_steps x G slab per group) followed by the per-path arrays of every side
+    thread_local std::vector<double> buffer;
+    buffer.resize(block_paths * (tile_steps + kExoticArraysPerSide * kSides));
+    double* Z = buffer.data();
+    double* logS = Z + block_paths * tile_steps;
+    double* a = logS + block_paths * kSides;
+    double* b = a + block_paths * kSides;
+    double* y = b + block_paths * kSides;
+    double* x = y + block_paths * kSides;
+
+    const V logS0 = V{} + p.logS;
+    EstimatorMoments moments;
+
+    for (long block = begin; block < end; block += static_cast<long>(block_paths)) {
+        const size_t count = static_cast<size_t>(std::min<long>(static_cast<long>(block_paths), end - block));
+        const size_t groups = (count + G - 1) / G;  //a short last block still runs whole groups
+        const size_t width = groups * G;
+        const std::uint64_t first_group = static_cast<std::uint64_t>(block - begin) / G;
+        for (size_t side = 0; side < kSides; ++side) {
+            for (size_t i = 0; i < width; i += W) {
+                V va, vb;
+                product.init(va, vb, logS0);
+                const size_t k = side * block_paths + i;
+                lanes::store(logS + k, logS0);
+                lanes::store(a + k, va);
+                lanes::store(b + k, vb);
+            }
+        }
+
+        for (unsigned s0 = 0; s0 < p.steps; s0 += tile_steps) {
+            const unsigned rows = std::min(tile_steps, p.steps - s0);
+            for (size_t g = 0; g < groups; ++g) {
+                normals.seek(((first_group + g) * p.steps + s0) * G);
+                normals.fill(Z + g * rows * G, rows * G);
+            }
+            for (unsigned row = 0; row < rows; ++row) {
+                for (size_t side = 0; side < kSides; ++side) {
+                    const double diffusion = side == 0 ? p.diffusion : -p.diffusion;
+                    for (size_t g = 0; g < groups; ++g) {
+                        const double* z = Z + (g * rows + row) * G;
+                        const size_t k0 = side * block_paths + g * G;
+                        for (size_t i = 0; i < G; i += W) {
+                            const size_t k = k0 + i;
+                            const V prev = lanes::load<V>(logS + k);
+                            const V next = prev + (p.drift + diffusion * lanes::load<V>(z + i));
+                            V va = lanes::load<V>(a + k), vb = lanes::load<V>(b + k);
+                            product.step(va, vb, prev, next);
+                            lanes::store(logS + k, next);
+                            lanes::store(a + k, va);
+                            lanes::store(b + k, vb);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t side = 0; side < kSides; ++side) {
+            for (size_t i = 0; i < width; i += W) {
+                const size_t k = side * block_paths + i;
+                const V va = lanes::load<V>(a + k), vb = lanes::load<V>(b + k), vs = lanes::load<V>(logS + k);
+                lanes::store(y + k, product.value(va, vb, vs));
+                if (p.use_control) lanes::store(x + k, product.control(va, vb, vs));
+            }
+        }
+        for (size_t j = 0; j < count; ++j) {
+            double yj = y[j];
+            double xj = p.use_control ? x[j] : 0.0;
+            if constexpr (Antithetic) {
+                const double y_anti = y[block_paths + j];
+                moments.addRaw(yj);
+                moments.addRaw(y_anti);
+                yj = 0.5 * (yj + y_anti);
+                if (p.use_control) xj = 0.5 * (xj + x[block_paths + j]);
+            }
+            moments.add(yj, p.use_control ? xj - p.control_mean : 0.0);
+        }
+    }
+    if (!Antithetic) {
+        moments.rawFromSamples();
+    }
+    return moments;
+}
+
+#if OPTION_PRICER_SIMD
+
+template <class Product, bool Antithetic>
+__attribute__((target("avx512f")))
+static EstimatorMoments exoticAvx512(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    return exoticChunkLoop<simd::Vec<8>::d, Product, Antithetic>(p, product, seed, c, draws);
+}
+
+template <class Product, bool Antithetic>
+__attribute__((target("avx2")))
+static EstimatorMoments exoticAvx2(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    return exoticChunkLoop<simd::Vec<4>::d, Product, Antithetic>(p, product, seed, c, draws);
+}
+
+template <class Product, bool Antithetic>
+static EstimatorMoments exoticSse2(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    return exoticChunkLoop<simd::Vec<2>::d, Product, Antithetic>(p, product, seed, c, draws);
+}
+
+template <class Product, bool Antithetic>
+static EstimatorMoments exoticScalar(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    return exoticChunkLoop<simd::Vec<1>::d, Product, Antithetic>(p, product, seed, c, draws);
+}
+
+template <class Product, bool Antithetic>
+static ExoticKernel<Product> exoticKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return exoticAvx512<Product, Antithetic>;
+        case SimdLevel::AVX2:   return exoticAvx2<Product, Antithetic>;
+        case SimdLevel::SSE2:   return exoticSse2<Product, Antithetic>;
+        default:                return exoticScalar<Product, Antithetic>;
+    }
+}
+
+#else
+
+template <class Product, bool Antithetic>
+static EstimatorMoments exoticPortable(const ExoticSetup& p, const Product& product, std::uint64_t seed, size_t c, long draws) {
+    return exoticChunkLoop<double, Product, Antithetic>(p, product, seed, c, draws);
+}
+
+template <class Product, bool Antithetic>
+static ExoticKernel<Product> exoticKernelFor(SimdLevel) {
+    return exoticPortable<Product, Antithetic>;
+}
+
+#endif // OPTION_PRICER_SIMD
+
+template <class Product>
+static MonteCarloResult runExotic(const ExoticSetup& setup, const Product& product, long n_sims,
+                                  std::uint64_t seed, unsigned max_threads) {
+    const SimdLevel level = detectSimdLevel();
+    const ExoticKernel<Product> kernel = setup.use_antithetic ? exoticKernelFor<Product, true>(level)
+                                                              : exoticKernelFor<Product, false>(level);
+    const long draws = setup.use_antithetic ? n_sims / 2 : n_sims;
+    if (draws <= 0) {
+        return {0.0, 0.0, 0};
+    }
+    const size_t chunks = static_cast<size_t>((draws + kExoticChunkPaths - 1) / kExoticChunkPaths);
+    EstimatorMoments total;
+    runChunks(0, chunks, [&](size_t c) { return kernel(setup, product, seed, c, draws); }, total, max_threads);
+    return summarize(setup, total);
+}
+
+MonteCarloResult monteCarloExotic(const OptionPricer& pricer, const ExoticOption& option, long n_sims,
+                                  std::uint64_t seed, VarianceReduction vr, unsigned max_threads,
+                                  size_t cache_bytes) {
+    const double S = pricer.getSpot();
+    const double K = pricer.getStrike();
+    const double T = pricer.getTimeToMaturity();
+    const double r = pricer.getRiskFreeRate();
+    const double sigma = pricer.getVolatility();
+    const unsigned steps = std::clamp(option.steps, 1u, kMaxExoticSteps);
+    const double dt = T / steps;
+
+    ExoticSetup setup;
+    setup.discount = std::exp(-r * T);
+    setup.use_antithetic = vr == VarianceReduction::ANTITHETIC || vr == VarianceReduction::BOTH;
+    setup.use_control = vr == VarianceReduction::CONTROL_VARIATE || vr == VarianceReduction::BOTH;
+    setup.logS = std::log(S);
+    setup.drift = (r - 0.5 * sigma * sigma) * dt;
+    setup.diffusion = sigma * std::sqrt(dt);
+    setup.steps = steps;
+    setup.control_mean = S / setup.discount;  //E[S_T]
+    setup.blocking = pathBlockingFor(cache_bytes, setup.use_antithetic);
+
+    const bool call = option.type == OptionType::CALL;
+    const double inv_n = 1.0 / steps;
+    auto run = [&](const auto& product) { return runExotic(setup, product, n_sims, seed, max_threads); };
+
+    switch (option.kind) {
+        case ExoticKind::ASIAN:
+            if (option.average == AsianAverage::GEOMETRIC) {
+                return call ? run(GeometricAsianPath<CallPayoff>{{K}, inv_n}) : run(GeometricAsianPath<PutPayoff>{{K}, inv_n});
+            }
+            setup.control_mean = geometricAsianPrice(S, K, T, r, sigma, steps, option.type) / setup.discount;
+            return call ? run(ArithmeticAsianPath<CallPayoff>{{K}, inv_n}) : run(ArithmeticAsianPath<PutPayoff>{{K}, inv_n});
+
+        case ExoticKind::BARRIER: {
+            const double log_barrier = std::log(option.barrier);
+            const double bridge = option.continuousMonitoring ? -2.0 / (sigma * sigma * dt) : 0.0;
+            const bool up = option.barrierType == BarrierType::UP_AND_OUT || option.barrierType == BarrierType::UP_AND_IN;
+            const bool in = option.barrierType == BarrierType::UP_AND_IN || option.barrierType == BarrierType::DOWN_AND_IN;
+            if (up) {
+                return call ? run(BarrierPath<CallPayoff, true>{{K}, log_barrier, bridge, in})
+                            : run(BarrierPath<PutPayoff, true>{{K}, log_barrier, bridge, in});
+            }
+            return call ? run(BarrierPath<CallPayoff, false>{{K}, log_barrier, bridge, in})
+                        : run(BarrierPath<PutPayoff, false>{{K}, log_barrier, bridge, in});
+        }
+
+        case ExoticKind::LOOKBACK:
+        default: {
+            //beta = -zeta(1/2) / sqrt(2 pi), Broadie, Glasserman & Kou (1997)
+            const double shift = option.continuousMonitoring ? 0.5825971579390106 * sigma * std::sqrt(dt) : 0.0;
+            return run(LookbackPath{K, shift, call, option.lookback == LookbackStrike::FLOATING});
+        }
+    }
+}
+
+//----- Heston -----
+
+//Andersen's switch between the quadratic (moment-matched squared normal) and exponential (point mass
+//at zero plus exponential tail) variance steps, on psi = Var[v'] / E[v']^2
+constexpr double kQeSwitch = 1.5;
+//paths stepped together in a chunk, one fill of normals per step: kHestonPathGroup for the variance
+//then as many for the log price
+constexpr size_t kHestonPathGroup = 256;
+
+//per-run constants of monteCarloHeston, the step coefficients of the QE scheme (gamma1 = gamma2 = 1/2)
+struct HestonSetup : EstimatorSetup {
+    double logS, v0, K, forward;
+    bool call;
+    unsigned steps;
+    double theta, decay;      //E[v'] = theta + (v - theta) decay, decay = e^(-kappa dt)
+    double var_v, var_c;      //Var[v'] = v var_v + var_c
+    double rdt;
+    double k0, k1, k2, k3, k4;  //ln S' = ln S + r dt + k0 + k1 v + k2 v' + sqrt(k3 v + k4 v') Z
+    double a;                 //k2 + k4 / 2, for the martingale correction
+};
+
+//one time step of one path. k0 is replaced by -ln E[e^(a v') | v] - (k1 + k3 / 2) v, which makes
+//E[S' | S, v] = S e^(r dt) exactly; the correction does not exist for a > 1 / (2 a_quadratic) or
+//a >= beta (strong positive correlation with coarse steps), plain k0 is used there
+static inline void hestonStep(const HestonSetup& p, double& logS, double& v, double zv, double zs) {
+    const double m = p.theta + (v - p.theta) * p.decay;
+    const double psi = (v * p.var_v + p.var_c) / (m * m);
+    double next;
+    double k0 = p.k0;
+    if (psi <= kQeSwitch) {
+        const double inv = 2.0 / psi;
+        const double b2 = inv - 1.0 + std::sqrt(inv * (inv - 1.0));
+        const double a = m / (1.0 + b2);
+        const double b = std::sqrt(b2);
+        next = a * (b + zv) * (b + zv);
+        const double q = 1.0 - 2.0 * p.a * a;
+        if (q > 0.0) k0 = -(p.a * b2 * a / q - 0.5 * std::log(q)) - (p.k1 + 0.5 * p.k3) * v;
+    } else {
+        const double prob = (psi - 1.0) / (psi + 1.0);  //of v' = 0
+        const double beta = (1.0 - prob) / m;
+        const double tail = OptionPricer::normalCDF(-zv);  //1 - U, U = N(zv)
+        next = tail >= 1.0 - prob ? 0.0 : std::log((1.0 - prob) / tail) / beta;
+        if (beta > p.a) k0 = -std::log(prob + beta * (1.0 - prob) / (beta - p.a)) - (p.k1 + 0.5 * p.k3) * v;
+    }
+    logS += p.rdt + k0 + p.k1 * v + p.k2 * next + std::sqrt(std::max(p.k3 * v + p.k4 * next, 0.0)) * zs;
+    v = next;
+}
+
+//draws [c * kHestonChunkPaths, end) of the run, kHestonPathGroup paths (and their antithetic twins)
+//at a time stepping side by side through one block of normals per step
+static EstimatorMoments hestonChunk(const HestonSetup& p, std::uint64_t seed, size_t c, long draws) {
+    constexpr size_t G = kHestonPathGroup;
+    const long begin = static_cast<long>(c) * kHestonChunkPaths;
+    const long end = std::min(draws, begin + kHestonChunkPaths);
+    const size_t sides = p.use_antithetic ? 2 : 1;
+    NormalGenerator normals(seed, c);
+    double Z[2 * G];
+    double logS[2 * G], v[2 * G];
+    EstimatorMoments moments;
+
+    for (long group = begin; group < end; group += static_cast<long>(G)) {
+        const size_t count = static_cast<size_t>(std::min<long>(static_cast<long>(G), end - group));
+        std::fill(logS, logS + sides * G, p.logS);
+        std::fill(v, v + sides * G, p.v0);
+        for (unsigned step = 0; step < p.steps; ++step) {
+            normals.fill(Z, 2 * G);  //whole fills, so a short last group keeps the stream aligned
+            for (size_t side = 0; side < sides; ++side) {
+                const double sign = side == 0 ? 1.0 : -1.0;
+                for (size_t i = 0; i < count; ++i) {
+                    hestonStep(p, logS[side * G + i], v[side * G + i], sign * Z[i], sign * Z[G + i]);
+                }
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            double y = 0.0, x = 0.0;
+            for (size_t side = 0; side < sides; ++side) {
+                const double ST = std::exp(logS[side * G + i]);
+                const double payoff = p.call ? std::max(ST - p.K, 0.0) : std::max(p.K - ST, 0.0);
+                if (p.use_antithetic) moments.addRaw(payoff);
+                y += payoff;
+                x += ST - p.forward;
+            }
+            moments.add(y / sides, p.use_control ? x / sides : 0.0);
+        }
+    }
+    if (!p.use_antithetic) {
+        moments.rawFromSamples();
+    }
+    return moments;
+}
+
+MonteCarloResult monteCarloHeston(double S, double K, double T, double r, const HestonParams& params,
+                                  OptionType type, long n_sims, std::uint64_t seed, unsigned steps,
+                                  VarianceReduction vr, unsigned max_threads) {
+    if (!(S > 0.0) || !(K > 0.0) || !(T > 0.0)) {
+        throw std::invalid_argument("spot, strike and maturity must be positive");
+    }
+    validateHeston(params);
+    steps = std::clamp(steps, 1u, kMaxHestonSteps);
+    const double dt = T / steps;
+    const double kappa = params.kappa, theta = params.theta, xi = params.xi, rho = params.rho;
+
+    HestonSetup setup;
+    setup.discount = std::exp(-r * T);
+    setup.use_antithetic = vr == VarianceReduction::ANTITHETIC || vr == VarianceReduction::BOTH;
+    setup.use_control = vr == VarianceReduction::CONTROL_VARIATE || vr == VarianceReduction::BOTH;
+    setup.logS = std::log(S);
+    setup.v0 = params.v0;
+    setup.K = K;
+    setup.forward = S / setup.discount;
+    setup.call = type == OptionType::CALL;
+    setup.steps = steps;
+    setup.theta = theta;
+    setup.decay = std::exp(-kappa * dt);
+    setup.var_v = xi * xi * setup.decay * (1.0 - setup.decay) / kappa;
+    setup.var_c = theta * xi * xi * (1.0 - setup.decay) * (1.0 - setup.decay) / (2.0 * kappa);
+    setup.rdt = r * dt;
+    setup.k0 = -rho * kappa * theta * dt / xi;
+    setup.k1 = 0.5 * dt * (kappa * rho / xi - 0.5) - rho / xi;
+    setup.k2 = 0.5 * dt * (kappa * rho / xi - 0.5) + rho / xi;
+    setup.k3 = 0.5 * dt * (1.0 - rho * rho);
+    setup.k4 = setup.k3;
+    setup.a = setup.k2 + 0.5 * setup.k4;
+
+    const long draws = setup.use_antithetic ? n_sims / 2 : n_sims;
+    if (draws <= 0) {
+        return {0.0, 0.0, 0};
+    }
+    const size_t chunks = static_cast<size_t>((draws + kHestonChunkPaths - 1) / kHestonChunkPaths);
+    EstimatorMoments total;
+    runChunks(0, chunks, [&](size_t c) { return hestonChunk(setup, seed, c, draws); }, total, max_threads);
+    return summarize(setup, total);
+}
+
+double geometricAsianPrice(double S, double K, double T, double r, double sigma, unsigned steps, OptionType type) {
+    //log G = log S + (r - sigma^2/2) T (n+1)/(2n) + noise with variance sigma^2 T (n+1)(2n+1)/(6n^2)
+    const double n = static_cast<double>(std::max(steps, 1u));
+    const double mean = std::log(S) + (r - 0.5 * sigma * sigma) * T * (n + 1.0) / (2.0 * n);
+    const double variance = sigma * sigma * T * (n + 1.0) * (2.0 * n + 1.0) / (6.0 * n * n);
+    const double sd = std::sqrt(variance);
+    const double discount = std::exp(-r * T);
+    const double forward = std::exp(mean + 0.5 * variance);  //E[G]
+    const double d1 = (mean - std::log(K) + variance) / sd;
+    const double d2 = d1 - sd;
+    if (type == OptionType::CALL) {
+        return discount * (forward * OptionPricer::normalCDF(d1) - K * OptionPricer::normalCDF(d2));
+    }
+    return discount * (K * OptionPricer::normalCDF(-d2) - forward * OptionPricer::normalCDF(-d1));
+}
@@ -0,0 +1,153 @@
+// MonteCarlo.h
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include <cstddef>
+#include <cstdint>
+#include "OptionPricer.h"
+#include "Payoff.h"
+
+//outcome of a Monte Carlo run
+struct MonteCarloResult {
+    double price;     //discounted average payoff
+    double stdError;  //standard error of the price estimate
+    long paths;       //simulated terminal prices (an antithetic pair counts as two)
+    double varianceReductionFactor = 1.0;  //plain-MC variance / this estimator's variance, same path count
+    double ciLow = 0.0;   //95% confidence interval for the price
+    double ciHigh = 0.0;
+};
+
+//normal quantile for a two-sided 95% confidence interval
+constexpr double kConfidenceZ95 = 1.959963984540054;
+
+//variance reduction used by monteCarloParallel
+enum class VarianceReduction {
+    NONE,
+    ANTITHETIC,       //pair every Z with -Z
+    CONTROL_VARIATE,  //regress the payoff on the terminal stock price, whose mean S*e^(rT) is known exactly
+    BOTH              //control variate applied to antithetic pair averages
+};
+
+//the draws are cut into fixed-size chunks, each chunk uses its own Philox stream (NormalGenerator)
+//and its moments are merged in chunk order, so the price depends only on the seed,
+//never on the number of threads or how chunks were scheduled. Chunks run in bounded rounds and
+//are merged as they finish, so memory does not grow with the path count
+constexpr long kMonteCarloChunkSize = 16384;  //normal draws per chunk
+
+//parallel, deterministic european Monte Carlo on the shared thread pool
+//max_threads caps the threads used (0 = whole pool), it does not change the result.
+//The path loop is compiled once per payoff and variance reduction (and SIMD width), this picks
+//the CallPayoff or PutPayoff instantiation for type
+MonteCarloResult monteCarloParallel(const OptionPricer& pricer, OptionType type, long n_sims,
+                                    std::uint64_t seed,
+                                    VarianceReduction vr = VarianceReduction::ANTITHETIC,
+                                    unsigned max_threads = 0);
+
+//same for any terminal payoff policy from Payoff.h: the pricer supplies S, T, r and sigma,
+//the strike is the payoff's. Instantiated for CallPayoff, PutPayoff, DigitalCallPayoff and DigitalPutPayoff
+template <class Payoff>
+MonteCarloResult monteCarloParallel(const OptionPricer& pricer, const Payoff& payoff, long n_sims,
+                                    std::uint64_t seed,
+                                    VarianceReduction vr = VarianceReduction::ANTITHETIC,
+                                    unsigned max_threads = 0);
+
+//adaptive stopping for monteCarloAdaptive, a zero target/budget means "not used"
+struct AdaptiveOptions {
+    double targetStdError = 0.0;  //stop once the standard error is at or below this
+    double timeBudgetMs = 0.0;    //stop before the next round would overrun this wall-clock budget
+    long maxSims = 10000000;      //hard cap on paths, always applies
+    unsigned roundChunks = 4;     //chunks run in parallel between convergence checks
+};
+
+enum class AdaptiveStop {
+    TARGET_REACHED,
+    TIME_BUDGET,
+    MAX_PATHS
+};
+
+struct AdaptiveMonteCarloResult {
+    MonteCarloResult result;  //paths is how many were actually simulated
+    AdaptiveStop stop;
+    double elapsedMs = 0.0;
+};
+
+//runs rounds of chunks until the target standard error, the time budget or maxSims is reached.
+//Stopping on the target is deterministic for a seed (rounds are fixed chunk counts, summed in order);
+//a time-budget stop depends on machine speed
+AdaptiveMonteCarloResult monteCarloAdaptive(const OptionPricer& pricer, OptionType type,
+                                            const AdaptiveOptions& options, std::uint64_t seed,
+                                            VarianceReduction vr = VarianceReduction::ANTITHETIC);
+
+//randomized quasi-Monte Carlo: scrambled Sobol points -> inverse normal CDF -> Brownian bridge
+//n_sims is split over kQmcReplicates independently scrambled replicates (run in parallel);
+//the price is their mean and the standard error comes from their spread.
+//Each replicate runs n_sims / kQmcReplicates points (the remainder is dropped); a power of two per
+//replicate gives complete, balanced Sobol nets, other counts are run as given.
+//steps > 1 builds each path on a time grid with the bridge (up to SobolSequence::kMaxDimensions steps)
+//Throws std::invalid_argument below kQmcReplicates simulations, one point per replicate
+constexpr unsigned kQmcReplicates = 16;
+
+MonteCarloResult monteCarloQMC(const OptionPricer& pricer, OptionType type, long n_sims,
+                               std::uint64_t seed, unsigned steps = 1);
+
+//----- path-dependent options -----
+
+enum class ExoticKind { ASIAN, BARRIER, LOOKBACK };
+enum class AsianAverage { ARITHMETIC, GEOMETRIC };
+enum class BarrierType { UP_AND_OUT, UP_AND_IN, DOWN_AND_OUT, DOWN_AND_IN };
+enum class LookbackStrike {
+    FLOATING,  //call pays S_T - min S, put pays max S - S_T
+    FIXED      //call pays max(max S - K, 0), put pays max(K - min S, 0)
+};
+
+//a path-dependent contract on the pricer's underlying (its strike is K where one is needed),
+//monitored on `steps` equally spaced dates t_i = i T / steps
+struct ExoticOption {
+    ExoticKind kind = ExoticKind::ASIAN;
+    OptionType type = OptionType::CALL;
+    unsigned steps = 252;                               //1 to kMaxExoticSteps
+    AsianAverage average = AsianAverage::ARITHMETIC;    //ASIAN: call/put on the average of S(t_1) .. S(t_n)
+    BarrierType barrierType = BarrierType::UP_AND_OUT;  //BARRIER: vanilla payoff, knocked in or out at barrier
+    double barrier = 0.0;                               //must be positive for BARRIER
+    LookbackStrike lookback = LookbackStrike::FLOATING; //LOOKBACK: the extremes include S(0)
+    //correct the discrete dates towards continuous monitoring: barriers weight every step by the
+    //Brownian-bridge probability that the path did not touch the barrier between the two dates,
+    //lookbacks shift the extremes by e^(+-0.5826 sigma sqrt(dt)) (Broadie-Glasserman-Kou).
+    //false prices the discretely monitored contract
+    bool continuousMonitoring = true;
+};
+
+//paths are simulated a block at a time: each time step updates the running state of every path in the
+//block (log price, running sum / extremes / survival weight) from one SoA row of normals, so no full path
+//is ever stored and memory stays O(block) whatever the path or step count. Every kExoticChunkPaths draws
+//use their own Philox stream, and inside a chunk every kExoticPathGroup paths read their own stretch of
+//it, so like monteCarloParallel the price only depends on the seed (not the threads, CPU or blocking)
+constexpr long kExoticChunkPaths = 2048;
+constexpr unsigned kExoticPathGroup = 256;
+constexpr unsigned kMaxExoticSteps = 10000;
+
+//how a path-dependent run tiles its working set: `paths` per block (a multiple of kExoticPathGroup, at
+//most kExoticChunkPaths) step together, reading normals `steps` time steps at a time. The block's state
+//arrays plus one tile of normals are what has to stay in cache
+struct PathBlocking {
+    unsigned paths;
+    unsigned steps;
+};
+
+//largest blocking whose working set fits in cache_bytes, 0 for half of the CPU's L2
+PathBlocking pathBlockingFor(size_t cache_bytes, bool antithetic);
+
+//Monte Carlo price of a path-dependent option on the shared thread pool (max_threads as in monteCarloParallel)
+//CONTROL_VARIATE/BOTH use the geometric Asian on the same dates (closed form, geometricAsianPrice) for
+//arithmetic Asians and the terminal stock price for everything else
+//cache_bytes is the working-set budget of one block (pathBlockingFor), 0 sizes it to the L2
+MonteCarloResult monteCarloExotic(const OptionPricer& pricer, const ExoticOption& option, long n_sims,
+                                  std::uint64_t seed,
+                                  VarianceReduction vr = VarianceReduction::ANTITHETIC,
+                                  unsigned max_threads = 0, size_t cache_bytes = 0);
+
+//closed-form price of a geometric-average Asian on `steps` equally spaced dates in (0, T]:
+//the log of the average is normal, so it is black-scholes with an adjusted forward and variance
+double geometricAsianPrice(double S, double K, double T, double r, double sigma, unsigned steps, OptionType type);
+
+#endif // MONTE_CARLO_H
@@ -0,0 +1,122 @@
+// NormalCdf.h
+#ifndef NORMAL_CDF_H
+#define NORMAL_CDF_H
+
+#include <cmath>
+
+//normal CDF kernels, picked at compile time as a policy type (NormalCdf below is the pricer's)
+//every policy provides
+//  static double cdf(double x)
+//  static double cdfFromPdf(double x, double pdf)  //pdf = φ(x) already known, skips the exp
+//  static constexpr const char* name
+//SimdMath.h has the vectorized counterparts, selected with the same policy types
+
+//Abramowitz & Stegun 26.2.17 in Horner form, absolute error below 7.5e-8
+//cheapest of the three, but the error is absolute: tail probabilities under ~1e-7 are noise
+struct HornerCdf {
+    static constexpr const char* name = "horner (A&S 26.2.17)";
+
+    static double cdfFromPdf(double x, double pdf) {
+        const double k = 1.0 / (1.0 + 0.2316419 * std::abs(x));
+        const double poly = k * (0.31938153 + k * (-0.356563782 + k * (1.781477937
+                          + k * (-1.821255978 + k * 1.330274429))));
+        const double upper = pdf * poly;  //N(-|x|)
+        return x < 0.0 ? upper : 1.0 - upper;
+    }
+
+    static double cdf(double x) {
+        return cdfFromPdf(x, 0.39894228040143267794 * std::exp(-0.5 * x * x));
+    }
+};
+
+//W. J. Cody's rational Chebyshev approximations (Math. Comp. 1969, the ANORM routine of TOMS 715)
+//relative error around 1e-16 over the whole range, lower tail included
+//three pieces: a rational in x^2 for |x| <= 0.66291, e^(-x^2/2) times a rational in |x| up to
+//sqrt(32), and an asymptotic-style rational in 1/x^2 beyond
+struct CodyCdf {
+    static constexpr const char* name = "cody (rational, erfc-accurate)";
+
+    static constexpr double kA[5] = {2.2352520354606839287, 161.02823106855587881, 1067.6894854603709582,
+                                     18154.981253343561249, 0.065682337918207449113};
+    static constexpr double kB[4] = {47.20258190468824187, 976.09855173777669322, 10260.932208618978205,
+                                     45507.789335026729956};
+    static constexpr double kC[9] = {0.39894151208813466764, 8.8831497943883759412, 93.506656132177855979,
+                                     597.27027639480026226, 2494.5375852903726711, 6848.1904505362823326,
+                                     11602.651437647350124, 9842.7148383839780218, 1.0765576773720192317e-8};
+    static constexpr double kD[8] = {22.266688044328115691, 235.38790178262499861, 1519.377599407554805,
+                                     6485.558298266760755, 18615.571640885098091, 34900.952721145977266,
+                                     38912.003286093271411, 19685.429676859990727};
+    static constexpr double kP[6] = {0.21589853405795699, 0.1274011611602473639, 0.022235277870649807,
+                                     0.001421619193227893466, 2.9112874951168792e-5, 0.02307344176494017303};
+    static constexpr double kQ[5] = {1.28426009614491121, 0.468238212480865118, 0.0659881378689285515,
+                                     0.00378239633202758244, 7.29751555083966205e-5};
+    static constexpr double kCentral = 0.66291;
+    static constexpr double kTail = 5.65685424949238019520;  //sqrt(32)
+    static constexpr double kSqrt2Pi = 2.50662827463100050242;
+
+    //N(x) for |x| <= kCentral
+    static double central(double x) {
+        const double xsq = x * x;
+        double num = kA[4] * xsq, den = xsq;
+        for (int i = 0; i < 3; ++i) {
+            num = (num + kA[i]) * xsq;
+            den = (den + kB[i]) * xsq;
+        }
+        return 0.5 + x * (num + kA[3]) / (den + kB[3]);
+    }
+
+    //N(-y) / e^(-y^2/2) for y = |x| > kCentral
+    static double tailRatio(double y) {
+        if (y <= kTail) {
+            double num = kC[8] * y, den = y;
+            for (int i = 0; i < 7; ++i) {
+                num = (num + kC[i]) * y;
+                den = (den + kD[i]) * y;
+            }
+            return (num + kC[7]) / (den + kD[7]);
+        }
+        const double z = 1.0 / (y * y);
+        double num = kP[5] * z, den = z;
+        for (int i = 0; i < 4; ++i) {
+            num = (num + kP[i]) * z;
+            den = (den + kQ[i]) * z;
+        }
+        return (1.0 / kSqrt2Pi - z * (num + kP[4]) / (den + kQ[4])) / y;
+    }
+
+    static double cdfFromPdf(double x, double pdf) {
+        const double y = std::abs(x);
+        if (y <= kCentral) return central(x);
+        const double upper = pdf * kSqrt2Pi * tailRatio(y);  //N(-|x|)
+        return x < 0.0 ? upper : 1.0 - upper;
+    }
+
+    static double cdf(double x) {
+        const double y = std::abs(x);
+        if (y <= kCentral) return central(x);
+        //e^(-y^2/2) as e^(-r^2/2) e^(-(y-r)(y+r)/2) with r = y rounded down to 1/16, so the
+        //large part of the exponent is exact and the tail keeps full relative precision
+        const double r = std::trunc(y * 16.0) / 16.0;
+        const double upper = std::exp(-0.5 * r * r) * std::exp(-0.5 * (y - r) * (y + r)) * tailRatio(y);
+        return x < 0.0 ? upper : 1.0 - upper;
+    }
+};
+
+//the C library's erfc, N(x) = erfc(-x / sqrt(2)) / 2: accurate, but no use for a known density
+//and no vector form, the reference the other two are measured against
+struct ErfcCdf {
+    static constexpr const char* name = "erfc (C library)";
+
+    static double cdf(double x) { return 0.5 * std::erfc(-x * 0.70710678118654752440); }
+    static double cdfFromPdf(double x, double) { return cdf(x); }
+};
+
+//the CDF used by OptionPricer, the batch kernels and the implied vol solver
+//Cody by default, the A&S polynomial when built with -DOPTION_PRICER_FAST_CDF
+#ifdef OPTION_PRICER_FAST_CDF
+using NormalCdf = HornerCdf;
+#else
+using NormalCdf = CodyCdf;
+#endif
+
+#endif // NORMAL_CDF_H
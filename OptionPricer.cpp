@@ -1,37 +1,76 @@
 #include "OptionPricer.h"
+#include "ImpliedVol.h"
+#include "MonteCarlo.h"
+#include <cfloat>
 
 //constructor: initialize random number generator
 OptionPricer::OptionPricer(double S, double K, double T, double r, double sigma)
     : S_(S), K_(K), T_(T), r_(r), sigma_(sigma),
-      rng_(std::random_device{}()),  //produces a seed from hardware
-      normal_dist_(0.0, 1.0)         //normal distrubution with mean 0 and stddev 1
+      rng_(std::random_device{}())  //produces a seed from hardware
 {
 }
 
-//Abramowitz & Stegun approximation for Normal CDF
+//normal CDF through the NormalCdf policy picked at compile time (see NormalCdf.h)
 //CDF = cumulative distribution function
 
-double OptionPricer::normalCDF(double x) const {
-    // Constants from A&S formula 26.2.17
-    const double a1 =  0.31938153;
-    const double a2 = -0.356563782;
-    const double a3 =  1.781477937;
-    const double a4 = -1.821255978;
-    const double a5 =  1.330274429;
-    const double k = 1.0 / (1.0 + 0.2316419 * std::abs(x));
-    
-    const double cdf = 1.0 - (1.0 / std::sqrt(2.0 * M_PI)) * 
-                       std::exp(-0.5 * x * x) *
-                       (a1*k + a2*k*k + a3*k*k*k + a4*k*k*k*k + a5*k*k*k*k*k);
-    
-    return x < 0 ? 1.0 - cdf : cdf;
+double OptionPricer::normalCDF(double x) {
+    return NormalCdf::cdf(x);
+}
+
+double OptionPricer::normalCDFFromPDF(double x, double pdf) {
+    return NormalCdf::cdfFromPdf(x, pdf);
 }
 
 //normal PDF: φ(x) = (1/√2π)e^(-x²/2)
 //PDF = probability density function
 //how probability is distributed over difference values of a random variable
-double OptionPricer::normalPDF(double x) const {
-    return (1.0 / std::sqrt(2.0 * M_PI)) * std::exp(-0.5 * x * x);
+double OptionPricer::normalPDF(double x) {
+    return 0.39894228040143267794 * std::exp(-0.5 * x * x);
+}
+
+//inverse normal CDF: the x with N(x) = p, for p in (0, 1)
+//Wichura's algorithm AS241 (PPND16), relative error about 1e-16
+//a rational function near the center, and of r = sqrt(-log(p)) in the tails
+double OptionPricer::inverseNormalCDF(double p) {
+    const double q = p - 0.5;
+    if (std::abs(q) <= 0.425) {
+        const double r = 0.180625 - q * q;
+        return q * (((((((r * 2509.0809287301226727 + 33430.575583588128105) * r
+                         + 67265.770927008700853) * r + 45921.953931549871457) * r
+                         + 13731.693765509461125) * r + 1971.5909503065514427) * r
+                         + 133.14166789178437745) * r + 3.387132872796366608)
+                 / (((((((r * 5226.495278852545925 + 28729.085735721942674) * r
+                         + 39307.89580009271061) * r + 21213.794301586595867) * r
+                         + 5394.1960214247511077) * r + 687.1870074920579083) * r
+                         + 42.313330701600911252) * r + 1.0);
+    }
+
+    //tails: work with the smaller of p and 1-p
+    double r = std::sqrt(-std::log(q < 0.0 ? p : 1.0 - p));
+    double x;
+    if (r <= 5.0) {
+        r -= 1.6;
+        x = (((((((r * 7.7454501427834140764e-4 + 0.0227238449892691845833) * r
+                  + 0.24178072517745061177) * r + 1.27045825245236838258) * r
+                  + 3.64784832476320460504) * r + 5.7694972214606914055) * r
+                  + 4.6303378461565452959) * r + 1.42343711074968357734)
+          / (((((((r * 1.05075007164441684324e-9 + 5.475938084995344946e-4) * r
+                  + 0.0151986665636164571966) * r + 0.14810397642748007459) * r
+                  + 0.68976733498510000455) * r + 1.6763848301838038494) * r
+                  + 2.05319162663775882187) * r + 1.0);
+    } else {
+        //far tail, p below ~1e-11
+        r -= 5.0;
+        x = (((((((r * 2.01033439929228813265e-7 + 2.71155556874348757815e-5) * r
+                  + 0.0012426609473880784386) * r + 0.026532189526576123093) * r
+                  + 0.29656057182850489123) * r + 1.7848265399172913358) * r
+                  + 5.4637849111641143699) * r + 6.6579046435011037772)
+          / (((((((r * 2.04426310338993978564e-15 + 1.4215117583164458887e-7) * r
+                  + 1.8463183175100546818e-5) * r + 7.868691311456132591e-4) * r
+                  + 0.0148753612908506148525) * r + 0.13692988092273580531) * r
+                  + 0.59983220655588793769) * r + 1.0);
+    }
+    return q < 0.0 ? -x : x;
 }
 
 //black-Scholes formula - closed form solution
@@ -61,136 +100,98 @@ double OptionPricer::blackScholes(OptionType type) const {
 double OptionPricer::monteCarlo(OptionType type, int n_sims, bool use_antithetic) const {
     //when use_antithetic is true, we use antithetic variates to reduce variance and improve accuracy
         //this means for every random normal variable Z we generate, we also use -Z to simulate another path
-
-    double sum_payoff = 0.0; //running total of the payoffs from each simulation
-    const int actual_sims = use_antithetic ? n_sims / 2 : n_sims; //number of simulations to run
-    
-    //pre-calculate constants, so its not done for every simulation
-    const double drift = (r_ - 0.5 * sigma_ * sigma_) * T_; //growth of an option price over time
-    const double diffusion = sigma_ * std::sqrt(T_); //volatility over time - small diffusion means price stays close to expected value, vice versa
-    const double discount = std::exp(-r_ * T_); //used to convert future prices into present value
     
-    for (int i = 0; i < actual_sims; ++i) {
-        //generate random normal variable
-        double Z = normal_dist_(rng_);
-        
-        //simulate final stock price using GBM
-        double ST = S_ * std::exp(drift + diffusion * Z);
-        
-        //calculate payoff
-        double payoff;
-        if (type == OptionType::CALL) {
-            //if ST>K, then payoff is ST-K and you can buy at K and sell at ST, else 0
-            payoff = std::max(ST - K_, 0.0);
-        } else {
-            payoff = std::max(K_ - ST, 0.0);
-        }
-        sum_payoff += payoff;
-        
-        //antithetic variate: use -Z for variance reduction
-        if (use_antithetic) {
-            double ST_anti = S_ * std::exp(drift + diffusion * (-Z));
-            double payoff_anti;
-            if (type == OptionType::CALL) {
-                payoff_anti = std::max(ST_anti - K_, 0.0);
-            } else {
-                payoff_anti = std::max(K_ - ST_anti, 0.0);
-            }
-            sum_payoff += payoff_anti;
-        }
-    }
-    
-    //return discounted average
-    const int total_paths = use_antithetic ? n_sims : actual_sims;
-    return discount * (sum_payoff / total_paths); //discount * average payoff
+    //thin wrapper over the Monte Carlo kernel in MonteCarlo.cpp, which is compiled once per payoff and
+    //variance reduction so the path loop has no branches. One thread, seeded from this pricer's generator
+    const std::uint64_t seed = (std::uint64_t(rng_()) << 32) | rng_();
+    const VarianceReduction vr = use_antithetic ? VarianceReduction::ANTITHETIC : VarianceReduction::NONE;
+    return monteCarloParallel(*this, type, n_sims, seed, vr, 1).price;
 }
 
 //analytical greeks, measures of sensitivity to different things
 
 Greeks OptionPricer::calculateGreeks(OptionType type) const {
-    Greeks greeks;
-    
-    //calculate d1 and d2 (same as before)
-    const double d1 = (std::log(S_ / K_) + (r_ + 0.5 * sigma_ * sigma_) * T_) / 
-                      (sigma_ * std::sqrt(T_));
-    const double d2 = d1 - sigma_ * std::sqrt(T_);
-    
-    const double discount = std::exp(-r_ * T_);
-    const double sqrt_T = std::sqrt(T_);
+    return priceWithGreeks(S_, K_, T_, r_, sigma_, type).greeks;
+}
+
+PriceGreeks OptionPricer::priceWithGreeks(OptionType type, bool second_order) const {
+    return priceWithGreeks(S_, K_, T_, r_, sigma_, type, second_order);
+}
+
+template <class Cdf>
+PriceGreeks OptionPricer::priceWithGreeks(double S, double K, double T, double r, double sigma,
+                                          OptionType type, bool second_order) {
+    PriceGreeks out{};
+    
+    //shared intermediates: one log, one sqrt, two exps for everything below
+    const double sqrt_T = std::sqrt(T);
+    const double vol_time = sigma * sqrt_T;
+    const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / vol_time;
+    const double d2 = d1 - vol_time;
+    const double discount = std::exp(-r * T);
+    const double K_disc = K * discount;
+    
+    //φ(d2) = φ(d1) S / (K e^(-rT)), so one density gives both CDFs
+    //unless φ(d1) has underflowed, far from the money
+    const double pdf_d1 = normalPDF(d1);
+    const double pdf_d2 = pdf_d1 >= DBL_MIN ? pdf_d1 * S / K_disc : normalPDF(d2);
+    const double Nd1 = Cdf::cdfFromPdf(d1, pdf_d1);
+    const double Nd2 = Cdf::cdfFromPdf(d2, pdf_d2);
+    const bool is_call = type == OptionType::CALL;
+    
+    //put side from N(-x) = 1 - N(x)
+    out.price = is_call ? S * Nd1 - K_disc * Nd2
+                        : K_disc * (1.0 - Nd2) - S * (1.0 - Nd1);
     
     //delta: ∂V/∂S, sensitivity to stock price
-    if (type == OptionType::CALL) {
-        greeks.delta = normalCDF(d1);
-    } else {
-        greeks.delta = normalCDF(d1) - 1.0;
-    }
+    out.greeks.delta = is_call ? Nd1 : Nd1 - 1.0;
     
     //gamma: ∂²V/∂S² (same for calls and puts), sensitivity of delta to stock price
     //high gamma means delta changes rapidly with stock price, low gamma means delta is stable
-    greeks.gamma = normalPDF(d1) / (S_ * sigma_ * sqrt_T);
+    out.greeks.gamma = pdf_d1 / (S * vol_time);
     
     //vega: ∂V/∂σ (same for calls and puts), sensitivity to volatility
-    //how option price changes with every 1% volatility increase
-    greeks.vega = S_ * normalPDF(d1) * sqrt_T;
-    
-    //theta: ∂V/∂t, sensitivity to time
-    //how much value the option loses per day
-    const double theta_common = -(S_ * normalPDF(d1) * sigma_) / (2.0 * sqrt_T);
-    if (type == OptionType::CALL) {
-        greeks.theta = theta_common - r_ * K_ * discount * normalCDF(d2);
-    } else {
-        greeks.theta = theta_common + r_ * K_ * discount * normalCDF(-d2);
+    out.greeks.vega = S * pdf_d1 * sqrt_T;
+    
+    //theta: ∂V/∂t, sensitivity to time, converted to per day
+    const double theta_common = -(S * pdf_d1 * sigma) / (2.0 * sqrt_T);
+    out.greeks.theta = (is_call ? theta_common - r * K_disc * Nd2
+                                : theta_common + r * K_disc * (1.0 - Nd2)) / 365.0;
+    
+    //rho: ∂V/∂r, sensitivity to interest rate, converted to per 1% change
+    out.greeks.rho = (is_call ? K * T * discount * Nd2
+                              : -K * T * discount * (1.0 - Nd2)) / 100.0;
+    
+    if (second_order) {
+        //with no dividend yield these are the same for calls and puts
+        const double carry = (2.0 * r * T - d2 * vol_time) / (2.0 * T * vol_time);
+        out.second.vanna = -pdf_d1 * d2 / sigma;
+        out.second.volga = out.greeks.vega * d1 * d2 / sigma;
+        out.second.charm = -pdf_d1 * carry / 365.0;
+        out.second.speed = -out.greeks.gamma / S * (d1 / vol_time + 1.0);
+        out.second.zomma = out.greeks.gamma * (d1 * d2 - 1.0) / sigma;
+        out.second.color = out.greeks.gamma * (1.0 / (2.0 * T) + carry * d1) / 365.0;
     }
-    //convert to per-day
-    greeks.theta /= 365.0;
     
-    //rho: ∂V/∂r, sensitivity to interest rate
-    if (type == OptionType::CALL) {
-        greeks.rho = K_ * T_ * discount * normalCDF(d2);
-    } else {
-        greeks.rho = -K_ * T_ * discount * normalCDF(-d2);
-    }
-    //convert to per 1% change
-    greeks.rho /= 100.0;
-    
-    return greeks;
+    return out;
 }
 
-//newton-Raphson for implied volatility
-//reverse engineer volatility from market price
+template PriceGreeks OptionPricer::priceWithGreeks<HornerCdf>(double, double, double, double, double,
+                                                              OptionType, bool);
+template PriceGreeks OptionPricer::priceWithGreeks<CodyCdf>(double, double, double, double, double,
+                                                            OptionType, bool);
+template PriceGreeks OptionPricer::priceWithGreeks<ErfcCdf>(double, double, double, double, double,
+                                                            OptionType, bool);
+
+//implied volatility, reverse engineer volatility from market price
+//thin wrapper over solveImpliedVol, which works on plain parameters without building pricers
 double OptionPricer::impliedVolatility(double market_price, OptionType type, 
                                        double tolerance, int max_iter) const {
     //tolerance: how close to the market price we need to be
     //max_iter: maximum number of iterations to prevent infinite loops
-    
-    //initial guess: at the money(ATM) implied vol approximation
-    double sigma_guess = std::sqrt(2.0 * M_PI / T_) * (market_price / S_);
-    
-    for (int i = 0; i < max_iter; ++i) {
-        //create temporary pricer with guessed volatility
-        OptionPricer temp_pricer(S_, K_, T_, r_, sigma_guess);
-        
-        //calculate price and vega with current guess
-        double price = temp_pricer.blackScholes(type);
-        Greeks greeks = temp_pricer.calculateGreeks(type);
-        
-        //price difference
-        double diff = price - market_price;
-        
-        //check convergence, if within tolerance, return guess
-        if (std::abs(diff) < tolerance) {
-            return sigma_guess;
-        }
-        
-        //Newton-Raphson update: σ_new = σ_old - f(σ)/f'(σ)
-        //f(σ) = BS_price(σ) - market_price
-        //f'(σ) = vega
-        sigma_guess -= diff / greeks.vega;
-        
-        //ensure volatility stays positive
-        sigma_guess = std::max(sigma_guess, 1e-6);
-    }
-    
-    return sigma_guess;  //return best guess if didn't converge
+    return solveImpliedVol(market_price, S_, K_, T_, r_, type, tolerance, max_iter).vol;
 }
 
+ImpliedVolResult OptionPricer::impliedVolatilityRational(double market_price, OptionType type) const {
+    return solveImpliedVolRational(market_price, S_, K_, T_, r_, type);
+}
@@ -7,11 +7,14 @@
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include "NormalCdf.h"
 
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
 #endif
 
+struct ImpliedVolResult;  //ImpliedVol.h
+
 // Enum for option types - better than string comparisons
 enum class OptionType {
     CALL, //buying
@@ -27,6 +30,23 @@ struct Greeks {
     double rho;
 };
 
+//second-order sensitivities, charm and color per day like theta, the rest per unit of S or sigma
+struct SecondOrderGreeks {
+    double vanna;  //∂delta/∂σ
+    double volga;  //∂vega/∂σ (vomma)
+    double charm;  //∂delta/∂t
+    double speed;  //∂gamma/∂S
+    double zomma;  //∂gamma/∂σ
+    double color;  //∂gamma/∂t
+};
+
+//price and greeks from one evaluation of d1, d2 and the normal terms
+struct PriceGreeks {
+    double price;
+    Greeks greeks;
+    SecondOrderGreeks second;  //only filled when asked for, zero otherwise
+};
+
 // Main pricing class
 class OptionPricer {
 private:
@@ -37,16 +57,23 @@ private:
     double sigma_;  //volatility
     
     //random number generator, is a class member for efficiency
+    //seeds the bulk normal generator on each monteCarlo call
     mutable std::mt19937 rng_;
-    mutable std::normal_distribution<double> normal_dist_;
     
-    //helper: Normal CDF using polynomial approximation
-    double normalCDF(double x) const;
+public:
+    //helper: Normal CDF, the compile-time NormalCdf policy (Cody's rational approximation by default)
+    //static so the batch pricer can share it without building an OptionPricer
+    static double normalCDF(double x);
     
     //helper: Normal PDF
-    double normalPDF(double x) const;
+    static double normalPDF(double x);
+    
+    //normal CDF when the density at x is already known, saves the exp inside normalCDF
+    static double normalCDFFromPDF(double x, double pdf);
+    
+    //helper: inverse Normal CDF (quantile), turns uniform random numbers into normal ones
+    static double inverseNormalCDF(double p);
     
-public:
     //constructor with member initializer list (efficient)
     OptionPricer(double S, double K, double T, double r, double sigma);
     
@@ -59,10 +86,24 @@ public:
     //analytical Greeks (exact, not numerical approximation)
     Greeks calculateGreeks(OptionType type) const;
     
-    //implied volatility using Newton-Raphson
+    //black-Scholes price and all greeks sharing log, sqrt, exp and the normal terms,
+    //cheaper than blackScholes() + calculateGreeks() when both are needed
+    PriceGreeks priceWithGreeks(OptionType type, bool second_order = false) const;
+    
+    //same on plain parameters, no OptionPricer (or random generator) needed
+    //Cdf is the normal CDF policy from NormalCdf.h, instantiated for HornerCdf, CodyCdf and ErfcCdf
+    template <class Cdf = NormalCdf>
+    static PriceGreeks priceWithGreeks(double S, double K, double T, double r, double sigma,
+                                       OptionType type, bool second_order = false);
+    
+    //implied volatility (safeguarded Halley/Newton, see ImpliedVol.h), NaN if the price is not attainable
     double impliedVolatility(double market_price, OptionType type, 
                             double tolerance = 1e-6, int max_iter = 100) const;
     
+    //implied volatility to near machine precision with a status for unattainable prices
+    //(solveImpliedVolRational in ImpliedVol.h)
+    ImpliedVolResult impliedVolatilityRational(double market_price, OptionType type) const;
+    
     //getters
     double getSpot() const { return S_; }
     double getStrike() const { return K_; }
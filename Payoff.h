@@ -0,0 +1,53 @@
+// Payoff.h
+#ifndef PAYOFF_H
+#define PAYOFF_H
+
+#include "SimdLevel.h"
+
+//payoffs of the terminal stock price, the policy types the Monte Carlo kernels are instantiated on
+//operator() is written once for a plain double and for the SIMD vector types of SimdMath.h
+//(comparisons give lane masks there, and ?: selects per lane), so one policy serves every width
+//without a branch per path. A new payoff is a struct like these plus an explicit instantiation
+//of monteCarloParallel in MonteCarlo.cpp
+
+//max(S_T - K, 0)
+struct CallPayoff {
+    double K;
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& ST) const {
+        const V v = ST - K;
+        return v > 0.0 ? v : V{};
+    }
+};
+
+//max(K - S_T, 0)
+struct PutPayoff {
+    double K;
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& ST) const {
+        const V v = K - ST;
+        return v > 0.0 ? v : V{};
+    }
+};
+
+//cash-or-nothing call: cash if S_T > K, else 0
+struct DigitalCallPayoff {
+    double K;
+    double cash = 1.0;
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& ST) const {
+        return ST > K ? V{} + cash : V{};
+    }
+};
+
+//cash-or-nothing put: cash if S_T < K, else 0
+struct DigitalPutPayoff {
+    double K;
+    double cash = 1.0;
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& ST) const {
+        return ST < K ? V{} + cash : V{};
+    }
+};
+
+#endif // PAYOFF_H
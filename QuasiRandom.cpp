@@ -0,0 +1,164 @@
+#include "QuasiRandom.h"
+#include "Random.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+//primitive polynomials and initial direction numbers for dimensions 2..21,
+//from Joe & Kuo's new-joe-kuo-6.21201 table (dimension 1 is van der Corput)
+struct SobolInit {
+    unsigned degree;         //s
+    unsigned coefficients;   //a, inner coefficients of the polynomial
+    std::uint32_t m[7];      //initial m_1..m_s
+};
+
+const SobolInit kSobolInit[SobolSequence::kMaxDimensions - 1] = {
+    {1,  0, {1}},
+    {2,  1, {1, 3}},
+    {3,  1, {1, 3, 1}},
+    {3,  2, {1, 1, 1}},
+    {4,  1, {1, 1, 3, 3}},
+    {4,  4, {1, 3, 5, 13}},
+    {5,  2, {1, 1, 5, 5, 17}},
+    {5,  4, {1, 1, 5, 5, 5}},
+    {5,  7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6,  1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+    {7,  4, {1, 3, 7, 13, 13, 15, 69}},
+};
+
+//unscrambled direction numbers v_1..v_32 of one dimension, v_k = m_k / 2^k as a 32-bit fraction
+void directionNumbers(unsigned dim, std::uint32_t* v) {
+    std::uint32_t m[32];
+    if (dim == 0) {
+        for (int k = 0; k < 32; ++k) m[k] = 1;
+    } else {
+        const SobolInit& init = kSobolInit[dim - 1];
+        const unsigned s = init.degree;
+        for (unsigned k = 0; k < s; ++k) m[k] = init.m[k];
+        //m_k = 2^s m_{k-s} ^ m_{k-s} ^ sum_j 2^j a_j m_{k-j}
+        for (unsigned k = s; k < 32; ++k) {
+            std::uint32_t value = (m[k - s] << s) ^ m[k - s];
+            for (unsigned j = 1; j < s; ++j) {
+                if ((init.coefficients >> (s - 1 - j)) & 1u) value ^= m[k - j] << j;
+            }
+            m[k] = value;
+        }
+    }
+    for (int k = 0; k < 32; ++k) v[k] = m[k] << (31 - k);
+}
+
+//parity of the set bits
+inline std::uint32_t parity(std::uint32_t x) {
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1u;
+}
+
+} // namespace
+
+SobolSequence::SobolSequence(unsigned dims, std::uint64_t scramble_seed)
+    : dims_(dims), directions_(dims * 32), state_(dims) {
+    if (dims == 0 || dims > kMaxDimensions) {
+        throw std::invalid_argument("Sobol dimensions must be between 1 and " + std::to_string(kMaxDimensions));
+    }
+
+    for (unsigned d = 0; d < dims; ++d) {
+        //one Philox stream per dimension gives the scrambling matrix rows and the shift
+        Philox4x32 rng(scramble_seed, d);
+        std::uint32_t rows[32];
+        for (int i = 0; i < 32; i += 4) {
+            Philox4x32::Block b = rng.next();
+            for (int j = 0; j < 4; ++j) rows[i + j] = b[j];
+        }
+        const std::uint32_t shift = rng.next()[0];
+
+        //lower-triangular matrix with a unit diagonal, row i (bit 31-i of the output) mixes in
+        //only the more significant input bits, so the scrambled set is still a (t, s)-net
+        for (int i = 0; i < 32; ++i) {
+            const std::uint32_t above = i == 0 ? 0u : ~0u << (32 - i);
+            rows[i] = (rows[i] & above) | (1u << (31 - i));
+        }
+
+        std::uint32_t v[32];
+        directionNumbers(d, v);
+        for (int k = 0; k < 32; ++k) {
+            std::uint32_t scrambled = 0;
+            for (int i = 0; i < 32; ++i) scrambled |= parity(rows[i] & v[k]) << (31 - i);
+            directions_[d * 32 + k] = scrambled;
+        }
+        state_[d] = shift;  //point 0 is the shift itself
+    }
+}
+
+void SobolSequence::next(double* point) {
+    for (unsigned d = 0; d < dims_; ++d) {
+        //centre of the 2^-32 cell, so the uniform is never 0 or 1
+        point[d] = (static_cast<double>(state_[d]) + 0.5) * (1.0 / 4294967296.0);
+    }
+    //Gray-code update: flip the direction number of the lowest zero bit of the index
+    std::uint32_t c = 0;
+    for (std::uint32_t i = index_; i & 1u; i >>= 1) ++c;
+    if (c < 32) {
+        for (unsigned d = 0; d < dims_; ++d) state_[d] ^= directions_[d * 32 + c];
+    }
+    ++index_;
+}
+
+BrownianBridge::BrownianBridge(size_t steps, double T)
+    : steps_(steps), bridge_index_(steps), left_index_(steps), right_index_(steps),
+      left_weight_(steps), right_weight_(steps), std_dev_(steps) {
+    if (steps == 0) throw std::invalid_argument("Brownian bridge needs at least one step");
+
+    std::vector<double> t(steps);
+    for (size_t i = 0; i < steps; ++i) t[i] = T * static_cast<double>(i + 1) / static_cast<double>(steps);
+
+    //map marks the points already fixed; the first normal fixes the end point
+    std::vector<size_t> map(steps, 0);
+    map[steps - 1] = 1;
+    bridge_index_[0] = steps - 1;
+    std_dev_[0] = std::sqrt(t[steps - 1]);
+    left_weight_[0] = right_weight_[0] = 0.0;
+
+    for (size_t j = 0, i = 1; i < steps; ++i) {
+        //next gap [j, k), fill its midpoint l between the fixed neighbours j-1 and k
+        while (map[j]) ++j;
+        size_t k = j;
+        while (!map[k]) ++k;
+        const size_t l = j + ((k - 1 - j) >> 1);
+        map[l] = i;
+        bridge_index_[i] = l;
+        left_index_[i] = j;
+        right_index_[i] = k;
+        const double t_left = j == 0 ? 0.0 : t[j - 1];
+        left_weight_[i] = (t[k] - t[l]) / (t[k] - t_left);
+        right_weight_[i] = (t[l] - t_left) / (t[k] - t_left);
+        std_dev_[i] = std::sqrt((t[l] - t_left) * (t[k] - t[l]) / (t[k] - t_left));
+        j = k + 1;
+        if (j >= steps) j = 0;
+    }
+}
+
+void BrownianBridge::buildPath(const double* normals, double* W) const {
+    W[steps_ - 1] = std_dev_[0] * normals[0];
+    for (size_t i = 1; i < steps_; ++i) {
+        const size_t j = left_index_[i];
+        const size_t k = right_index_[i];
+        const size_t l = bridge_index_[i];
+        const double left = j == 0 ? 0.0 : W[j - 1];  //W(0) = 0
+        W[l] = left_weight_[i] * left + right_weight_[i] * W[k] + std_dev_[i] * normals[i];
+    }
+}
@@ -0,0 +1,49 @@
+// QuasiRandom.h
+#ifndef QUASI_RANDOM_H
+#define QUASI_RANDOM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//Sobol low-discrepancy sequence (Joe-Kuo direction numbers), generated in Gray-code order
+//with Matousek's random linear scrambling plus a random digital shift. Each scramble seed gives
+//an independent, unbiased randomized QMC replicate, which is what the standard error is built from
+class SobolSequence {
+public:
+    static constexpr unsigned kMaxDimensions = 21;
+
+    //throws std::invalid_argument if dims is 0 or above kMaxDimensions
+    SobolSequence(unsigned dims, std::uint64_t scramble_seed);
+
+    //next point, dims uniforms in the open interval (0, 1)
+    void next(double* point);
+
+    unsigned dimensions() const { return dims_; }
+
+private:
+    unsigned dims_;
+    std::uint32_t index_ = 0;
+    std::vector<std::uint32_t> directions_;  //32 scrambled direction numbers per dimension
+    std::vector<std::uint32_t> state_;       //current point as 32-bit fractions
+};
+
+//Brownian-bridge construction on an equally spaced time grid (Glasserman ch. 3.1, Jaeckel)
+//the first normal sets W(T), the next ones the midpoints, so the leading (best distributed)
+//Sobol dimensions carry most of the path's variance
+class BrownianBridge {
+public:
+    BrownianBridge(size_t steps, double T);
+
+    //steps independent normals -> W(t_1), ..., W(t_steps) with t_i = i*T/steps
+    void buildPath(const double* normals, double* W) const;
+
+    size_t steps() const { return steps_; }
+
+private:
+    size_t steps_;
+    std::vector<size_t> bridge_index_, left_index_, right_index_;
+    std::vector<double> left_weight_, right_weight_, std_dev_;
+};
+
+#endif // QUASI_RANDOM_H
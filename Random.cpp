@@ -0,0 +1,133 @@
+#include "Random.h"
+#include "SimdMath.h"
+#include "OptionPricer.h"
+#include <algorithm>
+
+//no fused multiply-add contraction in this file: AVX-512 would otherwise round differently
+//from SSE2/AVX2 and a seed would give different normals on different CPUs
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+    #pragma clang fp contract(off)
+#endif
+
+namespace {
+
+constexpr std::uint64_t kCountersPerGroup = NormalGenerator::kGroup / 2;
+
+#if OPTION_PRICER_SIMD
+
+//one group of normals with W Philox counters per step
+//lane j of step i uses counter group*16 + i*W + j, its two normals go to slots i*W + j and 16 + i*W + j,
+//so every width (including W = 1) fills the group identically
+template <int W>
+inline __attribute__((always_inline))
+void normalGroup(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, double* out) {
+    typedef typename simd::Vec<W>::d VD;
+    typedef typename simd::Vec<W>::u VU;
+    const std::uint64_t lo32 = 0xffffffffULL;
+
+    for (std::uint64_t i = 0; i < kCountersPerGroup; i += W) {
+        //32-bit words held in 64-bit lanes, so the 32x32 -> 64 products are exact
+        VU c0, c1;
+        for (int j = 0; j < W; ++j) {
+            const std::uint64_t ctr = group * kCountersPerGroup + i + j;
+            c0[j] = ctr & lo32;
+            c1[j] = ctr >> 32;
+        }
+        VU c2 = VU{} + (stream & lo32);
+        VU c3 = VU{} + (stream >> 32);
+        std::uint64_t k0 = seed & lo32;
+        std::uint64_t k1 = seed >> 32;
+
+        for (int round = 0; round < 10; ++round) {
+            const VU p0 = c0 * 0xD2511F53ULL;
+            const VU p1 = c2 * 0xCD9E8D57ULL;
+            c0 = (p1 >> 32) ^ c1 ^ k0;
+            c1 = p1 & lo32;
+            c2 = (p0 >> 32) ^ c3 ^ k1;
+            c3 = p0 & lo32;
+            k0 = (k0 + 0x9E3779B9ULL) & lo32;
+            k1 = (k1 + 0xBB67AE85ULL) & lo32;
+        }
+
+        //same conversion as toUniform: top 52 bits into a [1, 2) mantissa
+        const std::uint64_t one = 0x3ff0000000000000ULL;
+        const VD u1 = ((VD)(one | (((c0 << 32) | c1) >> 12)) - 1.0) + 1.1102230246251565e-16;
+        const VD u2 = ((VD)(one | (((c2 << 32) | c3) >> 12)) - 1.0) + 1.1102230246251565e-16;
+
+        simd::store<W>(out + i, simd::inverseNormalCDF<W>(u1));
+        simd::store<W>(out + kCountersPerGroup + i, simd::inverseNormalCDF<W>(u2));
+    }
+}
+
+__attribute__((target("avx512f")))
+void fillAvx512(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, size_t groups, double* out) {
+    for (size_t g = 0; g < groups; ++g) normalGroup<8>(seed, stream, group + g, out + g * NormalGenerator::kGroup);
+}
+
+__attribute__((target("avx2")))
+void fillAvx2(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, size_t groups, double* out) {
+    for (size_t g = 0; g < groups; ++g) normalGroup<4>(seed, stream, group + g, out + g * NormalGenerator::kGroup);
+}
+
+void fillSse2(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, size_t groups, double* out) {
+    for (size_t g = 0; g < groups; ++g) normalGroup<2>(seed, stream, group + g, out + g * NormalGenerator::kGroup);
+}
+
+void fillScalar(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, size_t groups, double* out) {
+    for (size_t g = 0; g < groups; ++g) normalGroup<1>(seed, stream, group + g, out + g * NormalGenerator::kGroup);
+}
+
+#else
+
+//portable fallback: same counter layout with the scalar Philox and inverse CDF
+void fillScalar(std::uint64_t seed, std::uint64_t stream, std::uint64_t group, size_t groups, double* out) {
+    const std::array<std::uint32_t, 2> key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    for (size_t g = 0; g < groups; ++g) {
+        double* dst = out + g * NormalGenerator::kGroup;
+        for (std::uint64_t i = 0; i < kCountersPerGroup; ++i) {
+            const std::uint64_t ctr = (group + g) * kCountersPerGroup + i;
+            Philox4x32::Block b = Philox4x32::generate(
+                {static_cast<std::uint32_t>(ctr), static_cast<std::uint32_t>(ctr >> 32),
+                 static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)}, key);
+            dst[i] = OptionPricer::inverseNormalCDF(toUniform(b[0], b[1]));
+            dst[kCountersPerGroup + i] = OptionPricer::inverseNormalCDF(toUniform(b[2], b[3]));
+        }
+    }
+}
+
+#endif // OPTION_PRICER_SIMD
+
+} // namespace
+
+NormalGenerator::NormalGenerator(std::uint64_t seed, std::uint64_t stream, SimdLevel level)
+    : seed_(seed), stream_(stream), level_(std::min(level, detectSimdLevel())) {
+}
+
+void NormalGenerator::fill(double* out, size_t n) {
+    auto fillGroups = [&](double* dst, size_t groups) {
+#if OPTION_PRICER_SIMD
+        switch (level_) {
+            case SimdLevel::AVX512: fillAvx512(seed_, stream_, group_, groups, dst); break;
+            case SimdLevel::AVX2:   fillAvx2(seed_, stream_, group_, groups, dst);   break;
+            case SimdLevel::SSE2:   fillSse2(seed_, stream_, group_, groups, dst);   break;
+            default:                fillScalar(seed_, stream_, group_, groups, dst); break;
+        }
+#else
+        fillScalar(seed_, stream_, group_, groups, dst);
+#endif
+        group_ += groups;
+    };
+
+    const size_t whole = n / kGroup;
+    fillGroups(out, whole);
+
+    //partial group at the end: generate it in full and keep what was asked for
+    const size_t rest = n - whole * kGroup;
+    if (rest > 0) {
+        double tmp[kGroup];
+        fillGroups(tmp, 1);
+        std::copy(tmp, tmp + rest, out + whole * kGroup);
+    }
+}
@@ -0,0 +1,93 @@
+// Random.h
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include "SimdLevel.h"
+
+//Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3")
+//the output is a pure function of (key, counter), so any block of the sequence can be produced
+//directly. Monte Carlo chunks each get their own stream and give the same numbers on any thread
+class Philox4x32 {
+public:
+    using Block = std::array<std::uint32_t, 4>;
+
+    //seed picks the sequence, stream picks an independent substream of it (e.g. a chunk index)
+    Philox4x32(std::uint64_t seed, std::uint64_t stream)
+        : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          counter_{0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)} {}
+
+    //next 4 x 32 random bits, advances the counter
+    Block next() {
+        Block out = generate(counter_, key_);
+        if (++counter_[0] == 0) ++counter_[1];
+        return out;
+    }
+
+    //jump to block `index` of this stream
+    void seek(std::uint64_t index) {
+        counter_[0] = static_cast<std::uint32_t>(index);
+        counter_[1] = static_cast<std::uint32_t>(index >> 32);
+    }
+
+    //the bijection itself: 10 rounds of multiply-xor with a Weyl-sequence key schedule
+    static Block generate(Block ctr, std::array<std::uint32_t, 2> key) {
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * ctr[0];
+            const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * ctr[2];
+            ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+                   static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+
+private:
+    std::array<std::uint32_t, 2> key_;
+    Block counter_;
+};
+
+//two 32-bit words -> uniform double in the open interval (0, 1)
+//the top 52 bits become the mantissa of a double in [1, 2), then shift down and nudge by half a step
+//so it never returns 0 or 1 (safe for log and the inverse CDF). The vectorized generator does the same
+inline double toUniform(std::uint32_t hi, std::uint32_t lo) {
+    const std::uint64_t bits = 0x3ff0000000000000ULL | ((std::uint64_t(hi) << 32 | lo) >> 12);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return (d - 1.0) + 1.1102230246251565e-16;  //2^-53
+}
+
+//bulk standard normal generator: Philox uniforms through the inverse normal CDF,
+//a whole block at a time with the widest SIMD kernel the CPU supports
+//
+//each Philox block (4 words) gives two normals. Counters are laid out in groups of 16 so every
+//SIMD width writes the same numbers to the same slots: normals are a function of
+//(seed, stream, position) only, identical across thread counts and CPUs
+class NormalGenerator {
+public:
+    static constexpr size_t kGroup = 32;   //normals per group of 16 counters
+    static constexpr size_t kBlock = 512;  //fill size used by the Monte Carlo loops, 4KB stays in L1
+
+    NormalGenerator(std::uint64_t seed, std::uint64_t stream, SimdLevel level = SimdLevel::AVX512);
+
+    //writes the next n normals of the stream. Draws are consumed in whole groups,
+    //so the stream only lines up across runs when callers use the same fill sizes
+    //(multiples of kGroup always line up)
+    void fill(double* out, size_t n);
+
+    //continue the stream at normal `position` (a multiple of kGroup), for callers that lay several
+    //independent pieces out in one stream and read them out of order
+    void seek(std::uint64_t position) { group_ = position / kGroup; }
+
+private:
+    std::uint64_t seed_;
+    std::uint64_t stream_;
+    std::uint64_t group_ = 0;  //next group of counters
+    SimdLevel level_;
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,160 @@
+// ResultCache.h
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+//bounded LRU cache split into independently locked shards, so concurrent requests
+//for different contracts rarely wait on each other. Key needs operator== and a Hash functor
+template <typename Key, typename Value, typename Hash, size_t Shards = 16>
+class ShardedLruCache {
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<Key, Value>> entries;  //most recently used at the front
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+    };
+
+    std::array<Shard, Shards> shards_;
+    size_t shard_capacity_;
+    Hash hash_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+
+    Shard& shardFor(const Key& key) {
+        //high bits pick the shard, the low bits are what the shard's hash map uses
+        return shards_[(hash_(key) >> 32) % Shards];
+    }
+
+public:
+    //capacity is the total number of entries, spread evenly over the shards
+    explicit ShardedLruCache(size_t capacity)
+        : shard_capacity_(std::max<size_t>(1, (capacity + Shards - 1) / Shards)) {}
+
+    //copies the cached value into out and marks it most recently used
+    bool get(const Key& key, Value& out) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        out = it->second->second;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //inserts or replaces, evicting the shard's least recently used entry when full
+    void put(const Key& key, Value value) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        if (shard.entries.size() >= shard_capacity_) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.entries.begin());
+    }
+
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    size_t size() {
+        size_t total = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+
+    size_t capacity() const { return shard_capacity_ * Shards; }
+};
+
+//grid the contract parameters are snapped to before lookup; two requests that land on the
+//same grid point share a cache entry. Ticks of 0 mean exact matching
+struct CacheQuantization {
+    double price = 1e-4;  //spot and strike
+    double time = 1e-6;   //years, about 30 seconds
+    double rate = 1e-6;
+    double vol = 1e-6;
+};
+
+//contract parameters as integer grid indices, plus the Monte Carlo settings when they matter
+struct PriceCacheKey {
+    std::array<std::int64_t, 5> contract{};  //S, K, T, r, sigma
+    int type = 0;
+    //Monte Carlo part, left zero for Black-Scholes-only entries
+    std::int64_t sims = 0;
+    std::uint64_t seed = 0;
+    int method = 0;
+    int variance_reduction = 0;
+    int steps = 0;
+    std::int64_t target_std_error = 0;  //in units of 1e-9
+
+    bool operator==(const PriceCacheKey& o) const {
+        return contract == o.contract && type == o.type && sims == o.sims && seed == o.seed &&
+               method == o.method && variance_reduction == o.variance_reduction && steps == o.steps &&
+               target_std_error == o.target_std_error;
+    }
+};
+
+struct PriceCacheKeyHash {
+    //splitmix64 finaliser over every field
+    static std::uint64_t mix(std::uint64_t h, std::uint64_t v) {
+        h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+        return h ^ (h >> 31);
+    }
+    size_t operator()(const PriceCacheKey& k) const {
+        std::uint64_t h = 0;
+        for (std::int64_t c : k.contract) h = mix(h, static_cast<std::uint64_t>(c));
+        h = mix(h, static_cast<std::uint64_t>(k.type));
+        h = mix(h, static_cast<std::uint64_t>(k.sims));
+        h = mix(h, k.seed);
+        h = mix(h, static_cast<std::uint64_t>(k.method) << 16 | static_cast<std::uint64_t>(k.variance_reduction) << 8 |
+                   static_cast<std::uint64_t>(k.steps));
+        h = mix(h, static_cast<std::uint64_t>(k.target_std_error));
+        return static_cast<size_t>(h);
+    }
+};
+
+//grid index of x for a tick (exact bit pattern when the tick is 0)
+inline std::int64_t quantize(double x, double tick) {
+    if (tick <= 0.0) {
+        std::int64_t bits;
+        static_assert(sizeof(bits) == sizeof(x), "double must be 64-bit");
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+    return std::llround(x / tick);
+}
+
+inline PriceCacheKey makeContractKey(const CacheQuantization& q, double S, double K, double T,
+                                     double r, double sigma, int type) {
+    PriceCacheKey key;
+    key.contract = {quantize(S, q.price), quantize(K, q.price), quantize(T, q.time),
+                    quantize(r, q.rate), quantize(sigma, q.vol)};
+    key.type = type;
+    return key;
+}
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,134 @@
+// Sabr.cpp
+#include "SimdMath.h"
+#include "Sabr.h"
+#include <algorithm>
+#include <stdexcept>
+
+void validateSabr(const SabrParams& p) {
+    if (!(p.alpha > 0.0) || !(p.nu > 0.0) || !(p.beta >= 0.0 && p.beta <= 1.0) || !(p.rho > -1.0 && p.rho < 1.0)) {
+        throw std::invalid_argument("sabr parameters need alpha, nu > 0, 0 <= beta <= 1 and -1 < rho < 1");
+    }
+}
+
+double sabrLognormalVol(double F, double K, double T, const SabrParams& p) {
+    return haganLognormalVol(F, K, T, p.alpha, p.beta, p.rho, p.nu);
+}
+
+double sabrNormalVol(double F, double K, double T, const SabrParams& p) {
+    return haganNormalVol(F, K, T, p.alpha, p.beta, p.rho, p.nu);
+}
+
+//----- vectorized Hagan -----
+
+//haganLognormalVol / haganNormalVol on a lane type, from lf = ln F and lk = ln K: (F K)^((1 - beta) / 2)
+//becomes one exp of their sum, everything else is arithmetic, a sqrt and one log per lane
+template <bool Normal, class V>
+static OPTION_PRICER_ALWAYS_INLINE V haganLanes(double lf, const V& lk, double T, const SabrParams& p) {
+    const double omb = 1.0 - p.beta;
+    const V lfk = lf - lk;
+    const V lfk2 = lfk * lfk;
+    const V fkb = lanes::exp(0.5 * omb * (lf + lk));
+    const V inv_fkb = 1.0 / fkb;
+    const V denom = 1.0 + lfk2 * (omb * omb / 24.0 + omb * omb * omb * omb / 1920.0 * lfk2);
+    const V z = (p.nu / p.alpha) * fkb * lfk;
+    //both branches are computed, the series replaces 0 / 0 where z underflows the log
+    const V x = lanes::log((lanes::sqrt(1.0 - 2.0 * p.rho * z + z * z) + z - p.rho) / (1.0 - p.rho));
+    const V zx = lanes::abs(z) < 1e-6 ? 1.0 - 0.5 * p.rho * z : z / x;
+    const double c = Normal ? -p.beta * (2.0 - p.beta) / 24.0 : omb * omb / 24.0;
+    const V correction = 1.0 + ((c * p.alpha * p.alpha) * inv_fkb * inv_fkb + (0.25 * p.rho * p.beta * p.nu * p.alpha) * inv_fkb
+                                + (2.0 - 3.0 * p.rho * p.rho) / 24.0 * p.nu * p.nu) * T;
+    if constexpr (Normal) {
+        const V ratio = (1.0 + lfk2 * (1.0 / 24.0 + lfk2 / 1920.0)) / denom;
+        return p.alpha * lanes::exp(0.5 * p.beta * (lf + lk)) * ratio * zx * correction;
+    } else {
+        return p.alpha * inv_fkb / denom * zx * correction;
+    }
+}
+
+template <bool Normal>
+struct HaganStrike {
+    double lf, T;
+    SabrParams p;
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& K) const {
+        return haganLanes<Normal>(lf, lanes::log(K), T, p);
+    }
+};
+
+void sabrLognormalVols(double F, double T, const SabrParams& params, const double* K, double* out, size_t n,
+                       SimdLevel level) {
+    lanes::transform(HaganStrike<false>{std::log(F), T, params}, K, out, n, level);
+}
+
+void sabrNormalVols(double F, double T, const SabrParams& params, const double* K, double* out, size_t n,
+                    SimdLevel level) {
+    lanes::transform(HaganStrike<true>{std::log(F), T, params}, K, out, n, level);
+}
+
+//----- SabrSurface -----
+
+//the vols of one expiry T from the slices around it: at log-moneyness k = ln K - ln F(T) the total
+//variance is lo_weight vol_lo(k)^2 + hi_weight vol_hi(k)^2 (weights carry the slices' expiries), each
+//slice evaluated at its own forward and the strike with the same moneyness
+struct SabrStrip {
+    double lf, inv_T;
+    const SabrSlice* lo;
+    const SabrSlice* hi;  //null outside the slices or on one
+    double lf_lo, lf_hi, lo_weight, hi_weight;
+
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& K) const {
+        const V k = lanes::log(K) - lf;
+        const V v_lo = haganLanes<false>(lf_lo, lf_lo + k, lo->expiry, lo->params);
+        V w = lo_weight * (v_lo * v_lo);
+        if (hi) {
+            const V v_hi = haganLanes<false>(lf_hi, lf_hi + k, hi->expiry, hi->params);
+            w = w + hi_weight * (v_hi * v_hi);
+        }
+        return lanes::sqrt(w * inv_T);
+    }
+};
+
+SabrSurface::SabrSurface(double S, double r, std::vector<SabrSlice> slices)
+    : S_(S), r_(r), slices_(std::move(slices)) {
+    if (!(S > 0.0) || slices_.empty()) {
+        throw std::invalid_argument("a sabr surface needs a positive spot and at least one slice");
+    }
+    for (const SabrSlice& slice : slices_) {
+        if (!(slice.expiry > 0.0)) {
+            throw std::invalid_argument("slice expiries must be positive");
+        }
+        validateSabr(slice.params);
+    }
+    std::sort(slices_.begin(), slices_.end(), [](const SabrSlice& a, const SabrSlice& b) { return a.expiry < b.expiry; });
+}
+
+void SabrSurface::smile(double T, const double* K, double* out, size_t n, SimdLevel level) const {
+    if (!(T > 0.0)) {
+        throw std::invalid_argument("expiry must be positive");
+    }
+    const double ls = std::log(S_);
+    const auto after = std::upper_bound(slices_.begin(), slices_.end(), T,
+                                        [](double t, const SabrSlice& slice) { return t < slice.expiry; });
+    SabrStrip strip{ls + r_ * T, 1.0 / T, nullptr, nullptr, 0.0, 0.0, 0.0, 0.0};
+    if (after == slices_.begin() || after == slices_.end()) {
+        //flat vol from the nearest slice
+        strip.lo = after == slices_.begin() ? &slices_.front() : &slices_.back();
+        strip.lo_weight = T;
+    } else {
+        strip.lo = &*(after - 1);
+        strip.hi = &*after;
+        const double t = (T - strip.lo->expiry) / (strip.hi->expiry - strip.lo->expiry);
+        strip.lo_weight = (1.0 - t) * strip.lo->expiry;
+        strip.hi_weight = t * strip.hi->expiry;
+        strip.lf_hi = ls + r_ * strip.hi->expiry;
+    }
+    strip.lf_lo = ls + r_ * strip.lo->expiry;
+    lanes::transform(strip, K, out, n, level);
+}
+
+double SabrSurface::vol(double K, double T) const {
+    double out;
+    smile(T, &K, &out, 1, SimdLevel::SCALAR);
+    return out;
+}
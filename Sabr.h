@@ -0,0 +1,109 @@
+// Sabr.h
+#ifndef SABR_H
+#define SABR_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "AutoDiff.h"
+#include "SimdLevel.h"
+
+//SABR stochastic volatility for the smile of one expiry: dF = sigma F^beta dW1, dsigma = nu sigma dW2,
+//d<W1, W2> = rho dt, sigma(0) = alpha. beta is usually fixed by convention and the other three fitted
+struct SabrParams {
+    double alpha;  //initial volatility, in units of F^(1 - beta)
+    double beta;   //CEV exponent, 0..1
+    double rho;    //forward/volatility correlation
+    double nu;     //volatility of volatility
+};
+
+//throws std::invalid_argument unless alpha, nu > 0, 0 <= beta <= 1 and -1 < rho < 1
+void validateSabr(const SabrParams& params);
+
+//Hagan, Kumar, Lesniewski & Woodward (2002) lognormal (Black) implied vol at forward F, strike K,
+//expiry T. Written on the number type R of alpha, rho and nu so calibration can run it on Jets (AutoDiff.h)
+//for exact gradients; beta is a plain number, it is not fitted
+template <class R>
+R haganLognormalVol(double F, double K, double T, const R& alpha, double beta, const R& rho, const R& nu) {
+    using std::log;
+    using std::sqrt;
+    const double omb = 1.0 - beta;
+    const double lfk = std::log(F / K);
+    const double fkb = std::pow(F * K, 0.5 * omb);  //(F K)^((1 - beta) / 2)
+    const double lfk2 = lfk * lfk;
+    const double denom = fkb * (1.0 + omb * omb / 24.0 * lfk2 + omb * omb * omb * omb / 1920.0 * lfk2 * lfk2);
+    const R z = nu / alpha * (fkb * lfk);
+    //z / x(z), by its series near the money where x(z) -> 0 with z
+    R zx;
+    if (std::abs(valueOf(z)) < 1e-6) {
+        zx = 1.0 - 0.5 * rho * z;
+    } else {
+        zx = z / log((sqrt(1.0 - 2.0 * rho * z + z * z) + z - rho) / (1.0 - rho));
+    }
+    const R correction = 1.0 + (omb * omb / 24.0 * alpha * alpha / (fkb * fkb) + 0.25 * rho * beta * nu * alpha / fkb
+                                + (2.0 - 3.0 * rho * rho) / 24.0 * nu * nu) * T;
+    return alpha / denom * zx * correction;
+}
+
+//Hagan's normal (Bachelier) implied vol, the absolute vol of F for the same expansion, finite at K = F and
+//for beta = 0 where the lognormal form is usually quoted through it
+template <class R>
+R haganNormalVol(double F, double K, double T, const R& alpha, double beta, const R& rho, const R& nu) {
+    using std::log;
+    using std::sqrt;
+    const double omb = 1.0 - beta;
+    const double lfk = std::log(F / K);
+    const double fkb = std::pow(F * K, 0.5 * omb);
+    const double lfk2 = lfk * lfk;
+    const double ratio = (1.0 + lfk2 / 24.0 + lfk2 * lfk2 / 1920.0)
+                         / (1.0 + omb * omb / 24.0 * lfk2 + omb * omb * omb * omb / 1920.0 * lfk2 * lfk2);
+    const R z = nu / alpha * (fkb * lfk);
+    R zx;
+    if (std::abs(valueOf(z)) < 1e-6) {
+        zx = 1.0 - 0.5 * rho * z;
+    } else {
+        zx = z / log((sqrt(1.0 - 2.0 * rho * z + z * z) + z - rho) / (1.0 - rho));
+    }
+    const R correction = 1.0 + (-beta * (2.0 - beta) / 24.0 * alpha * alpha / (fkb * fkb)
+                                + 0.25 * rho * beta * nu * alpha / fkb + (2.0 - 3.0 * rho * rho) / 24.0 * nu * nu) * T;
+    return alpha * (std::sqrt(F * K) / fkb * ratio) * zx * correction;
+}
+
+double sabrLognormalVol(double F, double K, double T, const SabrParams& params);
+double sabrNormalVol(double F, double K, double T, const SabrParams& params);
+
+//the same for n strikes of one expiry, out[i] for K[i]: W strikes side by side in vector registers with the
+//SimdMath.h log/exp, matching the scalar formulas up to their rounding. level caps the instruction set
+//as in blackScholesBatch
+void sabrLognormalVols(double F, double T, const SabrParams& params, const double* K, double* out, size_t n,
+                       SimdLevel level = SimdLevel::AVX512);
+void sabrNormalVols(double F, double T, const SabrParams& params, const double* K, double* out, size_t n,
+                    SimdLevel level = SimdLevel::AVX512);
+
+//one expiry's fitted parameters (calibrateSabr in Calibration.h)
+struct SabrSlice {
+    double expiry;
+    SabrParams params;
+};
+
+//lognormal SABR vols for any strike and expiry from a set of slices on forwards F(T) = S e^(rT).
+//Between two slices the total implied variance vol^2 T is interpolated linearly in T at the same
+//log-moneyness ln(K / F(T)), which keeps it increasing when both slices' is; outside them the nearest
+//slice's vol at that moneyness is held flat. A strike is one or two Hagan evaluations, no solve
+class SabrSurface {
+public:
+    //throws std::invalid_argument for no slices, non-positive spot or expiries, or invalid parameters
+    SabrSurface(double S, double r, std::vector<SabrSlice> slices);
+
+    double vol(double K, double T) const;
+    //vols of n strikes at one expiry (a strip of an option chain), vectorized across the strikes
+    void smile(double T, const double* K, double* out, size_t n, SimdLevel level = SimdLevel::AVX512) const;
+
+    const std::vector<SabrSlice>& slices() const { return slices_; }
+
+private:
+    double S_, r_;
+    std::vector<SabrSlice> slices_;  //by increasing expiry
+};
+
+#endif // SABR_H
@@ -0,0 +1,55 @@
+// SimdLevel.h
+#ifndef SIMD_LEVEL_H
+#define SIMD_LEVEL_H
+
+//SIMD kernels need GCC/Clang vector extensions and target attributes on x86,
+//everything else builds the scalar paths only
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define OPTION_PRICER_SIMD 1
+#else
+    #define OPTION_PRICER_SIMD 0
+#endif
+
+//for small templates that are instantiated on SIMD vector types from outside SimdMath.h (the payoff
+//policies): always inlined into the target-specific kernel, never an out-of-line vector function
+#if OPTION_PRICER_SIMD
+    #define OPTION_PRICER_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+    #define OPTION_PRICER_ALWAYS_INLINE inline
+#endif
+
+//instruction sets the vectorized kernels are compiled for, ordered narrowest to widest
+enum class SimdLevel {
+    SCALAR,  //plain loop with std::log/std::exp, the reference path
+    SSE2,    //2 doubles per register
+    AVX2,    //4 doubles per register (with FMA)
+    AVX512   //8 doubles per register
+};
+
+//widest level the running CPU supports, detected once
+inline SimdLevel detectSimdLevel() {
+#if OPTION_PRICER_SIMD
+    //__builtin_cpu_supports also confirms the OS saves the wide registers
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::SSE2:   return "sse2";
+        default:                return "scalar";
+    }
+}
+
+#endif // SIMD_LEVEL_H
@@ -0,0 +1,424 @@
+// SimdMath.h
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+//portable SIMD math for the batch pricers
+//written once on GCC/Clang vector extensions and instantiated per width:
+//W=2 is SSE2, W=4 is AVX2, W=8 is AVX-512. The callers wrap these in functions with
+//__attribute__((target(...))) so the same source compiles to each instruction set,
+//and pick one at runtime with __builtin_cpu_supports (see BatchPricer.cpp)
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "SimdLevel.h"
+#include "NormalCdf.h"
+
+#if OPTION_PRICER_SIMD
+
+//the vector types are only ever used inside always_inline helpers (which take them by const reference),
+//so the "ABI changes with AVX" warning does not apply. GCC reports it at the end of the translation unit,
+//so it stays disabled for the rest of the including .cpp file (this header is never included by other headers)
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#define SIMD_INLINE static inline __attribute__((always_inline))
+
+namespace simd {
+
+//W doubles and W matching 64-bit integers (comparison results are integer masks)
+template <int W>
+struct Vec {
+    typedef double        d __attribute__((vector_size(sizeof(double) * W)));
+    typedef std::int64_t  i __attribute__((vector_size(sizeof(std::int64_t) * W)));
+    typedef std::uint64_t u __attribute__((vector_size(sizeof(std::uint64_t) * W)));  //wrapping bit math
+};
+
+template <int W>
+SIMD_INLINE typename Vec<W>::d load(const double* p) {
+    typename Vec<W>::d v;
+    std::memcpy(&v, p, sizeof(v));  //compiles to a single unaligned load
+    return v;
+}
+
+template <int W>
+SIMD_INLINE void store(double* p, const typename Vec<W>::d& v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+template <int W>
+SIMD_INLINE typename Vec<W>::d broadcast(double x) {
+    return typename Vec<W>::d{} + x;
+}
+
+template <int W>
+SIMD_INLINE typename Vec<W>::d abs(const typename Vec<W>::d& x) {
+    typedef typename Vec<W>::i VI;
+    typedef typename Vec<W>::d VD;
+    return (VD)((VI)x & 0x7fffffffffffffffLL);
+}
+
+//no element-wise sqrt in the vector extensions. Pairs of lanes go through SSE2's sqrtpd, which every
+//x86-64 target has (the wider sqrt instructions cannot be reached from these target-neutral helpers),
+//and which sets no errno: a plain sqrt per lane also carries the check for negative inputs
+template <int W>
+SIMD_INLINE typename Vec<W>::d sqrt(const typename Vec<W>::d& x) {
+    typename Vec<W>::d root;
+    if constexpr (W == 1) {
+        root[0] = __builtin_sqrt(x[0]);
+    } else {
+        for (int j = 0; j < W; j += 2) {
+            const typename Vec<2>::d pair = __builtin_ia32_sqrtpd(typename Vec<2>::d{x[j], x[j + 1]});
+            root[j] = pair[0];
+            root[j + 1] = pair[1];
+        }
+    }
+    return root;
+}
+
+//1.5 * 2^52: adding it rounds a double to an integer and leaves that integer in the low mantissa bits
+constexpr double kRoundMagic = 6755399441055744.0;
+
+//e^x, fdlibm reduction x = k*ln2 + r with a rational approximation on |r| <= ln2/2
+//accurate to ~1 ulp for -708 <= x <= 709, returns 0 below that range
+template <int W>
+SIMD_INLINE typename Vec<W>::d exp(const typename Vec<W>::d& in) {
+    typedef typename Vec<W>::d VD;
+    typedef typename Vec<W>::i VI;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double inv_ln2 = 1.44269504088896338700e+00;
+    const double P1 =  1.66666666666666019037e-01;
+    const double P2 = -2.77777777770155933842e-03;
+    const double P3 =  6.61375632143793436117e-05;
+    const double P4 = -1.65339022054652515390e-06;
+    const double P5 =  4.13813679705723846039e-08;
+
+    const VI underflow = in < -708.0;
+    VD x = in > 709.0 ? broadcast<W>(709.0) : in;
+    x = x < -708.0 ? broadcast<W>(-708.0) : x;
+
+    const VD shifted = x * inv_ln2 + kRoundMagic;
+    const VD k  = shifted - kRoundMagic;
+    const VD hi = x - k * ln2_hi;
+    const VD lo = k * ln2_lo;
+    const VD r  = hi - lo;
+
+    const VD t = r * r;
+    const VD c = r - t * (P1 + t * (P2 + t * (P3 + t * (P4 + t * P5))));
+    const VD y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+
+    //scale by 2^k by adding k straight into the exponent bits
+    const VI ki = (VI)shifted - (VI)broadcast<W>(kRoundMagic);
+    const VD result = (VD)((VI)y + (ki << 52));
+    return underflow ? broadcast<W>(0.0) : result;
+}
+
+//natural log for positive, normal x
+//fdlibm: x = 2^k * m with m in [sqrt(2)/2, sqrt(2)), then a minimax polynomial in s = (m-1)/(m+1)
+template <int W>
+SIMD_INLINE typename Vec<W>::d log(const typename Vec<W>::d& x) {
+    typedef typename Vec<W>::d VD;
+    typedef typename Vec<W>::i VI;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double Lg1 = 6.666666666666735130e-01;
+    const double Lg2 = 3.999999999940941908e-01;
+    const double Lg3 = 2.857142874366239149e-01;
+    const double Lg4 = 2.222219843214978396e-01;
+    const double Lg5 = 1.818357216161805012e-01;
+    const double Lg6 = 1.531383769920937332e-01;
+    const double Lg7 = 1.479819860511658591e-01;
+
+    const VI bits = (VI)x;
+    VI k = ((bits >> 52) & 0x7ff) - 1023;
+    VD m = (VD)((bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL);  //m in [1, 2)
+
+    const VI big = m > 1.41421356237309504880;
+    m = big ? m * 0.5 : m;
+    k = k - big;  //mask lanes are -1, so this adds one where m was halved
+
+    const VD dk = (VD)(k + (VI)broadcast<W>(kRoundMagic)) - kRoundMagic;
+    const VD f = m - 1.0;
+    const VD s = f / (2.0 + f);
+    const VD z = s * s;
+    const VD w = z * z;
+    const VD t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+    const VD t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+    const VD R = t2 + t1;
+    const VD hfsq = 0.5 * f * f;
+    return dk * ln2_hi - ((hfsq - (s * (hfsq + R) + dk * ln2_lo)) - f);
+}
+
+//normal PDF: (1/√2π)e^(-x²/2)
+template <int W>
+SIMD_INLINE typename Vec<W>::d normalPDF(const typename Vec<W>::d& x) {
+    return 0.39894228040143267794 * exp<W>(-0.5 * x * x);
+}
+
+//true if any lane of the mask is set
+//ORs the two halves together until two lanes are left, instead of extracting every lane
+template <int W>
+SIMD_INLINE bool any(const typename Vec<W>::i& mask) {
+    if constexpr (W <= 2) {
+        std::int64_t acc = 0;
+        for (int j = 0; j < W; ++j) acc |= mask[j];
+        return acc != 0;
+    } else {
+        typename Vec<W / 2>::i lo, hi;
+        std::memcpy(&lo, &mask, sizeof(lo));
+        std::memcpy(&hi, reinterpret_cast<const char*>(&mask) + sizeof(lo), sizeof(hi));
+        return any<W / 2>(lo | hi);
+    }
+}
+
+//vector forms of the NormalCdf.h policies, same formulas lane by lane
+//HornerCdf: the A&S 26.2.17 polynomial
+template <int W>
+SIMD_INLINE typename Vec<W>::d hornerCDFFromPDF(const typename Vec<W>::d& x, const typename Vec<W>::d& pdf) {
+    typedef typename Vec<W>::d VD;
+    const VD k = 1.0 / (1.0 + 0.2316419 * abs<W>(x));
+    const VD poly = k * (0.31938153 + k * (-0.356563782 + k * (1.781477937
+                  + k * (-1.821255978 + k * 1.330274429))));
+    const VD upper = pdf * poly;
+    return x < 0.0 ? upper : 1.0 - upper;
+}
+
+//CodyCdf: every lane picks the numerator and denominator of its range, one division for all three.
+//Ranges no lane falls in are skipped. The far range is multiplied through by w^5, w = y^2, so it needs
+//no 1/y^2 either: N(-y) e^(y^2/2) = (w den / sqrt(2 pi) - num) / (w den y) with num, den polynomials in w
+template <int W>
+SIMD_INLINE typename Vec<W>::d codyCDFFromPDF(const typename Vec<W>::d& x, const typename Vec<W>::d& pdf) {
+    typedef typename Vec<W>::d VD;
+    typedef typename Vec<W>::i VI;
+    typedef CodyCdf C;
+    const VD y = abs<W>(x);
+    const VI inner = y <= C::kCentral;
+    const VI far = y > C::kTail;
+    const VI mid = ~(inner | far);  //NaN lands here and propagates through the division
+    VD num = broadcast<W>(0.0), den = broadcast<W>(1.0);
+
+    if (any<W>(inner)) {
+        const VD xsq = x * x;
+        VD n = C::kA[4] * xsq, d = xsq;
+        for (int i = 0; i < 3; ++i) {
+            n = (n + C::kA[i]) * xsq;
+            d = (d + C::kB[i]) * xsq;
+        }
+        num = inner ? n + C::kA[3] : num;
+        den = inner ? d + C::kB[3] : den;
+    }
+    if (any<W>(mid)) {
+        VD n = C::kC[8] * y, d = y;
+        for (int i = 0; i < 7; ++i) {
+            n = (n + C::kC[i]) * y;
+            d = (d + C::kD[i]) * y;
+        }
+        num = mid ? n + C::kC[7] : num;
+        den = mid ? d + C::kD[7] : den;
+    }
+    if (any<W>(far)) {
+        //past y = 40 the density has underflowed to 0, clamping keeps w^5 finite
+        const VD yc = y < 40.0 ? y : 40.0;
+        const VD w = yc * yc;
+        VD n = C::kP[4] * w, d = C::kQ[4] * w;
+        for (int i = 3; i >= 0; --i) {
+            n = (n + C::kP[i]) * w;
+            d = (d + C::kQ[i]) * w;
+        }
+        n = n + C::kP[5];
+        d = d + 1.0;
+        num = far ? w * d * (1.0 / C::kSqrt2Pi) - n : num;
+        den = far ? w * d * yc : den;
+    }
+
+    const VD ratio = num / den;
+    const VD upper = pdf * C::kSqrt2Pi * ratio;  //N(-y) outside the central range
+    return inner ? 0.5 + x * ratio : (x < 0.0 ? upper : 1.0 - upper);
+}
+
+//ErfcCdf: no vector erfc here, one library call per lane
+template <int W>
+SIMD_INLINE typename Vec<W>::d erfcCDF(const typename Vec<W>::d& x) {
+    typename Vec<W>::d out;
+    for (int j = 0; j < W; ++j) out[j] = ErfcCdf::cdf(x[j]);
+    return out;
+}
+
+//normal CDF when the density at x is already known, Cdf picks the policy (the pricer's NormalCdf by default)
+template <int W, class Cdf = NormalCdf>
+SIMD_INLINE typename Vec<W>::d normalCDFFromPDF(const typename Vec<W>::d& x, const typename Vec<W>::d& pdf) {
+    if constexpr (std::is_same_v<Cdf, HornerCdf>) return hornerCDFFromPDF<W>(x, pdf);
+    else if constexpr (std::is_same_v<Cdf, CodyCdf>) return codyCDFFromPDF<W>(x, pdf);
+    else return erfcCDF<W>(x);
+}
+
+template <int W, class Cdf = NormalCdf>
+SIMD_INLINE typename Vec<W>::d normalCDF(const typename Vec<W>::d& x) {
+    if constexpr (std::is_same_v<Cdf, ErfcCdf>) return erfcCDF<W>(x);
+    else return normalCDFFromPDF<W, Cdf>(x, normalPDF<W>(x));
+}
+
+//inverse normal CDF for p in (0, 1), Wichura's AS241 (PPND16), relative error ~1e-16
+//same rational approximations as OptionPricer::inverseNormalCDF, the tail branches are only
+//evaluated when some lane needs them (|p - 0.5| > 0.425 is ~15% of uniform draws)
+template <int W>
+SIMD_INLINE typename Vec<W>::d inverseNormalCDF(const typename Vec<W>::d& p) {
+    typedef typename Vec<W>::d VD;
+    typedef typename Vec<W>::i VI;
+
+    const VD q = p - 0.5;
+    const VD rc = 0.180625 - q * q;
+    VD result = q * (((((((rc * 2509.0809287301226727 + 33430.575583588128105) * rc
+                          + 67265.770927008700853) * rc + 45921.953931549871457) * rc
+                          + 13731.693765509461125) * rc + 1971.5909503065514427) * rc
+                          + 133.14166789178437745) * rc + 3.387132872796366608)
+                   / (((((((rc * 5226.495278852545925 + 28729.085735721942674) * rc
+                          + 39307.89580009271061) * rc + 21213.794301586595867) * rc
+                          + 5394.1960214247511077) * rc + 687.1870074920579083) * rc
+                          + 42.313330701600911252) * rc + 1.0);
+
+    const VI tail = abs<W>(q) > 0.425;
+    if (!any<W>(tail)) return result;
+
+    //tails: r = sqrt(-log(min(p, 1-p))), central lanes get a harmless in-range value
+    VD pt = q < 0.0 ? p : 1.0 - p;
+    pt = tail ? pt : broadcast<W>(0.5);
+    const VD r = sqrt<W>(-log<W>(pt));
+
+    const VD rn = r - 1.6;
+    VD t = (((((((rn * 7.7454501427834140764e-4 + 0.0227238449892691845833) * rn
+                 + 0.24178072517745061177) * rn + 1.27045825245236838258) * rn
+                 + 3.64784832476320460504) * rn + 5.7694972214606914055) * rn
+                 + 4.6303378461565452959) * rn + 1.42343711074968357734)
+         / (((((((rn * 1.05075007164441684324e-9 + 5.475938084995344946e-4) * rn
+                 + 0.0151986665636164571966) * rn + 0.14810397642748007459) * rn
+                 + 0.68976733498510000455) * rn + 1.6763848301838038494) * rn
+                 + 2.05319162663775882187) * rn + 1.0);
+
+    //far tail, p below ~1e-11
+    const VI far = r > 5.0;
+    if (any<W>(far & tail)) {
+        const VD rf = r - 5.0;
+        const VD tf = (((((((rf * 2.01033439929228813265e-7 + 2.71155556874348757815e-5) * rf
+                            + 0.0012426609473880784386) * rf + 0.026532189526576123093) * rf
+                            + 0.29656057182850489123) * rf + 1.7848265399172913358) * rf
+                            + 5.4637849111641143699) * rf + 6.6579046435011037772)
+                    / (((((((rf * 2.04426310338993978564e-15 + 1.4215117583164458887e-7) * rf
+                            + 1.8463183175100546818e-5) * rf + 7.868691311456132591e-4) * rf
+                            + 0.0148753612908506148525) * rf + 0.13692988092273580531) * rf
+                            + 0.59983220655588793769) * rf + 1.0);
+        t = far ? tf : t;
+    }
+    t = q < 0.0 ? -t : t;
+    return tail ? t : result;
+}
+
+} // namespace simd
+
+#undef SIMD_INLINE
+
+#endif // OPTION_PRICER_SIMD
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+//for kernels written once on a lane type V: a simd::Vec<W>::d inside the target-specific
+//functions, a plain double in the portable build (the path-dependent and American Monte Carlo loops,
+//the smile strips)
+namespace lanes {
+
+template <class V>
+static OPTION_PRICER_ALWAYS_INLINE V load(const double* p) {
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template <class V>
+static OPTION_PRICER_ALWAYS_INLINE void store(double* p, const V& v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+static inline double exp(double x) { return std::exp(x); }
+static inline double log(double x) { return std::log(x); }
+static inline double sqrt(double x) { return std::sqrt(x); }
+static inline double abs(double x) { return std::abs(x); }
+
+#if OPTION_PRICER_SIMD
+template <class V>
+static inline __attribute__((always_inline)) V exp(const V& x) {
+    return simd::exp<static_cast<int>(sizeof(V) / sizeof(double))>(x);
+}
+
+template <class V>
+static inline __attribute__((always_inline)) V log(const V& x) {
+    return simd::log<static_cast<int>(sizeof(V) / sizeof(double))>(x);
+}
+
+template <class V>
+static inline __attribute__((always_inline)) V sqrt(const V& x) {
+    return simd::sqrt<static_cast<int>(sizeof(V) / sizeof(double))>(x);
+}
+
+template <class V>
+static inline __attribute__((always_inline)) V abs(const V& x) {
+    return simd::abs<static_cast<int>(sizeof(V) / sizeof(double))>(x);
+}
+#endif
+
+//out[i] = f(x[i]) for a functor whose operator() is a template on the lane type, W points at a time
+//(the smile strips of Sabr.cpp and Svi.cpp). A short tail runs as one padded vector, like cdfLoop
+template <class V, class F>
+static OPTION_PRICER_ALWAYS_INLINE void transformLoop(const F& f, const double* x, double* out, size_t n) {
+    constexpr size_t W = sizeof(V) / sizeof(double);
+    size_t i = 0;
+    for (; i + W <= n; i += W) store(out + i, f(load<V>(x + i)));
+    if (i == n) return;
+
+    const size_t rem = n - i;
+    double px[W], o[W];
+    for (size_t j = 0; j < W; ++j) px[j] = x[j < rem ? i + j : i];
+    store(o, f(load<V>(px)));
+    for (size_t j = 0; j < rem; ++j) out[i + j] = o[j];
+}
+
+#if OPTION_PRICER_SIMD
+
+template <class F>
+__attribute__((target("avx512f")))
+static void transformAvx512(const F& f, const double* x, double* out, size_t n) {
+    transformLoop<simd::Vec<8>::d>(f, x, out, n);
+}
+
+template <class F>
+__attribute__((target("avx2,fma")))
+static void transformAvx2(const F& f, const double* x, double* out, size_t n) {
+    transformLoop<simd::Vec<4>::d>(f, x, out, n);
+}
+
+template <class F>
+static void transformSse2(const F& f, const double* x, double* out, size_t n) {
+    transformLoop<simd::Vec<2>::d>(f, x, out, n);
+}
+
+#endif // OPTION_PRICER_SIMD
+
+//level caps the instruction set, clamped to what the CPU supports
+template <class F>
+static void transform(const F& f, const double* x, double* out, size_t n, SimdLevel level) {
+    level = std::min(level, detectSimdLevel());
+#if OPTION_PRICER_SIMD
+    switch (level) {
+        case SimdLevel::AVX512: transformAvx512(f, x, out, n); return;
+        case SimdLevel::AVX2:   transformAvx2(f, x, out, n);   return;
+        case SimdLevel::SSE2:   transformSse2(f, x, out, n);   return;
+        default: break;
+    }
+#endif
+    transformLoop<double>(f, x, out, n);
+}
+
+} // namespace lanes
+
+#endif // SIMD_MATH_H
@@ -0,0 +1,90 @@
+// SnapshotRegistry.h
+#ifndef SNAPSHOT_REGISTRY_H
+#define SNAPSHOT_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//immutable market objects by name (a vol surface per underlying, a curve per currency), published
+//read-copy-update style: the name -> object map is itself an immutable snapshot behind one atomic
+//shared_ptr. A reader takes the current map with one atomic load and keeps whatever object it found
+//alive for as long as it holds the pointer, so a request prices against one consistent snapshot and never
+//waits while a publisher builds the next one. Publishers copy the map, swap in the new object and store
+//the new map, one at a time under a mutex only they take. Old snapshots are freed by the last reader to
+//drop them.
+//std::atomic<std::shared_ptr> is not lock-free in libstdc++ (is_lock_free() is false): every load and
+//store holds a spin lock in the pointer for the few instructions of a reference count update, so a
+//reader can spin briefly behind another reader's load or the publisher's final store, never behind a
+//map copy or an object build
+//
+//capacity bounds the number of names, and with it each publish's O(names) map copy: publishing a new
+//name past it throws std::length_error and leaves the registry as it was
+template <class T>
+class SnapshotRegistry {
+public:
+    using Snapshot = std::shared_ptr<const T>;
+
+    explicit SnapshotRegistry(size_t capacity = std::numeric_limits<size_t>::max())
+        : map_(std::make_shared<const Map>()), capacity_(capacity) {}
+
+    //null if nothing has been published under name
+    Snapshot get(const std::string& name) const {
+        const std::shared_ptr<const Map> map = map_.load(std::memory_order_acquire);
+        const auto it = map->find(name);
+        return it == map->end() ? nullptr : it->second;
+    }
+
+    void publish(const std::string& name, Snapshot value) {
+        std::lock_guard<std::mutex> lock(writer_);
+        const std::shared_ptr<const Map> map = map_.load(std::memory_order_relaxed);
+        checkCapacity(*map, name);
+        auto next = std::make_shared<Map>(*map);
+        (*next)[name] = std::move(value);
+        map_.store(std::move(next), std::memory_order_release);
+    }
+
+    //read-modify-write: make(current) builds the replacement from the current object (null if none),
+    //with no other publish in between. An exception from make leaves the registry as it was
+    template <class Make>
+    Snapshot update(const std::string& name, Make&& make) {
+        std::lock_guard<std::mutex> lock(writer_);
+        const std::shared_ptr<const Map> map = map_.load(std::memory_order_relaxed);
+        const auto it = map->find(name);
+        if (it == map->end()) checkCapacity(*map, name);
+        Snapshot value = make(it == map->end() ? nullptr : it->second);
+        auto next = std::make_shared<Map>(*map);
+        (*next)[name] = value;
+        map_.store(std::move(next), std::memory_order_release);
+        return value;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> out;
+        for (const auto& entry : *map_.load(std::memory_order_acquire)) out.push_back(entry.first);
+        return out;
+    }
+
+private:
+    using Map = std::unordered_map<std::string, Snapshot>;
+
+    void checkCapacity(const Map& map, const std::string& name) const {
+        if (map.size() >= capacity_ && map.find(name) == map.end()) {
+            throw std::length_error("at most " + std::to_string(capacity_) + " names can be published");
+        }
+    }
+
+    std::atomic<std::shared_ptr<const Map>> map_;
+    std::mutex writer_;
+    size_t capacity_;
+};
+
+#endif // SNAPSHOT_REGISTRY_H
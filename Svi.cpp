@@ -0,0 +1,152 @@
+// Svi.cpp
+#include "SimdMath.h"
+#include "Svi.h"
+#include <algorithm>
+#include <stdexcept>
+
+void validateSvi(const SviParams& p) {
+    if (!(p.b >= 0.0) || !(p.rho > -1.0 && p.rho < 1.0) || !(p.sigma > 0.0)
+        || !(p.a + p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho) >= 0.0) || !(p.b * (1.0 + std::abs(p.rho)) <= 2.0)) {
+        throw std::invalid_argument("svi parameters need b >= 0, -1 < rho < 1, sigma > 0, "
+                                    "a + b sigma sqrt(1 - rho^2) >= 0 and b (1 + |rho|) <= 2");
+    }
+}
+
+double sviTotalVariance(double k, const SviParams& p) {
+    return sviTotalVariance(k, p.a, p.b, p.rho, p.m, p.sigma);
+}
+
+void validateSsvi(const SsviParams& p) {
+    if (!(p.rho > -1.0 && p.rho < 1.0) || !(p.eta > 0.0) || !(p.gamma > 0.0 && p.gamma <= 0.5)
+        || !(p.eta * (1.0 + std::abs(p.rho)) <= 2.0)) {
+        throw std::invalid_argument("ssvi parameters need -1 < rho < 1, eta > 0, 0 < gamma <= 1/2 "
+                                    "and eta (1 + |rho|) <= 2");
+    }
+}
+
+double ssviTotalVariance(double k, double theta, const SsviParams& p) {
+    return ssviTotalVariance(k, theta, p.rho, p.eta, p.gamma);
+}
+
+//----- SviSurface -----
+
+template <class V>
+static OPTION_PRICER_ALWAYS_INLINE V sviLanes(const V& k, const SviParams& p) {
+    const V x = k - p.m;
+    return p.a + p.b * (p.rho * x + lanes::sqrt(x * x + p.sigma * p.sigma));
+}
+
+//the vols of one expiry from the slices around it, weights as in SabrStrip (Sabr.cpp). Every slice
+//is a function of the same log-moneyness, so k = ln K - ln F(T) is the only log per strike
+struct SviStrip {
+    double lf, inv_T;
+    const SviParams* lo;
+    const SviParams* hi;  //null outside the slices or on one
+    double lo_weight, hi_weight;
+
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& K) const {
+        const V k = lanes::log(K) - lf;
+        V w = lo_weight * sviLanes(k, *lo);
+        if (hi) w = w + hi_weight * sviLanes(k, *hi);
+        return lanes::sqrt(w * inv_T);
+    }
+};
+
+SviSurface::SviSurface(double S, double r, std::vector<SviSlice> slices)
+    : S_(S), r_(r), slices_(std::move(slices)) {
+    if (!(S > 0.0) || slices_.empty()) {
+        throw std::invalid_argument("an svi surface needs a positive spot and at least one slice");
+    }
+    for (const SviSlice& slice : slices_) {
+        if (!(slice.expiry > 0.0)) {
+            throw std::invalid_argument("slice expiries must be positive");
+        }
+        validateSvi(slice.params);
+    }
+    std::sort(slices_.begin(), slices_.end(), [](const SviSlice& a, const SviSlice& b) { return a.expiry < b.expiry; });
+}
+
+void SviSurface::smile(double T, const double* K, double* out, size_t n, SimdLevel level) const {
+    if (!(T > 0.0)) {
+        throw std::invalid_argument("expiry must be positive");
+    }
+    const auto after = std::upper_bound(slices_.begin(), slices_.end(), T,
+                                        [](double t, const SviSlice& slice) { return t < slice.expiry; });
+    SviStrip strip{std::log(S_) + r_ * T, 1.0 / T, nullptr, nullptr, 0.0, 0.0};
+    if (after == slices_.begin() || after == slices_.end()) {
+        //flat vol: the nearest slice's total variance rescaled to T
+        const SviSlice& nearest = after == slices_.begin() ? slices_.front() : slices_.back();
+        strip.lo = &nearest.params;
+        strip.lo_weight = T / nearest.expiry;
+    } else {
+        const SviSlice& lo = *(after - 1);
+        const SviSlice& hi = *after;
+        strip.lo = &lo.params;
+        strip.hi = &hi.params;
+        strip.hi_weight = (T - lo.expiry) / (hi.expiry - lo.expiry);
+        strip.lo_weight = 1.0 - strip.hi_weight;
+    }
+    lanes::transform(strip, K, out, n, level);
+}
+
+double SviSurface::vol(double K, double T) const {
+    double out;
+    smile(T, &K, &out, 1, SimdLevel::SCALAR);
+    return out;
+}
+
+//----- SsviSurface -----
+
+//theta and phi are fixed for the expiry, a strike is a log, a sqrt for w and one for the vol
+struct SsviStrip {
+    double lf, inv_T, theta, phi, rho;
+
+    template <class V>
+    OPTION_PRICER_ALWAYS_INLINE V operator()(const V& K) const {
+        const V pk = phi * (lanes::log(K) - lf);
+        const V w = 0.5 * theta * (1.0 + rho * pk + lanes::sqrt((pk + rho) * (pk + rho) + (1.0 - rho * rho)));
+        return lanes::sqrt(w * inv_T);
+    }
+};
+
+SsviSurface::SsviSurface(double S, double r, const SsviParams& params, std::vector<double> expiries,
+                         std::vector<double> thetas)
+    : S_(S), r_(r), params_(params), expiries_(std::move(expiries)), thetas_(std::move(thetas)) {
+    validateSsvi(params_);
+    if (!(S > 0.0) || expiries_.empty() || expiries_.size() != thetas_.size()) {
+        throw std::invalid_argument("an ssvi surface needs a positive spot and one theta per expiry");
+    }
+    for (size_t i = 0; i < expiries_.size(); ++i) {
+        if (!(expiries_[i] > 0.0) || !(thetas_[i] > 0.0)) {
+            throw std::invalid_argument("ssvi expiries and thetas must be positive");
+        }
+        if (i > 0 && (!(expiries_[i] > expiries_[i - 1]) || thetas_[i] < thetas_[i - 1])) {
+            throw std::invalid_argument("ssvi expiries must increase and thetas must not decrease");
+        }
+    }
+}
+
+double SsviSurface::theta(double T) const {
+    const auto after = std::upper_bound(expiries_.begin(), expiries_.end(), T);
+    if (after == expiries_.begin()) return thetas_.front() * T / expiries_.front();
+    if (after == expiries_.end()) return thetas_.back() * T / expiries_.back();
+    const size_t i = after - expiries_.begin();
+    const double t = (T - expiries_[i - 1]) / (expiries_[i] - expiries_[i - 1]);
+    return thetas_[i - 1] + t * (thetas_[i] - thetas_[i - 1]);
+}
+
+void SsviSurface::smile(double T, const double* K, double* out, size_t n, SimdLevel level) const {
+    if (!(T > 0.0)) {
+        throw std::invalid_argument("expiry must be positive");
+    }
+    const double th = theta(T);
+    const double phi = params_.eta / (std::pow(th, params_.gamma) * std::pow(1.0 + th, 1.0 - params_.gamma));
+    lanes::transform(SsviStrip{std::log(S_) + r_ * T, 1.0 / T, th, phi, params_.rho}, K, out, n, level);
+}
+
+double SsviSurface::vol(double K, double T) const {
+    double out;
+    smile(T, &K, &out, 1, SimdLevel::SCALAR);
+    return out;
+}
@@ -0,0 +1,111 @@
+// Svi.h
+#ifndef SVI_H
+#define SVI_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "AutoDiff.h"
+#include "SimdLevel.h"
+
+//Gatheral's SVI ("stochastic volatility inspired") smiles, written in total implied variance
+//w(k) = vol^2 T as a function of log-moneyness k = ln(K / F). A vol is one square root away from w,
+//so pricing an off-grid strike costs one smile evaluation and one black-scholes evaluation
+
+//raw SVI of one expiry: w(k) = a + b (rho (k - m) + sqrt((k - m)^2 + sigma^2))
+struct SviParams {
+    double a;      //variance level
+    double b;      //wing slope
+    double rho;    //wing asymmetry
+    double m;      //smile's horizontal shift
+    double sigma;  //curvature at the minimum
+};
+
+//throws std::invalid_argument unless b >= 0, -1 < rho < 1, sigma > 0, the minimum a + b sigma sqrt(1 - rho^2)
+//is non-negative and b (1 + |rho|) <= 2 (Lee's moment bound on the slope of w in the wings). These are
+//necessary conditions only: butterfly arbitrage between the wings (Durrleman's g(k) >= 0) is not checked
+void validateSvi(const SviParams& params);
+
+//on the number type R of the parameters, for calibration gradients through Jets (AutoDiff.h)
+template <class R>
+R sviTotalVariance(double k, const R& a, const R& b, const R& rho, const R& m, const R& sigma) {
+    using std::sqrt;
+    const R x = k - m;
+    return a + b * (rho * x + sqrt(x * x + sigma * sigma));
+}
+
+double sviTotalVariance(double k, const SviParams& params);
+
+//SSVI (Gatheral & Jacquier 2014): one smile shape for every expiry, scaled by the at-the-money total
+//variance theta_t: w(k) = theta / 2 (1 + rho phi k + sqrt((phi k + rho)^2 + 1 - rho^2)), with the
+//power-law phi(theta) = eta / (theta^gamma (1 + theta)^(1 - gamma)). The surface is free of static
+//arbitrage when eta (1 + |rho|) <= 2, 0 < gamma <= 1/2 and theta_t does not decrease with t
+struct SsviParams {
+    double rho;
+    double eta;
+    double gamma;
+};
+
+//throws std::invalid_argument unless -1 < rho < 1, eta > 0, 0 < gamma <= 1/2 and eta (1 + |rho|) <= 2
+void validateSsvi(const SsviParams& params);
+
+template <class R>
+R ssviTotalVariance(double k, double theta, const R& rho, const R& eta, const R& gamma) {
+    using std::exp;
+    using std::sqrt;
+    const R phi = eta * exp(-gamma * std::log(theta) - (1.0 - gamma) * std::log1p(theta));
+    const R pk = phi * k;
+    return 0.5 * theta * (1.0 + rho * pk + sqrt((pk + rho) * (pk + rho) + 1.0 - rho * rho));
+}
+
+double ssviTotalVariance(double k, double theta, const SsviParams& params);
+
+//one expiry's fitted raw parameters (calibrateSvi in Calibration.h)
+struct SviSlice {
+    double expiry;
+    SviParams params;
+};
+
+//vols for any strike and expiry from raw SVI slices on forwards F(T) = S e^(rT), interpolated between
+//slices as in SabrSurface: total variance linear in T at the same log-moneyness, the nearest slice's vol
+//held flat outside them
+class SviSurface {
+public:
+    //throws std::invalid_argument for no slices, non-positive spot or expiries, or invalid parameters
+    SviSurface(double S, double r, std::vector<SviSlice> slices);
+
+    double vol(double K, double T) const;
+    //vols of n strikes at one expiry, vectorized across the strikes
+    void smile(double T, const double* K, double* out, size_t n, SimdLevel level = SimdLevel::AVX512) const;
+
+    const std::vector<SviSlice>& slices() const { return slices_; }
+
+private:
+    double S_, r_;
+    std::vector<SviSlice> slices_;  //by increasing expiry
+};
+
+//an SSVI surface: the at-the-money total variance theta is given at increasing expiries and linear in T
+//between them; before the first it is theta_1 T / T_1 and past the last the at-the-money vol stays flat
+class SsviSurface {
+public:
+    //throws std::invalid_argument for invalid parameters, non-positive spot, expiries or thetas, expiries
+    //not increasing or thetas decreasing (calendar arbitrage)
+    SsviSurface(double S, double r, const SsviParams& params, std::vector<double> expiries,
+                std::vector<double> thetas);
+
+    double theta(double T) const;
+    double vol(double K, double T) const;
+    void smile(double T, const double* K, double* out, size_t n, SimdLevel level = SimdLevel::AVX512) const;
+
+    const SsviParams& params() const { return params_; }
+    const std::vector<double>& expiries() const { return expiries_; }
+    const std::vector<double>& thetas() const { return thetas_; }
+
+private:
+    double S_, r_;
+    SsviParams params_;
+    std::vector<double> expiries_, thetas_;
+};
+
+#endif // SVI_H
@@ -0,0 +1,120 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    //the caller of parallelFor is one of the threads, so start one fewer worker
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            busy_workers_.fetch_add(1, std::memory_order_relaxed);
+        }
+        task();
+        busy_workers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+ThreadPoolStats ThreadPool::stats() {
+    ThreadPoolStats s;
+    s.threads = size();
+    s.busyWorkers = busy_workers_.load(std::memory_order_relaxed);
+    s.activeCalls = active_calls_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.queuedTasks = tasks_.size();
+    return s;
+}
+
+//shared between the caller and its helpers; helpers may start after the work is already
+//finished, so they hold it by shared_ptr and only touch fn while indices are left
+struct ParallelForState {
+    std::atomic<size_t> next{0};
+    size_t count = 0;
+    const std::function<void(size_t)>* fn = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t done = 0;
+    std::exception_ptr error;
+
+    //claim and run indices until none are left
+    void run() {
+        for (;;) {
+            size_t i = next.fetch_add(1);
+            if (i >= count) return;
+            std::exception_ptr failure;
+            try {
+                (*fn)(i);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (failure && !error) error = failure;
+            if (++done == count) done_cv.notify_all();
+        }
+    }
+};
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned max_threads) {
+    if (count == 0) return;
+    active_calls_.fetch_add(1, std::memory_order_relaxed);
+    struct CallGuard {
+        std::atomic<unsigned>& calls;
+        ~CallGuard() { calls.fetch_sub(1, std::memory_order_relaxed); }
+    } guard{active_calls_};
+
+    unsigned threads = max_threads == 0 ? size() : std::min(max_threads, size());
+    if (threads <= 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->count = count;
+    state->fn = &fn;
+
+    const size_t helpers = std::min<size_t>(threads - 1, count - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t h = 0; h < helpers; ++h) {
+            tasks_.emplace_back([state] { state->run(); });
+        }
+    }
+    cv_.notify_all();
+
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done_cv.wait(lock, [&] { return state->done == state->count; });
+    if (state->error) std::rethrow_exception(state->error);
+}
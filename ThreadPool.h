@@ -0,0 +1,59 @@
+// ThreadPool.h
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <atomic>
+#include <cstddef>
+
+//point-in-time load figures, for readiness checks
+struct ThreadPoolStats {
+    unsigned threads;      //size(), workers plus one calling thread
+    unsigned busyWorkers;  //workers currently running a task
+    unsigned activeCalls;  //parallelFor calls in progress (one per pricing request using the pool)
+    size_t queuedTasks;    //helper tasks waiting for a free worker
+};
+
+//fixed set of worker threads shared by the pricing engines
+//work is handed out as index ranges with parallelFor, the calling thread always helps,
+//so a request never waits on the pool to make progress (and nested calls cannot deadlock)
+class ThreadPool {
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::atomic<unsigned> busy_workers_{0};
+    std::atomic<unsigned> active_calls_{0};
+
+    void workerLoop();
+
+public:
+    //0 threads means one per hardware thread
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //process-wide pool, created on first use
+    static ThreadPool& shared();
+
+    //calls fn(i) for every i in [0, count), spread over at most max_threads threads
+    //(including the caller, 0 = all workers). Returns when every call has finished,
+    //rethrows the first exception thrown by fn
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned max_threads = 0);
+
+    //threads that can run work at once: the workers plus the calling thread
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    ThreadPoolStats stats();
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,41 @@
+// VolSource.h
+#ifndef VOL_SOURCE_H
+#define VOL_SOURCE_H
+
+#include <concepts>
+#include <vector>
+#include "BatchPricer.h"
+#include "OptionPricer.h"
+
+//a volatility for any strike and expiry in place of the flat sigma of OptionPricer: SabrSurface
+//(Sabr.h), SviSurface and SsviSurface (Svi.h). vol(K, T) for one contract, smile(T, K, out, n, level)
+//for the strikes of one expiry at once
+template <class S>
+concept VolSource = requires(const S& source, double x, const double* in, double* out, size_t n, SimdLevel level) {
+    { source.vol(x, x) } -> std::convertible_to<double>;
+    source.smile(x, in, out, n, level);
+};
+
+//black-scholes price and greeks at the source's vol for the strike and expiry (sticky-strike greeks:
+//the vol is held fixed as S moves). The source's forwards should use the same S and r
+template <VolSource Source>
+PriceGreeks priceWithSmile(double S, double K, double T, double r, const Source& source, OptionType type) {
+    return OptionPricer::priceWithGreeks(S, K, T, r, source.vol(K, T), type);
+}
+
+//blackScholesBatch with sigma from the source: every run of contracts sharing an expiry (an option
+//chain sorted by expiry is a few long runs) gets its vols from one vectorized smile call
+template <VolSource Source>
+void blackScholesBatch(const double* S, const double* K, const double* T, const double* r, const Source& source,
+                       const OptionType* type, double* out, size_t n, SimdLevel level = SimdLevel::AVX512) {
+    std::vector<double> sigma(n);
+    for (size_t begin = 0; begin < n;) {
+        size_t end = begin + 1;
+        while (end < n && T[end] == T[begin]) ++end;
+        source.smile(T[begin], K + begin, sigma.data() + begin, end - begin, level);
+        begin = end;
+    }
+    blackScholesBatch(S, K, T, r, sigma.data(), type, out, n, level);
+}
+
+#endif // VOL_SOURCE_H
@@ -0,0 +1,194 @@
+// VolSurface.cpp
+#include "VolSurface.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+//bucket table size cap, grids with wildly uneven spacing take a few extra steps instead of a huge table
+constexpr size_t kMaxBucketsPerCell = 64;
+
+const char* volInterpolationName(VolInterpolation interpolation) {
+    return interpolation == VolInterpolation::BILINEAR ? "bilinear" : "bicubic";
+}
+
+void VolSurface::Axis::build(const std::vector<double>& points) {
+    knots = points;
+    const size_t cells = knots.size() - 1;
+    double gap = knots[1] - knots[0];
+    for (size_t i = 1; i < cells; ++i) gap = std::min(gap, knots[i + 1] - knots[i]);
+    const double span = knots.back() - knots.front();
+    const size_t buckets = std::clamp<size_t>(static_cast<size_t>(std::ceil(span / gap)), cells, kMaxBucketsPerCell * cells);
+    origin = knots.front();
+    scale = buckets / span;
+    first.resize(buckets);
+    for (size_t b = 0; b < buckets; ++b) {
+        const double left = origin + b / scale;
+        const size_t i = std::upper_bound(knots.begin(), knots.end(), left) - knots.begin();
+        first[b] = static_cast<std::uint32_t>(std::min(i == 0 ? 0 : i - 1, cells - 1));
+    }
+}
+
+size_t VolSurface::Axis::locate(double x, double& t) const {
+    x = std::clamp(x, knots.front(), knots.back());
+    size_t i = first[std::min(static_cast<size_t>((x - origin) * scale), first.size() - 1)];
+    while (i + 2 < knots.size() && x >= knots[i + 1]) ++i;
+    t = (x - knots[i]) / (knots[i + 1] - knots[i]);
+    return i;
+}
+
+VolSurface::VolSurface(std::vector<double> strikes, std::vector<double> expiries, const std::vector<double>& vols,
+                       VolInterpolation interpolation)
+    : strikes_(std::move(strikes)), expiries_(std::move(expiries)), interpolation_(interpolation),
+      stride_(interpolation == VolInterpolation::BICUBIC ? 16 : 4) {
+    const size_t m = strikes_.size(), n = expiries_.size();
+    if (m < 2 || n < 2 || vols.size() != m * n) {
+        throw std::invalid_argument("a vol surface needs at least two strikes and two expiries and one vol per node");
+    }
+    for (size_t i = 0; i < m; ++i) {
+        if (!(strikes_[i] > 0.0) || (i > 0 && !(strikes_[i] > strikes_[i - 1]))) {
+            throw std::invalid_argument("surface strikes must be positive and increasing");
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!(expiries_[i] > 0.0) || (i > 0 && !(expiries_[i] > expiries_[i - 1]))) {
+            throw std::invalid_argument("surface expiries must be positive and increasing");
+        }
+    }
+    std::vector<double> logK(m);
+    for (size_t i = 0; i < m; ++i) logK[i] = std::log(strikes_[i]);
+    x_.build(logK);
+    t_.build(expiries_);
+
+    variance_.resize(m * n);
+    for (size_t row = 0; row < n; ++row) {
+        for (size_t col = 0; col < m; ++col) {
+            const double vol = vols[row * m + col];
+            if (!(vol > 0.0) || !std::isfinite(vol)) {
+                throw std::invalid_argument("surface vols must be positive");
+            }
+            variance_[row * m + col] = vol * vol * expiries_[row];
+        }
+    }
+    coefficients_.resize((n - 1) * (m - 1) * stride_);
+    for (size_t row = 0; row + 1 < n; ++row) {
+        for (size_t col = 0; col + 1 < m; ++col) buildCell(row, col);
+    }
+}
+
+//slope at knot i of the parabola through it and its neighbours, one-sided at the ends
+static double nodeSlope(const std::vector<double>& knots, size_t i, double fm, double f0, double fp) {
+    const size_t last = knots.size() - 1;
+    if (i == 0) return (fp - f0) / (knots[1] - knots[0]);
+    if (i == last) return (f0 - fm) / (knots[last] - knots[last - 1]);
+    const double h0 = knots[i] - knots[i - 1], h1 = knots[i + 1] - knots[i];
+    return (h1 * h1 * (f0 - fm) + h0 * h0 * (fp - f0)) / (h0 * h1 * (h0 + h1));
+}
+
+void VolSurface::buildCell(size_t row, size_t col) {
+    const size_t m = strikes_.size(), n = expiries_.size();
+    auto w = [&](size_t r, size_t c) { return variance_[r * m + c]; };
+    double* a = coefficients_.data() + (row * (m - 1) + col) * stride_;
+    if (interpolation_ == VolInterpolation::BILINEAR) {
+        a[0] = w(row, col);
+        a[1] = w(row, col + 1) - w(row, col);
+        a[2] = w(row + 1, col) - w(row, col);
+        a[3] = w(row + 1, col + 1) - w(row + 1, col) - w(row, col + 1) + w(row, col);
+        return;
+    }
+
+    //derivatives along ln K, along T and across both at node (r, c), neighbours clamped at the edges
+    auto dx = [&](size_t r, size_t c) {
+        return nodeSlope(x_.knots, c, w(r, c > 0 ? c - 1 : c), w(r, c), w(r, c + 1 < m ? c + 1 : c));
+    };
+    auto dt = [&](size_t r, size_t c) {
+        return nodeSlope(t_.knots, r, w(r > 0 ? r - 1 : r, c), w(r, c), w(r + 1 < n ? r + 1 : r, c));
+    };
+    auto dxt = [&](size_t r, size_t c) {
+        return nodeSlope(t_.knots, r, dx(r > 0 ? r - 1 : r, c), dx(r, c), dx(r + 1 < n ? r + 1 : r, c));
+    };
+    //Hermite data in the cell's unit square, u along ln K and v along T: F = [f fv; fu fuv] at the corners
+    const double hx = x_.knots[col + 1] - x_.knots[col], ht = t_.knots[row + 1] - t_.knots[row];
+    double F[4][4];
+    for (int du = 0; du < 2; ++du) {
+        for (int dv = 0; dv < 2; ++dv) {
+            const size_t r = row + dv, c = col + du;
+            F[du][dv] = w(r, c);
+            F[du][2 + dv] = dt(r, c) * ht;
+            F[2 + du][dv] = dx(r, c) * hx;
+            F[2 + du][2 + dv] = dxt(r, c) * hx * ht;
+        }
+    }
+    //a = M F M^T, a[i][j] the coefficient of u^i v^j
+    static const double M[4][4] = {{1, 0, 0, 0}, {0, 0, 1, 0}, {-3, 3, -2, -1}, {2, -2, 1, 1}};
+    double MF[4][4];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            MF[i][j] = 0.0;
+            for (int k = 0; k < 4; ++k) MF[i][j] += M[i][k] * F[k][j];
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            double sum = 0.0;
+            for (int k = 0; k < 4; ++k) sum += MF[i][k] * M[j][k];
+            a[i * 4 + j] = sum;
+        }
+    }
+}
+
+double VolSurface::evaluate(size_t row, double v, size_t col, double u) const {
+    const double* a = coefficients_.data() + (row * (strikes_.size() - 1) + col) * stride_;
+    if (interpolation_ == VolInterpolation::BILINEAR) {
+        return a[0] + a[1] * u + (a[2] + a[3] * u) * v;
+    }
+    double p = 0.0;
+    for (int i = 3; i >= 0; --i) {
+        const double* ai = a + i * 4;
+        p = p * u + (((ai[3] * v + ai[2]) * v + ai[1]) * v + ai[0]);
+    }
+    return p;
+}
+
+double VolSurface::vol(double K, double T) const {
+    double out;
+    smile(T, &K, &out, 1);
+    return out;
+}
+
+void VolSurface::smile(double T, const double* K, double* out, size_t n, SimdLevel) const {
+    if (!(T > 0.0)) {
+        throw std::invalid_argument("expiry must be positive");
+    }
+    //flat vol outside the expiries: total variance at the nearest one, over its own expiry
+    const double Tc = std::clamp(T, expiries_.front(), expiries_.back());
+    const double inv_T = 1.0 / Tc;
+    double v;
+    const size_t row = t_.locate(Tc, v);
+    for (size_t i = 0; i < n; ++i) {
+        double u;
+        const size_t col = x_.locate(std::log(K[i]), u);
+        //a cubic between nodes can dip below zero on a steep smile, no negative variance
+        out[i] = std::sqrt(std::max(evaluate(row, v, col, u), 0.0) * inv_T);
+    }
+}
+
+void VolSurface::setVol(size_t expiry, size_t strike, double vol) {
+    const size_t m = strikes_.size(), n = expiries_.size();
+    if (expiry >= n || strike >= m) {
+        throw std::out_of_range("no such surface node");
+    }
+    if (!(vol > 0.0) || !std::isfinite(vol)) {
+        throw std::invalid_argument("surface vols must be positive");
+    }
+    variance_[expiry * m + strike] = vol * vol * expiries_[expiry];
+    //a node's value enters its own cells and, through the slopes, those of its neighbours
+    const size_t reach = interpolation_ == VolInterpolation::BICUBIC ? 2 : 1;
+    const size_t row_end = std::min(expiry + reach, n - 1), col_end = std::min(strike + reach, m - 1);
+    for (size_t row = expiry > reach ? expiry - reach : 0; row < row_end; ++row) {
+        for (size_t col = strike > reach ? strike - reach : 0; col < col_end; ++col) buildCell(row, col);
+    }
+}
+
+double VolSurface::nodeVol(size_t expiry, size_t strike) const {
+    return std::sqrt(variance_.at(expiry * strikes_.size() + strike) / expiries_.at(expiry));
+}
@@ -0,0 +1,69 @@
+// VolSurface.h
+#ifndef VOL_SURFACE_H
+#define VOL_SURFACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SimdLevel.h"
+
+//market implied vols on a strike x expiry grid, interpolated at any (K, T) in constant time: the
+//surface keeps total variance vol^2 T at the nodes and, per grid cell, the coefficients of its
+//interpolating polynomial in (ln K, T), precomputed in one flat array (a cell is 4 or 16 contiguous
+//doubles). Finding the cell is an index into a bucket table, no search. Between expiries total variance
+//is linear (bilinear) or cubic (bicubic) in T, outside the grid the nearest edge's vol is held flat.
+//A VolSource (VolSource.h), so anything priced from a SABR or SVI surface can be priced from market vols
+enum class VolInterpolation {
+    BILINEAR,  //continuous, kinks at the nodes
+    BICUBIC    //Hermite bicubic, slopes from the parabola through each node and its neighbours
+};
+
+const char* volInterpolationName(VolInterpolation interpolation);
+
+class VolSurface {
+public:
+    //strikes and expiries increasing, at least two of each; vols row-major, one row of strikes per expiry.
+    //Throws std::invalid_argument for a grid that is not increasing and positive or a non-positive vol
+    VolSurface(std::vector<double> strikes, std::vector<double> expiries, const std::vector<double>& vols,
+               VolInterpolation interpolation = VolInterpolation::BICUBIC);
+
+    double vol(double K, double T) const;
+    //vols of n strikes at one expiry: the expiry's cell row and position are found once. The lookups gather
+    //from different cells, so level is accepted for VolSource and not used
+    void smile(double T, const double* K, double* out, size_t n, SimdLevel level = SimdLevel::AVX512) const;
+
+    //replaces one node's vol and recomputes only the cells whose coefficients depend on it (the 4 x 4
+    //block of cells around it for bicubic, 2 x 2 for bilinear), for streaming single-quote updates
+    void setVol(size_t expiry, size_t strike, double vol);
+    double nodeVol(size_t expiry, size_t strike) const;
+
+    const std::vector<double>& strikes() const { return strikes_; }
+    const std::vector<double>& expiries() const { return expiries_; }
+    VolInterpolation interpolation() const { return interpolation_; }
+
+private:
+    //one grid direction: the knots and a table of buckets narrower than the closest pair of knots (up to
+    //kMaxBucketsPerCell per cell), each holding the cell its left edge falls in, so locating a point is one
+    //multiply and at most a step to the next cell
+    struct Axis {
+        std::vector<double> knots;
+        double origin = 0.0, scale = 0.0;
+        std::vector<std::uint32_t> first;
+
+        void build(const std::vector<double>& points);
+        //cell of x (clamped to the knots) and the position in it, 0..1
+        size_t locate(double x, double& t) const;
+    };
+
+    void buildCell(size_t row, size_t col);
+    double evaluate(size_t row, double v, size_t col, double u) const;
+
+    std::vector<double> strikes_, expiries_;
+    VolInterpolation interpolation_;
+    Axis x_, t_;                      //ln K and T
+    std::vector<double> variance_;    //vol^2 T per node, row-major expiries x strikes
+    size_t stride_;                   //coefficients per cell: 4 or 16
+    std::vector<double> coefficients_;  //row-major (expiries - 1) x (strikes - 1) cells
+};
+
+#endif // VOL_SURFACE_H
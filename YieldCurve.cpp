@@ -0,0 +1,337 @@
+// YieldCurve.cpp
+#include "YieldCurve.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+static_assert((kCurveCacheSlots & (kCurveCacheSlots - 1)) == 0, "kCurveCacheSlots must be a power of two");
+
+//swap knots are re-solved until none moves by more than this in ln D
+constexpr double kBootstrapTolerance = 1e-15;
+constexpr int kBootstrapSweeps = 100;
+
+const char* curveInterpolationName(CurveInterpolation interpolation) {
+    return interpolation == CurveInterpolation::LOG_LINEAR ? "log_linear" : "monotone_convex";
+}
+
+static std::uint64_t bitsOf(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static double fromBits(std::uint64_t bits) {
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+//Hagan & West's forward on one interval, x in [0, 1], as its offset g(x) from the interval's discrete
+//forward, or the integral G(x) of g from 0 (G(1) = 0, which keeps D at the knots). g0 and g1 are the
+//offsets of the instantaneous forwards at the two ends; the four regions of (g0, g1) each get the
+//lowest-order shape that stays monotone between them
+static double monotoneConvex(double g0, double g1, double x, bool integral) {
+    if (g0 == 0.0 && g1 == 0.0) return 0.0;
+    //opposite signs, neither end much larger: one quadratic
+    if ((g0 < 0.0 && -0.5 * g0 <= g1 && g1 <= -2.0 * g0) || (g0 > 0.0 && -0.5 * g0 >= g1 && g1 >= -2.0 * g0)) {
+        const double x2 = x * x, x3 = x2 * x;
+        return integral ? g0 * (x - 2.0 * x2 + x3) + g1 * (x3 - x2) : g0 * (1.0 - 4.0 * x + 3.0 * x2) + g1 * (3.0 * x2 - 2.0 * x);
+    }
+    //g1 the larger: flat at g0, then a quadratic to g1
+    if ((g0 < 0.0 && g1 > -2.0 * g0) || (g0 > 0.0 && g1 < -2.0 * g0)) {
+        const double eta = (g1 + 2.0 * g0) / (g1 - g0);
+        if (x <= eta) return integral ? g0 * x : g0;
+        const double s = (x - eta) / (1.0 - eta);
+        return integral ? g0 * x + (g1 - g0) * (x - eta) * s * s / 3.0 : g0 + (g1 - g0) * s * s;
+    }
+    //g0 the larger: a quadratic from g0, then flat at g1
+    if ((g0 > 0.0 && 0.0 > g1 && g1 > -0.5 * g0) || (g0 < 0.0 && 0.0 < g1 && g1 < -0.5 * g0)) {
+        const double eta = 3.0 * g1 / (g1 - g0);
+        if (x >= eta) return integral ? g1 * x + (g0 - g1) * eta / 3.0 : g1;
+        const double s = (eta - x) / eta;
+        return integral ? g1 * x + (g0 - g1) * (eta - (eta - x) * s * s) / 3.0 : g1 + (g0 - g1) * s * s;
+    }
+    //same signs: two quadratics meeting at their common extremum A
+    const double eta = g1 / (g1 + g0);
+    const double A = -g0 * g1 / (g0 + g1);
+    //one end exactly on the discrete forward (flat curves, repeated rates): the limit is g = 0 with the
+    //other end's quadratic squeezed to nothing, and eta = 0 or 1 would divide 0 by 0 below
+    if (!(eta > 0.0 && eta < 1.0)) {
+        if (integral) return 0.0;
+        return x <= 0.0 ? g0 : (x >= 1.0 ? g1 : 0.0);
+    }
+    if (x < eta) {
+        const double s = (eta - x) / eta;
+        return integral ? A * x + (g0 - A) * (eta - (eta - x) * s * s) / 3.0 : A + (g0 - A) * s * s;
+    }
+    const double s = (x - eta) / (1.0 - eta);
+    return integral ? A * x + (g0 - A) * eta / 3.0 + (g1 - A) * (x - eta) * s * s / 3.0 : A + (g1 - A) * s * s;
+}
+
+YieldCurve::YieldCurve(CurveInterpolation interpolation)
+    : interpolation_(interpolation), times_{0.0}, logD_{0.0}, cache_(std::make_unique<Cache>()) {}
+
+YieldCurve::YieldCurve(const std::vector<double>& maturities, const std::vector<double>& zeroRates,
+                       CurveInterpolation interpolation)
+    : YieldCurve(interpolation) {
+    if (maturities.empty() || maturities.size() != zeroRates.size()) {
+        throw std::invalid_argument("a curve needs at least one maturity and one zero rate per maturity");
+    }
+    for (size_t i = 0; i < maturities.size(); ++i) {
+        if (!(maturities[i] > times_.back()) || !std::isfinite(maturities[i]) || !std::isfinite(zeroRates[i])) {
+            throw std::invalid_argument("curve maturities must be positive and increasing and rates finite");
+        }
+        maturities_.push_back(maturities[i]);
+        times_.push_back(maturities[i]);
+        logD_.push_back(-zeroRates[i] * maturities[i]);
+    }
+    buildForwards();
+}
+
+YieldCurve::YieldCurve(const YieldCurve& other)
+    : interpolation_(other.interpolation_), maturities_(other.maturities_), times_(other.times_),
+      logD_(other.logD_), discrete_(other.discrete_), instant_(other.instant_),
+      cache_(std::make_unique<Cache>()) {}
+
+YieldCurve YieldCurve::bootstrap(std::vector<CurveQuote> quotes, CurveInterpolation interpolation) {
+    if (quotes.empty()) {
+        throw std::invalid_argument("a curve needs at least one quote");
+    }
+    std::sort(quotes.begin(), quotes.end(), [](const CurveQuote& a, const CurveQuote& b) { return a.maturity < b.maturity; });
+    YieldCurve curve(interpolation);
+    bool swaps = false;
+    for (const CurveQuote& quote : quotes) {
+        if (!(quote.maturity > curve.times_.back()) || !std::isfinite(quote.maturity) || !std::isfinite(quote.rate)) {
+            throw std::invalid_argument("curve maturities must be positive and distinct and rates finite");
+        }
+        if (quote.instrument == CurveInstrument::SWAP && quote.frequency == 0) {
+            throw std::invalid_argument("swap frequency must be positive");
+        }
+        swaps = swaps || quote.instrument == CurveInstrument::SWAP;
+        //start from the previous knots' last forward carried on
+        const double guess = curve.logDiscount(quote.maturity);
+        curve.maturities_.push_back(quote.maturity);
+        curve.times_.push_back(quote.maturity);
+        curve.logD_.push_back(curve.maturities_.size() == 1 ? -quote.rate * quote.maturity : guess);
+        curve.solveKnot(curve.times_.size() - 1, quote);
+    }
+    //a later knot moves the monotone-convex forward at the knot before it, and with it the coupons of
+    //earlier swaps in that interval
+    if (swaps && interpolation == CurveInterpolation::MONOTONE_CONVEX) {
+        for (int sweep = 0; sweep < kBootstrapSweeps; ++sweep) {
+            double moved = 0.0;
+            for (size_t i = 0; i < quotes.size(); ++i) {
+                if (quotes[i].instrument != CurveInstrument::SWAP) continue;
+                const double before = curve.logD_[i + 1];
+                curve.solveKnot(i + 1, quotes[i]);
+                moved = std::max(moved, std::abs(curve.logD_[i + 1] - before));
+            }
+            if (moved <= kBootstrapTolerance) break;
+        }
+    }
+    return curve;
+}
+
+void YieldCurve::solveKnot(size_t i, const CurveQuote& quote) {
+    const double T = quote.maturity;
+    if (quote.instrument == CurveInstrument::ZERO) {
+        logD_[i] = -quote.rate * T;
+    } else if (quote.instrument == CurveInstrument::DEPOSIT) {
+        if (!(1.0 + quote.rate * T > 0.0)) {
+            throw std::invalid_argument("deposit rate gives no positive discount factor");
+        }
+        logD_[i] = -std::log1p(quote.rate * T);
+    } else {
+        //par: rate * sum of accrual * D(payment) = 1 - D(T). Payments every 1 / frequency back from T,
+        //the first period whatever is left. Coupons inside the last interval move with D(T) through the
+        //interpolation: a fixed-point iteration, each pass shrinking the error by about rate / frequency
+        const double period = 1.0 / quote.frequency;
+        if (!(T / period <= kMaxSwapPayments)) {
+            throw std::invalid_argument("a swap may have at most " + std::to_string(static_cast<long>(kMaxSwapPayments))
+                                        + " payments");
+        }
+        const long payments = std::max(1L, static_cast<long>(std::ceil(T / period - 1e-9)));
+        for (int iteration = 0; iteration < kBootstrapSweeps; ++iteration) {
+            buildForwards();
+            double annuity = 0.0;
+            for (long j = 1; j < payments; ++j) {
+                const double t = T - (payments - j) * period;
+                const double accrual = j == 1 ? t : period;
+                annuity += accrual * std::exp(logDiscount(t));
+            }
+            const double last = payments == 1 ? T : period;
+            const double D = (1.0 - quote.rate * annuity) / (1.0 + quote.rate * last);
+            if (!(D > 0.0)) {
+                throw std::invalid_argument("swap rate gives no positive discount factor");
+            }
+            const double next = std::log(D);
+            const bool done = std::abs(next - logD_[i]) <= kBootstrapTolerance;
+            logD_[i] = next;
+            if (done) break;
+        }
+    }
+    buildForwards();
+}
+
+void YieldCurve::buildForwards() {
+    const size_t n = times_.size() - 1;
+    discrete_.assign(n + 1, 0.0);
+    for (size_t i = 1; i <= n; ++i) discrete_[i] = -(logD_[i] - logD_[i - 1]) / (times_[i] - times_[i - 1]);
+    if (interpolation_ != CurveInterpolation::MONOTONE_CONVEX || n == 0) return;
+    //at an inner knot the average of the discrete forwards either side, weighted by the other side's
+    //length; at the ends whatever makes the end interval's forward linear through its discrete forward
+    instant_.assign(n + 1, discrete_[1]);
+    if (n == 1) return;
+    for (size_t i = 1; i < n; ++i) {
+        const double span = times_[i + 1] - times_[i - 1];
+        instant_[i] = (times_[i] - times_[i - 1]) / span * discrete_[i + 1] + (times_[i + 1] - times_[i]) / span * discrete_[i];
+    }
+    instant_[0] = discrete_[1] - 0.5 * (instant_[1] - discrete_[1]);
+    instant_[n] = discrete_[n] - 0.5 * (instant_[n - 1] - discrete_[n]);
+}
+
+size_t YieldCurve::interval(double T) const {
+    return std::lower_bound(times_.begin(), times_.end(), T) - times_.begin();
+}
+
+double YieldCurve::logDiscount(double T) const {
+    if (!(T > 0.0)) return 0.0;
+    const size_t n = times_.size() - 1;
+    if (n == 0) return 0.0;
+    const size_t i = interval(T);
+    if (i > n) {
+        const double tail = interpolation_ == CurveInterpolation::MONOTONE_CONVEX ? instant_[n] : discrete_[n];
+        return logD_[n] - tail * (T - times_[n]);
+    }
+    const double dt = T - times_[i - 1];
+    const double linear = logD_[i - 1] - discrete_[i] * dt;
+    if (interpolation_ == CurveInterpolation::LOG_LINEAR) return linear;
+    const double h = times_[i] - times_[i - 1];
+    return linear - h * monotoneConvex(instant_[i - 1] - discrete_[i], instant_[i] - discrete_[i], dt / h, true);
+}
+
+double YieldCurve::forwardRate(double T) const {
+    const size_t n = times_.size() - 1;
+    if (n == 0) return 0.0;
+    const bool convex = interpolation_ == CurveInterpolation::MONOTONE_CONVEX;
+    if (!(T > 0.0)) return convex ? instant_[0] : discrete_[1];
+    const size_t i = interval(T);
+    if (i > n) return convex ? instant_[n] : discrete_[n];
+    if (!convex) return discrete_[i];
+    const double h = times_[i] - times_[i - 1];
+    return discrete_[i] + monotoneConvex(instant_[i - 1] - discrete_[i], instant_[i] - discrete_[i],
+                                         (T - times_[i - 1]) / h, false);
+}
+
+double YieldCurve::zeroRate(double T) const {
+    return T > 0.0 ? -logDiscount(T) / T : forwardRate(0.0);
+}
+
+//a seqlock per slot: the reader checks the sequence is even and unchanged around its reads of the
+//expiry and value, the writer makes it odd while it stores them. A writer that finds the slot busy
+//leaves it to the other one
+double YieldCurve::discount(double T) const {
+    if (!(T > 0.0)) return 1.0;
+    const std::uint64_t key = bitsOf(T);
+    const std::uint64_t mixed = key * 0x9E3779B97F4A7C15ULL;
+    CacheSlot& slot = cache_->slots[(mixed >> 32) & (kCurveCacheSlots - 1)];
+
+    std::uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) == 0) {
+        const std::uint64_t expiry = slot.expiry.load(std::memory_order_relaxed);
+        const std::uint64_t value = slot.value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (expiry == key && slot.sequence.load(std::memory_order_relaxed) == sequence) {
+            return fromBits(value);
+        }
+    }
+
+    const double D = std::exp(logDiscount(T));
+    if ((sequence & 1) == 0 && slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.expiry.store(key, std::memory_order_relaxed);
+        slot.value.store(bitsOf(D), std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+    return D;
+}
+
+void YieldCurve::discounts(const double* T, double* out, size_t n) const {
+    for (size_t begin = 0; begin < n;) {
+        const double D = discount(T[begin]);
+        size_t end = begin;
+        while (end < n && T[end] == T[begin]) out[end++] = D;
+        begin = end;
+    }
+}
+
+//zero rate of an expiry from its (cached) discount factor
+static double rateFromDiscount(const YieldCurve& curve, double D, double T) {
+    return T > 0.0 ? -std::log(D) / T : curve.forwardRate(0.0);
+}
+
+PriceGreeks priceWithCurves(double S, double K, double T, const YieldCurve& rates, const YieldCurve* dividends,
+                            double sigma, OptionType type) {
+    const double carry = dividends ? dividends->discount(T) : 1.0;
+    const double r = rateFromDiscount(rates, rates.discount(T), T);
+    PriceGreeks out = OptionPricer::priceWithGreeks(S * carry, K, T, r, sigma, type);
+    if (dividends) {
+        //the formula's greeks are in the prepaid forward S Dq; its theta also needs the forward's drift
+        const double q = rateFromDiscount(*dividends, carry, T);
+        out.greeks.theta += out.greeks.delta * q * S * carry / 365.0;
+        out.greeks.delta *= carry;
+        out.greeks.gamma *= carry * carry;
+    }
+    return out;
+}
+
+void priceBatch(const OptionBatch& batch, const YieldCurve& rates, const YieldCurve* dividends, BatchResult& out,
+                SimdLevel level) {
+    const size_t n = batch.size();
+    //S becomes the prepaid forward, r the expiry's zero rate; the other fields are used as they are
+    std::vector<double> forward(n), rate(n);
+    for (size_t begin = 0; begin < n;) {
+        const double T = batch.T[begin];
+        const double Dq = dividends ? dividends->discount(T) : 1.0;
+        const double r = rateFromDiscount(rates, rates.discount(T), T);
+        size_t end = begin;
+        for (; end < n && batch.T[end] == T; ++end) {
+            forward[end] = batch.S[end] * Dq;
+            rate[end] = r;
+        }
+        begin = end;
+    }
+    priceBatch(forward.data(), batch.K.data(), batch.T.data(), rate.data(), batch.sigma.data(), batch.type.data(),
+               out, n, level);
+    if (!dividends) return;
+    for (size_t begin = 0; begin < n;) {
+        const double T = batch.T[begin];
+        const double Dq = dividends->discount(T);
+        const double q = rateFromDiscount(*dividends, Dq, T);
+        size_t end = begin;
+        for (; end < n && batch.T[end] == T; ++end) {
+            out.theta[end] += out.delta[end] * q * forward[end] / 365.0;
+            out.delta[end] *= Dq;
+            out.gamma[end] *= Dq * Dq;
+        }
+        begin = end;
+    }
+}
+
+YieldCurve impliedDividendCurve(double S, const YieldCurve& rates, const std::vector<double>& expiries,
+                                const std::vector<double>& forwards, CurveInterpolation interpolation) {
+    if (!(S > 0.0) || expiries.size() != forwards.size()) {
+        throw std::invalid_argument("implied dividends need a positive spot and one forward per expiry");
+    }
+    std::vector<double> yields(expiries.size());
+    for (size_t i = 0; i < expiries.size(); ++i) {
+        if (!(forwards[i] > 0.0) || !(expiries[i] > 0.0)) {
+            throw std::invalid_argument("forwards and expiries must be positive");
+        }
+        //Dq = F D / S
+        yields[i] = -(std::log(forwards[i] / S) + rates.logDiscount(expiries[i])) / expiries[i];
+    }
+    return YieldCurve(expiries, yields, interpolation);
+}
@@ -0,0 +1,129 @@
+// YieldCurve.h
+#ifndef YIELD_CURVE_H
+#define YIELD_CURVE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "BatchPricer.h"
+#include "OptionPricer.h"
+
+//a term structure of discount factors in place of the flat riskFreeRate: the curve keeps ln D(t) at its
+//knots and the discrete forward of every interval, so D(T) anywhere is a search over the knots, a
+//few flops and one exp. A dividend yield curve is the same object, its "discount factors" are
+//e^(-integral of q). Once built a curve never changes, and one instance is shared by every pricing call
+//(SnapshotRegistry.h publishes them to the server)
+enum class CurveInterpolation {
+    LOG_LINEAR,      //ln D linear between knots: piecewise flat forwards
+    MONOTONE_CONVEX  //Hagan & West (2006): continuous forwards that keep each interval's discrete forward
+                     //and add no oscillation between knots
+};
+
+const char* curveInterpolationName(CurveInterpolation interpolation);
+
+enum class CurveInstrument {
+    ZERO,     //continuously compounded zero rate (or dividend yield) to the maturity
+    DEPOSIT,  //simple rate, D = 1 / (1 + rate T)
+    SWAP      //par rate of a fixed leg paying frequency times a year (a short first period if needed)
+              //against a floating leg worth 1 - D(T)
+};
+
+struct CurveQuote {
+    double maturity;
+    double rate;
+    CurveInstrument instrument = CurveInstrument::ZERO;
+    unsigned frequency = 1;  //SWAP only
+};
+
+//discount factors remembered per expiry: most chains price thousands of contracts on a few dozen
+//expiries. Direct mapped on the expiry's bits, each slot guarded by its own sequence counter, so
+//readers never wait: a slot being written or holding another expiry is a miss, and the caller
+//interpolates. The table is a few KB and a miss costs less than the interpolation it may save
+constexpr size_t kCurveCacheSlots = 256;
+
+//most fixed coupons one swap quote may have (100 years of monthly payments): every bootstrap pass
+//re-prices each of them
+constexpr double kMaxSwapPayments = 1200.0;
+
+class YieldCurve {
+public:
+    //knots from zero rates: maturities positive and increasing, at least one.
+    //Throws std::invalid_argument otherwise
+    YieldCurve(const std::vector<double>& maturities, const std::vector<double>& zeroRates,
+               CurveInterpolation interpolation = CurveInterpolation::MONOTONE_CONVEX);
+
+    //one knot per quote, solved in maturity order so every quote reprices exactly on the finished
+    //curve. A swap's coupons between knots depend on the interpolation, and for monotone-convex on the
+    //knots after it as well, so swap knots are re-solved until none moves. Throws std::invalid_argument
+    //for repeated or non-positive maturities, a deposit or swap with no positive discount factor, a
+    //swap frequency of 0 or a swap of more than kMaxSwapPayments coupons
+    static YieldCurve bootstrap(std::vector<CurveQuote> quotes,
+                                CurveInterpolation interpolation = CurveInterpolation::MONOTONE_CONVEX);
+
+    YieldCurve(const YieldCurve& other);  //starts with an empty cache
+    YieldCurve(YieldCurve&&) noexcept = default;
+    YieldCurve& operator=(const YieldCurve&) = delete;
+
+    //D(T) through the cache, 1 for T <= 0
+    double discount(double T) const;
+    //D for n expiries, one lookup per run of equal expiries
+    void discounts(const double* T, double* out, size_t n) const;
+
+    //interpolated ln D(T), never cached. Beyond the last knot the final forward is held flat
+    double logDiscount(double T) const;
+    //continuously compounded zero rate -ln D(T) / T, the short rate at T = 0
+    double zeroRate(double T) const;
+    //instantaneous forward rate -d ln D / dT
+    double forwardRate(double T) const;
+
+    const std::vector<double>& maturities() const { return maturities_; }
+    CurveInterpolation interpolation() const { return interpolation_; }
+
+private:
+    explicit YieldCurve(CurveInterpolation interpolation);
+
+    //discrete forwards of every interval and, for monotone-convex, the instantaneous forwards at the knots
+    void buildForwards();
+    //interval holding T: i such that t_(i-1) < T <= t_i, 1..n, or n + 1 beyond the last knot
+    size_t interval(double T) const;
+    //solves knot i so quote reprices, the other knots as they stand
+    void solveKnot(size_t i, const CurveQuote& quote);
+
+    struct CacheSlot {
+        std::atomic<std::uint32_t> sequence{0};  //odd while a writer fills the slot
+        std::atomic<std::uint64_t> expiry{~std::uint64_t(0)};  //bits of T, a NaN when empty
+        std::atomic<std::uint64_t> value{0};                   //bits of D(T)
+    };
+    struct Cache {
+        CacheSlot slots[kCurveCacheSlots];
+    };
+
+    CurveInterpolation interpolation_;
+    std::vector<double> maturities_;       //knots t_1..t_n
+    std::vector<double> times_, logD_;     //t_0 = 0, ln D(0) = 0, then the knots
+    std::vector<double> discrete_;         //discrete forward of interval i, index i (0 unused)
+    std::vector<double> instant_;          //instantaneous forward at knot i (monotone-convex)
+    std::unique_ptr<Cache> cache_;
+};
+
+//black-scholes price and greeks with the rate and dividend yield of the contract's expiry read off
+//the curves (dividends may be null): the no-dividend formula on the prepaid forward S Dq(T) at the
+//zero rate r(T). Greeks are with respect to S, the zero rate and sigma; theta holds both zero rates
+//at their T values. Second-order greeks are left zero
+PriceGreeks priceWithCurves(double S, double K, double T, const YieldCurve& rates, const YieldCurve* dividends,
+                            double sigma, OptionType type);
+
+//priceBatch with rates (and dividend yields) from the curves instead of batch.r: the discount
+//factors are looked up once per run of equal expiries, contract by contract the same as
+//priceWithCurves up to the SIMD exp/log rounding
+void priceBatch(const OptionBatch& batch, const YieldCurve& rates, const YieldCurve* dividends, BatchResult& out,
+                SimdLevel level = SimdLevel::AVX512);
+
+//dividend yield curve implied by forward prices: Dq(T) = F(T) D(T) / S at each expiry, as zero knots
+YieldCurve impliedDividendCurve(double S, const YieldCurve& rates, const std::vector<double>& expiries,
+                                const std::vector<double>& forwards,
+                                CurveInterpolation interpolation = CurveInterpolation::MONOTONE_CONVEX);
+
+#endif // YIELD_CURVE_H
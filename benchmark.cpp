@@ -0,0 +1,865 @@
+// Throughput benchmarks for the pricing kernels
+//g++ -std=c++20 benchmark.cpp OptionPricer.cpp ImpliedVol.cpp BatchPricer.cpp MonteCarlo.cpp LongstaffSchwartz.cpp Lattice.cpp FiniteDifference.cpp Heston.cpp Sabr.cpp Svi.cpp VolSurface.cpp YieldCurve.cpp Calibration.cpp ThreadPool.cpp Random.cpp QuasiRandom.cpp -O2 -pthread -o benchmark.exe
+//./benchmark.exe
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "OptionPricer.h"
+#include "BatchPricer.h"
+#include "MonteCarlo.h"
+#include "LongstaffSchwartz.h"
+#include "Lattice.h"
+#include "FiniteDifference.h"
+#include "Heston.h"
+#include "Calibration.h"
+#include "VolSource.h"
+#include "VolSurface.h"
+#include "SnapshotRegistry.h"
+#include "YieldCurve.h"
+#include "Random.h"
+#include "ImpliedVol.h"
+#include "ThreadPool.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+//best of a few runs, in seconds
+template <typename F>
+double timeBest(F&& fn, int repeats = 5) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto t0 = Clock::now();
+        fn();
+        auto t1 = Clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+void printRate(const std::string& name, double items, double seconds, const std::string& unit,
+               double baseline_seconds = 0.0) {
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << items / seconds / 1e6 << " M" << unit << "/s";
+    if (baseline_seconds > 0.0) {
+        std::cout << std::setw(9) << std::setprecision(1) << baseline_seconds / seconds << "x";
+    }
+    std::cout << "\n";
+}
+
+//black-scholes over a random chain: one OptionPricer per contract vs the SoA batch kernels
+void benchBlackScholes() {
+    const size_t n = 1 << 20;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    OptionBatch batch;
+    batch.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        batch.add(80.0 + 40.0 * u(gen), 80.0 + 40.0 * u(gen), 0.05 + 2.0 * u(gen), 0.05 * u(gen),
+                  0.1 + 0.5 * u(gen), u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT);
+    }
+    std::vector<double> out(n);
+    volatile double sink = 0.0;
+
+    std::cout << "=== BLACK-SCHOLES THROUGHPUT (" << n << " contracts, single core) ===\n";
+
+    //the per-object path the server used before /price/batch, on a slice since it is slow
+    const size_t n_obj = n / 16;
+    double per_object = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n_obj; ++i) {
+            OptionPricer pricer(batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.sigma[i]);
+            acc += pricer.blackScholes(batch.type[i]);
+        }
+        sink = acc;
+    }, 3) * (double(n) / n_obj);
+    printRate("OptionPricer per object", n, per_object, "opt");
+
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        double secs = timeBest([&] {
+            blackScholesBatch(batch.S.data(), batch.K.data(), batch.T.data(), batch.r.data(),
+                              batch.sigma.data(), batch.type.data(), out.data(), n, level);
+        });
+        printRate(std::string("blackScholesBatch ") + simdLevelName(level), n, secs, "opt", per_object);
+    }
+
+    //price + greeks per contract: two separate calls vs the fused one
+    double separate = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n_obj; ++i) {
+            OptionPricer pricer(batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.sigma[i]);
+            acc += pricer.blackScholes(batch.type[i]) + pricer.calculateGreeks(batch.type[i]).delta;
+        }
+        sink = acc;
+    }, 3) * (double(n) / n_obj);
+    printRate("per object, blackScholes + greeks", n, separate, "opt");
+    double fused = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            PriceGreeks pg = OptionPricer::priceWithGreeks(batch.S[i], batch.K[i], batch.T[i], batch.r[i],
+                                                           batch.sigma[i], batch.type[i]);
+            acc += pg.price + pg.greeks.delta;
+        }
+        sink = acc;
+    });
+    printRate("priceWithGreeks (plain parameters)", n, fused, "opt", separate);
+
+    BatchResult result;
+    double greeks = timeBest([&] { priceBatch(batch, result); });
+    printRate("priceBatch (price + greeks)", n, greeks, "opt", per_object);
+    (void)sink;
+}
+
+//the Monte Carlo loop as it was before the bulk generator: one std::normal_distribution call per path
+double monteCarloPerPathRng(const OptionPricer& p, OptionType type, int n_sims, std::mt19937& rng) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    const double drift = (p.getRiskFreeRate() - 0.5 * p.getVolatility() * p.getVolatility()) * p.getTimeToMaturity();
+    const double diffusion = p.getVolatility() * std::sqrt(p.getTimeToMaturity());
+    double sum = 0.0;
+    for (int i = 0; i < n_sims / 2; ++i) {
+        double Z = normal(rng);
+        double ST = p.getSpot() * std::exp(drift + diffusion * Z);
+        double ST_anti = p.getSpot() * std::exp(drift - diffusion * Z);
+        sum += type == OptionType::CALL ? std::max(ST - p.getStrike(), 0.0) + std::max(ST_anti - p.getStrike(), 0.0)
+                                        : std::max(p.getStrike() - ST, 0.0) + std::max(p.getStrike() - ST_anti, 0.0);
+    }
+    return std::exp(-p.getRiskFreeRate() * p.getTimeToMaturity()) * sum / n_sims;
+}
+
+//normal generation on its own, then whole Monte Carlo runs (antithetic, 1 thread)
+void benchMonteCarlo() {
+    const size_t n = 1 << 22;
+    std::vector<double> normals(n);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== NORMAL GENERATION (" << n << " draws, single core) ===\n";
+    std::mt19937 rng(1);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    double std_secs = timeBest([&] { for (size_t i = 0; i < n; ++i) normals[i] = normal(rng); });
+    printRate("mt19937 + normal_distribution", n, std_secs, "draw");
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        NormalGenerator gen(1, 0, level);
+        double secs = timeBest([&] { gen.fill(normals.data(), n); });
+        printRate(std::string("NormalGenerator ") + simdLevelName(level), n, secs, "draw", std_secs);
+    }
+
+    const int sims = 4000000;
+    OptionPricer pricer(100.0, 100.0, 1.0, 0.05, 0.2);
+    std::cout << "\n=== MONTE CARLO (" << sims << " paths, antithetic, single core) ===\n";
+    double before = timeBest([&] { sink = monteCarloPerPathRng(pricer, OptionType::CALL, sims, rng); }, 3);
+    printRate("per-path normal_distribution", sims, before, "path");
+    double after = timeBest([&] { sink = pricer.monteCarlo(OptionType::CALL, sims, true); }, 3);
+    printRate("OptionPricer::monteCarlo (blocks)", sims, after, "path", before);
+    double parallel = timeBest([&] { sink = monteCarloParallel(pricer, OptionType::CALL, sims, 1, VarianceReduction::ANTITHETIC, 1).price; }, 3);
+    printRate("monteCarloParallel, 1 thread", sims, parallel, "path", before);
+
+    //one compiled kernel per payoff and variance reduction, the vanilla path is not slowed by the others
+    const std::pair<VarianceReduction, const char*> modes[] = {
+        {VarianceReduction::NONE, "none"}, {VarianceReduction::CONTROL_VARIATE, "control variate"},
+        {VarianceReduction::BOTH, "both"}};
+    for (const auto& [mode, name] : modes) {
+        double secs = timeBest([&] { sink = monteCarloParallel(pricer, OptionType::CALL, sims, 1, mode, 1).price; }, 3);
+        printRate(std::string("  vr ") + name, sims, secs, "path", before);
+    }
+    double digital = timeBest([&] {
+        sink = monteCarloParallel(pricer, DigitalCallPayoff{100.0}, sims, 1, VarianceReduction::ANTITHETIC, 1).price;
+    }, 3);
+    printRate("  digital call, antithetic", sims, digital, "path", before);
+    (void)sink;
+}
+
+//a path-dependent loop without the engine: one normal_distribution call per step and the whole
+//path stored before the payoff is taken
+double asianPerPathVector(const OptionPricer& p, long n_sims, unsigned steps, std::mt19937& rng) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    const double dt = p.getTimeToMaturity() / steps;
+    const double drift = (p.getRiskFreeRate() - 0.5 * p.getVolatility() * p.getVolatility()) * dt;
+    const double diffusion = p.getVolatility() * std::sqrt(dt);
+    std::vector<double> path(steps);
+    double sum = 0.0;
+    for (long i = 0; i < n_sims; ++i) {
+        double S = p.getSpot();
+        for (unsigned s = 0; s < steps; ++s) {
+            S *= std::exp(drift + diffusion * normal(rng));
+            path[s] = S;
+        }
+        double average = 0.0;
+        for (double v : path) average += v;
+        sum += std::max(average / steps - p.getStrike(), 0.0);
+    }
+    return std::exp(-p.getRiskFreeRate() * p.getTimeToMaturity()) * sum / n_sims;
+}
+
+//path-dependent engine, 252 monitoring dates, antithetic, 1 thread; rates are in path-steps
+void benchExoticMonteCarlo() {
+    const long sims = 20000;
+    const unsigned steps = 252;
+    const double items = double(sims) * steps;
+    OptionPricer pricer(100.0, 100.0, 1.0, 0.05, 0.2);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== PATH-DEPENDENT MONTE CARLO (" << sims << " paths x " << steps << " steps, 1 thread) ===\n";
+    std::mt19937 rng(1);
+    double before = timeBest([&] { sink = asianPerPathVector(pricer, sims, steps, rng); }, 3);
+    printRate("asian, stored path + mt19937", items, before, "step");
+
+    ExoticOption option;
+    option.steps = steps;
+    auto bench = [&](const char* name) {
+        double secs = timeBest([&] { sink = monteCarloExotic(pricer, option, sims, 1, VarianceReduction::ANTITHETIC, 1).price; }, 3);
+        printRate(name, items, secs, "step", before);
+    };
+    bench("  asian arithmetic");
+    option.average = AsianAverage::GEOMETRIC;
+    bench("  asian geometric");
+    option.kind = ExoticKind::BARRIER;
+    option.barrierType = BarrierType::UP_AND_OUT;
+    option.barrier = 130.0;
+    bench("  barrier, bridge corrected");
+    option.continuousMonitoring = false;
+    bench("  barrier, discrete");
+    option.kind = ExoticKind::LOOKBACK;
+    option.continuousMonitoring = true;
+    bench("  lookback floating");
+
+    //same prices at every budget, only the cache footprint of a block changes
+    option.kind = ExoticKind::ASIAN;
+    option.average = AsianAverage::ARITHMETIC;
+    const PathBlocking detected = pathBlockingFor(0, true);
+    std::cout << "block size sweep, arithmetic asian (default " << detected.paths << " paths x "
+              << detected.steps << " steps):\n";
+    for (size_t bytes : {size_t(16) << 10, size_t(64) << 10, size_t(256) << 10, size_t(1) << 20, size_t(4) << 20}) {
+        const PathBlocking blocking = pathBlockingFor(bytes, true);
+        double secs = timeBest([&] {
+            sink = monteCarloExotic(pricer, option, sims, 1, VarianceReduction::ANTITHETIC, 1, bytes).price;
+        }, 3);
+        printRate("  " + std::to_string(bytes >> 10) + "KB: " + std::to_string(blocking.paths) + " x "
+                  + std::to_string(blocking.steps), items, secs, "step", before);
+    }
+    (void)sink;
+}
+
+//Cox-Ross-Rubinstein American tree, the reference Longstaff-Schwartz is measured against
+double binomialAmerican(double S, double K, double T, double r, double sigma, OptionType type, int steps) {
+    const double dt = T / steps, u = std::exp(sigma * std::sqrt(dt)), d = 1.0 / u;
+    const double disc = std::exp(-r * dt), p = (std::exp(r * dt) - d) / (u - d);
+    auto exercise = [&](double s) { return std::max(type == OptionType::CALL ? s - K : K - s, 0.0); };
+    std::vector<double> v(steps + 1);
+    for (int i = 0; i <= steps; ++i) v[i] = exercise(S * std::pow(u, 2 * i - steps));
+    for (int n = steps - 1; n >= 0; --n) {
+        for (int i = 0; i <= n; ++i) {
+            v[i] = std::max(disc * (p * v[i + 1] + (1.0 - p) * v[i]), exercise(S * std::pow(u, 2 * i - n)));
+        }
+    }
+    return v[0];
+}
+
+//Longstaff-Schwartz (50 exercise dates, 1 thread) against a binomial tree, and a strike ladder priced on
+//one shared simulation vs a fresh simulation per strike
+void benchAmerican() {
+    const long sims = 200000;
+    const unsigned dates = 50;
+    const double S = 36.0, T = 1.0, r = 0.06, sigma = 0.2;
+    OptionPricer pricer(S, 40.0, T, r, sigma);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== AMERICAN PUT (Longstaff-Schwartz, " << sims << " paths x " << dates << " dates, 1 thread) ===\n";
+    const double reference = binomialAmerican(S, 40.0, T, r, sigma, OptionType::PUT, 20000);
+    std::cout << "reference: CRR tree, 20000 steps    $" << std::fixed << std::setprecision(6) << reference << "\n";
+    for (int steps : {500, 2000}) {
+        double price = 0.0;
+        double secs = timeBest([&] { price = binomialAmerican(S, 40.0, T, r, sigma, OptionType::PUT, steps); }, 3);
+        std::cout << "  CRR tree, " << std::left << std::setw(5) << steps << std::right << " steps           $" << price
+                  << "  error " << std::scientific << std::setprecision(1) << price - reference << std::fixed
+                  << std::setprecision(2) << std::setw(10) << secs * 1e3 << " ms\n" << std::setprecision(6);
+    }
+    for (VarianceReduction vr : {VarianceReduction::NONE, VarianceReduction::BOTH}) {
+        MonteCarloResult mc;
+        double secs = timeBest([&] { mc = monteCarloAmerican(pricer, OptionType::PUT, sims, 1, dates, vr, 3, 1); }, 3);
+        std::cout << "  LSM, vr " << std::left << std::setw(4) << (vr == VarianceReduction::NONE ? "none" : "both")
+                  << std::right << "                 $" << mc.price << " +/- " << mc.stdError
+                  << std::setprecision(2) << std::setw(10) << secs * 1e3 << " ms\n" << std::setprecision(6);
+    }
+
+    AmericanPathSet paths(pricer, sims, dates, 1, true, 1);
+    double simulate = timeBest([&] { AmericanPathSet fresh(pricer, sims, dates, 1, true, 1); sink = fresh.row(dates)[0]; }, 3);
+    double regress = timeBest([&] { sink = priceAmerican(paths, 40.0, OptionType::PUT, 3, true, 1).price; }, 3);
+    printRate("  simulate paths", double(sims) * dates, simulate, "path-date");
+    printRate("  regression passes", double(sims) * dates, regress, "path-date");
+
+    const double strikes[] = {30.0, 32.0, 34.0, 36.0, 38.0, 40.0, 42.0, 44.0, 46.0, 48.0};
+    double separate = timeBest([&] {
+        for (double K : strikes) {
+            OptionPricer strike(S, K, T, r, sigma);
+            sink = monteCarloAmerican(strike, OptionType::PUT, sims, 1, dates, VarianceReduction::BOTH, 3, 1).price;
+        }
+    }, 2);
+    double shared = timeBest([&] {
+        AmericanPathSet ladder(pricer, sims, dates, 1, true, 1);
+        for (double K : strikes) sink = priceAmerican(ladder, K, OptionType::PUT, 3, true, 1).price;
+    }, 2);
+    std::cout << std::left << std::setw(34) << "10 strikes, path set per strike" << std::right << std::setprecision(2)
+              << std::setw(10) << separate * 1e3 << " ms\n";
+    std::cout << std::left << std::setw(34) << "10 strikes, one shared path set" << std::right
+              << std::setw(10) << shared * 1e3 << " ms" << std::setw(9) << std::setprecision(1)
+              << separate / shared << "x\n" << std::setprecision(6);
+    (void)sink;
+}
+
+//the implied vol loop as it was before solveImpliedVol: a new OptionPricer per Newton step
+double impliedVolPerStepPricer(double market_price, double S, double K, double T, double r, OptionType type) {
+    double sigma_guess = std::sqrt(2.0 * M_PI / T) * (market_price / S);
+    for (int i = 0; i < 100; ++i) {
+        OptionPricer temp_pricer(S, K, T, r, sigma_guess);
+        double diff = temp_pricer.blackScholes(type) - market_price;
+        if (std::abs(diff) < 1e-6) break;
+        sigma_guess -= diff / temp_pricer.calculateGreeks(type).vega;
+        sigma_guess = std::max(sigma_guess, 1e-6);
+    }
+    return sigma_guess;
+}
+
+//implied vol inversions over a random chain
+void benchLattice() {
+    const double S = 36.0, K = 40.0, T = 1.0, r = 0.06, sigma = 0.2;
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== LATTICE (american put 36/40, error vs Leisen-Reimer 20001 steps + Richardson) ===\n";
+    LatticeOptions fine;
+    fine.steps = 20001;
+    const double reference = priceLattice(S, K, T, r, sigma, OptionType::PUT, fine).price;
+    std::cout << "reference $" << std::fixed << std::setprecision(6) << reference << "\n";
+
+    LatticeOptions raw;
+    raw.model = LatticeModel::CRR;
+    raw.smoothing = false;
+    raw.richardson = false;
+    for (unsigned steps : {500u, 2000u}) {
+        raw.steps = steps;
+        double naive = timeBest([&] { sink = binomialAmerican(S, K, T, r, sigma, OptionType::PUT, steps); }, 3);
+        double lattice = timeBest([&] { sink = priceLattice(S, K, T, r, sigma, OptionType::PUT, raw).price; }, 3);
+        std::cout << "CRR " << std::left << std::setw(5) << steps << std::right << " steps, naive tree" << std::setprecision(3)
+                  << std::setw(10) << naive * 1e3 << " ms, lattice" << std::setw(8) << lattice * 1e3 << " ms"
+                  << std::setw(8) << std::setprecision(1) << naive / lattice << "x\n" << std::setprecision(6);
+    }
+
+    for (LatticeModel model : {LatticeModel::CRR, LatticeModel::LEISEN_REIMER, LatticeModel::TRINOMIAL}) {
+        for (unsigned steps : {100u, 200u, 1000u, 5000u}) {
+            std::cout << std::left << std::setw(14) << latticeModelName(model) << std::setw(5) << steps << std::right;
+            for (bool richardson : {false, true}) {
+                LatticeOptions options;
+                options.model = model;
+                options.steps = steps;
+                options.richardson = richardson;
+                double price = 0.0;
+                double secs = timeBest([&] { price = priceLattice(S, K, T, r, sigma, OptionType::PUT, options).price; }, 3);
+                std::cout << (richardson ? "  richardson" : "  plain") << " error " << std::scientific << std::setprecision(1)
+                          << std::setw(8) << price - reference << std::fixed << std::setprecision(3) << std::setw(9)
+                          << secs * 1e3 << " ms";
+            }
+            std::cout << "\n" << std::setprecision(6);
+        }
+    }
+}
+
+void benchPde() {
+    const double S = 36.0, K = 40.0, T = 1.0, r = 0.06, sigma = 0.2;
+    volatile double sink = 0.0;
+    LatticeOptions fine;
+    fine.steps = 20001;
+    const double reference = priceLattice(S, K, T, r, sigma, OptionType::PUT, fine).price;
+
+    std::cout << "\n=== FINITE DIFFERENCES (Crank-Nicolson, american put 36/40, error vs lattice $" << std::fixed
+              << std::setprecision(6) << reference << ") ===\n";
+    for (unsigned nodes : {200u, 400u, 800u, 1600u}) {
+        PdeOptions options;
+        options.exercise = ExerciseStyle::AMERICAN;
+        options.spotNodes = nodes;
+        options.timeSteps = nodes / 2;
+        double price = 0.0;
+        double secs = timeBest([&] { price = solvePde(S, K, T, r, sigma, OptionType::PUT, options).value(S); }, 5);
+        std::cout << std::setw(5) << nodes << " x " << std::left << std::setw(4) << nodes / 2 << std::right
+                  << " Brennan-Schwartz error " << std::scientific << std::setprecision(1) << std::setw(8) << price - reference
+                  << std::fixed << std::setprecision(3) << std::setw(9) << secs * 1e3 << " ms"
+                  << std::setprecision(2) << std::setw(7) << secs * 1e9 / (double(nodes) * (nodes / 2)) << " ns/node-step\n";
+        if (nodes > 800) continue;  //PSOR sweeps grow with the grid, too slow past this
+        options.earlyExercise = EarlyExercise::PSOR;
+        secs = timeBest([&] { price = solvePde(S, K, T, r, sigma, OptionType::PUT, options).value(S); }, 2);
+        std::cout << std::setw(21) << "PSOR" << " error " << std::scientific << std::setprecision(1) << std::setw(8)
+                  << price - reference << std::fixed << std::setprecision(3) << std::setw(9) << secs * 1e3 << " ms\n";
+    }
+
+    //81 spots for a chart: one grid against one 400-step lattice per point
+    PdeOptions american;
+    american.exercise = ExerciseStyle::AMERICAN;
+    LatticeOptions tree;
+    tree.steps = 400;
+    double grid = timeBest([&] {
+        const PdeGrid g = solvePde(S, K, T, r, sigma, OptionType::PUT, american);
+        for (int i = 0; i < 81; ++i) sink = g.value(S * (0.6 + 0.01 * i));
+    }, 5);
+    double trees = timeBest([&] {
+        for (int i = 0; i < 81; ++i) sink = priceLattice(S * (0.6 + 0.01 * i), K, T, r, sigma, OptionType::PUT, tree).price;
+    }, 3);
+    std::cout << std::left << std::setw(34) << "81-point spot ladder, one PDE" << std::right << std::setprecision(3)
+              << std::setw(10) << grid * 1e3 << " ms\n";
+    std::cout << std::left << std::setw(34) << "81-point spot ladder, lattices" << std::right << std::setw(10)
+              << trees * 1e3 << " ms" << std::setw(9) << std::setprecision(1) << trees / grid << "x\n";
+
+    std::vector<double> strikes;
+    for (int i = 0; i < 41; ++i) strikes.push_back(28.0 + 0.5 * i);
+    PdeOptions ladder = american;
+    ladder.spotNodes = 800;
+    double one = timeBest([&] { sink = pdeStrikeLadder(S, strikes, T, r, sigma, OptionType::PUT, ladder)[0]; }, 5);
+    double each = timeBest([&] {
+        for (double k : strikes) sink = solvePde(S, k, T, r, sigma, OptionType::PUT, american).value(S);
+    }, 3);
+    std::cout << std::left << std::setw(34) << "41-strike ladder, one PDE" << std::right << std::setprecision(3)
+              << std::setw(10) << one * 1e3 << " ms\n";
+    std::cout << std::left << std::setw(34) << "41-strike ladder, PDE per strike" << std::right << std::setw(10)
+              << each * 1e3 << " ms" << std::setw(9) << std::setprecision(1) << each / one << "x\n" << std::setprecision(6);
+}
+
+void benchHeston() {
+    const double S = 100.0, T = 0.5, r = 0.03;
+    const HestonParams params{0.04, 1.5, 0.04, 0.5, -0.7};
+    std::vector<double> strikes;
+    for (int i = 0; i < 101; ++i) strikes.push_back(50.0 + i);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== HESTON (101 strikes, 256 COS terms, single core) ===\n";
+    double grid = timeBest([&] { sink = HestonCos(S, T, r, params).prices(strikes, OptionType::CALL)[0]; }, 20);
+    double each = timeBest([&] {
+        for (double k : strikes) sink = hestonPrice(S, k, T, r, params, OptionType::CALL);
+    }, 5);
+    const HestonCos cached(S, T, r, params);
+    double reuse = timeBest([&] { sink = cached.prices(strikes, OptionType::CALL)[0]; }, 20);
+    std::cout << std::left << std::setw(34) << "strike grid, one set of CF values" << std::right << std::setprecision(3)
+              << std::setw(10) << grid * 1e6 << " us\n";
+    std::cout << std::left << std::setw(34) << "strike grid, cached coefficients" << std::right << std::setw(10)
+              << reuse * 1e6 << " us" << std::setw(9) << std::setprecision(1) << grid / reuse << "x\n";
+    std::cout << std::left << std::setw(34) << "one COS pricing per strike" << std::right << std::setprecision(3)
+              << std::setw(10) << each * 1e6 << " us" << std::setw(9) << std::setprecision(1) << each / grid << "x slower\n";
+
+    const long paths = 200000;
+    const unsigned steps = 100;
+    double mc = timeBest([&] {
+        sink = monteCarloHeston(S, 100.0, T, r, params, OptionType::CALL, paths, 1, steps, VarianceReduction::BOTH).price;
+    }, 3);
+    std::cout << std::left << std::setw(34) << "QE Monte Carlo, 200k x 100 steps" << std::right << std::setprecision(3)
+              << std::setw(10) << mc * 1e3 << " ms" << std::setw(9) << std::setprecision(1)
+              << paths * steps / mc / 1e6 << " M steps/s\n" << std::setprecision(6);
+}
+
+void benchCalibration() {
+    const double S = 100.0, r = 0.02;
+    const HestonParams truth{0.05, 1.8, 0.045, 0.6, -0.65};
+    std::vector<VolQuote> quotes;
+    for (int e = 1; e <= 10; ++e) {
+        const double T = 0.1 * e * e / 5.0;
+        const HestonCos cos(S, T, r, truth);
+        for (int i = -10; i <= 10; ++i) {
+            const double K = S * std::exp(0.04 * i * std::sqrt(T));
+            quotes.push_back({K, T, solveImpliedVol(cos.price(K, OptionType::CALL), S, K, T, r, OptionType::CALL).vol});
+        }
+    }
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== CALIBRATION (Heston, " << quotes.size() << " quotes over 10 expiries) ===\n";
+    //one jacobian of every quote: AD through the characteristic function vs bump-and-reprice
+    double ad = timeBest([&] {
+        for (int e = 1; e <= 10; ++e) {
+            std::vector<double> strikes(21), prices, gradient;
+            for (size_t j = 0; j < strikes.size(); ++j) strikes[j] = quotes[21 * (e - 1) + j].strike;
+            HestonCos(S, quotes[21 * (e - 1)].expiry, r, truth, kHestonCosTerms, kHestonCosTruncation, true)
+                .pricesAndGradients(strikes, OptionType::CALL, prices, gradient);
+            sink = gradient[0];
+        }
+    }, 5);
+    double bumped = timeBest([&] {
+        for (int e = 1; e <= 10; ++e) {
+            std::vector<double> strikes(21);
+            for (size_t j = 0; j < strikes.size(); ++j) strikes[j] = quotes[21 * (e - 1) + j].strike;
+            const double T = quotes[21 * (e - 1)].expiry;
+            sink = HestonCos(S, T, r, truth).prices(strikes, OptionType::CALL)[0];
+            for (int a = 0; a < kHestonParamCount; ++a) {
+                HestonParams up = truth;
+                (&up.v0)[a] += 1e-5;
+                sink = HestonCos(S, T, r, up).prices(strikes, OptionType::CALL)[0];
+            }
+        }
+    }, 5);
+    std::cout << std::left << std::setw(34) << "jacobian, forward-mode AD" << std::right << std::setprecision(3)
+              << std::setw(10) << ad * 1e3 << " ms\n";
+    std::cout << std::left << std::setw(34) << "jacobian, bump and reprice" << std::right << std::setw(10)
+              << bumped * 1e3 << " ms" << std::setw(9) << std::setprecision(1) << bumped / ad << "x\n";
+
+    //the next snapshot moves every vol a little, refit it from scratch and from the previous fit
+    const HestonCalibration previous = calibrateHeston(S, r, quotes, hestonInitialGuess(quotes));
+    std::mt19937 gen(5);
+    std::normal_distribution<double> noise(0.0, 0.0005);
+    for (VolQuote& q : quotes) q.vol += 0.001 + noise(gen);
+    HestonCalibration cold, warm;
+    double coldTime = timeBest([&] { cold = calibrateHeston(S, r, quotes, hestonInitialGuess(quotes)); }, 3);
+    double warmTime = timeBest([&] { warm = calibrateHeston(S, r, quotes, previous.params); }, 3);
+    std::cout << std::left << std::setw(34) << "next snapshot, cold start" << std::right << std::setprecision(3) << std::setw(10)
+              << coldTime * 1e3 << " ms" << std::setw(5) << cold.report.iterations << " iterations\n";
+    std::cout << std::left << std::setw(34) << "next snapshot, warm start" << std::right << std::setw(10)
+              << warmTime * 1e3 << " ms" << std::setw(5) << warm.report.iterations << " iterations\n" << std::setprecision(6);
+}
+
+//vol lookups on fitted smiles for 1M (strike, expiry) points: 100 expiries between the slices, 10000 strikes
+//each. A point at a time through vol() vs whole strips through smile(), then off-grid prices
+template <class Source>
+void benchSmileSource(const std::string& name, const Source& source, const std::vector<double>& expiries,
+                      const std::vector<double>& strikes, std::vector<double>& out) {
+    const size_t m = strikes.size(), n = expiries.size() * m;
+    volatile double sink = 0.0;
+    double single = timeBest([&] {
+        for (size_t e = 0; e < expiries.size(); ++e) {
+            for (size_t j = 0; j < m; ++j) out[e * m + j] = source.vol(strikes[j], expiries[e]);
+        }
+        sink = out[n / 2];
+    }, 3);
+    printRate(name + " vol() per point", n, single, "pt");
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        double secs = timeBest([&] {
+            for (size_t e = 0; e < expiries.size(); ++e) source.smile(expiries[e], strikes.data(), out.data() + e * m, m, level);
+            sink = out[n / 2];
+        });
+        printRate(name + " smile() " + simdLevelName(level), n, secs, "pt", single);
+    }
+    (void)sink;
+}
+
+void benchSmile() {
+    const double S = 100.0, r = 0.02;
+    std::vector<double> expiries, strikes;
+    for (int e = 0; e < 100; ++e) expiries.push_back(0.05 + 0.02 * e);
+    for (int j = 0; j < 10000; ++j) strikes.push_back(50.0 + 0.01 * j);
+    const size_t n = expiries.size() * strikes.size();
+    std::vector<double> out(n);
+
+    const SabrSurface sabr(S, r, {{0.25, {2.0, 0.5, -0.3, 0.8}}, {1.0, {2.1, 0.5, -0.35, 0.6}}, {2.0, {2.2, 0.5, -0.4, 0.5}}});
+    const SviSurface svi(S, r, {{0.25, {0.004, 0.08, -0.4, 0.02, 0.12}}, {1.0, {0.02, 0.12, -0.5, 0.05, 0.25}},
+                                {2.0, {0.04, 0.14, -0.5, 0.08, 0.3}}});
+    const SsviSurface ssvi(S, r, {-0.6, 1.1, 0.35}, {0.25, 1.0, 2.0}, {0.01, 0.038, 0.07});
+
+    std::cout << "\n=== SMILES (" << n << " strike x expiry points, single core) ===\n";
+    benchSmileSource("sabr", sabr, expiries, strikes, out);
+    benchSmileSource("svi", svi, expiries, strikes, out);
+    benchSmileSource("ssvi", ssvi, expiries, strikes, out);
+
+    //off-grid prices: one smile + one black-scholes evaluation per contract, or per strip
+    std::vector<double> spot(n, S), K(n), T(n), rate(n, r);
+    std::vector<OptionType> type(n, OptionType::CALL);
+    for (size_t e = 0; e < expiries.size(); ++e) {
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            K[e * strikes.size() + j] = strikes[j];
+            T[e * strikes.size() + j] = expiries[e];
+        }
+    }
+    volatile double sink = 0.0;
+    double single = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n; ++i) acc += priceWithSmile(S, K[i], T[i], r, svi, OptionType::CALL).price;
+        sink = acc;
+    }, 3);
+    printRate("svi + priceWithGreeks per contract", n, single, "opt");
+    double batch = timeBest([&] {
+        blackScholesBatch(spot.data(), K.data(), T.data(), rate.data(), svi, type.data(), out.data(), n);
+        sink = out[n / 2];
+    });
+    printRate("svi strips + blackScholesBatch", n, batch, "opt", single);
+    (void)sink;
+}
+
+//market vol grid (41 strikes x 12 expiries) looked up at the same 1M points as the smiles: a point at a
+//time vs strips, bilinear vs bicubic, then the cost of moving one node vs rebuilding, and of a snapshot read
+void benchVolSurface() {
+    std::vector<double> gridStrikes, gridExpiries, gridVols;
+    for (int j = 0; j <= 40; ++j) gridStrikes.push_back(50.0 + 2.5 * j);
+    for (double T : {0.05, 0.1, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 2.5, 3.0, 4.0}) gridExpiries.push_back(T);
+    for (double T : gridExpiries) {
+        for (double K : gridStrikes) {
+            const double k = std::log(K / 100.0);
+            gridVols.push_back(0.2 - 0.1 * k / std::sqrt(T + 0.1) + 0.15 * k * k + 0.01 * T);
+        }
+    }
+    std::vector<double> expiries, strikes;
+    for (int e = 0; e < 100; ++e) expiries.push_back(0.05 + 0.02 * e);
+    for (int j = 0; j < 10000; ++j) strikes.push_back(50.0 + 0.01 * j);
+    const size_t m = strikes.size(), n = expiries.size() * m;
+    std::vector<double> out(n);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== VOL SURFACE (" << n << " lookups on a 41 x 12 grid, single core) ===\n";
+    for (VolInterpolation interpolation : {VolInterpolation::BILINEAR, VolInterpolation::BICUBIC}) {
+        const VolSurface surface(gridStrikes, gridExpiries, gridVols, interpolation);
+        const std::string name = volInterpolationName(interpolation);
+        double single = timeBest([&] {
+            for (size_t e = 0; e < expiries.size(); ++e) {
+                for (size_t j = 0; j < m; ++j) out[e * m + j] = surface.vol(strikes[j], expiries[e]);
+            }
+            sink = out[n / 2];
+        }, 3);
+        printRate(name + " vol() per point", n, single, "pt");
+        double strips = timeBest([&] {
+            for (size_t e = 0; e < expiries.size(); ++e) surface.smile(expiries[e], strikes.data(), out.data() + e * m, m);
+            sink = out[n / 2];
+        });
+        printRate(name + " smile() strips", n, strips, "pt", single);
+    }
+
+    //one node moved: setVol on a copy (what /volsurface/update publishes) vs constructing the surface again
+    const VolSurface base(gridStrikes, gridExpiries, gridVols);
+    const int updates = 2000;
+    double rebuild = timeBest([&] {
+        for (int i = 0; i < updates; ++i) {
+            gridVols[5 * gridStrikes.size() + 20] = 0.2 + 1e-6 * i;
+            VolSurface fresh(gridStrikes, gridExpiries, gridVols);
+            sink = fresh.nodeVol(5, 20);
+        }
+    }, 3);
+    double patch = timeBest([&] {
+        for (int i = 0; i < updates; ++i) {
+            VolSurface next(base);
+            next.setVol(5, 20, 0.2 + 1e-6 * i);
+            sink = next.nodeVol(5, 20);
+        }
+    }, 3);
+    std::cout << std::left << std::setw(34) << "node update, full rebuild" << std::right << std::setw(10)
+              << std::setprecision(2) << rebuild / updates * 1e6 << " us\n";
+    std::cout << std::left << std::setw(34) << "node update, copy + setVol" << std::right << std::setw(10)
+              << patch / updates * 1e6 << " us" << std::setw(9) << std::setprecision(1) << rebuild / patch << "x\n";
+
+    //what a pricing request pays to find the current surface, against a registry with 100 underlyings
+    SnapshotRegistry<VolSurface> registry;
+    for (int u = 0; u < 100; ++u) registry.publish("U" + std::to_string(u), std::make_shared<const VolSurface>(base));
+    const int reads = 1000000;
+    double get = timeBest([&] {
+        double acc = 0.0;
+        for (int i = 0; i < reads; ++i) acc += registry.get(i & 1 ? "U42" : "U7")->nodeVol(0, 0);
+        sink = acc;
+    }, 3);
+    printRate("snapshot get()", reads, get, "op");
+    std::cout << std::setprecision(6);
+    (void)sink;
+}
+
+//discount factors off a bootstrapped curve for 1M lookups on 50 listed expiries: interpolated every time
+//vs the shared per-expiry cache vs a flat rate's exp, then a chain priced with curves vs a flat rate
+void benchYieldCurve() {
+    const std::vector<CurveQuote> quotes = {
+        {0.25, 0.040, CurveInstrument::DEPOSIT}, {0.5, 0.042, CurveInstrument::DEPOSIT},
+        {1.0, 0.043, CurveInstrument::DEPOSIT},  {2.0, 0.041, CurveInstrument::SWAP, 2},
+        {3.0, 0.039, CurveInstrument::SWAP, 2},  {5.0, 0.038, CurveInstrument::SWAP, 2},
+        {7.0, 0.039, CurveInstrument::SWAP, 2},  {10.0, 0.040, CurveInstrument::SWAP, 2}};
+    const size_t expiry_count = 50, strikes = 20000, n = expiry_count * strikes;
+    std::vector<double> expiries(expiry_count);
+    for (size_t e = 0; e < expiry_count; ++e) expiries[e] = 7.0 / 365.0 + e * 0.06;
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== YIELD CURVES (" << n << " lookups on " << expiry_count << " expiries, single core) ===\n";
+    for (CurveInterpolation interpolation : {CurveInterpolation::LOG_LINEAR, CurveInterpolation::MONOTONE_CONVEX}) {
+        const double build = timeBest([&] { sink = YieldCurve::bootstrap(quotes, interpolation).zeroRate(1.0); });
+        const YieldCurve curve = YieldCurve::bootstrap(quotes, interpolation);
+        const std::string name = curveInterpolationName(interpolation);
+        std::cout << std::left << std::setw(34) << name + " bootstrap" << std::right << std::setw(10)
+                  << std::setprecision(2) << build * 1e6 << " us\n";
+        //contracts in random expiry order, so every lookup is a separate call
+        std::vector<double> T(n);
+        std::mt19937 gen(9);
+        for (double& t : T) t = expiries[gen() % expiry_count];
+        double flat = timeBest([&] {
+            double acc = 0.0;
+            for (size_t i = 0; i < n; ++i) acc += std::exp(-0.04 * T[i]);
+            sink = acc;
+        }, 3);
+        double interpolated = timeBest([&] {
+            double acc = 0.0;
+            for (size_t i = 0; i < n; ++i) acc += std::exp(curve.logDiscount(T[i]));
+            sink = acc;
+        }, 3);
+        double cached = timeBest([&] {
+            double acc = 0.0;
+            for (size_t i = 0; i < n; ++i) acc += curve.discount(T[i]);
+            sink = acc;
+        }, 3);
+        printRate(name + " flat exp(-rT)", n, flat, "op");
+        printRate(name + " interpolated", n, interpolated, "op", flat);
+        printRate(name + " cached discount()", n, cached, "op", flat);
+    }
+
+    //a chain sorted by expiry: priceBatch on a flat rate vs on a rate and dividend curve
+    const YieldCurve rates = YieldCurve::bootstrap(quotes);
+    const YieldCurve dividends({0.5, 2.0, 5.0}, {0.015, 0.018, 0.02});
+    OptionBatch batch;
+    batch.reserve(n);
+    for (double T : expiries) {
+        for (size_t j = 0; j < strikes; ++j) batch.add(100.0, 50.0 + 0.005 * j, T, 0.04, 0.2, OptionType::CALL);
+    }
+    BatchResult result;
+    double flat = timeBest([&] { priceBatch(batch, result); sink = result.price[n / 2]; }, 3);
+    double curved = timeBest([&] { priceBatch(batch, rates, &dividends, result); sink = result.price[n / 2]; }, 3);
+    printRate("priceBatch flat rate", n, flat, "opt");
+    printRate("priceBatch rate + dividend curves", n, curved, "opt", flat);
+    std::cout << std::setprecision(6);
+    (void)sink;
+}
+
+void benchImpliedVol() {
+    const size_t n = 1 << 20;
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    OptionBatch batch;
+    batch.reserve(n);
+    std::vector<double> prices(n);
+    for (size_t i = 0; i < n; ++i) {
+        batch.add(100.0, 70.0 + 60.0 * u(gen), 0.05 + 2.0 * u(gen), 0.05 * u(gen),
+                  0.1 + 0.5 * u(gen), u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT);
+    }
+    blackScholesBatch(batch.S.data(), batch.K.data(), batch.T.data(), batch.r.data(),
+                      batch.sigma.data(), batch.type.data(), prices.data(), n);
+    volatile double sink = 0.0;
+
+    std::cout << "\n=== IMPLIED VOLATILITY (" << n << " contracts, single core) ===\n";
+    const size_t n_old = n / 64;
+    double before = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n_old; ++i) {
+            acc += impliedVolPerStepPricer(prices[i], batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.type[i]);
+        }
+        sink = acc;
+    }, 3) * (double(n) / n_old);
+    printRate("Newton, OptionPricer per step", n, before, "IV");
+    long iterations = 0;
+    double after = timeBest([&] {
+        double acc = 0.0;
+        iterations = 0;
+        for (size_t i = 0; i < n; ++i) {
+            ImpliedVolResult iv = solveImpliedVol(prices[i], batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.type[i]);
+            acc += iv.vol;
+            iterations += iv.iterations;
+        }
+        sink = acc;
+    });
+    printRate("solveImpliedVol", n, after, "IV", before);
+    std::cout << "mean iterations: " << std::setprecision(2) << double(iterations) / n << "\n";
+
+    //same iterations, W quotes per register
+    std::vector<ImpliedVolResult> results(n);
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        double t = timeBest([&] {
+            impliedVolBatch(prices.data(), batch.S.data(), batch.K.data(), batch.T.data(), batch.r.data(),
+                            batch.type.data(), results.data(), n, 1e-10, 50, level, 1);
+        });
+        printRate(std::string("impliedVolBatch ") + simdLevelName(level), n, t, "IV", before);
+    }
+    const unsigned threads = ThreadPool::shared().size();
+    double pooled = timeBest([&] {
+        impliedVolBatch(prices.data(), batch.S.data(), batch.K.data(), batch.T.data(), batch.r.data(),
+                        batch.type.data(), results.data(), n);
+    });
+    printRate("impliedVolBatch, " + std::to_string(threads) + " threads", n, pooled, "IV", before);
+
+    //the rational solver inverts the erfc-based price, so give it prices from that
+    for (size_t i = 0; i < n; ++i) {
+        prices[i] = blackScholesExact(batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.sigma[i], batch.type[i]);
+    }
+    long rational_iterations = 0;
+    double rational = timeBest([&] {
+        double acc = 0.0;
+        rational_iterations = 0;
+        for (size_t i = 0; i < n; ++i) {
+            ImpliedVolResult iv = solveImpliedVolRational(prices[i], batch.S[i], batch.K[i], batch.T[i], batch.r[i], batch.type[i]);
+            acc += iv.vol;
+            rational_iterations += iv.iterations;
+        }
+        sink = acc;
+    });
+    printRate("solveImpliedVolRational", n, rational, "IV", before);
+    std::cout << "mean iterations: " << std::setprecision(2) << double(rational_iterations) / n << "\n";
+    (void)sink;
+}
+
+//one row of the normal CDF table: throughput of the scalar kernel, the widest SIMD kernel and
+//priceWithGreeks built on it, and the accuracy against a long double erfc reference
+template <class Cdf>
+void benchNormalCdfPolicy(const std::vector<double>& x, const OptionBatch& batch, std::vector<double>& out) {
+    const size_t n = x.size();
+    volatile double sink = 0.0;
+    double scalar = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < n; ++i) acc += Cdf::cdf(x[i]);
+        sink = acc;
+    });
+    double vector = timeBest([&] { normalCdfBatch<Cdf>(x.data(), out.data(), n); });
+    double pricing = timeBest([&] {
+        double acc = 0.0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            acc += OptionPricer::priceWithGreeks<Cdf>(batch.S[i], batch.K[i], batch.T[i], batch.r[i],
+                                                      batch.sigma[i], batch.type[i]).price;
+        }
+        sink = acc;
+    });
+    (void)sink;
+
+    double max_abs = 0.0, max_rel = 0.0;
+    for (double v = -37.0; v <= 8.5; v += 0.001) {
+        const long double exact = 0.5L * std::erfc(-(long double)v / std::sqrt(2.0L));
+        const double err = std::abs((double)(Cdf::cdf(v) - exact));
+        max_abs = std::max(max_abs, err);
+        if (v < 0.0) max_rel = std::max(max_rel, (double)(err / exact));
+    }
+
+    std::cout << std::left << std::setw(32) << Cdf::name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << n / scalar / 1e6 << std::setw(9) << n / vector / 1e6
+              << std::setw(9) << batch.size() / pricing / 1e6 << std::scientific << std::setprecision(1)
+              << std::setw(10) << max_abs << std::setw(10) << max_rel << std::fixed << "\n";
+}
+
+void benchNormalCdf() {
+    const size_t n = 1 << 20;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<double> x(n), out(n);
+    for (size_t i = 0; i < n; ++i) x[i] = -8.0 + 16.0 * u(gen);  //every range of the Cody kernel
+    OptionBatch batch;
+    batch.reserve(n / 4);
+    for (size_t i = 0; i < n / 4; ++i) {
+        batch.add(80.0 + 40.0 * u(gen), 80.0 + 40.0 * u(gen), 0.05 + 2.0 * u(gen), 0.05 * u(gen),
+                  0.1 + 0.5 * u(gen), u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT);
+    }
+
+    std::cout << "\n=== NORMAL CDF (" << n << " points in [-8, 8], single core, SIMD "
+              << simdLevelName(detectSimdLevel()) << ", pricer uses " << NormalCdf::name << ") ===\n";
+    std::cout << std::left << std::setw(32) << "policy" << std::right << std::setw(9) << "MN/s"
+              << std::setw(9) << "SIMD" << std::setw(9) << "Mopt/s" << std::setw(10) << "max abs"
+              << std::setw(10) << "max rel" << "\n";
+    benchNormalCdfPolicy<HornerCdf>(x, batch, out);
+    benchNormalCdfPolicy<CodyCdf>(x, batch, out);
+    benchNormalCdfPolicy<ErfcCdf>(x, batch, out);
+    std::cout << "(Mopt/s: priceWithGreeks on that policy; max rel over x in [-37, 0])\n";
+}
+
+int main() {
+    benchBlackScholes();
+    benchNormalCdf();
+    benchMonteCarlo();
+    benchExoticMonteCarlo();
+    benchAmerican();
+    benchLattice();
+    benchPde();
+    benchHeston();
+    benchCalibration();
+    benchSmile();
+    benchVolSurface();
+    benchYieldCurve();
+    benchImpliedVol();
+    return 0;
+}
@@ -34,20 +34,10 @@ const OptionPricingApp = () => {
   useEffect(() => {
     const checkBackend = async () => {
       try {
-        const response = await fetch(`${API_URL}/price`, { method: 'POST',
-          headers: { 'Content-Type': 'application/json' },
-          body: JSON.stringify({
-            spotPrice: 100,
-            strikePrice: 100,
-            timeToMaturity: 1.0,
-            riskFreeRate: 0.05,
-            volatility: 0.20,
-            simulations: 1000,
-            optionType: 'call'
-          })
-       });
-       const data = await response.json();
-       if (data && data.bsPrice !== undefined) {
+        // Liveness endpoint, does no pricing
+        const response = await fetch(`${API_URL}/health`);
+        const data = await response.json();
+        if (data && data.status === 'ok') {
           setBackendStatus('connected');
        } else {
           setBackendStatus('disconnected');
@@ -92,6 +82,12 @@ const OptionPricingApp = () => {
       });
       
       const data = await response.json();
+      // Prices outside the no-arbitrage bounds come back as an error, not a vol
+      if (!response.ok) {
+        console.error('Implied vol calculation failed:', data.error);
+        setImpliedVolResult(null);
+        return;
+      }
       setImpliedVolResult(data);
     } catch (err) {
       console.error('Implied vol calculation failed:', err);
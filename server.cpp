@@ -1,36 +1,531 @@
 #include "include/crow.h"
 //#include "crow_all.h"
 #include "OptionPricer.h"
+#include "BatchPricer.h"
+#include "MonteCarlo.h"
+#include "Lattice.h"
+#include "FiniteDifference.h"
+#include "Heston.h"
+#include "Calibration.h"
+#include "VolSurface.h"
+#include "SnapshotRegistry.h"
+#include "YieldCurve.h"
+#include "QuasiRandom.h"
+#include "ResultCache.h"
+#include "ImpliedVol.h"
+#include "ThreadPool.h"
 #include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <unordered_map>
 #include <cmath>
 #include "crow/middlewares/cors.h"
 
 //for testing the server endpoints
 //to start server:
-//g++ -std=c++20 server.cpp OptionPricer.cpp -Iinclude -O2 -pthread -o option_server.exe -lws2_32 -lmswsock
+//g++ -std=c++20 server.cpp OptionPricer.cpp ImpliedVol.cpp BatchPricer.cpp MonteCarlo.cpp Lattice.cpp FiniteDifference.cpp Heston.cpp Sabr.cpp Svi.cpp VolSurface.cpp YieldCurve.cpp Calibration.cpp ThreadPool.cpp Random.cpp QuasiRandom.cpp -Iinclude -O2 -pthread -o option_server.exe -lws2_32 -lmswsock
 //./option_server.exe
 
 //to send a test request using the test.json file:
 //curl.exe -X POST http://localhost:8080/price -H "Content-Type: application/json" -d "@test.json"
 
+//batch pricing takes either a list of contracts:
+//{"contracts": [{"spotPrice":100, "strikePrice":95, "timeToMaturity":0.5, "riskFreeRate":0.05, "volatility":0.2, "optionType":"call"}, ...]}
+//or one underlying with a strike/expiry grid (every strike is priced at every expiry):
+//{"spotPrice":100, "riskFreeRate":0.05, "volatility":0.2, "optionType":"put", "strikes":[90,95,100], "expiries":[0.25,0.5]}
+
+///price results are cached, cache size and quantization ticks can be set with environment variables:
+//OPTION_CACHE_CAPACITY, OPTION_CACHE_PRICE_TICK, OPTION_CACHE_TIME_TICK, OPTION_CACHE_RATE_TICK, OPTION_CACHE_VOL_TICK
+//hit/miss counters: curl.exe http://localhost:8080/cache/stats
+
+///price/exotic streams paths through blocks sized to half the L2 cache, OPTION_MC_CACHE_BYTES overrides the budget
+
+//path-dependent options (Asian, barrier, lookback) by Monte Carlo:
+//curl.exe -X POST http://localhost:8080/price/exotic -H "Content-Type: application/json" -d "{\"exotic\":\"barrier\", \"barrierType\":\"down_and_out\", \"barrier\":90, \"spotPrice\":100, \"strikePrice\":100, \"timeToMaturity\":1, \"riskFreeRate\":0.05, \"volatility\":0.2, \"optionType\":\"call\", \"simulations\":200000}"
+
+//american options on a tree ("model":"lattice" on /price), Leisen-Reimer with 200 steps unless given:
+//curl.exe -X POST http://localhost:8080/price -H "Content-Type: application/json" -d "{\"model\":\"lattice\", \"latticeModel\":\"crr\", \"exercise\":\"american\", \"steps\":500, \"spotPrice\":36, \"strikePrice\":40, \"timeToMaturity\":1, \"riskFreeRate\":0.06, \"volatility\":0.2, \"optionType\":\"put\"}"
+
+//Crank-Nicolson PDE ("model":"pde" on /price), also returns the option value across +/-40% of the spot
+//from the same solve (spotLadder), optional "barrierType"/"barrier" for continuously monitored barriers:
+//curl.exe -X POST http://localhost:8080/price -H "Content-Type: application/json" -d "{\"model\":\"pde\", \"exercise\":\"american\", \"spotPrice\":36, \"strikePrice\":40, \"timeToMaturity\":1, \"riskFreeRate\":0.06, \"volatility\":0.2, \"optionType\":\"put\"}"
+
+//Heston stochastic volatility ("model":"heston" on /price), Fourier-cosine prices of every strike in
+//"strikes" from one set of characteristic function values, with implied vols for the smile chart;
+//"simulations" adds a QE Monte Carlo check of the main strike:
+//curl.exe -X POST http://localhost:8080/price -H "Content-Type: application/json" -d "{\"model\":\"heston\", \"spotPrice\":100, \"strikePrice\":100, \"timeToMaturity\":1, \"riskFreeRate\":0.03, \"v0\":0.04, \"kappa\":1.5, \"theta\":0.04, \"volOfVol\":0.5, \"rho\":-0.7, \"strikes\":[80,90,100,110,120], \"optionType\":\"call\"}"
+
+//Heston or SABR calibration to one snapshot of implied vol quotes (Levenberg-Marquardt with exact
+//gradients). With "underlying" set, the next call for the same underlying and model starts from this
+//fit ("warmStart": false to start cold), SABR fits one (alpha, rho, nu) per expiry at "beta" (0.5 by default).
+//A fit stops after "timeBudgetMs" (1000 at most and by default) at its best point so far:
+//curl.exe -X POST http://localhost:8080/calibrate -H "Content-Type: application/json" -d "{\"model\":\"heston\", \"underlying\":\"SPX\", \"spotPrice\":100, \"riskFreeRate\":0.03, \"quotes\":[{\"strike\":90, \"expiry\":0.5, \"vol\":0.24}, {\"strike\":100, \"expiry\":0.5, \"vol\":0.2}, ...]}"
+
+//market vol surfaces per underlying, held in the server: publish a strike x expiry grid of vols (one row per
+//expiry, "interpolation" "bicubic" by default or "bilinear"), then price with "volSurface" in place of
+//"volatility" on /price (black-scholes, lattice and pde). Publishing never blocks pricing requests, each
+//request uses the surface that was current when it started:
+//curl.exe -X POST http://localhost:8080/volsurface -H "Content-Type: application/json" -d "{\"underlying\":\"SPX\", \"strikes\":[80,100,120], \"expiries\":[0.25,1], \"vols\":[[0.28,0.2,0.17],[0.25,0.21,0.19]]}"
+//curl.exe -X POST http://localhost:8080/price -H "Content-Type: application/json" -d "{\"volSurface\":\"SPX\", \"spotPrice\":100, \"strikePrice\":95, \"timeToMaturity\":0.5, \"riskFreeRate\":0.03, \"optionType\":\"put\", \"simulations\":100000}"
+//single nodes move without re-sending the grid, only the cells around them are recomputed:
+//curl.exe -X POST http://localhost:8080/volsurface/update -H "Content-Type: application/json" -d "{\"underlying\":\"SPX\", \"points\":[{\"strike\":100, \"expiry\":0.25, \"vol\":0.21}]}"
+
+//rate and dividend curves by name, held in the server like the vol surfaces: bootstrapped from "zero",
+//"deposit" and "swap" quotes ("interpolation" "monotone_convex" by default or "log_linear"), or a dividend
+//curve implied by forwards against a published discount curve. Batch pricing with "discountCurve" (and
+//optionally "dividendCurve") reads each expiry's rates off the curves instead of "riskFreeRate":
+//curl.exe -X POST http://localhost:8080/curve -H "Content-Type: application/json" -d "{\"name\":\"USD\", \"instruments\":[{\"type\":\"deposit\", \"maturity\":0.5, \"rate\":0.042}, {\"type\":\"swap\", \"maturity\":2, \"rate\":0.041, \"frequency\":2}]}"
+//curl.exe -X POST http://localhost:8080/curve -H "Content-Type: application/json" -d "{\"name\":\"SPX_DIV\", \"spotPrice\":100, \"discountCurve\":\"USD\", \"forwards\":[{\"expiry\":0.5, \"forward\":101.1}, {\"expiry\":1, \"forward\":102.2}]}"
+//{"discountCurve":"USD", "dividendCurve":"SPX_DIV", "spotPrice":100, "volatility":0.2, "strikes":[90,100], "expiries":[0.5,1]} to /price/batch
+
+//liveness and readiness checks, neither does any pricing:
+//curl.exe http://localhost:8080/health
+//curl.exe http://localhost:8080/ready
+
+//a finished Monte Carlo run, only cached when the request fixed the seed
+struct CachedMonteCarlo {
+    MonteCarloResult result;
+    std::string stopReason;
+};
+
+//black-scholes price and greeks (first and second order) of one contract, always safe to cache
+using AnalyticCache   = ShardedLruCache<PriceCacheKey, PriceGreeks, PriceCacheKeyHash>;
+using MonteCarloCache = ShardedLruCache<PriceCacheKey, CachedMonteCarlo, PriceCacheKeyHash>;
+
+//numeric environment variable, or the fallback if unset or unparsable
+double envNumber(const char* name, double fallback) {
+    const char* value = std::getenv(name);
+    if (!value) return fallback;
+    char* end = nullptr;
+    double parsed = std::strtod(value, &end);
+    return end != value ? parsed : fallback;
+}
+
+template <typename Cache>
+crow::json::wvalue cacheStats(Cache& cache) {
+    crow::json::wvalue out;
+    const std::uint64_t hits = cache.hits(), misses = cache.misses();
+    out["hits"]     = hits;
+    out["misses"]   = misses;
+    out["hitRate"]  = hits + misses ? double(hits) / double(hits + misses) : 0.0;
+    out["size"]     = static_cast<uint64_t>(cache.size());
+    out["capacity"] = static_cast<uint64_t>(cache.capacity());
+    return out;
+}
 
 OptionType parseOptionType(const std::string& s) {
     return (s == "put" || s == "PUT") ? OptionType::PUT : OptionType::CALL;
 }
 
+//"none", "antithetic", "control_variate" or "both", false if unknown
+bool parseVarianceReduction(const std::string& s, VarianceReduction& vr) {
+    if (s == "none")                 vr = VarianceReduction::NONE;
+    else if (s == "antithetic")      vr = VarianceReduction::ANTITHETIC;
+    else if (s == "control_variate") vr = VarianceReduction::CONTROL_VARIATE;
+    else if (s == "both")            vr = VarianceReduction::BOTH;
+    else return false;
+    return true;
+}
+
+//json response with the headers the frontend expects
+crow::response jsonResponse(int code, const crow::json::wvalue& out) {
+    crow::response res;
+    res.code = code;
+    res.set_header("Content-Type", "application/json");
+    res.set_header("Access-Control-Allow-Origin", "*");
+    res.write(out.dump());
+    return res;
+}
+
+crow::response errorResponse(int code, const std::string& message) {
+    crow::json::wvalue out;
+    out["error"] = message;
+    return jsonResponse(code, out);
+}
+
+//true if every key is present and numeric
+bool hasNumbers(const crow::json::rvalue& body, std::initializer_list<const char*> keys) {
+    for (const char* key : keys) {
+        if (!body.has(key) || body[key].t() != crow::json::type::Number) return false;
+    }
+    return true;
+}
+
+//most contracts one /price/batch request may price, list or chain
+constexpr size_t kMaxBatchContracts = 100000;
+
+//most paths one /price Monte Carlo run may simulate, the adaptive runs' own default cap
+constexpr int64_t kMaxSimulations = 10000000;
+
+//false unless spot, strike, maturity and vol are all positive (and not NaN)
+bool positiveContract(double S, double K, double T, double sigma) {
+    return S > 0.0 && K > 0.0 && T > 0.0 && sigma > 0.0;
+}
+
+//fills the SoA batch from either request layout, returns an error message on bad input.
+//Without rates (a discount curve supplies them) riskFreeRate is not needed and left 0
+std::string parseBatch(const crow::json::rvalue& body, OptionBatch& batch, bool rates = true) {
+    const std::string tooMany = "at most " + std::to_string(kMaxBatchContracts) + " contracts per batch";
+    const std::string notPositive = "spotPrice, strikePrice, timeToMaturity and volatility must be positive";
+    if (body.has("contracts")) {
+        if (body["contracts"].t() != crow::json::type::List) return "contracts must be a list";
+        const auto& contracts = body["contracts"];
+        if (contracts.size() > kMaxBatchContracts) return tooMany;
+        batch.reserve(contracts.size());
+        for (const auto& c : contracts) {
+            if (!hasNumbers(c, {"spotPrice", "strikePrice", "timeToMaturity", "volatility"})
+                || (rates && !hasNumbers(c, {"riskFreeRate"}))) {
+                return rates ? "each contract needs spotPrice, strikePrice, timeToMaturity, riskFreeRate and volatility"
+                             : "each contract needs spotPrice, strikePrice, timeToMaturity and volatility";
+            }
+            if (!positiveContract(c["spotPrice"].d(), c["strikePrice"].d(), c["timeToMaturity"].d(), c["volatility"].d())) {
+                return notPositive;
+            }
+            OptionType type = c.has("optionType") ? parseOptionType(c["optionType"].s()) : OptionType::CALL;
+            batch.add(c["spotPrice"].d(), c["strikePrice"].d(), c["timeToMaturity"].d(),
+                      rates ? c["riskFreeRate"].d() : 0.0, c["volatility"].d(), type);
+        }
+        return "";
+    }
+
+    if (body.has("strikes") && body.has("expiries")) {
+        if (!hasNumbers(body, {"spotPrice", "volatility"}) || (rates && !hasNumbers(body, {"riskFreeRate"}))) {
+            return rates ? "chain needs spotPrice, riskFreeRate and volatility" : "chain needs spotPrice and volatility";
+        }
+        if (body["strikes"].t() != crow::json::type::List || body["expiries"].t() != crow::json::type::List) {
+            return "strikes and expiries must be lists";
+        }
+        const double S     = body["spotPrice"].d();
+        const double r     = rates ? body["riskFreeRate"].d() : 0.0;
+        const double sigma = body["volatility"].d();
+        OptionType type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+
+        if (body["strikes"].size() * body["expiries"].size() > kMaxBatchContracts) return tooMany;
+        batch.reserve(body["strikes"].size() * body["expiries"].size());
+        for (const auto& T : body["expiries"]) {
+            for (const auto& K : body["strikes"]) {
+                if (T.t() != crow::json::type::Number || K.t() != crow::json::type::Number) {
+                    return "strikes and expiries must be numbers";
+                }
+                if (!positiveContract(S, K.d(), T.d(), sigma)) return notPositive;
+                batch.add(S, K.d(), T.d(), r, sigma, type);
+            }
+        }
+        return "";
+    }
+
+    return "expected a contracts list or a strikes/expiries chain";
+}
+
+//one side of a quote surface: a list of rows (one per expiry) of prices (one per strike),
+//null where there is no quote. Appends row-major to out, returns an error message on bad input
+std::string parseQuoteGrid(const crow::json::rvalue& grid, const char* name, size_t rows, size_t cols,
+                           std::vector<double>& out) {
+    const std::string label(name);
+    if (grid.t() != crow::json::type::List || grid.size() != rows) {
+        return label + " must have one row per expiry";
+    }
+    for (const auto& row : grid) {
+        if (row.t() != crow::json::type::List || row.size() != cols) {
+            return label + " rows must have one price per strike";
+        }
+        for (const auto& quote : row) {
+            if (quote.t() == crow::json::type::Null) {
+                out.push_back(std::numeric_limits<double>::quiet_NaN());  //no quote, reported as not converged
+            } else if (quote.t() == crow::json::type::Number) {
+                out.push_back(quote.d());
+            } else {
+                return label + " prices must be numbers or null";
+            }
+        }
+    }
+    return "";
+}
+
+//most paths one /price/exotic request may simulate, each walking up to kMaxExoticSteps dates, and the
+//most path-steps in total: a year of daily dates on every path, ~3.5 s at ~73 M path-steps/s
+constexpr long kMaxExoticSimulations = 1000000;
+constexpr long kMaxExoticPathSteps = 252000000;
+
+//the contract of a /price/exotic request, returns an error message on bad input
+//"exotic": "asian" | "barrier" | "lookback", then per kind
+//  asian:    "average": "arithmetic" (default) | "geometric"
+//  barrier:  "barrier": level, "barrierType": "up_and_out" | "up_and_in" | "down_and_out" | "down_and_in"
+//  lookback: "lookback": "floating" (default) | "fixed"
+//and for every kind "steps" (monitoring dates, 252 by default) and "continuousMonitoring" (default true)
+std::string parseExoticOption(const crow::json::rvalue& body, ExoticOption& option) {
+    const std::string kind = body.has("exotic") ? std::string(body["exotic"].s()) : "";
+    if (kind == "asian")         option.kind = ExoticKind::ASIAN;
+    else if (kind == "barrier")  option.kind = ExoticKind::BARRIER;
+    else if (kind == "lookback") option.kind = ExoticKind::LOOKBACK;
+    else return "exotic must be asian, barrier or lookback";
+
+    option.type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+    if (body.has("steps")) {
+        if (body["steps"].t() != crow::json::type::Number) return "steps must be a number";
+        const int64_t steps = body["steps"].i();
+        if (steps < 1 || steps > static_cast<int64_t>(kMaxExoticSteps)) {
+            return "steps must be between 1 and " + std::to_string(kMaxExoticSteps);
+        }
+        option.steps = static_cast<unsigned>(steps);
+    }
+    if (body.has("continuousMonitoring")) option.continuousMonitoring = body["continuousMonitoring"].b();
+
+    if (option.kind == ExoticKind::ASIAN && body.has("average")) {
+        const std::string average = body["average"].s();
+        if (average == "arithmetic")     option.average = AsianAverage::ARITHMETIC;
+        else if (average == "geometric") option.average = AsianAverage::GEOMETRIC;
+        else return "average must be arithmetic or geometric";
+    }
+    if (option.kind == ExoticKind::BARRIER) {
+        if (!hasNumbers(body, {"barrier"}) || body["barrier"].d() <= 0.0) return "barrier must be a positive number";
+        option.barrier = body["barrier"].d();
+        const std::string type = body.has("barrierType") ? std::string(body["barrierType"].s()) : "";
+        if (type == "up_and_out")        option.barrierType = BarrierType::UP_AND_OUT;
+        else if (type == "up_and_in")    option.barrierType = BarrierType::UP_AND_IN;
+        else if (type == "down_and_out") option.barrierType = BarrierType::DOWN_AND_OUT;
+        else if (type == "down_and_in")  option.barrierType = BarrierType::DOWN_AND_IN;
+        else return "barrierType must be up_and_out, up_and_in, down_and_out or down_and_in";
+    }
+    if (option.kind == ExoticKind::LOOKBACK && body.has("lookback")) {
+        const std::string strike = body["lookback"].s();
+        if (strike == "floating")   option.lookback = LookbackStrike::FLOATING;
+        else if (strike == "fixed") option.lookback = LookbackStrike::FIXED;
+        else return "lookback must be floating or fixed";
+    }
+    return "";
+}
+
+constexpr size_t kMaxExerciseTimes = 1000;
+
+//tree settings of a "model":"lattice" /price request, returns an error message on bad input
+std::string parseLatticeOptions(const crow::json::rvalue& body, LatticeOptions& options) {
+    if (body.has("latticeModel")) {
+        const std::string model = body["latticeModel"].s();
+        if (model == "crr")                options.model = LatticeModel::CRR;
+        else if (model == "leisen_reimer") options.model = LatticeModel::LEISEN_REIMER;
+        else if (model == "trinomial")     options.model = LatticeModel::TRINOMIAL;
+        else return "latticeModel must be crr, leisen_reimer or trinomial";
+    }
+    if (body.has("exercise")) {
+        const std::string exercise = body["exercise"].s();
+        if (exercise == "american")      options.exercise = ExerciseStyle::AMERICAN;
+        else if (exercise == "european") options.exercise = ExerciseStyle::EUROPEAN;
+        else if (exercise == "bermudan") options.exercise = ExerciseStyle::BERMUDAN;
+        else return "exercise must be american, european or bermudan";
+    }
+    if (options.exercise == ExerciseStyle::BERMUDAN) {
+        if (!body.has("exerciseTimes") || body["exerciseTimes"].t() != crow::json::type::List) {
+            return "bermudan exercise needs an exerciseTimes list";
+        }
+        if (body["exerciseTimes"].size() > kMaxExerciseTimes) {
+            return "at most " + std::to_string(kMaxExerciseTimes) + " exerciseTimes";
+        }
+        for (const auto& time : body["exerciseTimes"]) {
+            if (time.t() != crow::json::type::Number) return "exerciseTimes must be numbers";
+            options.exerciseTimes.push_back(time.d());
+        }
+    }
+    if (body.has("steps")) {
+        if (body["steps"].t() != crow::json::type::Number) return "steps must be a number";
+        const int64_t steps = body["steps"].i();
+        if (steps < 1 || steps > static_cast<int64_t>(kMaxLatticeSteps)) {
+            return "steps must be between 1 and " + std::to_string(kMaxLatticeSteps);
+        }
+        options.steps = static_cast<unsigned>(steps);
+    }
+    if (body.has("richardson")) options.richardson = body["richardson"].b();
+    if (body.has("smoothing"))  options.smoothing = body["smoothing"].b();
+    return "";
+}
+
+//grid settings of a "model":"pde" /price request, returns an error message on bad input
+std::string parsePdeOptions(const crow::json::rvalue& body, PdeOptions& options) {
+    if (body.has("exercise")) {
+        const std::string exercise = body["exercise"].s();
+        if (exercise == "american")      options.exercise = ExerciseStyle::AMERICAN;
+        else if (exercise == "european") options.exercise = ExerciseStyle::EUROPEAN;
+        else return "exercise must be american or european";
+    }
+    if (body.has("spotNodes")) {
+        if (body["spotNodes"].t() != crow::json::type::Number) return "spotNodes must be a number";
+        const int64_t nodes = body["spotNodes"].i();
+        if (nodes < 8 || nodes > static_cast<int64_t>(kMaxPdeNodes)) {
+            return "spotNodes must be between 8 and " + std::to_string(kMaxPdeNodes);
+        }
+        options.spotNodes = static_cast<unsigned>(nodes);
+    }
+    if (body.has("timeSteps")) {
+        if (body["timeSteps"].t() != crow::json::type::Number) return "timeSteps must be a number";
+        const int64_t steps = body["timeSteps"].i();
+        if (steps < 1 || steps > static_cast<int64_t>(kMaxPdeTimeSteps)) {
+            return "timeSteps must be between 1 and " + std::to_string(kMaxPdeTimeSteps);
+        }
+        options.timeSteps = static_cast<unsigned>(steps);
+    }
+    if (body.has("earlyExercise")) {
+        const std::string method = body["earlyExercise"].s();
+        if (method == "brennan_schwartz") options.earlyExercise = EarlyExercise::BRENNAN_SCHWARTZ;
+        else if (method == "psor")        options.earlyExercise = EarlyExercise::PSOR;
+        else return "earlyExercise must be brennan_schwartz or psor";
+    }
+    if (body.has("barrierType")) {
+        if (!hasNumbers(body, {"barrier"}) || body["barrier"].d() <= 0.0) return "barrier must be a positive number";
+        options.hasBarrier = true;
+        options.barrier = body["barrier"].d();
+        const std::string type = body["barrierType"].s();
+        if (type == "up_and_out")        options.barrierType = BarrierType::UP_AND_OUT;
+        else if (type == "up_and_in")    options.barrierType = BarrierType::UP_AND_IN;
+        else if (type == "down_and_out") options.barrierType = BarrierType::DOWN_AND_OUT;
+        else if (type == "down_and_in")  options.barrierType = BarrierType::DOWN_AND_IN;
+        else return "barrierType must be up_and_out, up_and_in, down_and_out or down_and_in";
+    }
+    return "";
+}
+
+//model parameters of a "model":"heston" request, returns an error message on bad input
+//(ranges are checked by the pricer)
+std::string parseHestonParams(const crow::json::rvalue& body, HestonParams& params) {
+    if (!hasNumbers(body, {"v0", "kappa", "theta", "volOfVol", "rho"})) {
+        return "v0, kappa, theta, volOfVol and rho are required numbers";
+    }
+    params.v0    = body["v0"].d();
+    params.kappa = body["kappa"].d();
+    params.theta = body["theta"].d();
+    params.xi    = body["volOfVol"].d();
+    params.rho   = body["rho"].d();
+    return "";
+}
+
+//most strikes one "model":"heston" request may price
+constexpr size_t kMaxHestonStrikes = 10000;
+//most paths of its QE Monte Carlo check, each walking up to kMaxHestonSteps steps, and the most
+//path-steps in total (QE runs ~17 M path-steps/s, so about 3 s)
+constexpr int64_t kMaxHestonSimulations = 1000000;
+constexpr int64_t kMaxHestonPathSteps = 50000000;
+
+//most quotes and distinct expiries one /calibrate request may fit (a heston iteration prices every
+//expiry), the most iterations it may ask for, and the wall-clock budget a fit gets unless it asks for less
+constexpr size_t kMaxCalibrationQuotes = 2000;
+constexpr size_t kMaxCalibrationExpiries = 64;
+constexpr int64_t kMaxCalibrationIterations = 1000;
+constexpr double kCalibrationBudgetMs = 1000.0;
+
+//quotes of a /calibrate request: [{"strike", "expiry", "vol", "weight" (optional)}, ...]
+std::string parseVolQuotes(const crow::json::rvalue& body, std::vector<VolQuote>& quotes) {
+    if (!body.has("quotes") || body["quotes"].t() != crow::json::type::List) return "quotes must be a list";
+    if (body["quotes"].size() > kMaxCalibrationQuotes) {
+        return "at most " + std::to_string(kMaxCalibrationQuotes) + " quotes";
+    }
+    quotes.reserve(body["quotes"].size());
+    std::set<double> expiries;
+    for (const auto& q : body["quotes"]) {
+        if (!hasNumbers(q, {"strike", "expiry", "vol"})) return "each quote needs strike, expiry and vol";
+        if (q.has("weight") && q["weight"].t() != crow::json::type::Number) return "weight must be a number";
+        quotes.push_back({q["strike"].d(), q["expiry"].d(), q["vol"].d(), q.has("weight") ? q["weight"].d() : 1.0});
+        expiries.insert(quotes.back().expiry);
+    }
+    if (expiries.size() > kMaxCalibrationExpiries) {
+        return "at most " + std::to_string(kMaxCalibrationExpiries) + " distinct expiries";
+    }
+    return "";
+}
+
+//most nodes one published vol surface may have (a bicubic surface keeps ~136 bytes per node, so
+//~2.7 MB) and most underlyings with a published surface, which bounds their memory to ~270 MB
+constexpr size_t kMaxSurfaceNodes = 20000;
+constexpr size_t kMaxVolSurfaces = 100;
+//most strikes x expiries of one /implied-vol/surface request, solved and returned but not kept
+constexpr size_t kMaxIvSurfaceNodes = 100000;
+
+//the contract's vol: "volatility", or the published surface named by "volSurface" at the strike and
+//expiry (surface is set to that surface's name). Returns an error message on bad input
+std::string resolveVolatility(const crow::json::rvalue& body, const SnapshotRegistry<VolSurface>& surfaces,
+                              double K, double T, double& sigma, std::string& surface) {
+    if (!body.has("volSurface")) {
+        if (!hasNumbers(body, {"volatility"})) return "volatility or volSurface is required";
+        sigma = body["volatility"].d();
+        return "";
+    }
+    if (body["volSurface"].t() != crow::json::type::String) return "volSurface must be a string";
+    surface = body["volSurface"].s();
+    const SnapshotRegistry<VolSurface>::Snapshot snapshot = surfaces.get(surface);
+    if (!snapshot) return "no vol surface published for " + surface;
+    if (!(K > 0.0) || !(T > 0.0)) return "strikePrice and timeToMaturity must be positive";
+    sigma = snapshot->vol(K, T);
+    return "";
+}
+
+//most instruments or forwards one /curve request may give, the longest maturity it may quote, and
+//most curves published at once
+constexpr size_t kMaxCurveInstruments = 200;
+constexpr size_t kMaxCurves = 100;
+constexpr double kMaxCurveMaturity = 100.0;
+
+//the published curve named by body[key], null with an error message if it is missing or not a name
+SnapshotRegistry<YieldCurve>::Snapshot findCurve(const crow::json::rvalue& body, const char* key,
+                                                 const SnapshotRegistry<YieldCurve>& curves, std::string& error) {
+    if (body[key].t() != crow::json::type::String) {
+        error = std::string(key) + " must be a string";
+        return nullptr;
+    }
+    const std::string name = body[key].s();
+    SnapshotRegistry<YieldCurve>::Snapshot curve = curves.get(name);
+    if (!curve) error = "no curve published as " + name;
+    return curve;
+}
+
+//last fitted parameters per underlying, where the next snapshot's calibration starts
+struct CalibrationStore {
+    std::mutex mutex;
+    std::unordered_map<std::string, HestonParams> heston;
+    std::unordered_map<std::string, std::vector<SabrSlice>> sabr;
+};
+
+//points of the /price spotLadder, spot +/- 40% like the frontend's sensitivity chart
+constexpr int kSpotLadderPoints = 81;
+constexpr double kSpotLadderRange = 0.4;
+
+//readiness fails once the shared pool has more than this many helper tasks waiting per thread,
+//at that point new pricing requests would mostly sit in the queue
+constexpr size_t kReadyMaxQueuedPerThread = 4;
+
 int main() {
     crow::App<crow::CORSHandler> app;
+    const auto startTime = std::chrono::steady_clock::now();
 
     //crow CORS middleware setup
     auto& cors = app.get_middleware<crow::CORSHandler>();
     cors.global()
         .origin("*") //allows any origin
-        .methods("POST"_method, "OPTIONS"_method)
+        .methods("GET"_method, "POST"_method, "OPTIONS"_method)
         .headers("Content-Type");
 
+    //result caches for /price, the frontend re-sends the same contract on every poll and slider settle
+    const size_t cacheCapacity = static_cast<size_t>(envNumber("OPTION_CACHE_CAPACITY", 65536));
+    CacheQuantization quantization;
+    quantization.price = envNumber("OPTION_CACHE_PRICE_TICK", quantization.price);
+    quantization.time  = envNumber("OPTION_CACHE_TIME_TICK", quantization.time);
+    quantization.rate  = envNumber("OPTION_CACHE_RATE_TICK", quantization.rate);
+    quantization.vol   = envNumber("OPTION_CACHE_VOL_TICK", quantization.vol);
+    AnalyticCache analyticCache(cacheCapacity);
+    MonteCarloCache monteCarloCache(cacheCapacity);
+
+    //working-set budget of a /price/exotic path block, 0 sizes it to the detected L2
+    const size_t pathBlockBytes = static_cast<size_t>(envNumber("OPTION_MC_CACHE_BYTES", 0));
+
+    CalibrationStore calibrationStore;
+    SnapshotRegistry<VolSurface> volSurfaces(kMaxVolSurfaces);
+    SnapshotRegistry<YieldCurve> curves(kMaxCurves);
+
     //main pricing endpoint
     CROW_ROUTE(app, "/price").methods(crow::HTTPMethod::Post)
-    ([](const crow::request& req) {
+    ([&](const crow::request& req) {
         auto body = crow::json::load(req.body);
         if (!body) {
             crow::response res(400);
@@ -39,27 +534,324 @@ int main() {
             return res;
         }
 
+        //"black-scholes" (default) is the analytic price next to a Monte Carlo estimate,
+        //"lattice" prices on a tree and "pde" on a finite-difference grid, both handle american exercise,
+        //"heston" prices a strike grid under stochastic volatility
+        const std::string model = body.has("model") ? std::string(body["model"].s()) : "black-scholes";
+        if (model == "lattice") {
+            if (!hasNumbers(body, {"spotPrice", "strikePrice", "timeToMaturity", "riskFreeRate"})) {
+                return errorResponse(400, "spotPrice, strikePrice, timeToMaturity and riskFreeRate are required numbers");
+            }
+            const double S = body["spotPrice"].d(), K = body["strikePrice"].d(), T = body["timeToMaturity"].d();
+            const double r = body["riskFreeRate"].d();
+            double sigma = 0.0;
+            std::string surface;
+            const std::string volError = resolveVolatility(body, volSurfaces, K, T, sigma, surface);
+            if (!volError.empty()) {
+                return errorResponse(400, volError);
+            }
+            if (S <= 0.0 || K <= 0.0 || T <= 0.0 || sigma <= 0.0) {
+                return errorResponse(400, "spotPrice, strikePrice, timeToMaturity and volatility must be positive");
+            }
+            LatticeOptions options;
+            const std::string parseError = parseLatticeOptions(body, options);
+            if (!parseError.empty()) {
+                return errorResponse(400, parseError);
+            }
+            const OptionType type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            LatticeResult lattice;
+            try {
+                lattice = priceLattice(S, K, T, r, sigma, type, options);
+            } catch (const std::invalid_argument& e) {
+                return errorResponse(400, e.what());
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            const double bs = OptionPricer(S, K, T, r, sigma).blackScholes(type);
+
+            crow::json::wvalue out;
+            out["latticePrice"]   = lattice.price;
+            out["bsPrice"]        = bs;  //european, for comparison
+            out["earlyExercisePremium"] = options.exercise != ExerciseStyle::EUROPEAN ? lattice.price - bs : 0.0;
+            out["latticeTimeMs"]  = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            out["model"]          = model;
+            out["latticeModel"]   = latticeModelName(options.model);
+            out["exercise"]       = exerciseStyleName(options.exercise);
+            out["steps"]          = lattice.steps;
+            out["richardson"]     = options.richardson;
+            out["greeks"]["delta"] = lattice.delta;
+            out["greeks"]["gamma"] = lattice.gamma;
+            out["greeks"]["theta"] = lattice.theta;
+            if (!surface.empty()) {
+                out["volSurface"] = surface;
+                out["volatility"] = sigma;
+            }
+            return jsonResponse(200, out);
+        }
+        if (model == "pde") {
+            if (!hasNumbers(body, {"spotPrice", "strikePrice", "timeToMaturity", "riskFreeRate"})) {
+                return errorResponse(400, "spotPrice, strikePrice, timeToMaturity and riskFreeRate are required numbers");
+            }
+            const double S = body["spotPrice"].d(), K = body["strikePrice"].d(), T = body["timeToMaturity"].d();
+            const double r = body["riskFreeRate"].d();
+            double sigma = 0.0;
+            std::string surface;
+            const std::string volError = resolveVolatility(body, volSurfaces, K, T, sigma, surface);
+            if (!volError.empty()) {
+                return errorResponse(400, volError);
+            }
+            PdeOptions options;
+            const std::string parseError = parsePdeOptions(body, options);
+            if (!parseError.empty()) {
+                return errorResponse(400, parseError);
+            }
+            const OptionType type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+            auto t0 = std::chrono::high_resolution_clock::now();
+            std::optional<PdeGrid> grid;
+            try {
+                grid.emplace(solvePde(S, K, T, r, sigma, type, options));
+            } catch (const std::invalid_argument& e) {
+                return errorResponse(400, e.what());
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+
+            crow::json::wvalue out;
+            out["pdePrice"]   = grid->value(S);
+            out["bsPrice"]    = OptionPricer(S, K, T, r, sigma).blackScholes(type);  //european, no barrier
+            out["pdeTimeMs"]  = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            out["model"]      = model;
+            out["exercise"]   = exerciseStyleName(options.exercise);
+            out["spotNodes"]  = options.spotNodes;
+            out["timeSteps"]  = options.timeSteps;
+            out["greeks"]["delta"] = grid->delta(S);
+            out["greeks"]["gamma"] = grid->gamma(S);
+            out["greeks"]["theta"] = grid->theta(S);
+            if (!surface.empty()) {
+                out["volSurface"] = surface;
+                out["volatility"] = sigma;
+            }
+            //the whole chart from the one solve, points off the grid (past a barrier) are left out
+            int point = 0;
+            for (int i = 0; i < kSpotLadderPoints; ++i) {
+                const double spot = S * (1.0 - kSpotLadderRange + 2.0 * kSpotLadderRange * i / (kSpotLadderPoints - 1));
+                const double value = grid->value(spot);
+                if (std::isnan(value)) continue;
+                out["spotLadder"][point]["spot"]  = spot;
+                out["spotLadder"][point]["value"] = value;
+                out["spotLadder"][point]["intrinsic"] = std::max(type == OptionType::CALL ? spot - K : K - spot, 0.0);
+                ++point;
+            }
+            return jsonResponse(200, out);
+        }
+        if (model == "heston") {
+            if (!hasNumbers(body, {"spotPrice", "strikePrice", "timeToMaturity", "riskFreeRate"})) {
+                return errorResponse(400, "spotPrice, strikePrice, timeToMaturity and riskFreeRate are required numbers");
+            }
+            const double S = body["spotPrice"].d(), K = body["strikePrice"].d(), T = body["timeToMaturity"].d();
+            const double r = body["riskFreeRate"].d();
+            HestonParams params;
+            const std::string parseError = parseHestonParams(body, params);
+            if (!parseError.empty()) {
+                return errorResponse(400, parseError);
+            }
+            //the contract's own strike first, then the optional grid
+            std::vector<double> strikes{K};
+            if (body.has("strikes")) {
+                if (body["strikes"].t() != crow::json::type::List) return errorResponse(400, "strikes must be a list");
+                if (body["strikes"].size() > kMaxHestonStrikes) {
+                    return errorResponse(400, "at most " + std::to_string(kMaxHestonStrikes) + " strikes");
+                }
+                for (const auto& strike : body["strikes"]) {
+                    if (strike.t() != crow::json::type::Number) return errorResponse(400, "strikes must be numbers");
+                    strikes.push_back(strike.d());
+                }
+            }
+            unsigned terms = kHestonCosTerms;
+            if (body.has("cosTerms")) {
+                if (body["cosTerms"].t() != crow::json::type::Number) return errorResponse(400, "cosTerms must be a number");
+                const int64_t n = body["cosTerms"].i();
+                if (n < 16 || n > static_cast<int64_t>(kMaxHestonCosTerms)) {
+                    return errorResponse(400, "cosTerms must be between 16 and " + std::to_string(kMaxHestonCosTerms));
+                }
+                terms = static_cast<unsigned>(n);
+            }
+            const int64_t sims = body.has("simulations") && body["simulations"].t() == crow::json::type::Number
+                               ? body["simulations"].i() : 0;
+            const int64_t mcSteps = body.has("steps") && body["steps"].t() == crow::json::type::Number
+                                  ? body["steps"].i() : 100;
+            if (sims < 0 || sims > kMaxHestonSimulations) {
+                return errorResponse(400, "simulations must be between 0 and " + std::to_string(kMaxHestonSimulations));
+            }
+            if (sims > 0 && (mcSteps < 1 || mcSteps > static_cast<int64_t>(kMaxHestonSteps))) {
+                return errorResponse(400, "steps must be between 1 and " + std::to_string(kMaxHestonSteps));
+            }
+            if (sims > 0 && sims * mcSteps > kMaxHestonPathSteps) {
+                return errorResponse(400, "simulations * steps must be at most " + std::to_string(kMaxHestonPathSteps));
+            }
+            const OptionType type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+
+            auto t0 = std::chrono::high_resolution_clock::now();
+            std::vector<double> prices;
+            try {
+                prices = HestonCos(S, T, r, params, terms).prices(strikes, type);
+            } catch (const std::invalid_argument& e) {
+                return errorResponse(400, e.what());
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+
+            crow::json::wvalue out;
+            out["hestonPrice"]   = prices[0];
+            const double vol = solveImpliedVol(prices[0], S, K, T, r, type).vol;
+            out["impliedVol"]    = std::isnan(vol) ? crow::json::wvalue(nullptr) : crow::json::wvalue(vol);
+            out["bsPrice"]       = OptionPricer(S, K, T, r, std::sqrt(params.v0)).blackScholes(type);  //flat vol sqrt(v0)
+            out["hestonTimeMs"]  = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            out["model"]         = model;
+            out["cosTerms"]      = terms;
+            for (size_t i = 1; i < strikes.size(); ++i) {
+                //null where the price is too far out of the money to carry a vol
+                const double smileVol = solveImpliedVol(prices[i], S, strikes[i], T, r, type).vol;
+                out["strikeGrid"][i - 1]["strike"] = strikes[i];
+                out["strikeGrid"][i - 1]["price"]  = prices[i];
+                out["strikeGrid"][i - 1]["impliedVol"] = std::isnan(smileVol) ? crow::json::wvalue(nullptr) : crow::json::wvalue(smileVol);
+            }
+            if (sims > 0) {
+                const uint64_t seed = body.has("seed") ? body["seed"].u()
+                                                       : (uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+                const MonteCarloResult mc = monteCarloHeston(S, K, T, r, params, type, sims, seed,
+                                                             static_cast<unsigned>(mcSteps), VarianceReduction::BOTH);
+                auto t2 = std::chrono::high_resolution_clock::now();
+                out["mcPrice"]    = mc.price;
+                out["mcStdError"] = mc.stdError;
+                out["mcPaths"]    = static_cast<int64_t>(mc.paths);
+                out["mcTimeMs"]   = std::chrono::duration<double, std::milli>(t2 - t1).count();
+                out["seed"]       = seed;
+            }
+            return jsonResponse(200, out);
+        }
+        if (model != "black-scholes") {
+            return errorResponse(400, "model must be \"black-scholes\", \"lattice\", \"pde\" or \"heston\"");
+        }
+
         //extract parameters
         double S     = body["spotPrice"].d(); //.d() is decimal
         double K     = body["strikePrice"].d();
         double T     = body["timeToMaturity"].d();
         double r     = body["riskFreeRate"].d();
-        double sigma = body["volatility"].d();
-        int    sims  = body["simulations"].i(); //.i() is integer
+        //a flat "volatility", or the underlying's published surface read at this strike and expiry
+        double sigma = 0.0;
+        std::string surface;
+        const std::string volError = resolveVolatility(body, volSurfaces, K, T, sigma, surface);
+        if (!volError.empty()) {
+            return errorResponse(400, volError);
+        }
+        if (!positiveContract(S, K, T, sigma)) {
+            return errorResponse(400, "spotPrice, strikePrice, timeToMaturity and volatility must be positive");
+        }
+        if (!hasNumbers(body, {"simulations"})) {
+            return errorResponse(400, "simulations must be a number");
+        }
+        const int64_t requestedSims = body["simulations"].i(); //.i() is integer
+        if (requestedSims < 2 || requestedSims > kMaxSimulations) {
+            return errorResponse(400, "simulations must be between 2 and " + std::to_string(kMaxSimulations));
+        }
+        int    sims  = static_cast<int>(requestedSims);
         std::string typeStr = body["optionType"].s(); //.s() is string
 
+        //optional seed makes the Monte Carlo price reproducible, otherwise pick a fresh one
+        uint64_t seed = body.has("seed") ? body["seed"].u()
+                                         : (uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+        //"mc" (default) is pseudo-random with antithetic variates, "qmc" is scrambled Sobol + Brownian bridge
+        std::string method = body.has("method") ? std::string(body["method"].s()) : "mc";
+        if (method != "mc" && method != "qmc") {
+            return errorResponse(400, "method must be \"mc\" or \"qmc\"");
+        }
+        //time steps of a "qmc" path, range checked before narrowing
+        int steps = 1;
+        if (method == "qmc" && body.has("steps")) {
+            if (body["steps"].t() != crow::json::type::Number) return errorResponse(400, "steps must be a number");
+            const int64_t requestedSteps = body["steps"].i();
+            if (requestedSteps < 1 || requestedSteps > static_cast<int64_t>(SobolSequence::kMaxDimensions)) {
+                return errorResponse(400, "steps must be between 1 and " + std::to_string(SobolSequence::kMaxDimensions));
+            }
+            steps = static_cast<int>(requestedSteps);
+        }
+        if (method == "qmc" && sims < static_cast<int>(kQmcReplicates)) {
+            return errorResponse(400, "method \"qmc\" needs at least " + std::to_string(kQmcReplicates) + " simulations");
+        }
+        //variance reduction for "mc", antithetic unless asked otherwise
+        std::string vrName = body.has("variance_reduction") ? std::string(body["variance_reduction"].s()) : "antithetic";
+        VarianceReduction vr;
+        if (!parseVarianceReduction(vrName, vr)) {
+            return errorResponse(400, "variance_reduction must be none, antithetic, control_variate or both");
+        }
+        if (method == "qmc" && body.has("variance_reduction")) {
+            return errorResponse(400, "variance_reduction only applies to method \"mc\"");
+        }
+        //adaptive stopping: run until the standard error target or the latency budget is met,
+        //"simulations" then acts as the cap
+        AdaptiveOptions adaptive;
+        adaptive.targetStdError = body.has("targetStdError") ? body["targetStdError"].d() : 0.0;
+        adaptive.timeBudgetMs   = body.has("timeBudgetMs") ? body["timeBudgetMs"].d() : 0.0;
+        adaptive.maxSims        = sims;
+        const bool isAdaptive = adaptive.targetStdError > 0.0 || adaptive.timeBudgetMs > 0.0;
+        if (isAdaptive && method == "qmc") {
+            return errorResponse(400, "targetStdError/timeBudgetMs only apply to method \"mc\"");
+        }
+
         OptionType type = parseOptionType(typeStr); //classify as call or put
         OptionPricer pricer(S, K, T, r, sigma); //initialize pricer
 
+        //black-scholes and greeks only depend on the contract; a Monte Carlo run also depends on
+        //everything that changes its paths, and is only reproducible (so cacheable) with a fixed seed.
+        //a time budget makes the path count depend on machine load, so those runs are never cached
+        PriceCacheKey key = makeContractKey(quantization, S, K, T, r, sigma, static_cast<int>(type));
+        PriceCacheKey mcKey = key;
+        mcKey.sims = sims;
+        mcKey.seed = seed;
+        mcKey.method = method == "qmc" ? 1 : 0;
+        mcKey.variance_reduction = method == "qmc" ? 0 : static_cast<int>(vr);
+        mcKey.steps = method == "qmc" ? steps : 0;
+        mcKey.target_std_error = std::llround(adaptive.targetStdError * 1e9);
+        const bool mcCacheable = body.has("seed") && adaptive.timeBudgetMs <= 0.0;
+
         auto t0 = std::chrono::high_resolution_clock::now();
-        double bs = pricer.blackScholes(type); //exact price
+        //exact price and every greek from one shared set of d1/d2/exp terms
+        PriceGreeks analytic;
+        const bool analyticHit = analyticCache.get(key, analytic);
+        if (!analyticHit) {
+            analytic = pricer.priceWithGreeks(type, true);
+            analyticCache.put(key, analytic);
+        }
         auto t1 = std::chrono::high_resolution_clock::now();
+        double bs = analytic.price;
 
         auto t2 = std::chrono::high_resolution_clock::now();
-        double mc = pricer.monteCarlo(type, sims, true); //mc price
+        //mc price, paths are spread over the shared thread pool
+        MonteCarloResult mcResult;
+        std::string stopReason = "simulations";
+        CachedMonteCarlo cachedRun;
+        const bool mcHit = mcCacheable && monteCarloCache.get(mcKey, cachedRun);
+        if (mcHit) {
+            mcResult = cachedRun.result;
+            stopReason = cachedRun.stopReason;
+        } else if (method == "qmc") {
+            mcResult = monteCarloQMC(pricer, type, sims, seed, steps);
+        } else if (isAdaptive) {
+            AdaptiveMonteCarloResult run = monteCarloAdaptive(pricer, type, adaptive, seed, vr);
+            mcResult = run.result;
+            stopReason = run.stop == AdaptiveStop::TARGET_REACHED ? "targetStdError"
+                       : run.stop == AdaptiveStop::TIME_BUDGET    ? "timeBudgetMs"
+                                                                   : "simulations";
+        } else {
+            mcResult = monteCarloParallel(pricer, type, sims, seed, vr);
+        }
+        if (mcCacheable && !mcHit) {
+            monteCarloCache.put(mcKey, {mcResult, stopReason});
+        }
+        double mc = mcResult.price;
         auto t3 = std::chrono::high_resolution_clock::now();
 
-        Greeks g = pricer.calculateGreeks(type); //compute greeks
+        const Greeks& g = analytic.greeks;
 
         //finding the time taken(in ms) for the black-scholes and monte-carlo methods
         //err is the absolute error between the two methods
@@ -73,14 +865,38 @@ int main() {
         out["mcPrice"]          = mc;
         out["bsTimeMs"]         = bsMs;
         out["mcTimeMs"]         = mcMs;
+        out["mcStdError"]       = mcResult.stdError;
+        out["mcPaths"]          = static_cast<int64_t>(mcResult.paths);
+        out["mcConfidenceInterval"][0] = mcResult.ciLow;   //95%
+        out["mcConfidenceInterval"][1] = mcResult.ciHigh;
+        out["mcStopReason"]     = stopReason;
+        out["seed"]             = seed;
+        out["method"]           = method;
+        out["varianceReduction"]       = method == "qmc" ? std::string("none") : vrName;
+        out["varianceReductionFactor"] = mcResult.varianceReductionFactor;
         out["error"]            = err;
         out["relativeErrorPct"] = err / bs * 100.0;
+        out["cached"]["bs"]     = analyticHit;
+        out["cached"]["mc"]     = mcHit;
+        if (!surface.empty()) {
+            out["volSurface"]   = surface;
+            out["volatility"]   = sigma;
+        }
 
         out["greeks"]["delta"]  = g.delta;
         out["greeks"]["gamma"]  = g.gamma;
         out["greeks"]["vega"]   = g.vega;
         out["greeks"]["theta"]  = g.theta;
         out["greeks"]["rho"]    = g.rho;
+        if (body.has("secondOrder") && body["secondOrder"].b()) {
+            const SecondOrderGreeks& g2 = analytic.second;
+            out["greeks"]["vanna"] = g2.vanna;
+            out["greeks"]["volga"] = g2.volga;
+            out["greeks"]["charm"] = g2.charm;
+            out["greeks"]["speed"] = g2.speed;
+            out["greeks"]["zomma"] = g2.zomma;
+            out["greeks"]["color"] = g2.color;
+        }
 
         crow::response res;
         res.code = 200;
@@ -91,6 +907,196 @@ int main() {
     });
 
 
+    //batch pricing endpoint
+    //prices a whole option chain in one request with one pass of the SoA batch pricer
+    //with "discountCurve" (and "dividendCurve") the rates come from published curves, one lookup per expiry
+    CROW_ROUTE(app, "/price/batch").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+
+        //the snapshots are held for the whole request, a curve published meanwhile applies to the next one
+        SnapshotRegistry<YieldCurve>::Snapshot rates, dividends;
+        std::string curveError;
+        if (body.has("discountCurve")) {
+            rates = findCurve(body, "discountCurve", curves, curveError);
+        }
+        if (curveError.empty() && body.has("dividendCurve")) {
+            if (!rates) {
+                return errorResponse(400, "dividendCurve needs a discountCurve");
+            }
+            dividends = findCurve(body, "dividendCurve", curves, curveError);
+        }
+        if (!curveError.empty()) {
+            return errorResponse(400, curveError);
+        }
+
+        OptionBatch batch;
+        std::string parseError = parseBatch(body, batch, !rates);
+        if (!parseError.empty()) {
+            return errorResponse(400, parseError);
+        }
+
+        BatchResult result;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (rates) {
+            priceBatch(batch, *rates, dividends.get(), result);
+        } else {
+            priceBatch(batch, result);
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue::list rows;
+        rows.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            crow::json::wvalue row;
+            row["strikePrice"]     = batch.K[i];
+            row["timeToMaturity"]  = batch.T[i];
+            row["optionType"]      = batch.type[i] == OptionType::CALL ? "call" : "put";
+            row["bsPrice"]         = result.price[i];
+            row["greeks"]["delta"] = result.delta[i];
+            row["greeks"]["gamma"] = result.gamma[i];
+            row["greeks"]["vega"]  = result.vega[i];
+            row["greeks"]["theta"] = result.theta[i];
+            row["greeks"]["rho"]   = result.rho[i];
+            rows.push_back(std::move(row));
+        }
+
+        //bsTimeMs is the pricing pass only, batchTimeMs also covers JSON parsing and building the response
+        double bsMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        crow::json::wvalue out;
+        out["count"]        = static_cast<uint64_t>(batch.size());
+        if (rates) {
+            out["discountCurve"] = body["discountCurve"].s();
+        }
+        if (dividends) {
+            out["dividendCurve"] = body["dividendCurve"].s();
+        }
+        out["bsTimeMs"]     = bsMs;
+        out["perOptionUs"]  = batch.size() ? bsMs * 1000.0 / batch.size() : 0.0;
+        out["results"]      = std::move(rows);
+        out["batchTimeMs"]  = std::chrono::duration<double, std::milli>(
+                                  std::chrono::high_resolution_clock::now() - start).count();
+        return jsonResponse(200, out);
+    });
+
+
+    //path-dependent Monte Carlo: Asian, barrier and lookback options on one underlying
+    //never cached, like the /price Monte Carlo runs without a seed these are on-demand simulations
+    CROW_ROUTE(app, "/price/exotic").methods(crow::HTTPMethod::Post)
+    ([pathBlockBytes](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!hasNumbers(body, {"spotPrice", "timeToMaturity", "riskFreeRate", "volatility"})) {
+            return errorResponse(400, "spotPrice, timeToMaturity, riskFreeRate and volatility are required numbers");
+        }
+        const double S     = body["spotPrice"].d();
+        const double T     = body["timeToMaturity"].d();
+        const double r     = body["riskFreeRate"].d();
+        const double sigma = body["volatility"].d();
+        //floating-strike lookbacks have no strike
+        const double K = hasNumbers(body, {"strikePrice"}) ? body["strikePrice"].d() : 0.0;
+        if (S <= 0.0 || T <= 0.0 || sigma <= 0.0) {
+            return errorResponse(400, "spotPrice, timeToMaturity and volatility must be positive");
+        }
+
+        ExoticOption option;
+        std::string parseError = parseExoticOption(body, option);
+        if (!parseError.empty()) {
+            return errorResponse(400, parseError);
+        }
+        const bool needsStrike = option.kind != ExoticKind::LOOKBACK || option.lookback == LookbackStrike::FIXED;
+        if (needsStrike && K <= 0.0) {
+            return errorResponse(400, "strikePrice must be a positive number");
+        }
+
+        const long sims = body.has("simulations") ? static_cast<long>(body["simulations"].i()) : 100000;
+        if (sims < 2 || sims > kMaxExoticSimulations) {
+            return errorResponse(400, "simulations must be between 2 and " + std::to_string(kMaxExoticSimulations));
+        }
+        if (sims * static_cast<long>(option.steps) > kMaxExoticPathSteps) {
+            return errorResponse(400, "simulations * steps must be at most " + std::to_string(kMaxExoticPathSteps));
+        }
+        uint64_t seed = body.has("seed") ? body["seed"].u()
+                                         : (uint64_t(std::random_device{}()) << 32 | std::random_device{}());
+        std::string vrName = body.has("variance_reduction") ? std::string(body["variance_reduction"].s()) : "antithetic";
+        VarianceReduction vr;
+        if (!parseVarianceReduction(vrName, vr)) {
+            return errorResponse(400, "variance_reduction must be none, antithetic, control_variate or both");
+        }
+
+        OptionPricer pricer(S, K, T, r, sigma);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        MonteCarloResult result = monteCarloExotic(pricer, option, sims, seed, vr, 0, pathBlockBytes);
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue out;
+        out["mcPrice"]          = result.price;
+        out["mcStdError"]       = result.stdError;
+        out["mcPaths"]          = static_cast<int64_t>(result.paths);
+        out["mcConfidenceInterval"][0] = result.ciLow;   //95%
+        out["mcConfidenceInterval"][1] = result.ciHigh;
+        out["mcTimeMs"]         = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        out["steps"]            = option.steps;
+        out["seed"]             = seed;
+        out["varianceReduction"]       = vrName;
+        out["varianceReductionFactor"] = result.varianceReductionFactor;
+        if (option.kind == ExoticKind::ASIAN && option.average == AsianAverage::GEOMETRIC) {
+            out["closedFormPrice"] = geometricAsianPrice(S, K, T, r, sigma, option.steps, option.type);
+        }
+        if (needsStrike) {
+            out["europeanPrice"] = pricer.blackScholes(option.type);  //for comparison
+        }
+        return jsonResponse(200, out);
+    });
+
+
+    //liveness: the process is up and serving requests
+    CROW_ROUTE(app, "/health").methods(crow::HTTPMethod::Get)
+    ([startTime]() {
+        crow::json::wvalue out;
+        out["status"] = "ok";
+        out["uptimeSeconds"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return jsonResponse(200, out);
+    });
+
+    //readiness: 503 while the pricing pool is saturated, so a load balancer can route elsewhere
+    CROW_ROUTE(app, "/ready").methods(crow::HTTPMethod::Get)
+    ([]() {
+        ThreadPoolStats pool = ThreadPool::shared().stats();
+        const size_t queueLimit = kReadyMaxQueuedPerThread * pool.threads;
+        const bool ready = pool.queuedTasks <= queueLimit;
+        crow::json::wvalue out;
+        out["status"] = ready ? "ready" : "saturated";
+        out["pool"]["threads"]     = pool.threads;
+        out["pool"]["busyWorkers"] = pool.busyWorkers;
+        out["pool"]["activeCalls"] = pool.activeCalls;
+        out["pool"]["queuedTasks"] = static_cast<uint64_t>(pool.queuedTasks);
+        out["pool"]["queueLimit"]  = static_cast<uint64_t>(queueLimit);
+        out["pool"]["utilization"] = double(pool.busyWorkers + pool.activeCalls) / pool.threads;
+        return jsonResponse(ready ? 200 : 503, out);
+    });
+
+    //hit/miss counters of the /price caches
+    CROW_ROUTE(app, "/cache/stats").methods(crow::HTTPMethod::Get)
+    ([&]() {
+        crow::json::wvalue out;
+        out["bs"] = cacheStats(analyticCache);
+        out["mc"] = cacheStats(monteCarloCache);
+        out["quantization"]["price"] = quantization.price;
+        out["quantization"]["time"]  = quantization.time;
+        out["quantization"]["rate"]  = quantization.rate;
+        out["quantization"]["vol"]   = quantization.vol;
+        return jsonResponse(200, out);
+    });
+
+
     //second endpoint
     //for implied volatility calculation, where user provides a market price and asks for volatility
     CROW_ROUTE(app, "/implied-vol").methods(crow::HTTPMethod::Post)
@@ -108,19 +1114,36 @@ int main() {
         double K      = body["strikePrice"].d();
         double T      = body["timeToMaturity"].d();
         double r      = body["riskFreeRate"].d();
-        double sigma0 = body.has("initialVol") ? body["initialVol"].d() : 0.2;
         double mkt    = body["marketPrice"].d();
         std::string typeStr = body["optionType"].s();
 
         OptionType type = parseOptionType(typeStr); //classify as call or put
-        OptionPricer pricer(S, K, T, r, sigma0); //initialize pricer
 
-        //calculate implied volatility
-        double iv = pricer.impliedVolatility(mkt, type); 
+        //"newton" (safeguarded Halley) by default, "rational" for the near machine precision solver
+        std::string method = body.has("method") ? std::string(body["method"].s()) : "newton";
+        if (method != "newton" && method != "rational") {
+            return errorResponse(400, "method must be \"newton\" or \"rational\"");
+        }
+
+        //calculate implied volatility, straight from the parameters (no pricer needed)
+        ImpliedVolResult iv = method == "rational" ? solveImpliedVolRational(mkt, S, K, T, r, type)
+                                                   : solveImpliedVol(mkt, S, K, T, r, type);
+        if (std::isnan(iv.vol)) {
+            crow::json::wvalue err;
+            err["error"]  = iv.status == ImpliedVolStatus::INVALID_INPUT
+                          ? "spotPrice, strikePrice and timeToMaturity must be positive, marketPrice non-negative"
+                          : "marketPrice is outside the no-arbitrage bounds for this contract";
+            err["status"] = impliedVolStatusName(iv.status);
+            return jsonResponse(400, err);  //crow has no 422 in its status table, it would send 500
+        }
 
         //building response for frontend
         crow::json::wvalue out; 
-        out["impliedVol"] = iv;
+        out["impliedVol"] = iv.vol;
+        out["iterations"] = iv.iterations;
+        out["converged"]  = iv.converged;
+        out["status"]     = impliedVolStatusName(iv.status);
+        out["method"]     = method;
 
         crow::response res;
         res.code = 200;
@@ -130,5 +1153,474 @@ int main() {
         return res;
     });
 
+    //implied vols for a whole quote surface of one underlying (strikes x expiries), for calibration
+    //takes "mid" or "bid" + "ask" grids (rows per expiry, columns per strike, null for no quote);
+    //with bid and ask the mid is their average and all three are solved. Every quote goes through
+    //one impliedVolBatch call, vectorized and spread over the thread pool
+    CROW_ROUTE(app, "/implied-vol/surface").methods(crow::HTTPMethod::Post)
+    ([](const crow::request& req) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!hasNumbers(body, {"spotPrice", "riskFreeRate"})) {
+            return errorResponse(400, "surface needs spotPrice and riskFreeRate");
+        }
+        if (!body.has("strikes") || !body.has("expiries") || body["strikes"].t() != crow::json::type::List
+            || body["expiries"].t() != crow::json::type::List) {
+            return errorResponse(400, "strikes and expiries must be lists");
+        }
+        //each side is a strikes x expiries array
+        if (body["strikes"].size() * body["expiries"].size() > kMaxIvSurfaceNodes) {
+            return errorResponse(400, "at most " + std::to_string(kMaxIvSurfaceNodes) + " surface nodes");
+        }
+        const double S = body["spotPrice"].d();
+        const double r = body["riskFreeRate"].d();
+        const OptionType type = body.has("optionType") ? parseOptionType(body["optionType"].s()) : OptionType::CALL;
+
+        std::vector<double> strikes, expiries;
+        for (const auto& K : body["strikes"]) {
+            if (K.t() != crow::json::type::Number) return errorResponse(400, "strikes and expiries must be numbers");
+            strikes.push_back(K.d());
+        }
+        for (const auto& T : body["expiries"]) {
+            if (T.t() != crow::json::type::Number) return errorResponse(400, "strikes and expiries must be numbers");
+            expiries.push_back(T.d());
+        }
+        const size_t points = strikes.size() * expiries.size();
+
+        //grids solved, in the order they sit in the price array
+        std::vector<const char*> sides;
+        std::vector<double> prices;
+        prices.reserve(3 * points);
+        if (body.has("bid") || body.has("ask")) {
+            if (!body.has("bid") || !body.has("ask")) {
+                return errorResponse(400, "bid and ask must be given together");
+            }
+            std::string parseError = parseQuoteGrid(body["bid"], "bid", expiries.size(), strikes.size(), prices);
+            if (parseError.empty()) {
+                parseError = parseQuoteGrid(body["ask"], "ask", expiries.size(), strikes.size(), prices);
+            }
+            if (!parseError.empty()) return errorResponse(400, parseError);
+            for (size_t i = 0; i < points; ++i) {
+                prices.push_back(0.5 * (prices[i] + prices[points + i]));  //NaN if either side is missing
+            }
+            sides = {"bid", "ask", "mid"};
+        } else if (body.has("mid")) {
+            std::string parseError = parseQuoteGrid(body["mid"], "mid", expiries.size(), strikes.size(), prices);
+            if (!parseError.empty()) return errorResponse(400, parseError);
+            sides = {"mid"};
+        } else {
+            return errorResponse(400, "expected a mid grid or bid and ask grids");
+        }
+
+        //contract arrays for every quote, expiry-major like the grids
+        const size_t n = prices.size();
+        std::vector<double> spot(n, S), strike(n), maturity(n), rate(n, r);
+        std::vector<OptionType> types(n, type);
+        for (size_t i = 0; i < n; ++i) {
+            const size_t point = i % points;
+            maturity[i] = expiries[point / strikes.size()];
+            strike[i]   = strikes[point % strikes.size()];
+        }
+
+        std::vector<ImpliedVolResult> vols(n);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        impliedVolBatch(prices.data(), spot.data(), strike.data(), maturity.data(), rate.data(), types.data(),
+                        vols.data(), n);
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue out;
+        size_t convergedCount = 0;
+        for (size_t side = 0; side < sides.size(); ++side) {
+            crow::json::wvalue::list volRows, convergedRows;
+            for (size_t e = 0; e < expiries.size(); ++e) {
+                crow::json::wvalue::list volRow, convergedRow;
+                for (size_t k = 0; k < strikes.size(); ++k) {
+                    const ImpliedVolResult& iv = vols[side * points + e * strikes.size() + k];
+                    //no quote, or a price outside the no-arbitrage bounds: null instead of NaN
+                    volRow.push_back(std::isnan(iv.vol) ? crow::json::wvalue(nullptr) : crow::json::wvalue(iv.vol));
+                    convergedRow.push_back(iv.converged);
+                    convergedCount += iv.converged;
+                }
+                volRows.push_back(std::move(volRow));
+                convergedRows.push_back(std::move(convergedRow));
+            }
+            out[sides[side]]["impliedVol"] = std::move(volRows);
+            out[sides[side]]["converged"]  = std::move(convergedRows);
+        }
+
+        //solveTimeMs is the inversion only, totalTimeMs also covers JSON parsing and building the response
+        const double solveMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        out["strikes"]     = strikes;
+        out["expiries"]    = expiries;
+        out["count"]       = static_cast<uint64_t>(n);
+        out["converged"]   = static_cast<uint64_t>(convergedCount);
+        out["solveTimeMs"] = solveMs;
+        out["perQuoteUs"]  = n ? solveMs * 1000.0 / n : 0.0;
+        out["simd"]        = simdLevelName(detectSimdLevel());
+        out["threads"]     = ThreadPool::shared().size();
+        out["totalTimeMs"] = std::chrono::duration<double, std::milli>(
+                                 std::chrono::high_resolution_clock::now() - start).count();
+        return jsonResponse(200, out);
+    });
+    //fits "model" ("heston" or "sabr") to a list of implied vol quotes, reports the parameters, the
+    //per-quote vol residuals (input order, null where the model price has no implied vol), iterations
+    //and wall time. An "initial" parameter object overrides the warm start
+    CROW_ROUTE(app, "/calibrate").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!hasNumbers(body, {"spotPrice", "riskFreeRate"})) {
+            return errorResponse(400, "calibration needs spotPrice and riskFreeRate");
+        }
+        const double S = body["spotPrice"].d();
+        const double r = body["riskFreeRate"].d();
+        const std::string model = body.has("model") ? std::string(body["model"].s()) : "heston";
+        if (model != "heston" && model != "sabr") {
+            return errorResponse(400, "model must be \"heston\" or \"sabr\"");
+        }
+        std::vector<VolQuote> quotes;
+        const std::string parseError = parseVolQuotes(body, quotes);
+        if (!parseError.empty()) {
+            return errorResponse(400, parseError);
+        }
+        CalibrationOptions options;
+        if (body.has("maxIterations")) {
+            if (body["maxIterations"].t() != crow::json::type::Number || body["maxIterations"].i() < 1
+                || body["maxIterations"].i() > kMaxCalibrationIterations) {
+                return errorResponse(400, "maxIterations must be between 1 and " + std::to_string(kMaxCalibrationIterations));
+            }
+            options.maxIterations = static_cast<unsigned>(body["maxIterations"].i());
+        }
+        //past the budget the fit stops at its best point so far, reported as "stop": "time_budget"
+        options.timeBudgetMs = kCalibrationBudgetMs;
+        if (body.has("timeBudgetMs")) {
+            if (!hasNumbers(body, {"timeBudgetMs"}) || !(body["timeBudgetMs"].d() > 0.0)
+                || body["timeBudgetMs"].d() > kCalibrationBudgetMs) {
+                return errorResponse(400, "timeBudgetMs must be positive and at most "
+                                          + std::to_string(static_cast<int>(kCalibrationBudgetMs)));
+            }
+            options.timeBudgetMs = body["timeBudgetMs"].d();
+        }
+        const std::string underlying = body.has("underlying") ? std::string(body["underlying"].s()) : "";
+        const bool useWarmStart = !underlying.empty() && (!body.has("warmStart") || body["warmStart"].b());
+
+        crow::json::wvalue out;
+        CalibrationReport report;
+        bool warmStarted = false;
+        try {
+            if (model == "heston") {
+                HestonParams initial = hestonInitialGuess(quotes);
+                if (body.has("initial")) {
+                    const std::string initialError = parseHestonParams(body["initial"], initial);
+                    if (!initialError.empty()) return errorResponse(400, "initial: " + initialError);
+                } else if (useWarmStart) {
+                    std::lock_guard<std::mutex> lock(calibrationStore.mutex);
+                    auto it = calibrationStore.heston.find(underlying);
+                    if (it != calibrationStore.heston.end()) {
+                        initial = it->second;
+                        warmStarted = true;
+                    }
+                }
+                const HestonCalibration fit = calibrateHeston(S, r, quotes, initial, options);
+                if (!underlying.empty()) {
+                    std::lock_guard<std::mutex> lock(calibrationStore.mutex);
+                    calibrationStore.heston[underlying] = fit.params;
+                }
+                out["params"]["v0"]       = fit.params.v0;
+                out["params"]["kappa"]    = fit.params.kappa;
+                out["params"]["theta"]    = fit.params.theta;
+                out["params"]["volOfVol"] = fit.params.xi;
+                out["params"]["rho"]      = fit.params.rho;
+                report = fit.report;
+            } else {
+                if (body.has("beta") && body["beta"].t() != crow::json::type::Number) {
+                    return errorResponse(400, "beta must be a number");
+                }
+                const double beta = body.has("beta") ? body["beta"].d() : 0.5;
+                std::vector<SabrSlice> initial;
+                if (useWarmStart && !body.has("initial")) {
+                    std::lock_guard<std::mutex> lock(calibrationStore.mutex);
+                    auto it = calibrationStore.sabr.find(underlying);
+                    //a different beta changes what alpha means, start cold
+                    if (it != calibrationStore.sabr.end() && !it->second.empty() && it->second[0].params.beta == beta) {
+                        initial = it->second;
+                        warmStarted = true;
+                    }
+                } else if (body.has("initial")) {
+                    if (!hasNumbers(body["initial"], {"alpha", "rho", "nu"})) {
+                        return errorResponse(400, "initial: alpha, rho and nu are required numbers");
+                    }
+                    initial.push_back({0.0, {body["initial"]["alpha"].d(), beta, body["initial"]["rho"].d(),
+                                             body["initial"]["nu"].d()}});
+                }
+                const SabrCalibration fit = calibrateSabr(S, r, quotes, beta, initial, options);
+                if (!underlying.empty()) {
+                    std::lock_guard<std::mutex> lock(calibrationStore.mutex);
+                    calibrationStore.sabr[underlying] = fit.slices;
+                }
+                for (size_t e = 0; e < fit.slices.size(); ++e) {
+                    out["params"][e]["expiry"] = fit.slices[e].expiry;
+                    out["params"][e]["alpha"]  = fit.slices[e].params.alpha;
+                    out["params"][e]["beta"]   = fit.slices[e].params.beta;
+                    out["params"][e]["rho"]    = fit.slices[e].params.rho;
+                    out["params"][e]["nu"]     = fit.slices[e].params.nu;
+                }
+                report = fit.report;
+            }
+        } catch (const std::invalid_argument& e) {
+            return errorResponse(400, e.what());
+        }
+
+        crow::json::wvalue::list residuals;
+        for (double e : report.volErrors) {
+            residuals.push_back(std::isnan(e) ? crow::json::wvalue(nullptr) : crow::json::wvalue(e));
+        }
+        out["model"]        = model;
+        out["residuals"]    = std::move(residuals);
+        out["rmsVolError"]  = report.rmsError;
+        out["maxVolError"]  = report.maxError;
+        out["iterations"]   = report.iterations;
+        out["evaluations"]  = report.evaluations;
+        out["stop"]         = calibrationStopName(report.stop);
+        out["warmStarted"]  = warmStarted;
+        out["quotes"]       = static_cast<uint64_t>(quotes.size());
+        out["threads"]      = ThreadPool::shared().size();
+        //calibrationTimeMs is the fit only, totalTimeMs also covers JSON parsing and building the response
+        out["calibrationTimeMs"] = report.elapsedMs;
+        out["totalTimeMs"]  = std::chrono::duration<double, std::milli>(
+                                  std::chrono::high_resolution_clock::now() - start).count();
+        return jsonResponse(200, out);
+    });
+
+    //publishes (or replaces) an underlying's vol surface
+    CROW_ROUTE(app, "/volsurface").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!body.has("underlying") || body["underlying"].t() != crow::json::type::String) {
+            return errorResponse(400, "underlying must be a string");
+        }
+        if (!body.has("strikes") || !body.has("expiries") || body["strikes"].t() != crow::json::type::List
+            || body["expiries"].t() != crow::json::type::List) {
+            return errorResponse(400, "strikes and expiries must be lists");
+        }
+        if (body["strikes"].size() * body["expiries"].size() > kMaxSurfaceNodes) {
+            return errorResponse(400, "at most " + std::to_string(kMaxSurfaceNodes) + " surface nodes");
+        }
+        std::vector<double> strikes, expiries, vols;
+        for (const auto& K : body["strikes"]) {
+            if (K.t() != crow::json::type::Number) return errorResponse(400, "strikes must be numbers");
+            strikes.push_back(K.d());
+        }
+        for (const auto& T : body["expiries"]) {
+            if (T.t() != crow::json::type::Number) return errorResponse(400, "expiries must be numbers");
+            expiries.push_back(T.d());
+        }
+        if (!body.has("vols")) {
+            return errorResponse(400, "vols is required");
+        }
+        const std::string gridError = parseQuoteGrid(body["vols"], "vols", expiries.size(), strikes.size(), vols);
+        if (!gridError.empty()) {
+            return errorResponse(400, gridError);
+        }
+        VolInterpolation interpolation = VolInterpolation::BICUBIC;
+        if (body.has("interpolation")) {
+            const std::string name = body["interpolation"].s();
+            if (name == "bilinear")     interpolation = VolInterpolation::BILINEAR;
+            else if (name != "bicubic") return errorResponse(400, "interpolation must be \"bicubic\" or \"bilinear\"");
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        const std::string underlying = body["underlying"].s();
+        try {
+            volSurfaces.publish(underlying, std::make_shared<const VolSurface>(strikes, expiries, vols, interpolation));
+        } catch (const std::invalid_argument& e) {
+            return errorResponse(400, e.what());
+        } catch (const std::length_error&) {
+            return errorResponse(400, "at most " + std::to_string(kMaxVolSurfaces) + " underlyings can have a vol surface");
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue out;
+        out["underlying"]    = underlying;
+        out["strikes"]       = static_cast<uint64_t>(strikes.size());
+        out["expiries"]      = static_cast<uint64_t>(expiries.size());
+        out["interpolation"] = volInterpolationName(interpolation);
+        out["publishTimeMs"] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        return jsonResponse(200, out);
+    });
+
+    //moves nodes of a published surface: [{"strike", "expiry", "vol"}, ...], each on the grid
+    CROW_ROUTE(app, "/volsurface/update").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!body.has("underlying") || body["underlying"].t() != crow::json::type::String) {
+            return errorResponse(400, "underlying must be a string");
+        }
+        if (!body.has("points") || body["points"].t() != crow::json::type::List) {
+            return errorResponse(400, "points must be a list");
+        }
+        for (const auto& point : body["points"]) {
+            if (!hasNumbers(point, {"strike", "expiry", "vol"})) {
+                return errorResponse(400, "each point needs strike, expiry and vol");
+            }
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        const std::string underlying = body["underlying"].s();
+        //index of a grid value, the request repeats the published numbers
+        auto node = [](const std::vector<double>& grid, double value, const char* name) {
+            const auto it = std::find_if(grid.begin(), grid.end(), [&](double g) {
+                return std::abs(g - value) <= 1e-9 * std::abs(g);
+            });
+            if (it == grid.end()) {
+                throw std::invalid_argument(std::string(name) + " " + std::to_string(value) + " is not on the surface grid");
+            }
+            return static_cast<size_t>(it - grid.begin());
+        };
+        try {
+            volSurfaces.update(underlying, [&](const SnapshotRegistry<VolSurface>::Snapshot& current) {
+                if (!current) {
+                    throw std::invalid_argument("no vol surface published for " + underlying);
+                }
+                auto next = std::make_shared<VolSurface>(*current);
+                for (const auto& point : body["points"]) {
+                    next->setVol(node(next->expiries(), point["expiry"].d(), "expiry"),
+                                 node(next->strikes(), point["strike"].d(), "strike"), point["vol"].d());
+                }
+                return SnapshotRegistry<VolSurface>::Snapshot(std::move(next));
+            });
+        } catch (const std::invalid_argument& e) {
+            return errorResponse(400, e.what());
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue out;
+        out["underlying"]    = underlying;
+        out["updated"]       = static_cast<uint64_t>(body["points"].size());
+        out["publishTimeMs"] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        return jsonResponse(200, out);
+    });
+
+    //publishes (or replaces) a rate or dividend curve: bootstrapped from "instruments"
+    //[{"type": "zero" | "deposit" | "swap", "maturity", "rate", "frequency" (swaps, default 2)}, ...],
+    //or implied by "forwards" [{"expiry", "forward"}, ...] with "spotPrice" and a published "discountCurve"
+    CROW_ROUTE(app, "/curve").methods(crow::HTTPMethod::Post)
+    ([&](const crow::request& req) {
+        auto body = crow::json::load(req.body);
+        if (!body) {
+            return errorResponse(400, "Invalid JSON");
+        }
+        if (!body.has("name") || body["name"].t() != crow::json::type::String) {
+            return errorResponse(400, "name must be a string");
+        }
+        CurveInterpolation interpolation = CurveInterpolation::MONOTONE_CONVEX;
+        if (body.has("interpolation")) {
+            const std::string name = body["interpolation"].s();
+            if (name == "log_linear")           interpolation = CurveInterpolation::LOG_LINEAR;
+            else if (name != "monotone_convex") return errorResponse(400, "interpolation must be \"monotone_convex\" or \"log_linear\"");
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<const YieldCurve> curve;
+        try {
+            if (body.has("instruments")) {
+                if (body["instruments"].t() != crow::json::type::List) {
+                    return errorResponse(400, "instruments must be a list");
+                }
+                if (body["instruments"].size() > kMaxCurveInstruments) {
+                    return errorResponse(400, "at most " + std::to_string(kMaxCurveInstruments) + " instruments");
+                }
+                std::vector<CurveQuote> quotes;
+                for (const auto& q : body["instruments"]) {
+                    if (!hasNumbers(q, {"maturity", "rate"})) {
+                        return errorResponse(400, "each instrument needs maturity and rate");
+                    }
+                    CurveQuote quote{q["maturity"].d(), q["rate"].d()};
+                    if (!(quote.maturity > 0.0 && quote.maturity <= kMaxCurveMaturity)) {
+                        return errorResponse(400, "maturity must be positive and at most "
+                                                  + std::to_string(static_cast<int>(kMaxCurveMaturity)) + " years");
+                    }
+                    const std::string type = q.has("type") ? std::string(q["type"].s()) : "zero";
+                    if (type == "deposit")   quote.instrument = CurveInstrument::DEPOSIT;
+                    else if (type == "swap") quote.instrument = CurveInstrument::SWAP;
+                    else if (type != "zero") return errorResponse(400, "instrument type must be \"zero\", \"deposit\" or \"swap\"");
+                    quote.frequency = 2;
+                    if (q.has("frequency")) {
+                        if (!hasNumbers(q, {"frequency"}) || q["frequency"].i() < 1 || q["frequency"].i() > 12) {
+                            return errorResponse(400, "frequency must be 1 to 12 payments a year");
+                        }
+                        quote.frequency = static_cast<unsigned>(q["frequency"].i());
+                    }
+                    quotes.push_back(quote);
+                }
+                curve = std::make_shared<const YieldCurve>(YieldCurve::bootstrap(std::move(quotes), interpolation));
+            } else if (body.has("forwards")) {
+                if (!hasNumbers(body, {"spotPrice"}) || !body.has("discountCurve")) {
+                    return errorResponse(400, "forwards need spotPrice and discountCurve");
+                }
+                if (body["forwards"].t() != crow::json::type::List) {
+                    return errorResponse(400, "forwards must be a list");
+                }
+                if (body["forwards"].size() > kMaxCurveInstruments) {
+                    return errorResponse(400, "at most " + std::to_string(kMaxCurveInstruments) + " forwards");
+                }
+                std::string curveError;
+                const auto rates = findCurve(body, "discountCurve", curves, curveError);
+                if (!rates) {
+                    return errorResponse(400, curveError);
+                }
+                std::vector<double> expiries, forwards;
+                for (const auto& f : body["forwards"]) {
+                    if (!hasNumbers(f, {"expiry", "forward"})) {
+                        return errorResponse(400, "each forward needs expiry and forward");
+                    }
+                    expiries.push_back(f["expiry"].d());
+                    forwards.push_back(f["forward"].d());
+                }
+                curve = std::make_shared<const YieldCurve>(
+                    impliedDividendCurve(body["spotPrice"].d(), *rates, expiries, forwards, interpolation));
+            } else {
+                return errorResponse(400, "expected instruments or forwards");
+            }
+        } catch (const std::invalid_argument& e) {
+            return errorResponse(400, e.what());
+        }
+        const std::string name = body["name"].s();
+        try {
+            curves.publish(name, curve);
+        } catch (const std::length_error&) {
+            return errorResponse(400, "at most " + std::to_string(kMaxCurves) + " curves can be published");
+        }
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        crow::json::wvalue::list knots;
+        for (double T : curve->maturities()) {
+            crow::json::wvalue knot;
+            knot["maturity"] = T;
+            knot["zeroRate"] = curve->zeroRate(T);
+            knots.push_back(std::move(knot));
+        }
+        crow::json::wvalue out;
+        out["name"]          = name;
+        out["interpolation"] = curveInterpolationName(interpolation);
+        out["knots"]         = std::move(knots);
+        out["publishTimeMs"] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        return jsonResponse(200, out);
+    });
+
     app.port(8080).multithreaded().run(); //start server
 }
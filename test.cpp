@@ -1,8 +1,27 @@
 // Example usage and testing
+//g++ -std=c++20 test.cpp OptionPricer.cpp ImpliedVol.cpp BatchPricer.cpp MonteCarlo.cpp LongstaffSchwartz.cpp Lattice.cpp FiniteDifference.cpp Heston.cpp Sabr.cpp Svi.cpp VolSurface.cpp YieldCurve.cpp Calibration.cpp ThreadPool.cpp Random.cpp QuasiRandom.cpp -O2 -pthread -o test.exe
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <random>
+#include <cfloat>
+#include <thread>
 #include "OptionPricer.h"
+#include "BatchPricer.h"
+#include "MonteCarlo.h"
+#include "LongstaffSchwartz.h"
+#include "Lattice.h"
+#include "FiniteDifference.h"
+#include "Heston.h"
+#include "Calibration.h"
+#include "VolSource.h"
+#include "VolSurface.h"
+#include "SnapshotRegistry.h"
+#include "YieldCurve.h"
+#include "Random.h"
+#include "ResultCache.h"
+#include "ImpliedVol.h"
+#include "QuasiRandom.h"
 
 
 
@@ -15,6 +34,1186 @@ void printGreeks(const Greeks& g) {
     std::cout << "Rho:   " << g.rho << " (per 1%)\n";
 }
 
+// SIMD batch kernel vs the scalar OptionPricer path on random contracts
+// returns false if any instruction set disagrees by more than the tolerance
+bool checkBatchAccuracy() {
+    const size_t n = 100003;  // odd size so the padded tail is exercised
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    std::vector<double> S(n), K(n), T(n), r(n), sigma(n), expected(n), out(n);
+    std::vector<OptionType> type(n);
+    for (size_t i = 0; i < n; ++i) {
+        S[i] = 50.0 + 100.0 * u(gen);
+        K[i] = 50.0 + 100.0 * u(gen);
+        T[i] = 0.01 + 3.0 * u(gen);
+        r[i] = 0.10 * u(gen);
+        sigma[i] = 0.05 + 0.8 * u(gen);
+        type[i] = u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT;
+        expected[i] = OptionPricer(S[i], K[i], T[i], r[i], sigma[i]).blackScholes(type[i]);
+    }
+
+    const double tolerance = 1e-10;
+    bool ok = true;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        blackScholesBatch(S.data(), K.data(), T.data(), r.data(), sigma.data(), type.data(),
+                          out.data(), n, level);
+        double max_err = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            max_err = std::max(max_err, std::abs(out[i] - expected[i]));
+        }
+        bool pass = max_err < tolerance;
+        ok = ok && pass;
+        std::cout << std::setw(7) << simdLevelName(level) << ": max abs error "
+                  << std::scientific << max_err << std::fixed << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    return ok;
+}
+
+// one normal CDF policy against a long double erfc reference on a fine grid over [-38, 8.5]
+// relative error is taken on the lower tail (x < 0, N(x) not subnormal), where the policies differ most
+// the vector kernels (normalCdfBatch) must match the scalar one to 1e-15 at every SIMD level
+template <class Cdf>
+bool checkNormalCdf(double abs_tolerance, double rel_tolerance) {
+    std::vector<double> x;
+    for (double v = -38.0; v <= 8.5; v += 0.00071) x.push_back(v);
+    std::vector<double> out(x.size());
+
+    double max_abs = 0.0, max_rel = 0.0;
+    for (double v : x) {
+        const long double exact = 0.5L * std::erfc(-(long double)v / std::sqrt(2.0L));
+        const double err = std::abs((double)(Cdf::cdf(v) - exact));
+        max_abs = std::max(max_abs, err);
+        if (v < 0.0 && exact >= DBL_MIN) max_rel = std::max(max_rel, (double)(err / exact));
+    }
+    double max_simd = 0.0;
+    for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        normalCdfBatch<Cdf>(x.data(), out.data(), x.size(), level);
+        for (size_t i = 0; i < x.size(); ++i) max_simd = std::max(max_simd, std::abs(out[i] - Cdf::cdf(x[i])));
+    }
+    const bool pass = max_abs < abs_tolerance && max_rel < rel_tolerance && max_simd < 1e-15;
+    std::cout << std::left << std::setw(32) << Cdf::name << std::right << std::scientific
+              << std::setprecision(2) << " max abs " << max_abs << ", max rel (x < 0) " << max_rel
+              << ", SIMD vs scalar " << max_simd << std::fixed << std::setprecision(6)
+              << (pass ? "  PASS" : "  FAIL") << "\n";
+    return pass;
+}
+
+// parallel Monte Carlo must give bit-identical prices for a seed whatever the thread count
+bool checkMonteCarloDeterminism(const OptionPricer& pricer, double bs_price) {
+    // Philox4x32-10 known-answer test (counter = 0, key = 0) from the Random123 distribution
+    Philox4x32::Block kat = Philox4x32::generate({0, 0, 0, 0}, {0, 0});
+    bool ok = kat == Philox4x32::Block{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+    std::cout << "Philox known answer: " << (ok ? "PASS" : "FAIL") << "\n";
+
+    const long sims = 1000000;
+    const std::uint64_t seed = 12345;
+    MonteCarloResult reference = monteCarloParallel(pricer, OptionType::CALL, sims, seed, VarianceReduction::ANTITHETIC, 1);
+    for (unsigned threads : {1u, 2u, 4u, 0u}) {
+        auto start = std::chrono::high_resolution_clock::now();
+        MonteCarloResult res = monteCarloParallel(pricer, OptionType::CALL, sims, seed, VarianceReduction::ANTITHETIC, threads);
+        auto end = std::chrono::high_resolution_clock::now();
+        bool same = res.price == reference.price && res.stdError == reference.stdError;
+        ok = ok && same;
+        std::cout << "Threads " << (threads ? std::to_string(threads) : std::string("all")) << ": $"
+                  << std::setprecision(10) << res.price << std::setprecision(6)
+                  << " +/- " << res.stdError << "  "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms"
+                  << (same ? "  identical" : "  MISMATCH") << "\n";
+    }
+    std::cout << "Error vs Black-Scholes: $" << std::abs(reference.price - bs_price)
+              << " (" << std::abs(reference.price - bs_price) / reference.stdError << " std errors)\n";
+    return ok;
+}
+
+// every estimator lands within 4 standard errors of black-scholes, and the regression control variate
+// (alone or with antithetic pairs) actually shrinks the variance
+bool checkVarianceReduction(const OptionPricer& pricer, double bs_price) {
+    bool ok = true;
+    const std::pair<VarianceReduction, const char*> modes[] = {
+        {VarianceReduction::NONE, "none"}, {VarianceReduction::ANTITHETIC, "antithetic"},
+        {VarianceReduction::CONTROL_VARIATE, "control variate"}, {VarianceReduction::BOTH, "both"}};
+    for (const auto& [mode, name] : modes) {
+        MonteCarloResult res = monteCarloParallel(pricer, OptionType::CALL, 100000, 7, mode);
+        const bool control = mode == VarianceReduction::CONTROL_VARIATE || mode == VarianceReduction::BOTH;
+        const bool pass = std::abs(res.price - bs_price) < 4.0 * res.stdError && (!control || res.varianceReductionFactor > 1.0);
+        ok = ok && pass;
+        std::cout << std::left << std::setw(16) << name << std::right << ": $" << res.price
+                  << " +/- " << res.stdError << "  variance reduction x" << std::setprecision(2)
+                  << res.varianceReductionFactor << std::setprecision(6) << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    return ok;
+}
+
+// adaptive stopping: a reachable target stops on it, below the cap and repeatably for a seed; an
+// unreachable one stops on maxSims; a time budget stops on the budget (or the cap on a fast machine)
+bool checkAdaptiveMonteCarlo(const OptionPricer& pricer) {
+    AdaptiveOptions adaptive;
+    adaptive.targetStdError = 0.005;
+    AdaptiveMonteCarloResult run = monteCarloAdaptive(pricer, OptionType::CALL, adaptive, 7, VarianceReduction::BOTH);
+    const AdaptiveMonteCarloResult again = monteCarloAdaptive(pricer, OptionType::CALL, adaptive, 7, VarianceReduction::BOTH);
+    const bool target_ok = run.stop == AdaptiveStop::TARGET_REACHED && run.result.stdError <= adaptive.targetStdError
+                        && run.result.paths <= adaptive.maxSims && again.result.paths == run.result.paths
+                        && again.result.price == run.result.price && again.result.stdError == run.result.stdError;
+    std::cout << "Paths: " << run.result.paths << ", price $" << run.result.price << " +/- " << run.result.stdError
+              << ", 95% CI [" << run.result.ciLow << ", " << run.result.ciHigh << "], "
+              << run.elapsedMs << " ms, " << (again.result.price == run.result.price ? "repeatable" : "NOT repeatable")
+              << (target_ok ? "  PASS" : "  FAIL") << "\n";
+
+    adaptive.targetStdError = 1e-6;
+    adaptive.maxSims = 50000;
+    run = monteCarloAdaptive(pricer, OptionType::CALL, adaptive, 7);
+    const bool cap_ok = run.stop == AdaptiveStop::MAX_PATHS && run.result.paths <= adaptive.maxSims;
+    std::cout << "unreachable target, cap " << adaptive.maxSims << ": " << run.result.paths << " paths"
+              << (cap_ok ? "  PASS" : "  FAIL") << "\n";
+
+    adaptive = AdaptiveOptions{};
+    adaptive.timeBudgetMs = 5.0;
+    run = monteCarloAdaptive(pricer, OptionType::CALL, adaptive, 7);
+    const bool budget_ok = run.stop != AdaptiveStop::TARGET_REACHED && run.result.paths <= adaptive.maxSims;
+    std::cout << "5 ms budget: " << run.result.paths << " paths, +/- " << run.result.stdError << ", "
+              << run.elapsedMs << " ms" << (run.stop == AdaptiveStop::TIME_BUDGET ? " (budget reached)" : " (cap reached)")
+              << (budget_ok ? "  PASS" : "  FAIL") << "\n";
+    return target_ok && cap_ok && budget_ok;
+}
+
+// payoff policies through the templated Monte Carlo kernel: cash-or-nothing digitals against
+// cash e^(-rT) N(+-d2), and a digital call plus put on the same seed must add up to the discounted cash
+bool checkDigitalMonteCarlo(const OptionPricer& pricer) {
+    const double S = pricer.getSpot(), K = 105.0, T = pricer.getTimeToMaturity();
+    const double r = pricer.getRiskFreeRate(), sigma = pricer.getVolatility(), cash = 10.0;
+    const double d2 = (std::log(S / K) + (r - 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
+    const double discount = std::exp(-r * T);
+    bool ok = true;
+    for (VarianceReduction vr : {VarianceReduction::NONE, VarianceReduction::BOTH}) {
+        MonteCarloResult call = monteCarloParallel(pricer, DigitalCallPayoff{K, cash}, 400000, 3, vr);
+        MonteCarloResult put = monteCarloParallel(pricer, DigitalPutPayoff{K, cash}, 400000, 3, vr);
+        const double call_z = std::abs(call.price - cash * discount * OptionPricer::normalCDF(d2)) / call.stdError;
+        const double put_z = std::abs(put.price - cash * discount * OptionPricer::normalCDF(-d2)) / put.stdError;
+        const double parity = std::abs(call.price + put.price - cash * discount);
+        const bool pass = call_z < 4.0 && put_z < 4.0 && parity < 1e-10;
+        ok = ok && pass;
+        std::cout << (vr == VarianceReduction::NONE ? "none" : "both") << ": digital call $" << call.price
+                  << " (" << std::setprecision(2) << call_z << " std errors), put $" << std::setprecision(6)
+                  << put.price << " (" << std::setprecision(2) << put_z << " std errors), parity error "
+                  << std::scientific << parity << std::fixed << std::setprecision(6)
+                  << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    return ok;
+}
+
+// path-dependent Monte Carlo against closed forms: the geometric Asian on the same dates, the
+// continuously monitored down-and-out call (Reiner & Rubinstein, checks the Brownian-bridge correction)
+// and the floating-strike lookback call (Goldman, Sosin & Gatto, checks the BGK shift)
+bool checkExoticMonteCarlo(const OptionPricer& pricer) {
+    const double S = pricer.getSpot(), K = pricer.getStrike(), T = pricer.getTimeToMaturity();
+    const double r = pricer.getRiskFreeRate(), sigma = pricer.getVolatility();
+    const double sqrtT = std::sqrt(T), discount = std::exp(-r * T);
+    auto report = [](const char* name, const MonteCarloResult& mc, double exact, double tol) {
+        const double err = std::abs(mc.price - exact);
+        const bool pass = err < tol;
+        std::cout << std::left << std::setw(28) << name << std::right << ": $" << mc.price << " +/- " << mc.stdError
+                  << " vs $" << exact << " (" << std::setprecision(2) << err / mc.stdError << " std errors)"
+                  << std::setprecision(6) << (pass ? "  PASS" : "  FAIL") << "\n";
+        return pass;
+    };
+    bool ok = true;
+
+    ExoticOption asian;
+    asian.steps = 12;
+    asian.average = AsianAverage::GEOMETRIC;
+    const double geometric = geometricAsianPrice(S, K, T, r, sigma, asian.steps, OptionType::CALL);
+    MonteCarloResult mc = monteCarloExotic(pricer, asian, 200000, 5);
+    ok = report("geometric asian, 12 dates", mc, geometric, 4.0 * mc.stdError) && ok;
+
+    //arithmetic >= geometric path by path; the geometric control removes almost all the variance
+    asian.average = AsianAverage::ARITHMETIC;
+    mc = monteCarloExotic(pricer, asian, 200000, 5, VarianceReduction::BOTH);
+    const bool asian_pass = mc.price > geometric && mc.varianceReductionFactor > 50.0;
+    ok = ok && asian_pass;
+    std::cout << "arithmetic asian, 12 dates  : $" << mc.price << " +/- " << mc.stdError << ", variance reduction x"
+              << std::setprecision(0) << mc.varianceReductionFactor << std::setprecision(6)
+              << (asian_pass ? "  PASS" : "  FAIL") << "\n";
+
+    //down-and-out call, B < K: C - C_di with C_di = S (B/S)^(2 lambda) N(y) - K e^(-rT) (B/S)^(2 lambda - 2) N(y - sigma sqrt T)
+    ExoticOption barrier;
+    barrier.kind = ExoticKind::BARRIER;
+    barrier.barrierType = BarrierType::DOWN_AND_OUT;
+    barrier.barrier = 90.0;
+    barrier.steps = 50;
+    const double B = barrier.barrier;
+    const double lambda = (r + 0.5 * sigma * sigma) / (sigma * sigma);
+    const double yb = std::log(B * B / (S * K)) / (sigma * sqrtT) + lambda * sigma * sqrtT;
+    const double down_in = S * std::pow(B / S, 2.0 * lambda) * OptionPricer::normalCDF(yb)
+                         - K * discount * std::pow(B / S, 2.0 * lambda - 2.0) * OptionPricer::normalCDF(yb - sigma * sqrtT);
+    const double vanilla = pricer.blackScholes(OptionType::CALL);
+    mc = monteCarloExotic(pricer, barrier, 200000, 5);
+    ok = report("down-and-out, bridge", mc, vanilla - down_in, 4.0 * mc.stdError) && ok;
+    barrier.continuousMonitoring = false;
+    MonteCarloResult discrete = monteCarloExotic(pricer, barrier, 200000, 5);
+    std::cout << "down-and-out, 50 dates only : $" << discrete.price << " (discrete monitoring knocks out less)\n";
+    ok = ok && discrete.price > mc.price;
+
+    //knock-in + knock-out is the vanilla payoff on every path
+    barrier.continuousMonitoring = true;
+    barrier.barrierType = BarrierType::UP_AND_OUT;
+    barrier.barrier = 120.0;
+    MonteCarloResult out = monteCarloExotic(pricer, barrier, 200000, 5);
+    barrier.barrierType = BarrierType::UP_AND_IN;
+    MonteCarloResult in = monteCarloExotic(pricer, barrier, 200000, 5);
+    MonteCarloResult sum = in;
+    sum.price += out.price;
+    sum.stdError += out.stdError;
+    ok = report("up-and-in + up-and-out", sum, vanilla, 4.0 * sum.stdError) && ok;
+
+    //floating-strike lookback call started at its minimum; BGK leaves an O(dt) bias, hence the extra 0.5%
+    ExoticOption lookback;
+    lookback.kind = ExoticKind::LOOKBACK;
+    const double a1 = (r + 0.5 * sigma * sigma) * sqrtT / sigma;
+    const double a2 = a1 - sigma * sqrtT, a3 = (-r + 0.5 * sigma * sigma) * sqrtT / sigma;
+    const double k = sigma * sigma / (2.0 * r);
+    const double floating = S * (OptionPricer::normalCDF(a1) - k * OptionPricer::normalCDF(-a1)
+                          - discount * (OptionPricer::normalCDF(a2) - k * OptionPricer::normalCDF(-a3)));
+    mc = monteCarloExotic(pricer, lookback, 100000, 5);
+    ok = report("floating lookback, 252 dates", mc, floating, 4.0 * mc.stdError + 0.005 * floating) && ok;
+    return ok;
+}
+
+// streaming: the path blocking (cache budget) must not change an exotic price, and the merged moments
+// must keep the variance of a payoff whose spread is 1e-10 of its mean (plain sums of squares lose it)
+bool checkStreamingMonteCarlo(const OptionPricer& pricer) {
+    ExoticOption asian;
+    asian.steps = 100;
+    const PathBlocking small = pathBlockingFor(16 * 1024, true), large = pathBlockingFor(8 << 20, true);
+    MonteCarloResult a = monteCarloExotic(pricer, asian, 50000, 9, VarianceReduction::BOTH, 0, 16 * 1024);
+    MonteCarloResult b = monteCarloExotic(pricer, asian, 50000, 9, VarianceReduction::BOTH, 0, 8 << 20);
+    const bool blocking_ok = a.price == b.price && a.stdError == b.stdError;
+    std::cout << "asian, " << small.paths << "x" << small.steps << " vs " << large.paths << "x" << large.steps
+              << " blocking: $" << std::setprecision(10) << a.price << " / $" << b.price << std::setprecision(6)
+              << (blocking_ok ? "  identical  PASS" : "  FAIL") << "\n";
+
+    //S_T - K with sigma = 1e-6: the payoff's standard deviation is S sigma sqrt(T) e^(rT) to first order
+    const double S = 1e4, sigma = 1e-6;
+    const long sims = 1000000;
+    OptionPricer tight(S, 1.0, 1.0, pricer.getRiskFreeRate(), sigma);
+    MonteCarloResult mc = monteCarloParallel(tight, OptionType::CALL, sims, 9, VarianceReduction::NONE);
+    const double expected = S * sigma / std::sqrt(double(sims));
+    const double ratio = mc.stdError / expected;
+    const bool moments_ok = std::abs(ratio - 1.0) < 0.01;
+    std::cout << "std error at sigma 1e-6, 1M paths: " << std::scientific << mc.stdError << " vs " << expected
+              << std::fixed << " (ratio " << ratio << ")" << (moments_ok ? "  PASS" : "  FAIL") << "\n";
+    return blocking_ok && moments_ok;
+}
+
+// the Brownian bridge is linear in its normals, W = A z, so feeding it the unit vectors gives A and the
+// exact covariance A A^T, which must be min(t_i, t_j) on the grid (a power of two and an uneven grid).
+// Scrambled Sobol prices, with and without the bridge, against Black-Scholes within 4 replicate std errors
+bool checkQuasiMonteCarlo(const OptionPricer& pricer, double bs_price) {
+    const double T = pricer.getTimeToMaturity();
+    bool ok = true;
+    for (size_t steps : {16u, 10u}) {
+        BrownianBridge bridge(steps, T);
+        std::vector<double> A(steps * steps), unit(steps, 0.0), W(steps);
+        for (size_t k = 0; k < steps; ++k) {
+            unit[k] = 1.0;
+            bridge.buildPath(unit.data(), W.data());
+            unit[k] = 0.0;
+            for (size_t i = 0; i < steps; ++i) A[i * steps + k] = W[i];
+        }
+        double worst = 0.0;
+        for (size_t i = 0; i < steps; ++i) {
+            for (size_t j = 0; j < steps; ++j) {
+                double cov = 0.0;
+                for (size_t k = 0; k < steps; ++k) cov += A[i * steps + k] * A[j * steps + k];
+                const double expected = T * static_cast<double>(std::min(i, j) + 1) / static_cast<double>(steps);
+                worst = std::max(worst, std::abs(cov - expected));
+            }
+        }
+        const bool pass = worst < 1e-12;
+        ok = ok && pass;
+        std::cout << "bridge, " << std::setw(2) << steps << " steps: max |Cov(W_i, W_j) - min(t_i, t_j)| "
+                  << std::scientific << worst << std::fixed << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    for (unsigned steps : {1u, 16u}) {
+        MonteCarloResult qmc = monteCarloQMC(pricer, OptionType::CALL, 16384, 7, steps);
+        const double z = std::abs(qmc.price - bs_price) / qmc.stdError;
+        const bool pass = z < 4.0;
+        ok = ok && pass;
+        std::cout << "QMC  16384 paths, " << std::setw(2) << steps << " steps: $" << qmc.price << " +/- "
+                  << qmc.stdError << "  error $" << std::abs(qmc.price - bs_price) << " (" << std::setprecision(2)
+                  << z << " std errors)" << std::setprecision(6) << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    //fewer paths than replicates leaves a replicate empty, which must be an error, not a zero price
+    bool rejected = false;
+    try {
+        monteCarloQMC(pricer, OptionType::CALL, kQmcReplicates - 1, 7);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    std::cout << "QMC  " << kQmcReplicates - 1 << " paths: " << (rejected ? "rejected  PASS" : "accepted  FAIL") << "\n";
+    return ok && rejected;
+}
+
+// Cox-Ross-Rubinstein tree with early exercise at every node, the reference for the American pricers
+double binomialAmerican(double S, double K, double T, double r, double sigma, OptionType type, int steps) {
+    const double dt = T / steps, u = std::exp(sigma * std::sqrt(dt)), d = 1.0 / u;
+    const double disc = std::exp(-r * dt), p = (std::exp(r * dt) - d) / (u - d);
+    auto exercise = [&](double s) { return std::max(type == OptionType::CALL ? s - K : K - s, 0.0); };
+    std::vector<double> v(steps + 1);
+    for (int i = 0; i <= steps; ++i) v[i] = exercise(S * std::pow(u, i) * std::pow(d, steps - i));
+    for (int n = steps - 1; n >= 0; --n) {
+        for (int i = 0; i <= n; ++i) {
+            v[i] = std::max(disc * (p * v[i + 1] + (1.0 - p) * v[i]), exercise(S * std::pow(u, i) * std::pow(d, n - i)));
+        }
+    }
+    return v[0];
+}
+
+// Longstaff-Schwartz against the binomial tree (the Longstaff & Schwartz paper's put, 50 exercise dates,
+// so the Bermudan may sit slightly under the American), a call that should never be exercised early,
+// and a strike ladder priced on one shared path set giving the same prices as separate runs
+bool checkLongstaffSchwartz() {
+    bool ok = true;
+    OptionPricer put_pricer(36.0, 40.0, 1.0, 0.06, 0.2);
+    const double tree = binomialAmerican(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, 2000);
+    MonteCarloResult put = monteCarloAmerican(put_pricer, OptionType::PUT, 200000, 3);
+    const double european_put = put_pricer.blackScholes(OptionType::PUT);
+    const bool put_ok = std::abs(put.price - tree) < 4.0 * put.stdError + 0.01 && put.price > european_put + 0.1;
+    ok = ok && put_ok;
+    std::cout << "american put (36/40, 50 dates): $" << put.price << " +/- " << put.stdError << " vs tree $" << tree
+              << ", european $" << european_put << (put_ok ? "  PASS" : "  FAIL") << "\n";
+
+    OptionPricer call_pricer(100.0, 100.0, 1.0, 0.05, 0.2);
+    MonteCarloResult call = monteCarloAmerican(call_pricer, OptionType::CALL, 100000, 3);
+    const double european_call = call_pricer.blackScholes(OptionType::CALL);
+    const bool call_ok = std::abs(call.price - european_call) < 4.0 * call.stdError + 0.01;
+    ok = ok && call_ok;
+    std::cout << "american call, no dividends:    $" << call.price << " +/- " << call.stdError << " vs european $"
+              << european_call << (call_ok ? "  PASS" : "  FAIL") << "\n";
+
+    AmericanPathSet shared(put_pricer, 50000, 50, 4);
+    bool reuse_ok = true;
+    for (double K : {32.0, 40.0, 48.0}) {
+        OptionPricer strike(36.0, K, 1.0, 0.06, 0.2);
+        const double ladder = priceAmerican(shared, K, OptionType::PUT).price;
+        const double alone = monteCarloAmerican(strike, OptionType::PUT, 50000, 4).price;
+        reuse_ok = reuse_ok && ladder == alone;
+    }
+    ok = ok && reuse_ok;
+    std::cout << "strike ladder on one path set (" << shared.bytes() / (1 << 20) << " MB): "
+              << (reuse_ok ? "identical to separate runs  PASS" : "FAIL") << "\n";
+    return ok;
+}
+
+// implied vol round trip: price random contracts at a known vol and recover it
+// the lattice engine: the raw CRR tree is the textbook one, every model with Richardson extrapolation
+// lands on black-scholes (european) at 200 steps and the tree greeks match the analytic ones. American
+// prices at 200 steps do not reach the 2000 step tree: the exercise boundary leaves an O(1/N)
+// oscillation the extrapolation cannot remove, so they are held to the errors the trees actually have.
+// Bermudan trees match the american one with a date on every step and the european one with only T
+bool checkLattice() {
+    bool ok = true;
+    LatticeOptions raw;
+    raw.model = LatticeModel::CRR;
+    raw.steps = 500;
+    raw.smoothing = false;
+    raw.richardson = false;
+    const double lattice_crr = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, raw).price;
+    const double naive_crr = binomialAmerican(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, 500);
+    const bool raw_ok = std::abs(lattice_crr - naive_crr) < 1e-10;
+    ok = ok && raw_ok;
+    std::cout << "CRR 500 steps, no smoothing: $" << lattice_crr << " vs naive tree $" << naive_crr
+              << (raw_ok ? "  PASS" : "  FAIL") << "\n";
+
+    OptionPricer pricer(36.0, 40.0, 1.0, 0.06, 0.2);
+    const double european = pricer.blackScholes(OptionType::PUT);
+    const double american = binomialAmerican(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, 2000);
+    const Greeks greeks = pricer.calculateGreeks(OptionType::PUT);
+    for (LatticeModel model : {LatticeModel::CRR, LatticeModel::LEISEN_REIMER, LatticeModel::TRINOMIAL}) {
+        LatticeOptions options;
+        options.model = model;
+        options.exercise = ExerciseStyle::EUROPEAN;
+        const LatticeResult euro = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options);
+        options.richardson = false;
+        const double plain = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options).price;
+        options.richardson = true;
+        options.exercise = ExerciseStyle::AMERICAN;
+        const double amer = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options).price;
+
+        options.richardson = false;
+        const double amer_plain = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options).price;
+        options.richardson = true;
+
+        const bool euro_ok = std::abs(euro.price - european) < 5e-5;
+        const bool amer_ok = std::abs(amer - american) < 7e-4;
+        const bool greeks_ok = std::abs(euro.delta - greeks.delta) < 2e-3 && std::abs(euro.gamma - greeks.gamma) < 1e-3
+                            && std::abs(euro.theta - greeks.theta) < 5e-5;
+        ok = ok && euro_ok && amer_ok && greeks_ok;
+        std::cout << std::left << std::setw(14) << latticeModelName(model) << std::right << std::scientific
+                  << std::setprecision(1) << " european error " << std::abs(euro.price - european) << " (plain "
+                  << std::abs(plain - european) << "), american vs 2000 steps " << std::abs(amer - american)
+                  << " (plain " << std::abs(amer_plain - american) << ")" << std::fixed << std::setprecision(6) << ", greeks"
+                  << (euro_ok && amer_ok && greeks_ok ? "  PASS" : "  FAIL") << "\n";
+    }
+
+    //CRR keeps 200 steps (Leisen-Reimer would round up to 201 and miss a date)
+    LatticeOptions bermudan;
+    bermudan.model = LatticeModel::CRR;
+    bermudan.exercise = ExerciseStyle::BERMUDAN;
+    for (unsigned i = 1; i <= bermudan.steps; ++i) bermudan.exerciseTimes.push_back(double(i) / bermudan.steps);
+    const double every_step = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, bermudan).price;
+    LatticeOptions amer_options;
+    amer_options.model = LatticeModel::CRR;
+    const double amer = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, amer_options).price;
+    bermudan.exerciseTimes = {1.0};
+    const double at_expiry = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, bermudan).price;
+    LatticeOptions euro_options;
+    euro_options.model = LatticeModel::CRR;
+    euro_options.exercise = ExerciseStyle::EUROPEAN;
+    const double euro = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, euro_options).price;
+    bermudan.exerciseTimes = {0.25, 0.5, 0.75, 1.0};
+    const double quarterly = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, bermudan).price;
+    int rejected = 0;
+    for (const std::vector<double>& times : {std::vector<double>{}, std::vector<double>{0.5, 1.5}, std::vector<double>{0.0}}) {
+        bermudan.exerciseTimes = times;
+        try {
+            priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, bermudan);
+        } catch (const std::invalid_argument&) {
+            ++rejected;
+        }
+    }
+    const bool bermudan_ok = std::abs(every_step - amer) < 1e-12 && std::abs(at_expiry - euro) < 1e-12
+                          && euro < quarterly && quarterly < amer && rejected == 3;
+    ok = ok && bermudan_ok;
+    std::cout << "bermudan put: every step $" << every_step << " (american $" << amer << "), quarterly $" << quarterly
+              << ", at expiry $" << at_expiry << " (european $" << euro << "), " << rejected << "/3 bad dates rejected"
+              << (bermudan_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+// Crank-Nicolson on the default 400 x 200 grid: european price and grid greeks against black-scholes,
+// the american put against the lattice with Brennan-Schwartz and PSOR agreeing, the down-and-out call
+// against Reiner-Rubinstein with in + out = vanilla, and a strike ladder from one solve
+bool checkPde() {
+    bool ok = true;
+    OptionPricer pricer(36.0, 40.0, 1.0, 0.06, 0.2);
+    const double european = pricer.blackScholes(OptionType::PUT);
+    const Greeks greeks = pricer.calculateGreeks(OptionType::PUT);
+    const PdeGrid euro = solvePde(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT);
+    const bool euro_ok = std::abs(euro.value(36.0) - european) < 2e-4 && std::abs(euro.delta(36.0) - greeks.delta) < 1e-4
+                      && std::abs(euro.gamma(36.0) - greeks.gamma) < 1e-4 && std::abs(euro.theta(36.0) - greeks.theta) < 1e-5;
+    ok = ok && euro_ok;
+    std::cout << "european put: $" << euro.value(36.0) << " vs $" << european << ", delta " << euro.delta(36.0)
+              << " vs " << greeks.delta << ", gamma " << euro.gamma(36.0) << " vs " << greeks.gamma
+              << (euro_ok ? "  PASS" : "  FAIL") << "\n";
+
+    LatticeOptions fine;
+    fine.steps = 5001;
+    const double lattice = priceLattice(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, fine).price;
+    PdeOptions options;
+    options.exercise = ExerciseStyle::AMERICAN;
+    const double brennan = solvePde(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options).value(36.0);
+    options.earlyExercise = EarlyExercise::PSOR;
+    const PdeGrid psor = solvePde(36.0, 40.0, 1.0, 0.06, 0.2, OptionType::PUT, options);
+    const bool amer_ok = std::abs(brennan - lattice) < 1e-3 && std::abs(psor.value(36.0) - brennan) < 1e-6;
+    ok = ok && amer_ok;
+    std::cout << "american put: $" << brennan << " (Brennan-Schwartz), $" << psor.value(36.0) << " (PSOR, "
+              << psor.psorIterations() << " sweeps) vs lattice $" << lattice << (amer_ok ? "  PASS" : "  FAIL") << "\n";
+
+    const double S = 100.0, K = 100.0, B = 90.0, r = 0.05, sigma = 0.2;
+    const double lambda = (r + 0.5 * sigma * sigma) / (sigma * sigma);
+    const double yb = std::log(B * B / (S * K)) / sigma + lambda * sigma;
+    const double down_in = S * std::pow(B / S, 2.0 * lambda) * OptionPricer::normalCDF(yb)
+                         - K * std::exp(-r) * std::pow(B / S, 2.0 * lambda - 2.0) * OptionPricer::normalCDF(yb - sigma);
+    const double vanilla = OptionPricer(S, K, 1.0, r, sigma).blackScholes(OptionType::CALL);
+    PdeOptions barrier;
+    barrier.hasBarrier = true;
+    barrier.barrier = B;
+    barrier.barrierType = BarrierType::DOWN_AND_OUT;
+    const double out = solvePde(S, K, 1.0, r, sigma, OptionType::CALL, barrier).value(S);
+    barrier.barrierType = BarrierType::DOWN_AND_IN;
+    const double in = solvePde(S, K, 1.0, r, sigma, OptionType::CALL, barrier).value(S);
+    const bool barrier_ok = std::abs(out - (vanilla - down_in)) < 1e-3 && std::abs(in + out - vanilla) < 1e-6;
+    ok = ok && barrier_ok;
+    std::cout << "down-and-out call: $" << out << " vs $" << vanilla - down_in << ", in + out - vanilla "
+              << std::scientific << std::setprecision(1) << in + out - vanilla << std::fixed << std::setprecision(6)
+              << (barrier_ok ? "  PASS" : "  FAIL") << "\n";
+
+    const std::vector<double> strikes = {32.0, 36.0, 40.0, 44.0};
+    PdeOptions ladder_options;
+    ladder_options.exercise = ExerciseStyle::AMERICAN;
+    ladder_options.spotNodes = 800;
+    const std::vector<double> ladder = pdeStrikeLadder(36.0, strikes, 1.0, 0.06, 0.2, OptionType::PUT, ladder_options);
+    double max_err = 0.0;
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        const double tree = priceLattice(36.0, strikes[i], 1.0, 0.06, 0.2, OptionType::PUT, fine).price;
+        max_err = std::max(max_err, std::abs(ladder[i] - tree));
+    }
+    const bool ladder_ok = max_err < 1e-3;
+    ok = ok && ladder_ok;
+    std::cout << "american strike ladder, one solve: max error vs lattice " << std::scientific << std::setprecision(1)
+              << max_err << std::fixed << std::setprecision(6) << (ladder_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkHeston() {
+    bool ok = true;
+    //Fang & Oosterlee (2008) test case, reference price from numerical integration
+    const HestonParams fo{0.0175, 1.5768, 0.0398, 0.5751, -0.5711};
+    const double reference = 5.785155450;
+    const double cos = hestonPrice(100.0, 100.0, 1.0, 0.0, fo, OptionType::CALL);
+    const bool ref_ok = std::abs(cos - reference) < 1e-6;
+    ok = ok && ref_ok;
+    std::cout << "COS call: $" << std::setprecision(9) << cos << " vs $" << reference << std::setprecision(6)
+              << (ref_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //a whole strike grid from one set of coefficients gives the single-strike prices, calls and puts in parity
+    const HestonParams skew{0.04, 1.5, 0.04, 0.5, -0.7};
+    const HestonCos grid(100.0, 0.5, 0.03, skew);
+    const std::vector<double> strikes = {40.0, 70.0, 90.0, 100.0, 110.0, 130.0, 200.0};
+    const std::vector<double> calls = grid.prices(strikes, OptionType::CALL);
+    const std::vector<double> puts = grid.prices(strikes, OptionType::PUT);
+    double grid_err = 0.0, parity_err = 0.0;
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        grid_err = std::max(grid_err, std::abs(calls[i] - hestonPrice(100.0, strikes[i], 0.5, 0.03, skew, OptionType::CALL)));
+        parity_err = std::max(parity_err, std::abs(calls[i] - puts[i] - (100.0 - strikes[i] * std::exp(-0.015))));
+    }
+    const bool grid_ok = grid_err < 1e-12 && parity_err < 1e-9;
+    ok = ok && grid_ok;
+    std::cout << "strike grid vs single strikes: max error " << std::scientific << std::setprecision(1) << grid_err
+              << ", parity " << parity_err << std::fixed << std::setprecision(6) << (grid_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //vanishing vol of variance with v0 = theta is black-scholes at sqrt(theta)
+    const HestonParams flat{0.04, 2.0, 0.04, 1e-3, 0.0};
+    const double bs = OptionPricer(100.0, 110.0, 0.5, 0.03, 0.2).blackScholes(OptionType::CALL);
+    const double flat_price = hestonPrice(100.0, 110.0, 0.5, 0.03, flat, OptionType::CALL);
+    const bool flat_ok = std::abs(flat_price - bs) < 1e-5;
+    ok = ok && flat_ok;
+    std::cout << "vol of vol 0.001: $" << flat_price << " vs black-scholes $" << bs << (flat_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //QE Monte Carlo agrees with the Fourier price
+    const MonteCarloResult mc = monteCarloHeston(100.0, 90.0, 0.5, 0.03, skew, OptionType::PUT, 100000, 7, 50,
+                                                 VarianceReduction::BOTH);
+    const double put = grid.price(90.0, OptionType::PUT);
+    const bool mc_ok = std::abs(mc.price - put) < 4.0 * mc.stdError;
+    ok = ok && mc_ok;
+    std::cout << "QE Monte Carlo put: $" << mc.price << " +/- " << mc.stdError << " vs COS $" << put
+              << (mc_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkCalibration() {
+    bool ok = true;
+    //AD gradients of the COS prices against central differences
+    const HestonParams truth{0.05, 1.8, 0.045, 0.6, -0.65};
+    const std::vector<double> strikes = {80.0, 100.0, 125.0};
+    std::vector<double> prices, gradient;
+    HestonCos(100.0, 0.7, 0.02, truth, kHestonCosTerms, kHestonCosTruncation, true)
+        .pricesAndGradients(strikes, OptionType::CALL, prices, gradient);
+    double grad_err = 0.0;
+    for (int a = 0; a < kHestonParamCount; ++a) {
+        HestonParams up = truth, down = truth;
+        const double h = 1e-5;
+        (&up.v0)[a] += h;
+        (&down.v0)[a] -= h;
+        const std::vector<double> pu = HestonCos(100.0, 0.7, 0.02, up).prices(strikes, OptionType::CALL);
+        const std::vector<double> pd = HestonCos(100.0, 0.7, 0.02, down).prices(strikes, OptionType::CALL);
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            grad_err = std::max(grad_err, std::abs(gradient[j * kHestonParamCount + a] - (pu[j] - pd[j]) / (2.0 * h)));
+        }
+    }
+    const bool grad_ok = grad_err < 1e-4;
+    ok = ok && grad_ok;
+    std::cout << "heston gradient vs central differences: max error " << std::scientific << std::setprecision(1)
+              << grad_err << std::fixed << std::setprecision(6) << (grad_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //recover the parameters behind a synthetic surface, then refit a shifted snapshot from them
+    std::vector<VolQuote> quotes;
+    for (double T : {0.1, 0.25, 0.5, 1.0, 2.0}) {
+        const HestonCos cos(100.0, T, 0.02, truth);
+        for (int i = -6; i <= 6; ++i) {
+            const double K = 100.0 * std::exp(0.05 * i * std::sqrt(T));
+            const double vol = solveImpliedVol(cos.price(K, OptionType::CALL), 100.0, K, T, 0.02, OptionType::CALL).vol;
+            quotes.push_back({K, T, vol});
+        }
+    }
+    const HestonCalibration cold = calibrateHeston(100.0, 0.02, quotes, hestonInitialGuess(quotes));
+    const HestonParams& p = cold.params;
+    const double param_err = std::max({std::abs(p.v0 - truth.v0), std::abs(p.kappa - truth.kappa), std::abs(p.theta - truth.theta),
+                                       std::abs(p.xi - truth.xi), std::abs(p.rho - truth.rho)});
+    const bool cold_ok = param_err < 1e-5 && cold.report.rmsError < 1e-8;
+    ok = ok && cold_ok;
+    std::cout << "heston fit of " << quotes.size() << " quotes: " << cold.report.iterations << " iterations, rms vol error "
+              << std::scientific << std::setprecision(1) << cold.report.rmsError << ", max parameter error " << param_err
+              << std::fixed << std::setprecision(6) << (cold_ok ? "  PASS" : "  FAIL") << "\n";
+
+    for (VolQuote& q : quotes) q.vol += 0.002;
+    const HestonCalibration warm = calibrateHeston(100.0, 0.02, quotes, cold.params);
+    const HestonCalibration rerun = calibrateHeston(100.0, 0.02, quotes, hestonInitialGuess(quotes));
+    const bool warm_ok = warm.report.iterations <= rerun.report.iterations && warm.report.rmsError < 1e-3;
+    ok = ok && warm_ok;
+    std::cout << "shifted snapshot: " << warm.report.iterations << " iterations warm, " << rerun.report.iterations
+              << " cold, rms vol error " << std::scientific << std::setprecision(1) << warm.report.rmsError << std::fixed
+              << std::setprecision(6) << (warm_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //a spent time budget stops the fit before its first step, at the starting point
+    CalibrationOptions budget;
+    budget.timeBudgetMs = 1e-6;
+    const HestonParams guess = hestonInitialGuess(quotes);
+    const HestonCalibration late = calibrateHeston(100.0, 0.02, quotes, guess, budget);
+    const bool budget_ok = late.report.stop == CalibrationStop::TIME_BUDGET && late.report.iterations == 0
+                           && late.params.v0 == guess.v0 && late.params.rho == guess.rho;
+    ok = ok && budget_ok;
+    std::cout << "time budget spent: stop " << calibrationStopName(late.report.stop) << " after "
+              << late.report.iterations << " iterations" << (budget_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //SABR per expiry
+    const SabrParams sabr{2.0, 0.5, -0.3, 0.8};
+    std::vector<VolQuote> smile;
+    for (double T : {0.25, 1.0}) {
+        const double F = 100.0 * std::exp(0.02 * T);
+        for (double K = 70.0; K <= 130.0; K += 5.0) smile.push_back({K, T, sabrLognormalVol(F, K, T, sabr)});
+    }
+    const SabrCalibration fit = calibrateSabr(100.0, 0.02, smile, 0.5);
+    double sabr_err = 0.0;
+    for (const SabrSlice& slice : fit.slices) {
+        sabr_err = std::max({sabr_err, std::abs(slice.params.alpha - sabr.alpha), std::abs(slice.params.rho - sabr.rho),
+                             std::abs(slice.params.nu - sabr.nu)});
+    }
+    const bool sabr_ok = fit.slices.size() == 2 && sabr_err < 1e-6 && fit.report.rmsError < 1e-10;
+    ok = ok && sabr_ok;
+    std::cout << "sabr fit, 2 expiries: max parameter error " << std::scientific << std::setprecision(1) << sabr_err
+              << std::fixed << std::setprecision(6) << (sabr_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkSmiles() {
+    bool ok = true;
+    //vectorized Hagan against the scalar formulas at every instruction set, the money strike included
+    const SabrParams sabr{2.0, 0.5, -0.3, 0.8};
+    const double F = 101.0, T = 0.75;
+    std::vector<double> strikes;
+    for (int i = 0; i <= 60; ++i) strikes.push_back(60.0 + i * 1.5);
+    strikes.push_back(F);
+    std::vector<double> vols(strikes.size());
+    double hagan_err = 0.0;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        sabrLognormalVols(F, T, sabr, strikes.data(), vols.data(), strikes.size(), level);
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            hagan_err = std::max(hagan_err, std::abs(vols[j] / sabrLognormalVol(F, strikes[j], T, sabr) - 1.0));
+        }
+        sabrNormalVols(F, T, sabr, strikes.data(), vols.data(), strikes.size(), level);
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            hagan_err = std::max(hagan_err, std::abs(vols[j] / sabrNormalVol(F, strikes[j], T, sabr) - 1.0));
+        }
+    }
+    const bool hagan_ok = hagan_err < 1e-13;
+    ok = ok && hagan_ok;
+    std::cout << "vectorized hagan vs scalar: max relative difference " << std::scientific << std::setprecision(1)
+              << hagan_err << std::fixed << std::setprecision(6) << (hagan_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //the normal and lognormal expansions price the same option to their order of accuracy (they part by
+    //O(T) terms away from the money, 2e-4 of vol at K = 80 here)
+    double bachelier_err = 0.0;
+    for (double K : {80.0, 101.0, 125.0}) {
+        const double sn = sabrNormalVol(F, K, T, sabr) * std::sqrt(T), d = (F - K) / sn;
+        const double bachelier = (F - K) * OptionPricer::normalCDF(d) + sn * OptionPricer::normalPDF(d);
+        const double sb = sabrLognormalVol(F, K, T, sabr) * std::sqrt(T);
+        const double d1 = std::log(F / K) / sb + 0.5 * sb;
+        const double black = F * OptionPricer::normalCDF(d1) - K * OptionPricer::normalCDF(d1 - sb);
+        const double vega = F * std::sqrt(T) * OptionPricer::normalPDF(d1);
+        bachelier_err = std::max(bachelier_err, std::abs(bachelier - black) / vega);
+    }
+    const bool bachelier_ok = bachelier_err < 5e-4;
+    ok = ok && bachelier_ok;
+    std::cout << "normal vs lognormal hagan, forward prices: max difference " << std::scientific << std::setprecision(1)
+              << bachelier_err << " in vol" << std::fixed << std::setprecision(6) << (bachelier_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //raw SVI recovered from its own smiles, one slice per expiry
+    const double S = 100.0, r = 0.02;
+    const std::vector<SviSlice> svi_truth = {{0.25, {0.004, 0.08, -0.4, 0.02, 0.12}},
+                                             {1.0, {0.02, 0.12, -0.5, 0.05, 0.25}}};
+    std::vector<VolQuote> quotes;
+    for (const SviSlice& slice : svi_truth) {
+        for (int i = -8; i <= 8; ++i) {
+            const double k = 0.05 * i;
+            const double K = S * std::exp(r * slice.expiry + k);
+            quotes.push_back({K, slice.expiry, std::sqrt(sviTotalVariance(k, slice.params) / slice.expiry)});
+        }
+    }
+    const SviCalibration svi = calibrateSvi(S, r, quotes);
+    double svi_err = 0.0;
+    for (size_t e = 0; e < svi.slices.size(); ++e) {
+        const SviParams& p = svi.slices[e].params;
+        const SviParams& t = svi_truth[e].params;
+        svi_err = std::max({svi_err, std::abs(p.a - t.a), std::abs(p.b - t.b), std::abs(p.rho - t.rho),
+                            std::abs(p.m - t.m), std::abs(p.sigma - t.sigma)});
+        validateSvi(p);
+    }
+    //a wing slope b (1 + |rho|) = 3.8 breaks Lee's bound: call prices would tend to F, not 0, as K grows
+    bool steep_rejected = false;
+    try {
+        validateSvi({0.01, 2.0, 0.9, 0.0, 0.1});
+    } catch (const std::invalid_argument&) {
+        steep_rejected = true;
+    }
+    const bool svi_ok = svi.slices.size() == 2 && svi_err < 1e-6 && svi.report.rmsError < 1e-10 && steep_rejected;
+    ok = ok && svi_ok;
+    std::cout << "raw svi fit, 2 expiries: " << svi.report.iterations << " iterations, max parameter error "
+              << std::scientific << std::setprecision(1) << svi_err << std::fixed << std::setprecision(6)
+              << (svi_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //SSVI from quotes on a surface with strikes at the forward, so theta is read off exactly
+    const SsviParams ssvi_truth{-0.6, 1.1, 0.35};
+    const std::vector<double> expiries = {0.1, 0.5, 1.0, 2.0}, thetas = {0.005, 0.02, 0.038, 0.07};
+    quotes.clear();
+    for (size_t e = 0; e < expiries.size(); ++e) {
+        for (int i = -6; i <= 6; ++i) {
+            const double k = 0.06 * i * std::sqrt(expiries[e]);
+            const double K = S * std::exp(r * expiries[e] + k);
+            quotes.push_back({K, expiries[e], std::sqrt(ssviTotalVariance(k, thetas[e], ssvi_truth) / expiries[e])});
+        }
+    }
+    const SsviCalibration ssvi = calibrateSsvi(S, r, quotes);
+    double theta_err = 0.0;
+    for (size_t e = 0; e < thetas.size(); ++e) theta_err = std::max(theta_err, std::abs(ssvi.thetas[e] - thetas[e]));
+    const double ssvi_err = std::max({std::abs(ssvi.params.rho - ssvi_truth.rho), std::abs(ssvi.params.eta - ssvi_truth.eta),
+                                      std::abs(ssvi.params.gamma - ssvi_truth.gamma), theta_err});
+    const bool ssvi_ok = ssvi_err < 1e-6 && ssvi.report.rmsError < 1e-10;
+    ok = ok && ssvi_ok;
+    std::cout << "ssvi fit of " << quotes.size() << " quotes: " << ssvi.report.iterations << " iterations, max parameter error "
+              << std::scientific << std::setprecision(1) << ssvi_err << std::fixed << std::setprecision(6)
+              << (ssvi_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //surfaces as vol sources: slices reproduced, strips vectorized, off-grid prices one smile + one BS
+    const SabrSurface sabr_surface(S, r, {{0.25, sabr}, {1.0, {2.2, 0.5, -0.4, 0.6}}});
+    const SviSurface svi_surface(S, r, svi_truth);
+    const SsviSurface ssvi_surface(S, r, ssvi.params, ssvi.expiries, ssvi.thetas);
+    double slice_err = std::abs(sabr_surface.vol(90.0, 0.25) / sabrLognormalVol(S * std::exp(r * 0.25), 90.0, 0.25, sabr) - 1.0);
+    slice_err = std::max(slice_err, std::abs(svi_surface.vol(S * std::exp(r + 0.1), 1.0)
+                                             - std::sqrt(sviTotalVariance(0.1, svi_truth[1].params))));
+    double strip_err = 0.0, price_err = 0.0;
+    std::vector<double> s(strikes.size(), S), t(strikes.size(), 0.6), rr(strikes.size(), r), batch(strikes.size());
+    std::vector<OptionType> types(strikes.size(), OptionType::PUT);
+    auto checkSource = [&](const auto& source) {
+        source.smile(0.6, strikes.data(), vols.data(), strikes.size());
+        blackScholesBatch(s.data(), strikes.data(), t.data(), rr.data(), source, types.data(), batch.data(), strikes.size());
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            const double vol = source.vol(strikes[j], 0.6);
+            strip_err = std::max(strip_err, std::abs(vols[j] / vol - 1.0));
+            const double price = priceWithSmile(S, strikes[j], 0.6, r, source, OptionType::PUT).price;
+            price_err = std::max({price_err, std::abs(price - OptionPricer::priceWithGreeks(S, strikes[j], 0.6, r, vol, OptionType::PUT).price),
+                                  std::abs(batch[j] - price)});
+        }
+    };
+    checkSource(sabr_surface);
+    checkSource(svi_surface);
+    checkSource(ssvi_surface);
+    const bool source_ok = slice_err < 1e-14 && strip_err < 1e-13 && price_err < 1e-10;
+    ok = ok && source_ok;
+    std::cout << "sabr/svi/ssvi surfaces as vol sources: slice error " << std::scientific << std::setprecision(1) << slice_err
+              << ", strip vs single " << strip_err << ", price " << price_err << std::fixed << std::setprecision(6)
+              << (source_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkVolSurface() {
+    bool ok = true;
+    //market vols off a smooth SVI surface on a 41 x 12 grid
+    const double S = 100.0, r = 0.02;
+    const SviSurface svi(S, r, {{0.1, {0.002, 0.05, -0.4, 0.01, 0.1}}, {3.0, {0.05, 0.15, -0.5, 0.05, 0.3}}});
+    std::vector<double> strikes, expiries, vols;
+    for (int i = 0; i <= 40; ++i) strikes.push_back(60.0 + 2.0 * i);
+    for (double T : {0.1, 0.2, 0.3, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 2.25, 2.5, 3.0}) expiries.push_back(T);
+    for (double T : expiries) {
+        for (double K : strikes) vols.push_back(svi.vol(K, T));
+    }
+    const VolSurface bilinear(strikes, expiries, vols, VolInterpolation::BILINEAR);
+    const VolSurface bicubic(strikes, expiries, vols, VolInterpolation::BICUBIC);
+
+    double node_err = 0.0, linear_err = 0.0, cubic_err = 0.0;
+    for (size_t e = 0; e < expiries.size(); ++e) {
+        for (size_t j = 0; j < strikes.size(); ++j) {
+            const double vol = vols[e * strikes.size() + j];
+            node_err = std::max({node_err, std::abs(bilinear.vol(strikes[j], expiries[e]) - vol),
+                                 std::abs(bicubic.vol(strikes[j], expiries[e]) - vol)});
+        }
+    }
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (int i = 0; i < 2000; ++i) {
+        const double K = 61.0 + 78.0 * u(gen), T = 0.1 + 2.9 * u(gen);
+        const double vol = svi.vol(K, T);
+        linear_err = std::max(linear_err, std::abs(bilinear.vol(K, T) - vol));
+        cubic_err = std::max(cubic_err, std::abs(bicubic.vol(K, T) - vol));
+    }
+    const bool interp_ok = node_err < 1e-12 && cubic_err < 2e-4 && cubic_err < 0.2 * linear_err;
+    ok = ok && interp_ok;
+    std::cout << "41 x 12 surface: node error " << std::scientific << std::setprecision(1) << node_err
+              << ", off-grid vol error bilinear " << linear_err << ", bicubic " << cubic_err << std::fixed
+              << std::setprecision(6) << (interp_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //a single-node update leaves every cell as a rebuild from scratch would
+    VolSurface updated = bicubic;
+    updated.setVol(5, 20, 0.3);
+    std::vector<double> bumped = vols;
+    bumped[5 * strikes.size() + 20] = 0.3;
+    const VolSurface rebuilt(strikes, expiries, bumped, VolInterpolation::BICUBIC);
+    double update_err = 0.0;
+    for (int i = 0; i < 2000; ++i) {
+        const double K = 55.0 + 90.0 * u(gen), T = 0.05 + 3.0 * u(gen);
+        update_err = std::max(update_err, std::abs(updated.vol(K, T) - rebuilt.vol(K, T)));
+    }
+    const bool update_ok = update_err == 0.0 && std::abs(updated.vol(strikes[20], expiries[5]) - 0.3) < 1e-14;
+    ok = ok && update_ok;
+    std::cout << "setVol vs rebuilt surface: max difference " << std::scientific << std::setprecision(1) << update_err
+              << std::fixed << std::setprecision(6) << (update_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //readers never see a half-published surface: every snapshot is flat at one vol
+    SnapshotRegistry<VolSurface> registry;
+    auto flat = [&](double vol) {
+        return std::make_shared<const VolSurface>(strikes, expiries, std::vector<double>(vols.size(), vol));
+    };
+    registry.publish("SPX", flat(0.1));
+    std::atomic<bool> done{false};
+    std::atomic<long> torn{0}, reads{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                const auto surface = registry.get("SPX");
+                if (std::abs(surface->vol(70.0, 0.2) - surface->vol(130.0, 2.9)) > 1e-12) torn.fetch_add(1);
+                reads.fetch_add(1);
+            }
+        });
+    }
+    for (int i = 1; i <= 200; ++i) registry.publish("SPX", flat(0.1 + 0.001 * i));
+    done.store(true);
+    for (std::thread& t : readers) t.join();
+    const double last = registry.get("SPX")->vol(100.0, 1.0);
+    const bool rcu_ok = torn.load() == 0 && std::abs(last - 0.3) < 1e-12 && !registry.get("NDX");
+    ok = ok && rcu_ok;
+    std::cout << "200 publishes under " << reads.load() << " concurrent reads: " << torn.load() << " inconsistent snapshots"
+              << (rcu_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //a full registry still replaces existing names, refuses new ones and stays as it was
+    SnapshotRegistry<VolSurface> bounded(2);
+    bounded.publish("SPX", flat(0.1));
+    bounded.publish("NDX", flat(0.2));
+    bounded.publish("SPX", flat(0.3));
+    bool refused = false;
+    try {
+        bounded.publish("RUT", flat(0.4));
+    } catch (const std::length_error&) {
+        refused = true;
+    }
+    const bool capacity_ok = refused && !bounded.get("RUT") && bounded.names().size() == 2
+                          && std::abs(bounded.get("SPX")->vol(100.0, 1.0) - 0.3) < 1e-12;
+    ok = ok && capacity_ok;
+    std::cout << "registry of 2: third name " << (refused ? "refused" : "accepted") << ", existing names replaced"
+              << (capacity_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkYieldCurve() {
+    bool ok = true;
+    //deposits to a year, semiannual swaps beyond: every quote reprices on the bootstrapped curve
+    const std::vector<CurveQuote> quotes = {
+        {0.25, 0.040, CurveInstrument::DEPOSIT}, {0.5, 0.042, CurveInstrument::DEPOSIT},
+        {1.0, 0.043, CurveInstrument::DEPOSIT},  {2.0, 0.041, CurveInstrument::SWAP, 2},
+        {3.0, 0.039, CurveInstrument::SWAP, 2},  {5.0, 0.038, CurveInstrument::SWAP, 2},
+        {7.0, 0.039, CurveInstrument::SWAP, 2},  {10.0, 0.040, CurveInstrument::SWAP, 2}};
+    for (CurveInterpolation interpolation : {CurveInterpolation::LOG_LINEAR, CurveInterpolation::MONOTONE_CONVEX}) {
+        const YieldCurve curve = YieldCurve::bootstrap(quotes, interpolation);
+        double reprice_err = 0.0;
+        for (const CurveQuote& q : quotes) {
+            double model = 0.0;
+            if (q.instrument == CurveInstrument::DEPOSIT) {
+                model = (1.0 / curve.discount(q.maturity) - 1.0) / q.maturity;
+            } else {
+                double annuity = 0.0;
+                for (double t = 0.5; t <= q.maturity + 1e-9; t += 0.5) annuity += 0.5 * curve.discount(t);
+                model = (1.0 - curve.discount(q.maturity)) / annuity;
+            }
+            reprice_err = std::max(reprice_err, std::abs(model - q.rate));
+        }
+        //forwards against the slope of ln D, and across the inner knots
+        double slope_err = 0.0, jump = 0.0;
+        for (double T = 0.05; T < 12.0; T += 0.173) {
+            const double h = 1e-5;
+            const double slope = -(curve.logDiscount(T + h) - curve.logDiscount(T - h)) / (2.0 * h);
+            slope_err = std::max(slope_err, std::abs(slope - curve.forwardRate(T)));
+        }
+        for (size_t i = 0; i + 1 < curve.maturities().size(); ++i) {
+            const double t = curve.maturities()[i];
+            jump = std::max(jump, std::abs(curve.forwardRate(t + 1e-9) - curve.forwardRate(t - 1e-9)));
+        }
+        const bool convex = interpolation == CurveInterpolation::MONOTONE_CONVEX;
+        const bool curve_ok = reprice_err < 1e-12 && slope_err < 1e-6 && (!convex || jump < 1e-6);
+        ok = ok && curve_ok;
+        std::cout << std::left << std::setw(16) << curveInterpolationName(interpolation) << std::right
+                  << "reprice error " << std::scientific << std::setprecision(1) << reprice_err << ", forward vs slope "
+                  << slope_err << ", largest forward jump at a knot " << jump << std::fixed << std::setprecision(6)
+                  << (curve_ok ? "  PASS" : "  FAIL") << "\n";
+    }
+
+    //knots where a forward offset is exactly zero: a flat curve, and repeated rates before a step,
+    //looked up on the knots themselves and between them
+    double flat_err = 0.0, step_err = 0.0;
+    bool finite = true;
+    for (CurveInterpolation interpolation : {CurveInterpolation::LOG_LINEAR, CurveInterpolation::MONOTONE_CONVEX}) {
+        const YieldCurve flat({0.5, 1.0, 2.0, 5.0}, {0.04, 0.04, 0.04, 0.04}, interpolation);
+        for (double T : {0.25, 0.5, 0.75, 1.0, 1.5, 2.0, 3.0, 5.0, 7.0}) {
+            flat_err = std::max({flat_err, std::abs(flat.discount(T) - std::exp(-0.04 * T)),
+                                 std::abs(flat.forwardRate(T) - 0.04)});
+        }
+        const YieldCurve step({1.0, 2.0, 3.0}, {0.03, 0.03, 0.05}, interpolation);
+        const YieldCurve booted = YieldCurve::bootstrap({{1.0, 0.03}, {2.0, 0.03}, {3.0, 0.05}}, interpolation);
+        for (double T : {0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 4.0}) {
+            finite = finite && std::isfinite(step.discount(T)) && std::isfinite(step.forwardRate(T))
+                     && std::isfinite(booted.discount(T));
+        }
+        for (double T : {1.0, 2.0, 3.0}) {
+            step_err = std::max({step_err, std::abs(step.zeroRate(T) - (T < 3.0 ? 0.03 : 0.05)),
+                                 std::abs(booted.zeroRate(T) - step.zeroRate(T))});
+        }
+    }
+    const bool zero_ok = finite && flat_err < 1e-15 && step_err < 1e-15;
+    ok = ok && zero_ok;
+    std::cout << "flat curve error " << std::scientific << std::setprecision(1) << flat_err
+              << ", repeated rates at the knots " << step_err << std::fixed << std::setprecision(6)
+              << (zero_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //swaps past kMaxSwapPayments coupons, including maturities no long can count, are rejected up front
+    int too_long = 0;
+    for (double T : {101.0, 1e8, 1e300}) {
+        try {
+            YieldCurve::bootstrap({{T, 0.04, CurveInstrument::SWAP, 12}});
+        } catch (const std::invalid_argument&) {
+            ++too_long;
+        }
+    }
+    const bool swap_cap_ok = too_long == 3;
+    ok = ok && swap_cap_ok;
+    std::cout << "monthly swaps of 101, 1e8 and 1e300 years: " << too_long << " of 3 rejected"
+              << (swap_cap_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //the shared discount cache under concurrent readers, with far more expiries than slots
+    const YieldCurve curve = YieldCurve::bootstrap(quotes);
+    std::vector<double> expiries(3 * kCurveCacheSlots), expected(expiries.size());
+    for (size_t i = 0; i < expiries.size(); ++i) {
+        expiries[i] = 0.01 + 0.0037 * i;
+        expected[i] = std::exp(curve.logDiscount(expiries[i]));
+    }
+    std::atomic<long> wrong{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 gen(t);
+            for (int i = 0; i < 200000; ++i) {
+                const size_t j = gen() % (i % 2 ? 16 : expiries.size());  //half the reads on a few hot expiries
+                if (curve.discount(expiries[j]) != expected[j]) wrong.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& t : readers) t.join();
+    const bool cache_ok = wrong.load() == 0;
+    ok = ok && cache_ok;
+    std::cout << "discount cache, 4 threads x 200000 reads: " << wrong.load() << " wrong values"
+              << (cache_ok ? "  PASS" : "  FAIL") << "\n";
+
+    //flat curves against the black-scholes-merton formula with a dividend yield
+    const double S = 100.0, r = 0.03, q = 0.02, sigma = 0.25;
+    const YieldCurve rates({1.0}, {r}), dividends({1.0}, {q});
+    double merton_err = 0.0;
+    for (OptionType type : {OptionType::CALL, OptionType::PUT}) {
+        for (double K : {80.0, 100.0, 125.0}) {
+            for (double T : {0.1, 1.0, 3.0}) {
+                const PriceGreeks pg = priceWithCurves(S, K, T, rates, &dividends, sigma, type);
+                const double sq = sigma * std::sqrt(T);
+                const double d1 = (std::log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / sq, d2 = d1 - sq;
+                const double Sq = S * std::exp(-q * T), Kr = K * std::exp(-r * T);
+                const double w = type == OptionType::CALL ? 1.0 : -1.0;
+                const double N1 = OptionPricer::normalCDF(w * d1), N2 = OptionPricer::normalCDF(w * d2);
+                const double n1 = OptionPricer::normalPDF(d1);
+                const double price = w * (Sq * N1 - Kr * N2);
+                const double delta = w * std::exp(-q * T) * N1;
+                const double gamma = std::exp(-q * T) * n1 / (S * sq);
+                const double theta = (-Sq * n1 * sigma / (2.0 * std::sqrt(T)) + w * (q * Sq * N1 - r * Kr * N2)) / 365.0;
+                merton_err = std::max({merton_err, std::abs(pg.price - price), std::abs(pg.greeks.delta - delta),
+                                       std::abs(pg.greeks.gamma - gamma), std::abs(pg.greeks.theta - theta)});
+            }
+        }
+    }
+    //a chain through priceBatch on the bootstrapped curve and an implied dividend curve
+    std::vector<double> fwdExpiries = {0.25, 0.5, 1.0, 2.0}, forwards;
+    for (double T : fwdExpiries) forwards.push_back(S * std::exp(-q * T) / curve.discount(T));
+    const YieldCurve implied = impliedDividendCurve(S, curve, fwdExpiries, forwards);
+    double implied_err = 0.0;
+    for (double T : fwdExpiries) implied_err = std::max(implied_err, std::abs(implied.zeroRate(T) - q));
+    OptionBatch chain;
+    for (double T : {0.1, 0.1, 0.1, 0.7, 0.7, 1.5, 4.0, 4.0}) {
+        for (double K : {70.0, 95.0, 100.0, 140.0}) chain.add(S, K, T, 0.0, sigma, K < 100.0 ? OptionType::PUT : OptionType::CALL);
+    }
+    BatchResult result;
+    priceBatch(chain, curve, &implied, result);
+    double batch_err = 0.0;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        const PriceGreeks pg = priceWithCurves(S, chain.K[i], chain.T[i], curve, &implied, sigma, chain.type[i]);
+        batch_err = std::max({batch_err, std::abs(result.price[i] - pg.price), std::abs(result.delta[i] - pg.greeks.delta),
+                              std::abs(result.gamma[i] - pg.greeks.gamma), std::abs(result.theta[i] - pg.greeks.theta)});
+    }
+    const bool pricing_ok = merton_err < 1e-12 && implied_err < 1e-14 && batch_err < 1e-9;
+    ok = ok && pricing_ok;
+    std::cout << "flat curves vs merton " << std::scientific << std::setprecision(1) << merton_err
+              << ", implied dividend yield " << implied_err << ", batch vs single " << batch_err << std::fixed
+              << std::setprecision(6) << (pricing_ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+bool checkImpliedVolRoundTrip() {
+    const size_t n = 100000;
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    double max_err = 0.0;
+    long total_iter = 0;
+    int max_iter = 0;
+    size_t failures = 0, solved = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double S = 100.0, K = 50.0 + 100.0 * u(gen), T = 0.02 + 3.0 * u(gen);
+        const double r = 0.08 * u(gen), sigma = 0.05 + 1.0 * u(gen);
+        const OptionType type = u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT;
+        const double price = OptionPricer::priceWithGreeks(S, K, T, r, sigma, type).price;
+        //skip contracts whose time value is too small to pin down the vol (deep in or out of the money)
+        const double K_disc = K * std::exp(-r * T);
+        const double time_value = price - std::max(type == OptionType::CALL ? S - K_disc : K_disc - S, 0.0);
+        if (time_value < 1e-6 * S * std::sqrt(T)) continue;
+        ImpliedVolResult iv = solveImpliedVol(price, S, K, T, r, type, 1e-12);
+        if (!iv.converged) { ++failures; continue; }
+        max_err = std::max(max_err, std::abs(iv.vol - sigma));
+        ++solved;
+        total_iter += iv.iterations;
+        max_iter = std::max(max_iter, iv.iterations);
+    }
+    bool ok = failures == 0 && max_err < 1e-6;
+    std::cout << "Round trip on " << solved << " contracts: max vol error " << std::scientific << max_err << std::fixed
+              << ", mean " << std::setprecision(2) << double(total_iter) / solved << std::setprecision(6)
+              << " / max " << max_iter << " iterations, " << failures << " failures" << (ok ? "  PASS" : "  FAIL") << "\n";
+    return ok;
+}
+
+// rational implied vol: machine precision (relative to the conditioning of the price) in at most two
+// iterations over a much wider range than the round trip above, and statuses for impossible prices
+bool checkRationalImpliedVol() {
+    const size_t n = 100000;
+    std::mt19937 gen(12);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    double max_err = 0.0;  //in units of the error the price itself allows
+    int max_iter = 0;
+    size_t failures = 0, solved = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double S = 100.0, K = S * std::exp(-4.0 + 8.0 * u(gen)), T = 0.003 + 3.0 * u(gen);
+        const double r = 0.08 * u(gen), sigma = 0.01 + 2.0 * u(gen);
+        const OptionType type = u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT;
+        const double price = blackScholesExact(S, K, T, r, sigma, type);
+        //a price of ~1e-300 has lost its mantissa, and deep in the money the time value can be
+        //below the rounding of the intrinsic value: either way sigma is invisible in the price
+        const double K_disc = K * std::exp(-r * T);
+        const double time_value = price - std::max(type == OptionType::CALL ? S - K_disc : K_disc - S, 0.0);
+        if (price < 1e-290 || time_value < 1e-12 * price) continue;
+        ImpliedVolResult iv = solveImpliedVolRational(price, S, K, T, r, type);
+        if (iv.status != ImpliedVolStatus::OK) { ++failures; continue; }
+        //a relative error eps in the price moves the vol by eps price / vega
+        const double vega = S * OptionPricer::normalPDF(std::log(S / K) / (sigma * std::sqrt(T))
+                                                        + (r / sigma + 0.5 * sigma) * std::sqrt(T)) * std::sqrt(T);
+        const double allowed = DBL_EPSILON * std::max(sigma, price / vega);
+        max_err = std::max(max_err, std::abs(iv.vol - sigma) / allowed);
+        max_iter = std::max(max_iter, iv.iterations);
+        ++solved;
+    }
+    bool ok = failures == 0 && max_err < 64.0 && max_iter <= 2;
+    std::cout << "Rational on " << solved << " contracts: max vol error " << std::setprecision(1) << max_err
+              << std::setprecision(6) << " x price precision, max " << max_iter << " iterations, " << failures
+              << " failures" << (ok ? "  PASS" : "  FAIL") << "\n";
+
+    const bool below = solveImpliedVolRational(9.0, 110.0, 100.0, 1.0, 0.0, OptionType::CALL).status
+                       == ImpliedVolStatus::BELOW_INTRINSIC;
+    const bool above = solveImpliedVolRational(100.0, 100.0, 90.0, 1.0, 0.0, OptionType::CALL).status
+                       == ImpliedVolStatus::ABOVE_MAXIMUM;
+    const bool invalid = solveImpliedVolRational(1.0, 100.0, 100.0, 0.0, 0.0, OptionType::PUT).status
+                         == ImpliedVolStatus::INVALID_INPUT;
+    std::cout << "Below intrinsic, above maximum, invalid input statuses: "
+              << (below && above && invalid ? "PASS" : "FAIL") << "\n";
+    return ok && below && above && invalid;
+}
+
+// batch implied vols vs solveImpliedVol quote by quote, on every instruction set
+// statuses must match, vols agree to within the price tolerance (|dvol| * vega)
+bool checkImpliedVolBatch() {
+    const size_t n = 100003;  // odd size so the padded tail is exercised
+    std::mt19937 gen(13);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::vector<double> price(n), S(n, 100.0), K(n), T(n), r(n);
+    std::vector<OptionType> type(n);
+    for (size_t i = 0; i < n; ++i) {
+        K[i] = 60.0 + 80.0 * u(gen);
+        T[i] = 0.02 + 2.0 * u(gen);
+        r[i] = 0.08 * u(gen);
+        type[i] = u(gen) < 0.5 ? OptionType::CALL : OptionType::PUT;
+        price[i] = OptionPricer::priceWithGreeks(S[i], K[i], T[i], r[i], 0.05 + 0.8 * u(gen), type[i]).price;
+    }
+    price[1] = -1.0;  //invalid
+    price[2] = 1e6;   //above the maximum
+    T[3] = 0.0;       //invalid
+
+    bool ok = true;
+    std::vector<ImpliedVolResult> out(n);
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel()) continue;
+        impliedVolBatch(price.data(), S.data(), K.data(), T.data(), r.data(), type.data(), out.data(), n,
+                        1e-10, 50, level);
+        double max_err = 0.0;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const ImpliedVolResult expected = solveImpliedVol(price[i], S[i], K[i], T[i], r[i], type[i]);
+            if (expected.status != out[i].status) { ++mismatches; continue; }
+            if (!expected.converged || expected.vol == out[i].vol) continue;
+            const double vega = OptionPricer::priceWithGreeks(S[i], K[i], T[i], r[i], expected.vol, type[i]).greeks.vega;
+            max_err = std::max(max_err, std::abs(out[i].vol - expected.vol) * vega);
+        }
+        bool pass = mismatches == 0 && max_err < 1e-9;
+        ok = ok && pass;
+        std::cout << std::setw(7) << simdLevelName(level) << ": max |dvol| * vega " << std::scientific << max_err
+                  << std::fixed << ", " << mismatches << " status mismatches" << (pass ? "  PASS" : "  FAIL") << "\n";
+    }
+    return ok;
+}
+
+// result cache: quantized keys collide as intended, and each shard evicts its least recently used entry
+bool checkResultCache() {
+    CacheQuantization q;
+    PriceCacheKey a = makeContractKey(q, 100.0, 100.0, 1.0, 0.05, 0.2, 0);
+    PriceCacheKey near = makeContractKey(q, 100.00001, 100.0, 1.0, 0.05, 0.2, 0);
+    PriceCacheKey put = makeContractKey(q, 100.0, 100.0, 1.0, 0.05, 0.2, 1);
+    bool ok = a == near && !(a == put);
+
+    //one shard of capacity 2 makes the eviction order observable
+    ShardedLruCache<PriceCacheKey, double, PriceCacheKeyHash, 1> cache(2);
+    PriceCacheKey b = makeContractKey(q, 101.0, 100.0, 1.0, 0.05, 0.2, 0);
+    PriceCacheKey c = makeContractKey(q, 102.0, 100.0, 1.0, 0.05, 0.2, 0);
+    double value = 0.0;
+    cache.put(a, 1.0);
+    cache.put(b, 2.0);
+    ok = ok && cache.get(a, value) && value == 1.0;  //a is now most recent
+    cache.put(c, 3.0);                                 //evicts b
+    ok = ok && !cache.get(b, value) && cache.get(c, value) && value == 3.0 && cache.size() == 2;
+    ok = ok && cache.hits() == 2 && cache.misses() == 1;
+    std::cout << "Quantized keys, LRU eviction, hit/miss counters: " << (ok ? "PASS" : "FAIL") << "\n";
+    return ok;
+}
+
 int main() {
     // Test parameters
     double S = 100.0;     // Spot price
@@ -67,5 +1266,76 @@ int main() {
     std::cout << "Implied Vol:  " << implied_vol*100 << "%\n";
     std::cout << "Input Vol:    " << sigma*100 << "%\n";
     
-    return 0;
+    // normal CDF policies (NormalCdf.h), the pricer uses NormalCdf
+    std::cout << "\n=== NORMAL CDF (vs long double erfc, pricer uses " << NormalCdf::name << ") ===\n";
+    bool cdf_ok = checkNormalCdf<HornerCdf>(7.5e-8, 1.0);
+    cdf_ok = checkNormalCdf<CodyCdf>(1e-15, 1e-14) && cdf_ok;
+    cdf_ok = checkNormalCdf<ErfcCdf>(1e-15, 1e-12) && cdf_ok;
+    
+    // SIMD batch pricing
+    std::cout << "\n=== SIMD BATCH ACCURACY (vs scalar blackScholes) ===\n";
+    std::cout << "Detected: " << simdLevelName(detectSimdLevel()) << "\n";
+    bool batch_ok = checkBatchAccuracy();
+    
+    // Parallel Monte Carlo
+    std::cout << "\n=== PARALLEL MONTE CARLO DETERMINISM (1M sims, seed 12345) ===\n";
+    bool mc_ok = checkMonteCarloDeterminism(pricer, call_bs);
+    
+    // Control variates
+    std::cout << "\n=== VARIANCE REDUCTION (100k paths, seed 7) ===\n";
+    bool vr_ok = checkVarianceReduction(pricer, call_bs);
+    
+    std::cout << "\n=== DIGITAL PAYOFFS (400k paths, seed 3, vs cash e^(-rT) N(d2)) ===\n";
+    bool digital_ok = checkDigitalMonteCarlo(pricer);
+
+    std::cout << "\n=== PATH-DEPENDENT MONTE CARLO (seed 5, vs closed forms) ===\n";
+    bool exotic_ok = checkExoticMonteCarlo(pricer);
+
+    std::cout << "\n=== STREAMING MONTE CARLO (seed 9) ===\n";
+    bool streaming_ok = checkStreamingMonteCarlo(pricer);
+
+    std::cout << "\n=== AMERICAN MONTE CARLO (Longstaff-Schwartz, seed 3, vs CRR 2000 steps) ===\n";
+    bool american_ok = checkLongstaffSchwartz();
+
+    std::cout << "\n=== LATTICE (200 steps with Richardson, put 36/40) ===\n";
+    bool lattice_ok = checkLattice();
+
+    std::cout << "\n=== FINITE DIFFERENCES (Crank-Nicolson, 400 nodes x 200 steps) ===\n";
+    bool pde_ok = checkPde();
+
+    std::cout << "\n=== HESTON (COS, 256 terms; QE Monte Carlo, seed 7) ===\n";
+    bool heston_ok = checkHeston();
+
+    std::cout << "\n=== CALIBRATION (Levenberg-Marquardt, AD gradients) ===\n";
+    bool calibration_ok = checkCalibration();
+
+    std::cout << "\n=== SMILES (SABR / SVI / SSVI, vectorized strips) ===\n";
+    bool smile_ok = checkSmiles();
+
+    std::cout << "\n=== VOL SURFACE (41 x 12 grid, O(1) lookup, snapshot publishing) ===\n";
+    bool surface_ok = checkVolSurface();
+
+    std::cout << "\n=== YIELD CURVES (bootstrap, monotone-convex, shared discount cache) ===\n";
+    bool curve_ok = checkYieldCurve();
+    
+    // Adaptive stopping
+    std::cout << "\n=== ADAPTIVE MONTE CARLO (target std error $0.005, seed 7) ===\n";
+    bool adaptive_ok = checkAdaptiveMonteCarlo(pricer);
+    
+    // Quasi-Monte Carlo: same accuracy with an order of magnitude fewer paths
+    std::cout << "\n=== QUASI-MONTE CARLO (scrambled Sobol, seed 7) ===\n";
+    MonteCarloResult mc100k = monteCarloParallel(pricer, OptionType::CALL, 100000, 7);
+    std::cout << "MC  100000 paths:          $" << mc100k.price << " +/- " << mc100k.stdError
+              << "  error $" << std::abs(mc100k.price - call_bs) << "\n";
+    bool qmc_ok = checkQuasiMonteCarlo(pricer, call_bs);
+    
+    std::cout << "\n=== RESULT CACHE ===\n";
+    bool cache_ok = checkResultCache();
+    
+    std::cout << "\n=== IMPLIED VOLATILITY SOLVER ===\n";
+    bool iv_ok = checkImpliedVolRoundTrip();
+    bool rational_ok = checkRationalImpliedVol();
+    bool iv_batch_ok = checkImpliedVolBatch();
+    
+    return cdf_ok && batch_ok && mc_ok && vr_ok && adaptive_ok && digital_ok && exotic_ok && streaming_ok && qmc_ok && american_ok && lattice_ok && pde_ok && heston_ok && calibration_ok && smile_ok && surface_ok && curve_ok && cache_ok && iv_ok && rational_ok && iv_batch_ok ? 0 : 1;
 }
\ No newline at end of file